@@ -0,0 +1,2460 @@
+﻿/// \file
+/// \brief Narzędzie konsolowe (bez GUI) do pracy z danymi GIOŚ.
+/// \details Polecenie "sync" pobiera pomiary wszystkich stacji naraz i raportuje przepustowość,
+/// "startup" mierzy czas do pierwszej listy stacji, "refresh" dociąga tylko nowe pomiary jednej stacji, "migrate" importuje stary plik dane.json do lokalnej bazy pomiarów,
+/// "cache" buduje binarną pamięć podręczną do pracy offline, "stats" liczy statystyki stacji,
+/// "rollup" zestawia wszystkie stacje bazy (ranking województw i stacji), "search" wyszukuje stacje jak pole "Szukaj" w GUI,
+/// "alerts" przepuszcza pomiary przez silnik alertów (progi, skoki, anomalie), "archive" przenosi bazę do skompresowanego archiwum,
+/// "export" zapisuje bazę do CSV lub pliku kolumnowego,
+/// "chart" rysuje wykres do pliku PPM (czas klatki, suma kontrolna obrazu),
+/// "correlate" przelicza mierniki stacji na siatkę godzinową i liczy macierz korelacji,
+/// "query" mierzy zapytania o zakres dat na syntetycznej historii, "windows" porównuje okna kroczące przyrostowe i liczone od nowa,
+/// "decimate" sprawdza redukcję serii wykresu, "parse" porównuje parser strumieniowy z drzewem dokumentu JSON,
+/// "check" uruchamia sprawdzenia zachowania (np. liczby połączeń klienta HTTP).
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <sstream>
+#include "ApiClient.h"
+#include "MeasurementStore.h"
+#include "BinaryCache.h"
+#include "MeasurementSeries.h"
+#include "Statistics.h"
+#include "RollingWindow.h"
+#include "StationDiff.h"
+#include "FetchPipeline.h"
+#include "Trace.h"
+#include "ReplayServer.h"
+#include "GiosReaders.h"
+#include "Rollups.h"
+#include "StationIndex.h"
+#include "AlertEngine.h"
+#include "HistoryArchive.h"
+#include "StoreExport.h"
+#include "ChartLayout.h"
+#include "ChartRaster.h"
+#include "HourlyGrid.h"
+#include "TimeUtils.h"
+#include <nlohmann/json.hpp>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <cmath>
+#include <limits>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>    //SetConsoleOutputCP
+#endif
+
+/// \brief Wyświetla sposób użycia programu.
+static void printUsage() {
+    std::cout << "Użycie:\n"
+        << "  AirQualityCli sync [--url ADRES] [--stations PLIK] [--store KATALOG] [--threads N] [--gzip]\n"
+        << "      Pobiera pomiary wszystkich stacji i zapisuje je do lokalnej bazy.\n"
+        << "      --url       adres API (domyślnie http://api.gios.gov.pl, np. lokalny serwer testowy)\n"
+        << "      --stations  lista stacji z pliku zamiast z API (np. stations.json)\n"
+        << "      --store     katalog lokalnej bazy pomiarów (domyślnie dane)\n"
+        << "      --threads   liczba wątków (domyślnie liczba rdzeni)\n"
+        << "      --gzip      pobieranie odpowiedzi skompresowanych\n"
+        << "  AirQualityCli refresh --station ID [--url ADRES] [--store KATALOG] [--repeat N] [--interval MS]\n"
+        << "      Pobiera tylko pomiary nowsze niż zapisane w bazie (synchronizacja przyrostowa).\n"
+        << "      --repeat    powtórz odświeżenie N razy (kolejne zapytania są warunkowe)\n"
+        << "      --interval  przerwa między odświeżeniami [ms]\n"
+        << "  AirQualityCli select --ids ID,ID,... [--gap MS] [--url ADRES] [--store KATALOG]\n"
+        << "      Symuluje szybkie przełączanie stacji w GUI: nowszy wybór anuluje wcześniejsze pobieranie.\n"
+        << "  AirQualityCli startup [--url ADRES] [--stations PLIK]\n"
+        << "      Mierzy czas do pierwszej użytecznej listy stacji: z pliku (start ciepły) i tylko z API (start zimny).\n"
+        << "  AirQualityCli migrate [--in PLIK] [--store KATALOG]\n"
+        << "      Importuje stary plik dane.json do lokalnej bazy pomiarów.\n"
+        << "  AirQualityCli cache [--in PLIK] [--out PLIK] | --bench [--stations N] [--days N]\n"
+        << "      Konwertuje dane.json do binarnej pamięci podręcznej (domyślnie dane.aqc). --bench: czas wczytania\n"
+        << "      jednej stacji z pamięci podręcznej, dane.json i lokalnej bazy na syntetycznym roku danych.\n"
+        << "  AirQualityCli stats --station ID [--metric NAZWA] [--from DATA] [--to DATA] [--store KATALOG]\n"
+        << "      Analiza pomiarów stacji z lokalnej bazy (jak przycisk \"Pokaż analizę\").\n"
+        << "  AirQualityCli stats --synthetic N [--repeat N]\n"
+        << "      Zgodność statystyk AVX2 i skalarnych ze wzorcem na losowych seriach (także n < 4) i czas analizy serii N punktów.\n"
+        << "  AirQualityCli rollup [--metric NAZWA] [--province NAZWA] [--from DATA] [--to DATA] [--last-hours N] [--limit X]\n"
+        << "                       [--hourly] [--top N] [--threads N] [--store KATALOG] [--stations PLIK] [--synthetic N]\n"
+        << "      Zestawienie wszystkich stacji z lokalnej bazy: ranking województw i stacji wg przekroczeń progu,\n"
+        << "      kwantyle krajowe (--hourly: dla każdej godziny). --last-hours: N godzin przed najnowszym pomiarem wszystkich stacji.\n"
+        << "      --synthetic N: benchmark na N stacjach z rokiem danych godzinowych.\n"
+        << "  AirQualityCli search [--query TEKST] [--stations PLIK] [--scale N] [--top N]\n"
+        << "      Wyszukiwanie stacji po nazwie i województwie (bez polskich znaków i wielkości liter). Bez --query: benchmark\n"
+        << "      czasu zapytania dla kolejnych wpisywanych liter na liście powielonej N razy (domyślnie 100) i zgodność z pełnym przeglądem.\n"
+        << "  AirQualityCli alerts [--store KATALOG] [--top N] | --synthetic N [--hours H]\n"
+        << "      Alerty (przekroczenie progu, nagły skok, anomalia z-score) dla pomiarów z lokalnej bazy.\n"
+        << "      --synthetic N: benchmark przepustowości na N stacjach x H godzin (PM10, PM2.5, NO2) z osobnym wątkiem odbierającym alerty.\n"
+        << "  AirQualityCli archive [--store KATALOG] [--out KATALOG] [--raw-days N] | --bench [--stations N] [--days N]\n"
+        << "      Dopisuje pomiary z lokalnej bazy do długoterminowego archiwum (domyślnie katalog archiwum, pomiary\n"
+        << "      godzinowe z ostatnich --raw-days dni, starsze jako zestawienia dobowe). --bench: rozmiar i czas zapytań\n"
+        << "      archiwum i formatu dane.json na syntetycznym roku danych.\n"
+        << "  AirQualityCli export [--format csv|columnar] [--out PLIK] [--store KATALOG] [--station ID,ID,...] [--province NAZWA]\n"
+        << "                       [--stations PLIK] [--metric NAZWA,...] [--from DATA] [--to DATA] | --synthetic N [--days N]\n"
+        << "      Strumieniowy eksport lokalnej bazy do CSV (domyślnie eksport.csv) lub pliku kolumnowego w formacie\n"
+        << "      pamięci podręcznej (eksport.aqc). --synthetic N: przepustowość na syntetycznej bazie N stacji.\n"
+        << "  AirQualityCli chart [--station ID] [--metric NAZWA,...] [--from DATA] [--to DATA] [--store KATALOG] | --synthetic N\n"
+        << "                      [--width N] [--height N] [--repeat N] [--out PLIK] [--expect SUMA]\n"
+        << "      Rysuje wykres (kilka mierników na wspólnych osiach) do obrazu PPM (domyślnie wykres.ppm) tym samym układem\n"
+        << "      co okno wykresu; czas układu i rysowania, suma kontrolna obrazu (--expect: porównanie ze wzorcem;\n"
+        << "      dla --synthetic 8760 i 800x500 domyślnie wzorzec zapisany w programie).\n"
+        << "  AirQualityCli correlate [--store KATALOG] [--station ID] [--gaps leave|linear|hold] [--max-gap N] [--from DATA]\n"
+        << "                          [--to DATA] [--threads N] | --synthetic N [--days N]\n"
+        << "      Wszystkie mierniki stacji na wspólnej siatce godzinowej (przerwy do --max-gap godzin: puste, interpolowane\n"
+        << "      lub ostatnia wartość) i macierz korelacji mierników, równolegle dla stacji. --synthetic N: benchmark na N\n"
+        << "      stacjach (1 wątek i pula, jądro skalarne i AVX2) ze sprawdzeniem wyników.\n"
+        << "  AirQualityCli query --synthetic LATA [--queries N]\n"
+        << "      Zapytania o zakres dat (doba..rok) na syntetycznej historii stacji: wyszukiwanie binarne w indeksie czasowym\n"
+        << "      wobec przeglądu całej serii, ze sprawdzeniem zgodności wyników.\n"
+        << "  AirQualityCli windows --synthetic DNI [--repeat N] [--wide GODZINY]\n"
+        << "      Okna kroczące 24h/8h (i okno --wide, domyślnie 720h) liczone przyrostowo wobec przeliczania każdego okna\n"
+        << "      od nowa (czas, zgodność wyników).\n"
+        << "  AirQualityCli decimate --synthetic N [--width N] [--height N] [--repeat N]\n"
+        << "      Sprawdza redukcję serii wykresu (minimum i maksimum globalne i każdej kolumny pikseli osi czasu, najwyżej\n"
+        << "      2 punkty na kolumnę; także przy nierównym kroku i przerwach) i mierzy czas klatki wobec rysowania N punktów.\n"
+        << "  AirQualityCli parse --synthetic N [--repeat N] [--chunk B]\n"
+        << "      Parser strumieniowy wobec drzewa dokumentu JSON na syntetycznych odpowiedziach API (dane czujnika z N pomiarami,\n"
+        << "      lista N/50 stacji): czas, przepustowość i zgodność wyników.\n"
+        << "  AirQualityCli check [NAZWA...] [--stations PLIK] [--data PLIK]\n"
+        << "      Sprawdzenia zachowania (bez nazw - wszystkie): connections, delta, breaker (na lokalnym serwerze\n"
+        << "      odtwarzającym), chart (obraz wykresu zgodny ze wzorcem), dates (poprawność zakresu dat),\n"
+        << "      migrate (import uszkodzonego dane.json).\n"
+        << "  AirQualityCli serve [--port N] [--scale N] [--latency MS] [--slow MS] [--stations PLIK] [--data PLIK]\n"
+        << "      Lokalny serwer odtwarzający odpowiedzi API z stations.json i dane.json (tryb: GET /replay/mode/up|down|slow).\n"
+        << "  AirQualityCli bench [--scales 1,10,100] [--repeat N] [--latency MS] [--concurrency N] [--out PLIK] [--stations PLIK]\n"
+        << "                      [--data PLIK]\n"
+        << "      Benchmarki (lista stacji, wczytanie stacji, czujniki po kolei i przez --concurrency połączeń, odczyt offline,\n"
+        << "      zapis, filtrowanie, statystyki) na serwerze odtwarzającym z opóźnieniem --latency; wyniki w JSON\n"
+        << "      (domyślnie bench.json) do porównywania wersji.\n"
+        << "DATA: YYYY, YYYY-MM, YYYY-MM-DD lub YYYY-MM-DD HH:MM (--to: do końca roku, miesiąca, dnia lub minuty).\n"
+        << "Każde polecenie przyjmuje --trace PLIK: pomiary etapów zapisane jako ślad Chrome i podsumowanie na końcu.\n";
+}
+
+/// \brief Odczytuje wartość opcji "--nazwa wartość" z linii poleceń.
+/// \return Wartość opcji lub def, jeśli opcji nie podano.
+static std::string getOption(int argc, char* argv[], const std::string& name, const std::string& def) {
+    for (int i = 2; i + 1 < argc; ++i)  //argv[1] to nazwa polecenia
+        if (name == argv[i]) return argv[i + 1];
+    return def;
+}
+
+/// \brief Sprawdza, czy w linii poleceń podano przełącznik (np. "--gzip").
+static bool hasFlag(int argc, char* argv[], const std::string& name) {
+    for (int i = 2; i < argc; ++i)
+        if (name == argv[i]) return true;
+    return false;
+}
+
+/// \brief Odczytuje zakres --from/--to (parseRangeBound); false i komunikat dla niepoprawnej daty.
+static bool getRangeOptions(int argc, char* argv[], int64_t& start, int64_t& end) {
+    if (!parseRangeBound(getOption(argc, argv, "--from", ""), false, start)) {
+        std::cerr << "Niepoprawna data --from: " << getOption(argc, argv, "--from", "") << " (YYYY, YYYY-MM, YYYY-MM-DD [HH:MM])\n";
+        return false;
+    }
+    if (!parseRangeBound(getOption(argc, argv, "--to", ""), true, end)) {
+        std::cerr << "Niepoprawna data --to: " << getOption(argc, argv, "--to", "") << " (YYYY, YYYY-MM, YYYY-MM-DD [HH:MM])\n";
+        return false;
+    }
+    return true;
+}
+
+/// \brief Polecenie "sync": masowa synchronizacja wszystkich stacji.
+static int runSync(int argc, char* argv[]) {
+    ApiClient api(getOption(argc, argv, "--url", "http://api.gios.gov.pl"));
+    std::string stationsFile = getOption(argc, argv, "--stations", "");
+    MeasurementStore store(getOption(argc, argv, "--store", "dane"));
+    unsigned threads = (unsigned)std::atoi(getOption(argc, argv, "--threads", "0").c_str());
+    if (hasFlag(argc, argv, "--gzip")) api.setCompression(true);
+
+    std::vector<Station> stations = stationsFile.empty() ? api.getAllStations() : api.loadStationsFromFile(stationsFile);
+    if (stations.empty()) {
+        std::cerr << "Brak listy stacji.\n";
+        return 1;
+    }
+
+    SyncStats stats;
+    auto results = api.syncAllStations(stations, stats, threads); //cala praca sieciowa
+    size_t written = 0;
+    for (const auto& station : results) //dopisanie tylko nowych pomiarow
+        written += store.append(std::to_string(station.first), station.second);
+
+    std::cout << std::fixed << std::setprecision(2)
+        << "Stacje:     " << stats.stations << " (" << stats.stationsPerSecond() << " stacji/s)\n"
+        << "Czujniki:   " << stats.sensors << " (" << stats.sensorsPerSecond() << " czujników/s)\n"
+        << "Pomiary:    " << stats.measurements << " (nowych: " << written << ")\n"
+        << "Dane:       " << stats.bytes << " B (" << stats.bytesPerSecond() / 1024.0 << " KiB/s)\n"
+        << "Błędy:      " << stats.failedRequests << "\n"
+        << "Czas:       " << stats.seconds << " s\n";
+    HttpSessionStats session = api.sessionStats();
+    std::cout << "Połączenia: " << session.connectionsOpened << " (żądań: " << session.requestsServed
+        << ", " << session.requestsPerConnection() << " na połączenie)\n";
+    return 0;
+}
+
+/// \brief Polecenie "refresh": synchronizacja przyrostowa jednej stacji.
+static int runRefresh(int argc, char* argv[]) {
+    std::string stationId = getOption(argc, argv, "--station", "");
+    if (stationId.empty()) {
+        printUsage();
+        return 1;
+    }
+    ApiClient api(getOption(argc, argv, "--url", "http://api.gios.gov.pl"));
+    MeasurementStore store(getOption(argc, argv, "--store", "dane"));
+    int repeat = std::max(1, std::atoi(getOption(argc, argv, "--repeat", "1").c_str()));
+    int interval = std::atoi(getOption(argc, argv, "--interval", "0").c_str()); //przerwa miedzy odswiezeniami [ms]
+
+    for (int i = 0; i < repeat; ++i) { //kolejne odswiezenia tej samej stacji
+        if (i > 0 && interval > 0) std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+        auto start = std::chrono::steady_clock::now();
+        DeltaSyncResult delta = api.fetchStationDelta(std::atoi(stationId.c_str()), store.newestDates(stationId));
+        if (!delta.online) { //tryb offline - dane z lokalnej bazy
+            size_t local = store.load(stationId).size();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            CircuitBreakerStats health = api.connectionHealth();
+            static const char* states[] = { "zamknięty", "otwarty", "półotwarty" };
+            std::cout << std::fixed << std::setprecision(1)
+                << "Offline: " << local << " pomiarów z bazy, " << ms << " ms (bezpiecznik: " << states[health.state]
+                << ", kolejne błędy: " << health.consecutiveFailures << ", próba za " << health.retryInMs << " ms)\n";
+            continue;
+        }
+        size_t written = store.append(stationId, delta.fresh);
+        size_t corrected = store.append(stationId, delta.rechecked); //zapisuje tylko poprawione wartosci
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << std::fixed << std::setprecision(1)
+            << "Nowe: " << delta.newPoints << " (zapisane: " << written << "), znane: " << delta.knownPoints
+            << " (poprawione: " << corrected << ")"
+            << ", czujniki: " << delta.sensors << " (bez zmian: " << delta.unchangedSensors
+            << ", błędy: " << delta.failedSensors << "), " << ms << " ms\n";
+    }
+    HttpSessionStats session = api.sessionStats();
+    CircuitBreakerStats health = api.connectionHealth();
+    std::cout << "Żądania: " << session.requestsServed << " (304: " << session.notModified
+        << "), odebrano " << session.bytesReceived << " B, odrzucone bez łączenia: " << health.shortCircuited
+        << ", otwarcia bezpiecznika: " << health.trips << "\n";
+    return 0;
+}
+
+/// \brief Polecenie "select": kolejne wybory stacji co gap ms przez potok pobierania (jak w GUI).
+/// Pokazuje, które wyniki dotarły do odbiorcy i po jakim czasie od ostatniego wyboru.
+static int runSelect(int argc, char* argv[]) {
+    std::vector<std::string> ids;
+    std::stringstream list(getOption(argc, argv, "--ids", ""));
+    for (std::string id; std::getline(list, id, ',');)
+        if (!id.empty()) ids.push_back(id);
+    if (ids.empty()) {
+        printUsage();
+        return 1;
+    }
+    ApiClient api(getOption(argc, argv, "--url", "http://api.gios.gov.pl"));
+    MeasurementStore store(getOption(argc, argv, "--store", "dane"));
+    int gap = std::atoi(getOption(argc, argv, "--gap", "50").c_str());
+    typedef std::chrono::steady_clock Clock;
+
+    struct Selected {
+        std::string id;
+        size_t points = 0;
+        bool online = false;
+    };
+    FetchPipeline pipeline;
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    FetchPipeline::Ticket lastTicket = 0, deliveredTicket = 0;
+    double deliveredMs = 0;
+
+    for (const auto& id : ids) {
+        Clock::time_point submitted = Clock::now();
+        FetchPipeline::Ticket ticket = pipeline.submit<Selected>(
+            [&, id](const CancelToken& cancel) {
+                Selected result;
+                result.id = id;
+                DeltaSyncResult delta = api.fetchStationDelta(std::atoi(id.c_str()), store.newestDates(id), &cancel);
+                if (!delta.fresh.empty()) store.append(id, delta.fresh);
+                if (!delta.rechecked.empty()) store.append(id, delta.rechecked);    //zapisuje tylko poprawione wartosci
+                if (delta.cancelled) return result;  //wynik i tak nie zostanie przekazany
+                result.online = delta.online;
+                result.points = store.load(id).size();
+                return result;
+            },
+            [&, submitted](FetchPipeline::Ticket ticket, Selected& result) {
+                double ms = std::chrono::duration<double, std::milli>(Clock::now() - submitted).count();
+                std::cout << std::fixed << std::setprecision(1) << "Stacja " << result.id << ": " << result.points
+                    << " pomiarów" << (result.online ? "" : " (offline)") << " po " << ms << " ms\n";
+                std::lock_guard<std::mutex> lock(doneMutex);
+                deliveredTicket = ticket;
+                deliveredMs = ms;
+                doneCv.notify_all();
+            });
+        {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            lastTicket = ticket;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(gap));
+    }
+
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneCv.wait(lock, [&] { return deliveredTicket == lastTicket; });  //ostatni wybor zawsze jest przekazywany
+    double ms = deliveredMs;
+    lock.unlock();
+    FetchPipelineStats stats = pipeline.stats();
+    std::cout << std::fixed << std::setprecision(1)
+        << "Wybory: " << stats.submitted << ", przekazane: " << stats.delivered << ", anulowane w trakcie: " << stats.cancelled
+        << ", zastąpione przed startem: " << stats.superseded << "; ostatnia stacja po " << ms << " ms od wyboru\n";
+    return 0;
+}
+
+/// \brief Polecenie "serve": serwer odtwarzający działa do naciśnięcia Enter.
+static int runServe(int argc, char* argv[]) {
+    ReplayFixtures fixtures;
+    if (!fixtures.load(getOption(argc, argv, "--stations", "stations.json"), getOption(argc, argv, "--data", "dane.json"),
+        std::atoi(getOption(argc, argv, "--scale", "1").c_str()))) {
+        std::cerr << "Nie można wczytać listy stacji.\n";
+        return 1;
+    }
+    ReplayOptions options;
+    options.latencyMs = std::atoi(getOption(argc, argv, "--latency", "0").c_str());
+    options.slowMs = std::atoi(getOption(argc, argv, "--slow", "10000").c_str());
+    ReplayServer server(fixtures, options);
+    if (server.start(std::atoi(getOption(argc, argv, "--port", "8080").c_str())) < 0) return 1;
+    std::cout << "Serwer odtwarzający: " << server.url() << " (" << fixtures.stationsWithData().size() << " stacji z danymi, "
+        << fixtures.measurementCount() << " pomiarów). Enter kończy.\n";
+    std::cin.get();
+    std::cout << "Obsłużone żądania: " << server.requests() << "\n";
+    return 0;
+}
+
+/// \brief Polecenie "bench": benchmarki głównych ścieżek na serwerze odtwarzającym dla kilku skal danych.
+static int runBench(int argc, char* argv[]) {
+    typedef std::chrono::steady_clock Clock;
+    std::vector<int> scales;
+    std::stringstream list(getOption(argc, argv, "--scales", "1,10,100"));
+    for (std::string item; std::getline(list, item, ',');)
+        if (std::atoi(item.c_str()) > 0) scales.push_back(std::atoi(item.c_str()));
+    int repeat = std::max(1, std::atoi(getOption(argc, argv, "--repeat", "5").c_str()));
+    std::string outFile = getOption(argc, argv, "--out", "bench.json");
+    std::string workDir = "bench_store_" + std::to_string((long long)std::time(nullptr));   //osobny katalog - zapis zawsze "na zimno"
+    ReplayOptions options;
+    options.latencyMs = std::atoi(getOption(argc, argv, "--latency", "0").c_str());
+    int concurrency = std::max(2, std::atoi(getOption(argc, argv, "--concurrency", "4").c_str()));
+
+    nlohmann::json results = nlohmann::json::array();
+    auto measure = [&](const char* name, int scale, const std::function<size_t(int)>& run) { //run(powtorzenie) zwraca liczbe elementow
+        std::vector<double> ms;
+        size_t items = 0;
+        for (int i = 0; i < repeat; ++i) {
+            auto start = Clock::now();
+            items = run(i);
+            ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        }
+        std::sort(ms.begin(), ms.end());
+        double mean = 0;
+        for (double v : ms) mean += v;
+        mean /= ms.size();
+        results.push_back({ { "name", name }, { "scale", scale }, { "items", items }, { "runs", repeat },
+            { "min_ms", ms.front() }, { "mean_ms", mean }, { "p50_ms", ms[ms.size() / 2] }, { "max_ms", ms.back() } });
+        std::cout << std::fixed << std::setprecision(2) << "  " << std::left << std::setw(16) << name << std::right
+            << " x" << scale << ": " << items << " el., min " << ms.front() << " ms, mediana " << ms[ms.size() / 2] << " ms\n";
+    };
+
+    for (int scale : scales) {
+        ReplayFixtures fixtures;
+        if (!fixtures.load(getOption(argc, argv, "--stations", "stations.json"), getOption(argc, argv, "--data", "dane.json"), scale)) {
+            std::cerr << "Nie można wczytać listy stacji.\n";
+            return 1;
+        }
+        std::vector<int> withData = fixtures.stationsWithData();
+        if (withData.empty()) {
+            std::cerr << "Brak nagranych pomiarów (dane.json).\n";
+            return 1;
+        }
+        int stationId = *std::max_element(withData.begin(), withData.end(), [&](int a, int b) {
+            return fixtures.measurementCount(a) < fixtures.measurementCount(b); //stacja z najwieksza liczba pomiarow
+        });
+        ReplayServer server(fixtures, options);
+        if (server.start() < 0) return 1;
+        std::cout << "Skala x" << scale << " (stacja " << stationId << ", " << fixtures.measurementCount(stationId) << " pomiarów):\n";
+
+        measure("stations", scale, [&](int) {
+            ApiClient api(server.url());
+            return api.getAllStations().size();
+        });
+        std::vector<Measurement> loaded;
+        measure("station_load", scale, [&](int) {
+            ApiClient api(server.url()); //nowy klient - bez zapamietanych ETagow, pelne pobranie
+            loaded = api.fetchStationDelta(stationId, std::map<std::string, std::string>()).fresh;
+            return loaded.size();
+        });
+        if (loaded.empty()) { //bez HTTP (np. zablokowany port) - pozostale etapy na danych wprost z nagran
+            std::cerr << "Wczytanie stacji przez HTTP nie powiodło się - dalsze pomiary na danych z nagrań.\n";
+            std::string body;
+            fixtures.sensorsJson(stationId, body);
+            std::vector<int> sensorIds;
+            parseSensorIdsJson(body, sensorIds);
+            for (int sensorId : sensorIds)
+                if (fixtures.dataJson(sensorId, body)) parseSensorDataJson(body, loaded);
+        }
+        double sequentialMs = 0;
+        for (int limit : { 1, concurrency }) { //czujniki stacji po kolei i rownolegle (roznica rosnie z --latency)
+            measure(limit == 1 ? "sensors_seq" : "sensors_parallel", scale, [&](int) {
+                ApiClient api(server.url());
+                api.setMaxConcurrency(limit);
+                return api.getMeasurementsForStation(stationId).size();
+            });
+            double ms = results.back()["p50_ms"].get<double>();
+            if (limit == 1) sequentialMs = ms;
+            else std::cout << "  przyspieszenie przy --concurrency " << concurrency << ": x" << std::setprecision(2) << sequentialMs / ms << "\n";
+        }
+        MeasurementStore store(workDir);
+        std::string key = "bench" + std::to_string(scale) + "_";
+        measure("save", scale, [&](int i) { return store.append(key + std::to_string(i), loaded); });
+        measure("offline_load", scale, [&](int i) { return store.load(key + std::to_string(i)).size(); });
+        SeriesSet series;
+        measure("filter", scale, [&](int) {
+            series = SeriesSet::fromMeasurements(loaded);
+            size_t points = 0;
+            for (const auto& name : series.metricNames()) points += series.range(name, parseRangeBound("", false), parseRangeBound("", true)).size();
+            return points;
+        });
+        measure("statistics", scale, [&](int) {
+            size_t metrics = 0;
+            for (const auto& name : series.metricNames()) {
+                SeriesView view = series.range(name, parseRangeBound("", false), parseRangeBound("", true));
+                computeStatistics(view, defaultLimits(name));
+                computeWindows(view);
+                ++metrics;
+            }
+            return metrics;
+        });
+        server.stop();
+    }
+
+    nlohmann::json report = { { "tool", "AirQualityCli bench" }, { "unix_time", (long long)std::time(nullptr) },
+        { "latency_ms", options.latencyMs }, { "repeat", repeat }, { "results", results } };
+    std::ofstream out(outFile);
+    if (!out) {
+        std::cerr << "Nie można zapisać wyników do pliku: " << outFile << "\n";
+        return 1;
+    }
+    out << report.dump(2) << "\n";
+    std::cout << "Wyniki zapisane do " << outFile << " (dane testowe w katalogu " << workDir << ")\n";
+    return 0;
+}
+
+/// \brief Polecenie "startup": czas do pierwszej użytecznej listy stacji przy starcie GUI.
+static int runStartup(int argc, char* argv[]) {
+    std::string url = getOption(argc, argv, "--url", "http://api.gios.gov.pl");
+    std::string stationsFile = getOption(argc, argv, "--stations", "stations.json");
+    typedef std::chrono::steady_clock Clock;
+    auto ms = [](Clock::time_point a, Clock::time_point b) { return std::chrono::duration<double, std::milli>(b - a).count(); };
+
+    ApiClient api(url);
+    auto start = Clock::now();
+    std::vector<Station> local = api.loadStationsFromFile(stationsFile);    //start cieply - lista z pliku
+    auto localReady = Clock::now();
+    std::vector<Station> fresh = api.getAllStations();                      //odswiezenie (w GUI w tle)
+    auto apiReady = Clock::now();
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Start ciepły: " << local.size() << " stacji z " << stationsFile << " po " << ms(start, localReady) << " ms\n";
+    if (fresh.empty()) {
+        std::cout << "API niedostępne (" << ms(localReady, apiReady) << " ms) - zostaje lista lokalna\n";
+        return local.empty() ? 1 : 0;
+    }
+    StationDiff diff = diffStations(local, fresh);
+    std::cout << "Odświeżenie z API po " << ms(localReady, apiReady) << " ms: dodane " << diff.added.size()
+        << ", usunięte " << diff.removed.size() << ", zmienione " << diff.renamed.size() << "\n";
+
+    ApiClient coldApi(url); //start zimny - nowe polaczenie, brak pliku
+    auto coldStart = Clock::now();
+    std::vector<Station> cold = coldApi.getAllStations();
+    std::cout << "Start zimny:  " << cold.size() << " stacji z API po " << ms(coldStart, Clock::now()) << " ms\n";
+    return 0;
+}
+
+/// \brief Polecenie "migrate": import starego pliku dane.json do bazy segmentów.
+static int runMigrate(int argc, char* argv[]) {
+    MeasurementStore store(getOption(argc, argv, "--store", "dane"));
+    std::string inFile = getOption(argc, argv, "--in", "dane.json");
+    size_t imported = store.migrateFromJson(inFile);
+    std::cout << "Zaimportowano pomiarów: " << imported << "\n";
+    return 0;
+}
+
+/// \brief Parametry powtarzalnych serii syntetycznych (makeSyntheticSeries): godzinowe błądzenie losowe
+/// każdego miernika wracające do jego poziomu, od 2024-01-01.
+struct SyntheticOptions {
+    std::vector<std::string> metrics;   ///< Nazwy mierników
+    std::vector<double> levels;         ///< Poziom, do którego wraca seria miernika (kolejność jak metrics)
+    int64_t hours = 0;                  ///< Długość serii w godzinach
+    double gapRate = 0.0;               ///< Prawdopodobieństwo początku przerwy w danej godzinie
+    int gapHours = 1;                   ///< Najdłuższa przerwa (długość losowana z 1..gapHours)
+    unsigned seed = 1;                  ///< Ziarno - te same parametry dają te same serie
+    double step = 2.5;                  ///< Największa zmiana poziomu w godzinie (szum równomierny +-step)
+    double reversion = 0.02;            ///< Część odchylenia od poziomu znikająca w ciągu godziny
+    double minimum = 0.0;               ///< Dolne ograniczenie poziomu
+    double spikeRate = 0.0;             ///< Prawdopodobieństwo pojedynczego piku (wartość razy spikeFactor)
+    double spikeFactor = 5.0;
+    bool rounded = true;                ///< Jedno miejsce po przecinku jak w GIOŚ
+};
+
+/// Pierwsza godzina serii syntetycznych.
+static int64_t syntheticStart() {
+    return parseRangeBound("2024-01-01", false);
+}
+
+/// Liczba z [0, 1) wprost z wyniku mt19937, więc ten sam ciąg w każdej bibliotece standardowej
+/// (algorytmy rozkładów std:: zależą od implementacji, a od serii zależy wzorzec wykresu).
+static double unitRandom(std::mt19937& rng) {
+    return rng() / 4294967296.0;
+}
+
+/// \brief Serie syntetyczne: wartość każdej godziny każdego miernika, NaN dla brakującej godziny.
+static std::vector<std::vector<double>> makeSyntheticSeries(const SyntheticOptions& options) {
+    std::mt19937 rng(options.seed);
+    std::vector<std::vector<double>> series(options.metrics.size());
+    for (size_t k = 0; k < series.size(); ++k) {
+        std::vector<double>& values = series[k];
+        values.assign((size_t)options.hours, std::numeric_limits<double>::quiet_NaN());
+        const double target = options.levels[k];
+        double level = target;
+        for (int64_t h = 0; h < options.hours; ++h) {
+            if (unitRandom(rng) < options.gapRate) { //przerwa 1..gapHours godzin
+                h += (int64_t)(rng() % (unsigned)std::max(1, options.gapHours));
+                continue;
+            }
+            level = std::max(options.minimum, level + options.step * (2.0 * unitRandom(rng) - 1.0) + options.reversion * (target - level));
+            double value = options.rounded ? std::round(level * 10.0) / 10.0 : level;
+            if (options.spikeRate > 0.0 && unitRandom(rng) < options.spikeRate) value *= options.spikeFactor; //bledny odczyt czujnika
+            values[h] = value;
+        }
+    }
+    return series;
+}
+
+/// Pomiary serii syntetycznych w formacie API (bez brakujących godzin); newestFirst - kolejność jak w odpowiedzi GIOŚ.
+static std::vector<Measurement> syntheticMeasurements(const SyntheticOptions& options, const std::vector<std::vector<double>>& series,
+    bool newestFirst) {
+    std::vector<Measurement> out;
+    const int64_t first = syntheticStart();
+    char date[24];
+    for (size_t k = 0; k < series.size(); ++k)
+        for (int64_t i = 0; i < options.hours; ++i) {
+            const int64_t h = newestFirst ? options.hours - 1 - i : i;
+            if (std::isnan(series[k][h])) continue;
+            formatTimestamp(first + h * 3600, date);
+            Measurement m;
+            m.name = options.metrics[k];
+            m.date = date;
+            m.value = series[k][h];
+            out.push_back(m);
+        }
+    return out;
+}
+
+/// Serie syntetyczne jako SeriesSet bez brakujących godzin (indeks czasowy buduje wywołujący).
+static SeriesSet syntheticSeriesSet(const SyntheticOptions& options, const std::vector<std::vector<double>>& series, bool newestFirst) {
+    SeriesSet set;
+    const int64_t first = syntheticStart();
+    for (size_t k = 0; k < series.size(); ++k) {
+        const uint16_t metric = MetricRegistry::intern(options.metrics[k]);
+        for (int64_t i = 0; i < options.hours; ++i) {
+            const int64_t h = newestFirst ? options.hours - 1 - i : i;
+            if (std::isnan(series[k][h])) continue;
+            CompactMeasurement m;
+            m.timestamp = first + h * 3600;
+            m.metric = metric;
+            m.value = series[k][h];
+            set.add(m);
+        }
+    }
+    return set;
+}
+
+/// \brief Syntetyczna historia w formacie pomiarów API: stacje 1..stationCount, days dni pomiarów godzinowych
+/// PM10, PM2.5 i NO2 od 2024-01-01 (wartości z jednym miejscem po przecinku jak w GIOŚ, średnio co 200. godzina brakuje).
+static std::map<int, std::vector<Measurement>> makeSyntheticHistory(int stationCount, int days) {
+    SyntheticOptions options;
+    options.metrics = { "PM10", "PM2.5", "NO2" };
+    options.levels = { 20.0, 25.0, 30.0 };
+    options.hours = (int64_t)days * 24;
+    options.gapRate = 0.005;
+    options.minimum = 0.5;
+    std::map<int, std::vector<Measurement>> all;
+    for (int s = 0; s < stationCount; ++s) {
+        options.seed = 11 + s; //powtarzalne dane, inne dla kazdej stacji
+        all[s + 1] = syntheticMeasurements(options, makeSyntheticSeries(options), false);
+    }
+    return all;
+}
+
+/// \brief Polecenie "cache": konwersja dane.json do binarnej pamięci podręcznej
+/// lub (--bench) porównanie czasu wczytania jednej stacji z pamięci podręcznej, dane.json i lokalnej bazy.
+static int runCache(int argc, char* argv[]) {
+    if (!hasFlag(argc, argv, "--bench")) {
+        std::string inFile = getOption(argc, argv, "--in", "dane.json");
+        std::string outFile = getOption(argc, argv, "--out", "dane.aqc");
+        int count = BinaryCache::convertFromJson(inFile, outFile);
+        if (count < 0) {
+            std::cerr << "Nie udało się utworzyć pliku " << outFile << "\n";
+            return 1;
+        }
+        std::cout << "Zapisano stacji: " << count << "\n";
+        return 0;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    int stationCount = std::max(1, std::atoi(getOption(argc, argv, "--stations", "20").c_str()));
+    int days = std::max(1, std::atoi(getOption(argc, argv, "--days", "365").c_str()));
+    std::map<int, std::vector<Measurement>> all = makeSyntheticHistory(stationCount, days);
+    const std::string jsonFile = "cache_bench.json", cacheFile = "cache_bench.aqc", storeDir = "cache_bench_store";
+    ApiClient files;
+    files.saveAllMeasurementsToFile(all, jsonFile);
+    int converted = BinaryCache::convertFromJson(jsonFile, cacheFile);
+    size_t points = 0;
+    {
+        MeasurementStore store(storeDir);
+        for (const auto& kv : all) {
+            store.append(std::to_string(kv.first), kv.second);
+            points += kv.second.size();
+        }
+    }
+    if (converted != stationCount) {
+        std::cerr << "Nie udało się utworzyć pliku " << cacheFile << "\n";
+        return 1;
+    }
+
+    //kazda stacja wczytywana raz, jak przy wyborze stacji w trybie offline
+    auto start = Clock::now();
+    size_t jsonPoints = 0;
+    for (const auto& kv : all) jsonPoints += files.loadMeasurementsFromFile(std::to_string(kv.first), jsonFile).size();
+    double jsonMs = elapsedMs(start) / stationCount;
+    start = Clock::now();
+    size_t storePoints = 0;
+    {
+        MeasurementStore store(storeDir);
+        for (const auto& kv : all) storePoints += store.load(std::to_string(kv.first)).size();
+    }
+    double storeMs = elapsedMs(start) / stationCount;
+    start = Clock::now();
+    size_t cachePoints = 0;
+    bool same = true;
+    for (const auto& kv : all) { //otwarcie (mapowanie) przy kazdym wyborze stacji
+        BinaryCache cache;
+        if (!cache.open(cacheFile)) { same = false; break; }
+        std::vector<Measurement> loaded = cache.load(kv.first);
+        cachePoints += loaded.size();
+        same = same && loaded.size() == kv.second.size();
+    }
+    double cacheMs = elapsedMs(start) / stationCount;
+    BinaryCache cache;
+    cache.open(cacheFile);
+    start = Clock::now();
+    double checksum = 0.0;
+    for (const auto& kv : all) { //same kolumny bez zamiany na Measurement
+        BinaryCache::StationColumns columns;
+        if (cache.find(kv.first, columns))
+            for (size_t i = 0; i < columns.count; ++i) checksum += columns.values[i];
+    }
+    double columnsMs = elapsedMs(start) / stationCount;
+    std::vector<Measurement> sample = cache.load(1);
+    for (size_t i = 0; same && i < sample.size(); ++i)
+        same = sample[i].name == all[1][i].name && sample[i].date == all[1][i].date && sample[i].value == all[1][i].value;
+    cache.close();
+
+    std::cout << std::fixed << std::setprecision(3) << "Dane: " << stationCount << " stacji x " << days << " dni x 3 mierniki = " << points
+        << " pomiarów\nWczytanie jednej stacji (średnio):\n"
+        << "  dane.json (loadMeasurementsFromFile): " << jsonMs << " ms (" << jsonPoints << " pomiarów)\n"
+        << "  lokalna baza (MeasurementStore::load): " << storeMs << " ms (" << storePoints << ")\n"
+        << "  pamięć podręczna (open + load):        " << cacheMs << " ms (" << cachePoints << "), x" << std::setprecision(1)
+        << jsonMs / cacheMs << " względem dane.json\n"
+        << "  same kolumny (find):                   " << std::setprecision(4) << columnsMs << " ms\n"
+        << "Zgodność z danymi źródłowymi: " << (same ? "tak" : "NIE") << "\n";
+    std::remove(jsonFile.c_str());
+    std::remove(cacheFile.c_str());
+    for (const auto& kv : all) std::remove((storeDir + "/" + std::to_string(kv.first) + ".jsonl").c_str());
+    return same ? 0 : 1;
+}
+
+/// \brief Wzorcowe statystyki liczone wprost (suma po kolei, pełne sortowanie dla percentyli) do sprawdzania computeStatistics.
+static SeriesStatistics naiveStatistics(const SeriesView& series, const std::vector<double>& limits) {
+    SeriesStatistics s;
+    s.limits = limits;
+    s.exceedances.assign(limits.size(), 0);
+    s.count = series.size();
+    if (s.count == 0) return s;
+    const size_t n = series.size();
+    const int64_t t0 = series.timestamps[0];
+    s.firstTimestamp = t0;
+    s.lastTimestamp = series.timestamps[n - 1];
+    size_t minIdx = 0, maxIdx = 0;
+    long double sum = 0.0L, sumDx = 0.0L;
+    for (size_t i = 0; i < n; ++i) {
+        sum += series.values[i];
+        sumDx += (long double)(series.timestamps[i] - t0);
+        if (series.values[i] < series.values[minIdx]) minIdx = i;
+        if (series.values[i] > series.values[maxIdx]) maxIdx = i;
+        for (size_t k = 0; k < limits.size(); ++k)
+            if (series.values[i] > limits[k]) ++s.exceedances[k];
+    }
+    s.mean = (double)(sum / n);
+    s.min = series.values[minIdx];
+    s.max = series.values[maxIdx];
+    s.minTimestamp = series.timestamps[minIdx];
+    s.maxTimestamp = series.timestamps[maxIdx];
+    const long double meanDx = sumDx / n;
+    long double sumSqDev = 0.0L, sumDxDv = 0.0L, sumSqDx = 0.0L;
+    for (size_t i = 0; i < n; ++i) {
+        long double dv = series.values[i] - (long double)s.mean;
+        long double dx = (long double)(series.timestamps[i] - t0) - meanDx;
+        sumSqDev += dv * dv;
+        sumDxDv += dx * dv;
+        sumSqDx += dx * dx;
+    }
+    s.variance = (double)(sumSqDev / n);
+    s.stddev = std::sqrt(s.variance);
+    if (sumSqDx > 0) s.trendPerHour = (double)(sumDxDv / sumSqDx * 3600.0L);
+    std::vector<double> sorted(series.values, series.values + n);
+    std::sort(sorted.begin(), sorted.end());
+    double* out[3] = { &s.p50, &s.p95, &s.p98 };
+    const double q[3] = { 0.50, 0.95, 0.98 };
+    for (int j = 0; j < 3; ++j) {
+        double pos = q[j] * (n - 1);
+        size_t k = (size_t)pos;
+        double frac = pos - k;
+        *out[j] = sorted[k] + frac * ((k + 1 < n ? sorted[k + 1] : sorted[k]) - sorted[k]);
+    }
+    return s;
+}
+
+/// \brief Opis pierwszej różnicy między statystykami (pusty, gdy zgodne; sumy z tolerancją względną).
+static std::string statisticsDifference(const SeriesStatistics& a, const SeriesStatistics& b) {
+    auto close = [](double x, double y, double scale) { return std::fabs(x - y) <= 1e-9 * std::max(1.0, scale); };
+    const double range = std::max(std::fabs(b.min), std::fabs(b.max));
+    if (a.count != b.count) return "count";
+    if (a.min != b.min || a.minTimestamp != b.minTimestamp) return "min";
+    if (a.max != b.max || a.maxTimestamp != b.maxTimestamp) return "max";
+    if (a.exceedances != b.exceedances) return "przekroczenia";
+    if (a.p50 != b.p50) return "p50";
+    if (a.p95 != b.p95) return "p95";
+    if (a.p98 != b.p98) return "p98";
+    if (!close(a.mean, b.mean, range)) return "średnia";
+    if (!close(a.variance, b.variance, range * range)) return "wariancja";
+    if (!close(a.trendPerHour, b.trendPerHour, std::fabs(b.trendPerHour) + range / std::max<double>(1.0, (double)b.count))) return "trend";
+    return "";
+}
+
+/// \brief Tryb "stats --synthetic N": zgodność AVX2, wersji skalarnej i wzorca na losowych seriach
+/// nieparzystej długości (także n < 4) oraz czas analizy serii N punktów.
+static int runStatsSynthetic(int argc, char* argv[]) {
+    typedef std::chrono::steady_clock Clock;
+    auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    const size_t points = (size_t)std::max(1, std::atoi(getOption(argc, argv, "--synthetic", "0").c_str()));
+    const int repeat = std::max(1, std::atoi(getOption(argc, argv, "--repeat", "5").c_str()));
+    const bool avx2 = statisticsUseAvx2();
+    const std::vector<double> limits = { 25.0, 50.0, 200.0 };
+    std::mt19937 rng(2024); //powtarzalne dane
+    auto makeSeries = [&rng](size_t n, bool rounded, std::vector<int64_t>& ts, std::vector<double>& vals) {
+        std::uniform_real_distribution<double> value(0.0, 300.0);
+        ts.resize(n);
+        vals.resize(n);
+        int64_t t = syntheticStart();
+        for (size_t i = 0; i < n; ++i) {
+            t += 3600 * (1 + (rng() % 50 == 0 ? rng() % 24 : 0)); //godziny z przerwami
+            ts[i] = t;
+            vals[i] = rounded ? std::round(value(rng) * 10.0) / 10.0 : value(rng); //zaokraglone jak w GIOŚ - powtorzenia wartosci
+        }
+    };
+
+    //zgodnosc: wszystkie dlugosci 1..67 (ogony petli AVX2 i n < 4) i losowe nieparzyste do 20001
+    std::vector<size_t> lengths;
+    for (size_t n = 1; n <= 67; ++n) lengths.push_back(n);
+    for (int i = 0; i < 200; ++i) lengths.push_back(69 + 2 * (rng() % 9967));
+    size_t checked = 0, failed = 0;
+    std::vector<int64_t> ts;
+    std::vector<double> vals;
+    for (size_t i = 0; i < lengths.size(); ++i) {
+        makeSeries(lengths[i], i % 2 == 0, ts, vals);
+        SeriesView view;
+        view.timestamps = ts.data();
+        view.values = vals.data();
+        view.count = ts.size();
+        SeriesStatistics reference = naiveStatistics(view, limits);
+        setStatisticsScalarOnly(true);
+        std::string scalarDiff = statisticsDifference(computeStatistics(view, limits), reference);
+        setStatisticsScalarOnly(false);
+        std::string avxDiff = avx2 ? statisticsDifference(computeStatistics(view, limits), reference) : "";
+        ++checked;
+        if (scalarDiff.empty() && avxDiff.empty()) continue;
+        if (++failed <= 5)
+            std::cerr << "n = " << view.count << ": " << (scalarDiff.empty() ? "AVX2 " + avxDiff : "skalarna " + scalarDiff) << " różni się od wzorca\n";
+    }
+    std::cout << "Zgodność ze wzorcem (" << (avx2 ? "AVX2 i skalarna" : "skalarna, AVX2 niedostępne") << "): " << checked - failed
+        << "/" << checked << " serii, długości 1.." << *std::max_element(lengths.begin(), lengths.end()) << "\n";
+
+    //czas analizy jednej duzej serii (najlepszy z repeat)
+    makeSeries(points, true, ts, vals);
+    SeriesView view;
+    view.timestamps = ts.data();
+    view.values = vals.data();
+    view.count = ts.size();
+    auto best = [&](std::function<void()> run) {
+        double ms = 1e300;
+        for (int r = 0; r < repeat; ++r) {
+            auto start = Clock::now();
+            run();
+            ms = std::min(ms, elapsedMs(start));
+        }
+        return ms;
+    };
+    double sink = 0.0;
+    setStatisticsScalarOnly(true);
+    double scalarMs = best([&] { sink += computeStatistics(view, limits).p98; });
+    setStatisticsScalarOnly(false);
+    double avxMs = avx2 ? best([&] { sink += computeStatistics(view, limits).p98; }) : 0.0;
+    double naiveMs = best([&] { sink += naiveStatistics(view, limits).p98; });
+    std::cout << std::fixed << std::setprecision(2) << "Seria " << points << " punktów (najlepszy z " << repeat << "):\n"
+        << "  wzorzec (pełne sortowanie): " << naiveMs << " ms\n"
+        << "  skalarna:                   " << scalarMs << " ms (x" << std::setprecision(1) << naiveMs / scalarMs << ")\n";
+    if (avx2) std::cout << std::setprecision(2) << "  AVX2:                       " << avxMs << " ms (x" << std::setprecision(1) << naiveMs / avxMs << ")\n";
+    if (sink < 0) std::cout << sink; //wynik uzyty - petla nie zostanie usunieta
+    return failed == 0 ? 0 : 1;
+}
+
+/// \brief Polecenie "stats": statystyki pomiarów stacji z lokalnej bazy (--synthetic N: sprawdzenie i czas jąder na danych syntetycznych).
+static int runStats(int argc, char* argv[]) {
+    if (!getOption(argc, argv, "--synthetic", "").empty()) return runStatsSynthetic(argc, argv);
+    std::string stationId = getOption(argc, argv, "--station", "");
+    if (stationId.empty()) {
+        printUsage();
+        return 1;
+    }
+    MeasurementStore store(getOption(argc, argv, "--store", "dane"));
+    SeriesSet series = SeriesSet::fromMeasurements(store.load(stationId));
+    int64_t start, end;
+    if (!getRangeOptions(argc, argv, start, end)) return 1;
+
+    std::string metric = getOption(argc, argv, "--metric", "");
+    std::vector<std::string> metrics = metric.empty() ? series.metricNames() : std::vector<std::string>{ metric };
+    if (metrics.empty()) {
+        std::cerr << "Brak pomiarów stacji " << stationId << "\n";
+        return 1;
+    }
+    for (const auto& name : metrics) { //raport dla kazdego miernika
+        SeriesView view = series.range(name, start, end);
+        if (view.empty()) {
+            std::cout << "Analiza - " << name << "\nBrak danych w zakresie.\n\n";
+            continue;
+        }
+        std::cout << formatStatisticsReport(name, computeStatistics(view, defaultLimits(name)), "\n");
+        std::cout << formatWindowReport(computeWindows(view), defaultDailyLimit(name), "\n") << "\n";
+    }
+    return 0;
+}
+
+/// \brief Tworzy w pamięci syntetyczną bazę: count stacji w 16 województwach, rok pomiarów godzinowych PM10.
+static void makeSyntheticStations(size_t count, std::vector<Station>& stations, std::vector<SeriesSet>& data) {
+    static const char* provinces[] = { "DOLNOŚLĄSKIE", "KUJAWSKO-POMORSKIE", "LUBELSKIE", "LUBUSKIE", "ŁÓDZKIE", "MAŁOPOLSKIE",
+        "MAZOWIECKIE", "OPOLSKIE", "PODKARPACKIE", "PODLASKIE", "POMORSKIE", "ŚLĄSKIE", "ŚWIĘTOKRZYSKIE", "WARMIŃSKO-MAZURSKIE",
+        "WIELKOPOLSKIE", "ZACHODNIOPOMORSKIE" };
+    SyntheticOptions options;
+    options.metrics = { "PM10" };
+    options.hours = 365 * 24;
+    options.step = 14.0;        //niezalezny szum godzinowy wokol poziomu stacji
+    options.reversion = 1.0;
+    options.rounded = false;
+    stations.resize(count);
+    data.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        stations[i].id = (int)i;
+        stations[i].name = "Stacja " + std::to_string(i);
+        stations[i].province = provinces[i % 16];
+        options.levels = { 15.0 + (i % 16) * 1.5 + (i % 7) }; //rozne poziomy zanieczyszczenia
+        options.seed = 12345 + (unsigned)i; //powtarzalne dane
+        std::vector<std::vector<double>> series = makeSyntheticSeries(options);
+        for (int64_t h = 0; h < options.hours; ++h)
+            if ((h % 8760) < 2160 || (h % 8760) > 7200) series[0][h] += 20.0; //sezon grzewczy
+        data[i] = syntheticSeriesSet(options, series, false);
+        data[i].buildIndex();
+    }
+}
+
+/// \brief Polecenie "rollup": zestawienie wszystkich stacji (równolegle, stacja = zadanie puli wątków).
+static int runRollup(int argc, char* argv[]) {
+    typedef std::chrono::steady_clock Clock;
+    RollupQuery query;
+    query.metric = getOption(argc, argv, "--metric", "PM10");
+    query.province = getOption(argc, argv, "--province", "");
+    if (!getRangeOptions(argc, argv, query.start, query.end)) return 1;
+    query.lastHours = std::atoi(getOption(argc, argv, "--last-hours", "0").c_str());
+    query.limit = std::atof(getOption(argc, argv, "--limit", "-1").c_str());
+    query.hourly = hasFlag(argc, argv, "--hourly");
+    size_t top = (size_t)std::max(0, std::atoi(getOption(argc, argv, "--top", "10").c_str()));
+    unsigned threads = (unsigned)std::max(0, std::atoi(getOption(argc, argv, "--threads", "0").c_str()));
+
+    size_t synthetic = (size_t)std::max(0, std::atoi(getOption(argc, argv, "--synthetic", "0").c_str()));
+    if (synthetic > 0) { //benchmark bez dysku: 1 watek i pelna pula
+        std::vector<Station> stations;
+        std::vector<SeriesSet> data;
+        makeSyntheticStations(synthetic, stations, data);
+        RollupSource source = [&data](const Station& station, SeriesSet& series) {
+            series = data[station.id];
+            return true;
+        };
+        RollupResult result;
+        for (unsigned count : { 1u, threads }) {
+            auto start = Clock::now();
+            result = computeRollups(stations, source, query, count);
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            std::cout << "Wątki " << (count ? std::to_string(count) : "auto") << ": " << std::fixed << std::setprecision(1) << ms
+                << " ms, " << result.points << " pomiarów (" << std::setprecision(0) << result.points / ms / 1000.0 << " mln/s)\n";
+        }
+        std::cout << "\n" << formatRollupReport(result, query, top, "\n");
+        return 0;
+    }
+
+    MeasurementStore store(getOption(argc, argv, "--store", "dane"));
+    std::map<int, Station> known; //nazwy i wojewodztwa z listy stacji (jesli jest)
+    ApiClient files;
+    for (const auto& s : files.loadStationsFromFile(getOption(argc, argv, "--stations", "stations.json"))) known[s.id] = s;
+    std::vector<Station> stations;
+    for (const auto& id : store.stationIds()) {
+        Station s;
+        s.id = std::atoi(id.c_str());
+        auto it = known.find(s.id);
+        if (it != known.end()) s = it->second;
+        else s.name = id;
+        stations.push_back(s);
+    }
+    if (stations.empty()) {
+        std::cerr << "Brak stacji w lokalnej bazie.\n";
+        return 1;
+    }
+    RollupSource source = [&store](const Station& station, SeriesSet& series) {
+        std::vector<Measurement> measurements = store.load(std::to_string(station.id));
+        if (measurements.empty()) return false;
+        series = SeriesSet::fromMeasurements(measurements);
+        return true;
+    };
+    auto start = Clock::now();
+    RollupResult result = computeRollups(stations, source, query, threads);
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::cout << formatRollupReport(result, query, top, "\n");
+    std::cout << "\nCzas: " << std::fixed << std::setprecision(1) << ms << " ms\n";
+    return 0;
+}
+
+/// \brief Polecenie "search": wyszukiwanie stacji i benchmark indeksu (zapytanie po każdej wpisanej literze).
+static int runSearch(int argc, char* argv[]) {
+    typedef std::chrono::steady_clock Clock;
+    ApiClient files;
+    std::vector<Station> stations = files.loadStationsFromFile(getOption(argc, argv, "--stations", "stations.json"));
+    if (stations.empty()) {
+        std::cerr << "Nie można wczytać listy stacji.\n";
+        return 1;
+    }
+    StationIndex index;
+    std::string query = getOption(argc, argv, "--query", "");
+    if (!query.empty()) {
+        index.build(stations);
+        size_t top = (size_t)std::max(1, std::atoi(getOption(argc, argv, "--top", "20").c_str()));
+        std::vector<size_t> found = index.search(query);
+        for (size_t i = 0; i < found.size() && i < top; ++i)
+            std::cout << stations[found[i]].id << "\t" << stations[found[i]].name << " (" << stations[found[i]].province << ")\n";
+        std::cout << "Znaleziono: " << found.size() << "\n";
+        return 0;
+    }
+
+    const char* typed[] = { "Warszawa", "Kraków, ul.", "lodz", "ŚLĄSKIE", "zywiec", "Al. Krasińskiego", "mazowieckie warsz", "ul" };
+    index.build(stations); //zgodnosc z pelnym przegladem dla kazdego prefiksu
+    size_t mismatches = 0, checked = 0;
+    for (const char* q : typed) {
+        std::string text(q);
+        for (size_t len = 1; len <= text.size(); ++len) {
+            std::string prefix = text.substr(0, len);
+            std::vector<size_t> found = index.search(prefix);
+            std::sort(found.begin(), found.end());
+            std::vector<size_t> expected;
+            for (size_t i = 0; i < stations.size(); ++i)
+                if (stationMatches(stations[i], prefix)) expected.push_back(i);
+            if (found != expected) ++mismatches;
+            ++checked;
+        }
+    }
+    std::cout << "Zgodność z pełnym przeglądem (" << stations.size() << " stacji): " << checked - mismatches << "/" << checked << " zapytań\n";
+
+    int scale = std::max(1, std::atoi(getOption(argc, argv, "--scale", "100").c_str()));
+    std::vector<Station> scaled;
+    for (int copy = 0; copy < scale; ++copy)
+        for (Station s : stations) {
+            s.id += copy * 1000000;
+            scaled.push_back(s);
+        }
+    auto start = Clock::now();
+    index.build(scaled);
+    double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::cout << "Indeks: " << index.size() << " stacji, budowa " << std::fixed << std::setprecision(1) << buildMs << " ms, "
+        << index.memoryBytes() / 1024 << " KB\n";
+
+    double totalUs = 0.0, worstUs = 0.0;
+    size_t queries = 0;
+    for (const char* q : typed) {
+        std::string text(q);
+        for (size_t len = 1; len <= text.size(); ++len) { //kolejne litery jak przy wpisywaniu
+            auto t0 = Clock::now();
+            size_t count = index.search(text.substr(0, len)).size();
+            double us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+            totalUs += us;
+            worstUs = std::max(worstUs, us);
+            ++queries;
+            if (len == text.size()) std::cout << "  \"" << text << "\": " << count << " wyników, " << std::setprecision(0) << us << " µs\n";
+        }
+    }
+    std::cout << "Zapytania: " << queries << ", średnio " << std::setprecision(1) << totalUs / queries << " µs, najdłużej " << worstUs << " µs\n";
+    return mismatches ? 1 : 0;
+}
+
+/// \brief Polecenie "alerts": alerty dla lokalnej bazy lub benchmark silnika na danych syntetycznych.
+static int runAlerts(int argc, char* argv[]) {
+    typedef std::chrono::steady_clock Clock;
+    size_t top = (size_t)std::max(0, std::atoi(getOption(argc, argv, "--top", "20").c_str()));
+    int synthetic = std::atoi(getOption(argc, argv, "--synthetic", "0").c_str());
+    if (synthetic <= 0) {
+        MeasurementStore store(getOption(argc, argv, "--store", "dane"));
+        AlertEngine engine(1 << 16);
+        size_t shown = 0;
+        Alert alert;
+        for (const auto& id : store.stationIds()) {
+            engine.ingest(std::atoi(id.c_str()), store.load(id));
+            while (engine.poll(alert))
+                if (shown++ < top) std::cout << formatAlert(alert) << "\n";
+        }
+        AlertEngineStats stats = engine.stats();
+        std::cout << "Pomiary: " << stats.points << " (pominięte: " << stats.skipped << "), alerty: " << stats.alerts << "\n";
+        return 0;
+    }
+
+    int hours = std::max(1, std::atoi(getOption(argc, argv, "--hours", "720").c_str()));
+    SyntheticOptions options;
+    options.metrics = { "PM10", "PM2.5", "NO2" };
+    options.levels = { 30.0, 18.0, 40.0 };
+    options.hours = hours;
+    options.step = 5.0;
+    options.reversion = 0.1;
+    options.minimum = 1.0;
+    options.rounded = false;
+    options.spikeRate = 0.001;  //rzadkie bledne skoki czujnika
+    options.spikeFactor = 10.0;
+    const uint16_t metrics[] = { MetricRegistry::intern("PM10"), MetricRegistry::intern("PM2.5"), MetricRegistry::intern("NO2") };
+    const int64_t first = syntheticStart();
+    std::vector<std::vector<CompactMeasurement>> data(synthetic); //stacja -> godzina x 3 mierniki
+    for (int s = 0; s < synthetic; ++s) {
+        options.seed = 7 + s; //powtarzalne dane
+        const std::vector<std::vector<double>> series = makeSyntheticSeries(options);
+        for (int h = 0; h < hours; ++h)
+            for (int k = 0; k < 3; ++k) {
+                CompactMeasurement m;
+                m.timestamp = first + (int64_t)h * 3600;
+                m.metric = metrics[k];
+                m.value = series[k][h];
+                data[s].push_back(m);
+            }
+    }
+    size_t total = (size_t)synthetic * hours * 3;
+
+    AlertEngine engine(1 << 14);
+    std::atomic<bool> done(false);
+    std::atomic<size_t> received(0);
+    std::thread consumer([&]() { //odbiorca alertow rownolegle z ocena pomiarow
+        Alert alert;
+        while (!done) {
+            if (engine.poll(alert)) received++;
+            else std::this_thread::yield();
+        }
+        while (engine.poll(alert)) received++;
+    });
+    auto start = Clock::now();
+    for (int h = 0; h < hours; ++h) //kazda godzina: nowe pomiary kazdej stacji (jak synchronizacja przyrostowa)
+        for (int s = 0; s < synthetic; ++s)
+            engine.ingest(s, &data[s][h * 3], 3);
+    double streamed = std::chrono::duration<double>(Clock::now() - start).count();
+    done = true;
+    consumer.join();
+    AlertEngineStats stats = engine.stats();
+    std::cout << std::fixed << std::setprecision(0) << "Strumień (po 3 pomiary na wywołanie): " << total << " pomiarów, "
+        << total / streamed << " pomiarów/s, alerty: " << stats.alerts << " (odebrane " << received << ", odrzucone " << stats.dropped << ")\n";
+
+    AlertEngine batch(1 << 20);
+    start = Clock::now();
+    for (int s = 0; s < synthetic; ++s) batch.ingest(s, data[s].data(), data[s].size()); //cala historia stacji naraz (serie przeplecione)
+    double whole = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "Paczki (historia stacji na wywołanie): " << total / whole << " pomiarów/s, alerty: " << batch.stats().alerts << "\n";
+    return 0;
+}
+
+/// \brief Polecenie "archive": archiwizacja lokalnej bazy lub porównanie archiwum z formatem dane.json.
+static int runArchive(int argc, char* argv[]) {
+    typedef std::chrono::steady_clock Clock;
+    auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    ArchiveOptions options;
+    options.rawDays = std::atoi(getOption(argc, argv, "--raw-days", "90").c_str());
+    if (!hasFlag(argc, argv, "--bench")) {
+        MeasurementStore store(getOption(argc, argv, "--store", "dane"));
+        HistoryArchive archive(getOption(argc, argv, "--out", "archiwum"), options);
+        size_t appended = 0, bytes = 0, raw = 0, daily = 0;
+        std::vector<std::string> ids = store.stationIds();
+        for (const auto& id : ids) {
+            appended += archive.append(id, store.load(id));
+            ArchiveStats stats = archive.stats(id);
+            bytes += stats.bytes;
+            raw += stats.rawPoints;
+            daily += stats.dailyPoints;
+        }
+        std::cout << "Stacje: " << ids.size() << ", dopisane pomiary: " << appended << ", w archiwum: " << raw
+            << " godzinowych i " << daily << " dobowych, " << bytes << " B\n";
+        return 0;
+    }
+
+    int stationCount = std::max(1, std::atoi(getOption(argc, argv, "--stations", "20").c_str()));
+    int days = std::max(1, std::atoi(getOption(argc, argv, "--days", "365").c_str()));
+    std::map<int, std::vector<Measurement>> all = makeSyntheticHistory(stationCount, days);
+    const int64_t first = syntheticStart();
+    size_t points = 0;
+    for (const auto& kv : all) points += kv.second.size();
+
+    std::string jsonFile = "archive_bench.json";
+    ApiClient files;
+    auto start = Clock::now();
+    files.saveAllMeasurementsToFile(all, jsonFile);
+    double jsonWriteMs = elapsedMs(start);
+    std::ifstream sizeProbe(jsonFile, std::ios::binary | std::ios::ate);
+    double jsonBytes = (double)sizeProbe.tellg();
+    sizeProbe.close();
+    start = Clock::now();
+    std::vector<Measurement> loaded = files.loadMeasurementsFromFile("1", jsonFile);
+    SeriesSet jsonSeries = SeriesSet::fromMeasurements(loaded);
+    size_t jsonWeek = jsonSeries.range("PM10", first + (int64_t)(days - 7) * 86400, first + (int64_t)days * 86400).size();
+    double jsonQueryMs = elapsedMs(start);
+    std::remove(jsonFile.c_str());
+
+    std::cout << std::fixed << std::setprecision(2) << "Dane: " << stationCount << " stacji x " << days << " dni x 3 mierniki = " << points << " pomiarów\n";
+    std::cout << "dane.json: " << jsonBytes / points << " B/pomiar (" << (size_t)jsonBytes / 1024 << " KB), zapis " << jsonWriteMs
+        << " ms, tydzień PM10 jednej stacji (wczytanie pliku) " << jsonQueryMs << " ms (" << jsonWeek << " pomiarów)\n";
+
+    for (int rawDays : { 0, options.rawDays }) {
+        ArchiveOptions o = options;
+        o.rawDays = rawDays;
+        std::string dir = "archive_bench_" + std::to_string(rawDays);
+        HistoryArchive archive(dir, o);
+        start = Clock::now();
+        for (const auto& kv : all) archive.append(std::to_string(kv.first), kv.second);
+        double appendMs = elapsedMs(start);
+        size_t bytes = 0, raw = 0, daily = 0, blocks = 0;
+        for (const auto& kv : all) {
+            ArchiveStats st = archive.stats(std::to_string(kv.first));
+            bytes += st.bytes;
+            raw += st.rawPoints;
+            daily += st.dailyPoints;
+            blocks += st.blocks;
+        }
+        std::cout << "Archiwum" << (rawDays > 0 ? " (godzinowe " + std::to_string(rawDays) + " dni, starsze dobowe)" : " (same pomiary godzinowe)")
+            << ": " << (double)bytes / points << " B/pomiar źródłowy (" << bytes / 1024 << " KB, " << raw << " godzinowych, " << daily
+            << " dobowych, " << blocks << " bloków), zapis " << appendMs << " ms\n";
+
+        const int repeat = 20;
+        start = Clock::now();
+        ArchiveRange week;
+        for (int r = 0; r < repeat; ++r) week = archive.query("1", "PM10", first + (int64_t)(days - 7) * 86400, first + (int64_t)days * 86400);
+        double weekMs = elapsedMs(start) / repeat;
+        start = Clock::now();
+        ArchiveRange year;
+        for (int r = 0; r < repeat; ++r) year = archive.query("1", "PM10", first, first + (int64_t)days * 86400);
+        double yearMs = elapsedMs(start) / repeat;
+        std::cout << "  tydzień PM10: " << weekMs << " ms (" << week.timestamps.size() << " pomiarów, bloki " << week.blocksDecoded << " rozpakowane / "
+            << week.blocksSkipped << " pominięte), cały okres: " << yearMs << " ms (" << year.timestamps.size() << " godzinowych + "
+            << year.daily.size() << " dobowych)\n";
+        if (rawDays == 0) { //bez zestawien archiwum musi oddac dokladnie dane wejsciowe
+            SeriesSet input = SeriesSet::fromMeasurements(all[1]);
+            SeriesView source = input.range("PM10", first, first + (int64_t)days * 86400);
+            bool same = source.size() == year.timestamps.size();
+            for (size_t i = 0; same && i < source.size(); ++i)
+                same = source.timestamps[i] == year.timestamps[i] && source.values[i] == year.values[i];
+            std::cout << "  odczyt bez strat: " << (same ? "tak" : "NIE") << "\n";
+        }
+        for (const auto& kv : all) std::remove((dir + "/" + std::to_string(kv.first) + ".aqh").c_str());
+    }
+    return 0;
+}
+
+/// \brief Polecenie "export": strumieniowy eksport lokalnej bazy do CSV lub pliku kolumnowego.
+static int runExport(int argc, char* argv[]) {
+    typedef std::chrono::steady_clock Clock;
+    auto seconds = [](Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); };
+    ExportFilter filter;
+    std::stringstream idList(getOption(argc, argv, "--station", ""));
+    for (std::string id; std::getline(idList, id, ',');)
+        if (!id.empty()) filter.stationIds.push_back(std::atoi(id.c_str()));
+    std::stringstream metricList(getOption(argc, argv, "--metric", ""));
+    for (std::string metric; std::getline(metricList, metric, ',');)
+        if (!metric.empty()) filter.metrics.push_back(metric);
+    filter.province = getOption(argc, argv, "--province", "");
+    if (!getRangeOptions(argc, argv, filter.start, filter.end)) return 1;
+
+    int synthetic = std::max(0, std::atoi(getOption(argc, argv, "--synthetic", "0").c_str()));
+    if (synthetic == 0) {
+        std::string format = getOption(argc, argv, "--format", "csv");
+        if (format != "csv" && format != "columnar") {
+            printUsage();
+            return 1;
+        }
+        std::string outFile = getOption(argc, argv, "--out", format == "csv" ? "eksport.csv" : "eksport.aqc");
+        MeasurementStore store(getOption(argc, argv, "--store", "dane"));
+        std::vector<Station> stations;
+        if (!filter.province.empty()) {
+            ApiClient files;
+            stations = files.loadStationsFromFile(getOption(argc, argv, "--stations", "stations.json"));
+        }
+        std::vector<int> ids = selectExportStations(store.stationIds(), stations, filter);
+        StoreExporter exporter(store, filter);
+        auto start = Clock::now();
+        bool ok = format == "csv" ? exporter.writeCsv(ids, outFile) : exporter.writeColumnar(ids, outFile);
+        double elapsed = seconds(start);
+        if (!ok) return 1;
+        const ExportStats& st = exporter.stats();
+        std::cout << "Stacje: " << st.stations << ", wpisy: " << st.linesRead << ", zapisane pomiary: " << st.rowsWritten
+            << " -> " << outFile << " (" << st.bytesWritten << " B, " << std::fixed << std::setprecision(1) << elapsed * 1000.0 << " ms)\n";
+        return 0;
+    }
+
+    //syntetyczna baza: rok pomiarow godzinowych 6 miernikow, ostatnia doba zapisana dwa razy (poprawione wartosci)
+    int days = std::max(1, std::atoi(getOption(argc, argv, "--days", "365").c_str()));
+    std::string directory = getOption(argc, argv, "--store", "eksport_test");
+    SyntheticOptions options;
+    options.metrics = { "PM10", "PM2.5", "NO2", "SO2", "O3", "C6H6" };
+    options.levels = { 15.0, 20.0, 25.0, 30.0, 35.0, 40.0 };
+    options.hours = (int64_t)days * 24;
+    options.step = 3.5;
+    options.minimum = 0.1;
+    const std::string lastDay = formatTimestamp(syntheticStart() + (int64_t)(days - 1) * 86400);
+    auto start = Clock::now();
+    {
+        MeasurementStore store(directory);
+        for (int s = 1; s <= synthetic; ++s) {
+            options.seed = 5 + s; //powtarzalne dane
+            std::vector<Measurement> measurements = syntheticMeasurements(options, makeSyntheticSeries(options), true); //jak API: od najnowszych
+            std::vector<Measurement> corrected;
+            for (const auto& m : measurements)
+                if (m.date >= lastDay) {
+                    corrected.push_back(m);
+                    corrected.back().value += 0.1;
+                }
+            store.append(std::to_string(s), measurements);
+            store.append(std::to_string(s), corrected);
+        }
+    }
+    std::cout << "Baza syntetyczna: " << synthetic << " stacji x " << days << " dni x 6 mierników (" << std::fixed << std::setprecision(1)
+        << seconds(start) << " s)\n";
+
+    MeasurementStore store(directory);
+    std::vector<int> ids = selectExportStations(store.stationIds(), std::vector<Station>(), filter);
+    auto report = [](const char* label, double elapsed, size_t rows, uint64_t read, uint64_t written) {
+        std::cout << std::fixed << std::setprecision(2) << label << ": " << elapsed << " s, " << std::setprecision(0) << rows / elapsed
+            << " wierszy/s, odczyt " << std::setprecision(1) << read / elapsed / 1e6 << " MB/s, zapis " << written / elapsed / 1e6
+            << " MB/s (" << rows << " wierszy, " << written / 1e6 << " MB)\n";
+    };
+
+    start = Clock::now(); //punkt odniesienia: load() stacji i zapis strumieniem ostream
+    size_t baselineRows = 0;
+    uint64_t segmentBytes = 0;
+    {
+        std::ofstream out("eksport_test_load.csv");
+        out << "station_id,metric,date,value\n";
+        for (int id : ids) {
+            std::ifstream probe(store.segmentPath(std::to_string(id)), std::ios::binary | std::ios::ate);
+            segmentBytes += (uint64_t)probe.tellg();
+            for (const auto& m : store.load(std::to_string(id))) {
+                int64_t ts;
+                if (!parseTimestamp(m.date, ts) || ts < filter.start || ts > filter.end) continue;
+                if (!filter.metrics.empty() && std::find(filter.metrics.begin(), filter.metrics.end(), m.name) == filter.metrics.end()) continue;
+                out << id << ',' << m.name << ',' << m.date << ',' << m.value << '\n';
+                baselineRows++;
+            }
+        }
+        out.flush();
+        report("load() + ostream", seconds(start), baselineRows, segmentBytes, (uint64_t)out.tellp());
+    }
+    std::remove("eksport_test_load.csv");
+
+    bool ok = true;
+    size_t csvRows = 0;
+    for (int columnar = 0; columnar < 2; ++columnar) {
+        std::string outFile = columnar ? "eksport_test.aqc" : "eksport_test.csv";
+        StoreExporter exporter(store, filter);
+        start = Clock::now();
+        ok = (columnar ? exporter.writeColumnar(ids, outFile) : exporter.writeCsv(ids, outFile)) && ok;
+        double elapsed = seconds(start);
+        const ExportStats& st = exporter.stats();
+        report(columnar ? "StoreExporter kolumnowy" : "StoreExporter CSV", elapsed, st.rowsWritten, st.bytesRead, st.bytesWritten);
+        if (!columnar) {
+            csvRows = st.rowsWritten;
+            std::cout << "  wpisy w segmentach: " << st.linesRead << ", pełny parser JSON: " << st.slowLines << "\n";
+            continue;
+        }
+        BinaryCache cache; //plik kolumnowy czytany jak pamiec podreczna offline
+        size_t cachedRows = 0;
+        if (cache.open(outFile))
+            for (int id : cache.stationIds()) {
+                BinaryCache::StationColumns columns;
+                if (cache.find(id, columns)) cachedRows += columns.count;
+            }
+        cache.close();
+        std::cout << "  zgodność: load() " << baselineRows << ", CSV " << csvRows << ", BinaryCache " << cachedRows
+            << (baselineRows == csvRows && csvRows == cachedRows ? " - tak" : " - NIE") << "\n";
+        std::remove(outFile.c_str());
+    }
+    std::remove("eksport_test.csv");
+    for (int id : ids) std::remove(store.segmentPath(std::to_string(id)).c_str());
+    return ok ? 0 : 1;
+}
+
+/// Suma kontrolna wzorcowego obrazu "chart --synthetic 8760" w rozmiarze 800x500 (rok danych godzinowych).
+/// Zmiana układu lub rysowania wykresu, która zmienia obraz, wymaga świadomej aktualizacji tej wartości.
+static const char* const goldenChartChecksum = "a6b96cf10c04e9d0";
+
+/// Powtarzalne serie wykresu (stałe ziarno): PM10, PM2.5 i NO2 po points pomiarów godzinowych od 2024-01-01.
+static std::vector<ChartSeries> makeSyntheticChart(int points) {
+    SyntheticOptions options;
+    options.metrics = { "PM10", "PM2.5", "NO2" };
+    options.levels = { 20.0, 30.0, 40.0 };
+    options.hours = points;
+    options.seed = 3;
+    options.step = 3.0;
+    options.reversion = 0.05;
+    const std::vector<std::vector<double>> values = makeSyntheticSeries(options);
+    const int64_t first = syntheticStart();
+    std::vector<ChartSeries> series;
+    for (size_t k = 0; k < values.size(); ++k) {
+        ChartSeries s;
+        s.metric = options.metrics[k];
+        for (int i = 0; i < points; ++i) s.timestamps.push_back(first + (int64_t)i * 3600);
+        s.values = values[k];
+        series.push_back(std::move(s));
+    }
+    return series;
+}
+
+/// Suma kontrolna obrazu jako tekst szesnastkowy (jak w wyniku polecenia "chart").
+static std::string checksumText(const RasterCanvas& canvas) {
+    char hash[32];
+    std::snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)canvas.checksum());
+    return hash;
+}
+
+/// \brief Polecenie "chart": wykres do pliku PPM, czas klatki i porównanie obrazu ze wzorcem.
+/// Dla --synthetic 8760 w rozmiarze 800x500 domyślnym wzorcem jest goldenChartChecksum.
+static int runChart(int argc, char* argv[]) {
+    typedef std::chrono::steady_clock Clock;
+    auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    int width = std::max(1, std::atoi(getOption(argc, argv, "--width", "800").c_str()));
+    int height = std::max(1, std::atoi(getOption(argc, argv, "--height", "500").c_str()));
+    int repeat = std::max(1, std::atoi(getOption(argc, argv, "--repeat", "50").c_str()));
+    std::vector<std::string> metrics;
+    std::stringstream metricList(getOption(argc, argv, "--metric", ""));
+    for (std::string metric; std::getline(metricList, metric, ',');)
+        if (!metric.empty()) metrics.push_back(metric);
+
+    std::vector<ChartSeries> series;
+    int synthetic = std::max(0, std::atoi(getOption(argc, argv, "--synthetic", "0").c_str()));
+    if (synthetic > 0) series = makeSyntheticChart(synthetic); //powtarzalne dane - obraz porownywalny ze wzorcem
+    else {
+        std::string stationId = getOption(argc, argv, "--station", "");
+        if (stationId.empty()) {
+            printUsage();
+            return 1;
+        }
+        MeasurementStore store(getOption(argc, argv, "--store", "dane"));
+        SeriesSet data = SeriesSet::fromMeasurements(store.load(stationId));
+        int64_t start, end;
+        if (!getRangeOptions(argc, argv, start, end)) return 1;
+        for (const auto& name : metrics.empty() ? data.metricNames() : metrics) {
+            SeriesView view = data.range(name, start, end);
+            if (view.size() >= 2) series.push_back(makeChartSeries(view));
+        }
+    }
+    size_t points = 0;
+    for (const auto& s : series) points += s.values.size();
+
+    ChartModel model;
+    model.setSeries(series);
+    RasterCanvas canvas(width, height);
+    auto start = Clock::now();
+    const ChartLayout& layout = model.layout(width, height);
+    double layoutMs = elapsedMs(start);
+    start = Clock::now();
+    renderChart(layout, canvas);
+    double renderMs = elapsedMs(start);
+
+    start = Clock::now(); //kolejne klatki bez zmian - uklad z pamieci podrecznej
+    for (int i = 0; i < repeat; ++i) renderChart(model.layout(width, height), canvas);
+    double cachedMs = elapsedMs(start) / repeat;
+    start = Clock::now(); //zmiana rozmiaru co klatke - uklad liczony za kazdym razem
+    for (int i = 0; i < repeat; ++i) {
+        int w = width - (i % 2);
+        RasterCanvas resized(w, height);
+        renderChart(model.layout(w, height), resized);
+    }
+    double resizeMs = elapsedMs(start) / repeat;
+    renderChart(model.layout(width, height), canvas);
+
+    size_t drawn = 0;
+    for (const auto& line : model.layout(width, height).lines) drawn += line.points.size();
+    std::cout << std::fixed << std::setprecision(3) << "Serie: " << series.size() << ", punkty: " << points << " (rysowane " << drawn
+        << "), obraz " << width << "x" << height << "\n"
+        << "Pierwsza klatka: układ " << layoutMs << " ms + rysowanie " << renderMs << " ms\n"
+        << "Klatka z układem z pamięci: " << cachedMs << " ms, klatka po zmianie rozmiaru: " << resizeMs << " ms (przeliczenia układu: "
+        << model.rebuilds() << ")\n";
+
+    std::string outFile = getOption(argc, argv, "--out", "wykres.ppm");
+    if (!canvas.writePpm(outFile)) {
+        std::cerr << "Nie można zapisać pliku " << outFile << "\n";
+        return 1;
+    }
+    const std::string hash = checksumText(canvas);
+    std::cout << "Obraz: " << outFile << ", suma kontrolna " << hash << "\n";
+    const bool golden = synthetic == 8760 && width == 800 && height == 500;
+    std::string expected = getOption(argc, argv, "--expect", golden ? goldenChartChecksum : "");
+    if (!expected.empty() && expected != hash) {
+        std::cerr << "Obraz różni się od wzorca (oczekiwano " << expected << ")\n";
+        return 1;
+    }
+    return 0;
+}
+
+/// \brief Średnia macierz korelacji stacji (po nazwach mierników) w formie tabeli.
+static void printMeanCorrelation(const std::vector<StationCorrelation>& results) {
+    std::vector<std::string> names;
+    for (const auto& r : results)
+        for (const auto& m : r.matrix.metrics)
+            if (std::find(names.begin(), names.end(), m) == names.end()) names.push_back(m);
+    std::sort(names.begin(), names.end());
+    const size_t n = names.size();
+    std::vector<double> sum(n * n, 0.0);
+    std::vector<size_t> count(n * n, 0);
+    for (const auto& r : results) {
+        const CorrelationMatrix& matrix = r.matrix;
+        std::vector<size_t> index; //pozycja miernika stacji w tabeli
+        for (const auto& m : matrix.metrics) index.push_back(std::find(names.begin(), names.end(), m) - names.begin());
+        for (size_t i = 0; i < index.size(); ++i)
+            for (size_t j = 0; j < index.size(); ++j) {
+                double c = matrix.at(matrix.correlation, i, j);
+                if (std::isnan(c)) continue;
+                sum[index[i] * n + index[j]] += c;
+                count[index[i] * n + index[j]]++;
+            }
+    }
+    std::cout << "Średnia korelacja (" << results.size() << " stacji):\n" << std::setw(8) << "";
+    for (const auto& name : names) std::cout << std::setw(8) << name;
+    std::cout << "\n";
+    for (size_t i = 0; i < n; ++i) {
+        std::cout << std::setw(8) << names[i];
+        for (size_t j = 0; j < n; ++j) {
+            if (count[i * n + j]) std::cout << std::setw(8) << std::fixed << std::setprecision(3) << sum[i * n + j] / count[i * n + j];
+            else std::cout << std::setw(8) << "-";
+        }
+        std::cout << "\n";
+    }
+}
+
+/// \brief Korelacja pary wierszy siatki liczona wprost, dwoma przebiegami (sprawdzenie jądra blokowego).
+static double naiveCorrelation(const HourlyGrid& grid, size_t a, size_t b) {
+    const double* x = grid.row(a);
+    const double* y = grid.row(b);
+    double sx = 0.0, sy = 0.0;
+    size_t n = 0;
+    for (size_t h = 0; h < grid.hours; ++h)
+        if (!std::isnan(x[h]) && !std::isnan(y[h])) { sx += x[h]; sy += y[h]; n++; }
+    if (n < 3) return std::numeric_limits<double>::quiet_NaN();
+    double mx = sx / n, my = sy / n, cxy = 0.0, cxx = 0.0, cyy = 0.0;
+    for (size_t h = 0; h < grid.hours; ++h)
+        if (!std::isnan(x[h]) && !std::isnan(y[h])) {
+            cxy += (x[h] - mx) * (y[h] - my);
+            cxx += (x[h] - mx) * (x[h] - mx);
+            cyy += (y[h] - my) * (y[h] - my);
+        }
+    return cxx > 0.0 && cyy > 0.0 ? cxy / std::sqrt(cxx * cyy) : std::numeric_limits<double>::quiet_NaN();
+}
+
+/// \brief Tworzy count syntetycznych stacji z days dni pomiarów pięciu skorelowanych mierników: pomiary
+/// w różnych minutach godziny, czasem dwa w godzinie, pojedyncze braki i kilkudniowe awarie miernika.
+static void makeSyntheticCorrelation(size_t count, int days, std::vector<SeriesSet>& data) {
+    static const char* names[] = { "CO", "NO2", "O3", "PM10", "PM2.5" };
+    uint16_t ids[5];
+    for (int k = 0; k < 5; ++k) ids[k] = MetricRegistry::intern(names[k]);
+    const int64_t first = syntheticStart();
+    const int64_t hours = (int64_t)days * 24;
+    SyntheticOptions common;   //wspolny czynnik stacji (ruch, ogrzewanie): 0.9 * poprzednia godzina + szum
+    common.metrics = { "ruch" };
+    common.levels = { 0.0 };
+    common.hours = hours;
+    common.step = std::sqrt(3.0);
+    common.reversion = 0.1;
+    common.minimum = -std::numeric_limits<double>::infinity();
+    common.rounded = false;
+    std::mt19937 rng(2024); //powtarzalne dane
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<int> minute(0, 59);
+    data.assign(count, SeriesSet());
+    for (size_t s = 0; s < count; ++s) {
+        int64_t outageEnd[5] = { 0, 0, 0, 0, 0 };
+        common.seed = 2024 + (unsigned)s;
+        const std::vector<double> factor = makeSyntheticSeries(common)[0];
+        for (int64_t h = 0; h < hours; ++h) {
+            const double traffic = factor[h];
+            double level[5] = { 400.0 + 40.0 * traffic, 25.0 + 6.0 * traffic, 60.0 - 5.0 * traffic, 30.0 + 8.0 * traffic, 20.0 + 6.0 * traffic };
+            for (int k = 0; k < 5; ++k) {
+                if (h < outageEnd[k]) continue;
+                double u = unit(rng);
+                if (u < 0.002) { outageEnd[k] = h + 12 + (int64_t)(unit(rng) * 72); continue; } //awaria miernika
+                if (u < 0.05) continue;                                                        //pojedynczy brak
+                CompactMeasurement m;
+                m.metric = ids[k];
+                m.timestamp = first + h * 3600 + minute(rng) * 60;
+                m.value = std::max(0.0, level[k] + 3.0 * noise(rng));
+                data[s].add(m);
+                if (u > 0.98) { //drugi pomiar w tej samej godzinie
+                    m.timestamp = first + h * 3600 + 59 * 60;
+                    m.value = std::max(0.0, level[k] + 3.0 * noise(rng));
+                    data[s].add(m);
+                }
+            }
+        }
+        data[s].buildIndex();
+    }
+}
+
+/// \brief Polecenie "correlate": siatka godzinowa stacji, uzupełnianie przerw i macierz korelacji mierników.
+static int runCorrelate(int argc, char* argv[]) {
+    typedef std::chrono::steady_clock Clock;
+    auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    ResampleOptions options;
+    if (!parseGapPolicy(getOption(argc, argv, "--gaps", "leave"), options.gaps)) {
+        std::cerr << "Nieznana polityka przerw: " << getOption(argc, argv, "--gaps", "") << " (leave, linear, hold)\n";
+        return 1;
+    }
+    options.maxGap = (size_t)std::max(0, std::atoi(getOption(argc, argv, "--max-gap", "6").c_str()));
+    if (!getRangeOptions(argc, argv, options.start, options.end)) return 1;
+    unsigned threads = (unsigned)std::max(0, std::atoi(getOption(argc, argv, "--threads", "0").c_str()));
+
+    size_t synthetic = (size_t)std::max(0, std::atoi(getOption(argc, argv, "--synthetic", "0").c_str()));
+    if (synthetic > 0) { //benchmark bez dysku
+        int days = std::max(1, std::atoi(getOption(argc, argv, "--days", "365").c_str()));
+        std::vector<SeriesSet> data;
+        makeSyntheticCorrelation(synthetic, days, data);
+        std::vector<std::string> ids;
+        size_t points = 0;
+        for (size_t i = 0; i < data.size(); ++i) {
+            ids.push_back(std::to_string(i));
+            points += data[i].size();
+        }
+        CorrelationSource source = [&data](const std::string& id, SeriesSet& series) {
+            series = data[std::atoi(id.c_str())];
+            return true;
+        };
+        std::vector<StationCorrelation> results;
+        for (unsigned count : { 1u, threads }) {
+            auto start = Clock::now();
+            results = correlateStations(ids, source, options, count);
+            double ms = elapsedMs(start);
+            std::cout << "Wątki " << (count ? std::to_string(count) : "auto") << ": " << std::fixed << std::setprecision(1) << ms
+                << " ms, " << points << " pomiarów (" << std::setprecision(1) << points / ms / 1000.0 << " mln/s)\n";
+        }
+
+        std::vector<HourlyGrid> grids; //samo jadro korelacji: wersja skalarna i AVX2
+        size_t cells = 0;
+        for (const auto& series : data) {
+            grids.push_back(resampleHourly(series, options));
+            cells += grids.back().values.size();
+        }
+        bool avx2 = statisticsUseAvx2();
+        for (bool scalar : { true, false }) {
+            if (!scalar && !avx2) break;
+            setStatisticsScalarOnly(scalar);
+            auto start = Clock::now();
+            for (const auto& grid : grids) correlateMetrics(grid);
+            double ms = elapsedMs(start);
+            std::cout << "Jądro korelacji (" << (scalar ? "skalarne" : "AVX2") << ", 1 wątek): " << std::setprecision(1) << ms << " ms, "
+                << std::setprecision(0) << cells / ms / 1000.0 << " mln komórek/s\n";
+        }
+        setStatisticsScalarOnly(false);
+
+        double maxDiff = 0.0;
+        for (size_t s = 0; s < grids.size(); ++s) {
+            const CorrelationMatrix& matrix = results[s].matrix;
+            for (size_t i = 0; i < matrix.metrics.size(); ++i)
+                for (size_t j = 0; j < matrix.metrics.size(); ++j) {
+                    double expected = naiveCorrelation(grids[s], i, j), got = matrix.at(matrix.correlation, i, j);
+                    if (std::isnan(expected) != std::isnan(got)) maxDiff = 1.0;
+                    else if (!std::isnan(expected)) maxDiff = std::max(maxDiff, std::fabs(expected - got));
+                }
+        }
+        const HourlyGrid& grid = grids.front();
+        std::cout << "Siatka: " << cells << " komórek, stacja 0: " << grid.observed << " z pomiarem, " << grid.filled << " uzupełnionych, "
+            << grid.missing << " pustych\n"
+            << "Zgodność z obliczeniem dwuprzebiegowym: max różnica " << std::scientific << std::setprecision(2) << maxDiff
+            << (maxDiff < 1e-9 ? " - tak" : " - NIE") << "\n\n";
+        printMeanCorrelation(results);
+        return maxDiff < 1e-9 ? 0 : 1;
+    }
+
+    MeasurementStore store(getOption(argc, argv, "--store", "dane"));
+    std::string stationId = getOption(argc, argv, "--station", "");
+    std::vector<std::string> ids = stationId.empty() ? store.stationIds() : std::vector<std::string>{ stationId };
+    CorrelationSource source = [&store](const std::string& id, SeriesSet& series) {
+        std::vector<Measurement> measurements = store.load(id);
+        if (measurements.empty()) return false;
+        series = SeriesSet::fromMeasurements(measurements);
+        return true;
+    };
+    auto start = Clock::now();
+    std::vector<StationCorrelation> results = correlateStations(ids, source, options, threads);
+    double ms = elapsedMs(start);
+    if (results.empty()) {
+        std::cerr << "Brak pomiarów w lokalnej bazie.\n";
+        return 1;
+    }
+    if (!stationId.empty()) { //jedna stacja - pelna macierz z kowariancja i liczba wspolnych godzin
+        const StationCorrelation& r = results.front();
+        const CorrelationMatrix& matrix = r.matrix;
+        std::cout << "Stacja " << r.stationId << ": " << r.hours << " godzin, " << r.observed << " komórek z pomiarem, "
+            << r.filled << " uzupełnionych\n";
+        for (size_t i = 0; i < matrix.metrics.size(); ++i)
+            for (size_t j = i + 1; j < matrix.metrics.size(); ++j)
+                std::cout << "  " << matrix.metrics[i] << " - " << matrix.metrics[j] << ": r = " << std::fixed << std::setprecision(3)
+                    << matrix.at(matrix.correlation, i, j) << ", kowariancja " << matrix.at(matrix.covariance, i, j)
+                    << ", wspólne godziny " << matrix.overlap[i * matrix.metrics.size() + j] << "\n";
+        std::cout << "\n";
+    }
+    printMeanCorrelation(results);
+    std::cout << "\nCzas: " << std::fixed << std::setprecision(1) << ms << " ms\n";
+    return 0;
+}
+
+/// \brief Polecenie "query": zapytania o zakres dat na syntetycznej historii jednej stacji (--synthetic LATA):
+/// wyszukiwanie binarne w indeksie czasowym (SeriesSet::range) wobec przeglądu całej serii z kopiowaniem.
+static int runQuery(int argc, char* argv[]) {
+    typedef std::chrono::steady_clock Clock;
+    auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    int years = std::atoi(getOption(argc, argv, "--synthetic", "0").c_str());
+    int queries = std::max(1, std::atoi(getOption(argc, argv, "--queries", "10000").c_str()));
+    if (years <= 0) {
+        printUsage();
+        return 1;
+    }
+    const int64_t first = syntheticStart();
+    const int64_t hours = (int64_t)years * 8760;
+    SyntheticOptions options;
+    options.metrics = { "PM10", "PM2.5", "NO2" };
+    options.levels = { 25.0, 30.0, 35.0 };
+    options.hours = hours;
+    options.gapRate = 0.005;    //brakujace godziny
+    options.seed = 7;
+    options.step = 14.0;        //niezalezny szum godzinowy wokol poziomu
+    options.reversion = 1.0;
+    options.rounded = false;
+    SeriesSet set = syntheticSeriesSet(options, makeSyntheticSeries(options), true); //od najnowszych, jak API
+    std::mt19937 rng(7); //powtarzalne zapytania
+    auto start = Clock::now();
+    set.buildIndex();
+    double indexMs = elapsedMs(start);
+
+    struct RangeQuery { int metric; int64_t start, end; };
+    std::vector<RangeQuery> ranges(queries);
+    std::uniform_int_distribution<int64_t> hourOf(0, hours - 1);
+    const int64_t spans[] = { 24, 7 * 24, 30 * 24, 365 * 24 }; //doba, tydzien, miesiac, rok - jak w oknie analizy
+    for (int i = 0; i < queries; ++i) {
+        ranges[i].metric = i % 3;
+        ranges[i].start = first + hourOf(rng) * 3600;
+        ranges[i].end = ranges[i].start + spans[rng() % 4] * 3600 - 1;
+    }
+
+    //zapytanie z indeksem: dwa wyszukiwania binarne i widok bez kopiowania, suma wartosci jak w analizie
+    start = Clock::now();
+    size_t indexedPoints = 0;
+    double indexedSum = 0.0;
+    for (const auto& q : ranges) {
+        SeriesView view = set.range(options.metrics[q.metric], q.start, q.end);
+        indexedPoints += view.size();
+        for (size_t j = 0; j < view.size(); ++j) indexedSum += view.values[j];
+    }
+    double indexedMs = elapsedMs(start);
+
+    //bez indeksu: przeglad calej serii i kopia pasujacych pomiarow (jak filtrowanie przed indeksem czasowym)
+    start = Clock::now();
+    size_t scannedPoints = 0;
+    double scannedSum = 0.0;
+    for (const auto& q : ranges) {
+        const MetricSeries* series = set.find(options.metrics[q.metric]);
+        MetricSeries filtered;
+        for (size_t j = 0; j < series->size(); ++j)
+            if (series->timestamps[j] >= q.start && series->timestamps[j] <= q.end) {
+                filtered.timestamps.push_back(series->timestamps[j]);
+                filtered.values.push_back(series->values[j]);
+            }
+        scannedPoints += filtered.size();
+        for (double v : filtered.values) scannedSum += v;
+    }
+    double scannedMs = elapsedMs(start);
+
+    bool same = indexedPoints == scannedPoints && std::fabs(indexedSum - scannedSum) <= 1e-9 * std::fabs(scannedSum);
+    std::cout << std::fixed << std::setprecision(2) << "Historia: " << years << " lat x 3 mierniki = " << set.size()
+        << " pomiarów, indeks czasowy " << indexMs << " ms\n"
+        << "Zapytania: " << queries << " (doba, tydzień, miesiąc lub rok), średnio " << indexedPoints / queries << " pomiarów\n"
+        << std::setprecision(4)
+        << "  wyszukiwanie binarne (SeriesSet::range): " << indexedMs * 1000.0 / queries << " us/zapytanie\n"
+        << "  przegląd serii z kopią:                 " << scannedMs * 1000.0 / queries << " us/zapytanie (x" << std::setprecision(1)
+        << scannedMs / indexedMs << ")\n"
+        << "Zgodność wyników: " << (same ? "tak" : "NIE") << "\n";
+    return same ? 0 : 1;
+}
+
+/// \brief Polecenie "windows": okna kroczące 24h/8h liczone przyrostowo (computeWindows) wobec
+/// przeliczania każdego okna od nowa, na syntetycznej serii godzinowej (--synthetic DNI).
+static int runWindows(int argc, char* argv[]) {
+    typedef std::chrono::steady_clock Clock;
+    auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    int days = std::atoi(getOption(argc, argv, "--synthetic", "0").c_str());
+    int repeat = std::max(1, std::atoi(getOption(argc, argv, "--repeat", "5").c_str()));
+    if (days <= 0) {
+        printUsage();
+        return 1;
+    }
+    std::vector<int64_t> ts;
+    std::vector<double> vals;
+    {
+        SyntheticOptions synthetic;
+        synthetic.metrics = { "PM10" };
+        synthetic.levels = { 30.0 };
+        synthetic.hours = (int64_t)days * 24;
+        synthetic.gapRate = 0.02;   //przerwy w danych - okno przesuwa sie o czas, nie o liczbe pomiarow
+        synthetic.gapHours = 12;
+        synthetic.seed = 24; //powtarzalne dane
+        synthetic.minimum = 0.5;
+        const std::vector<double> hourly = makeSyntheticSeries(synthetic)[0];
+        const int64_t first = syntheticStart();
+        for (int64_t h = 0; h < synthetic.hours; ++h)
+            if (!std::isnan(hourly[h])) {
+                ts.push_back(first + h * 3600);
+                vals.push_back(hourly[h]);
+            }
+    }
+    SeriesView view;
+    view.timestamps = ts.data();
+    view.values = vals.data();
+    view.count = ts.size();
+    const WindowOptions options;
+
+    //przyrostowo: suma i kolejki monotoniczne, zamortyzowane O(1) na pomiar
+    MetricWindows incremental;
+    double incrementalMs = 1e300;
+    for (int r = 0; r < repeat; ++r) {
+        auto start = Clock::now();
+        incremental = computeWindows(view, options);
+        incrementalMs = std::min(incrementalMs, elapsedMs(start));
+    }
+
+    //od nowa: dla kazdego pomiaru przeglad wszystkich pomiarow okna (t - szerokosc, t]
+    const size_t n = view.size();
+    std::vector<double> mean24(n), mean8(n), max24(n), min24(n);
+    auto rescan = [&](size_t i, int64_t width, double& mean, double* minimum, double* maximum) {
+        double sum = 0.0, lo = vals[i], hi = vals[i];
+        size_t count = 0;
+        for (size_t j = i + 1; j-- > 0 && ts[j] > ts[i] - width;) {
+            sum += vals[j];
+            lo = std::min(lo, vals[j]);
+            hi = std::max(hi, vals[j]);
+            ++count;
+        }
+        mean = count >= options.minCoverage * width / 3600 ? sum / count : std::numeric_limits<double>::quiet_NaN();
+        if (minimum) *minimum = lo;
+        if (maximum) *maximum = hi;
+    };
+    double naiveMs = 1e300;
+    for (int r = 0; r < repeat; ++r) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            rescan(i, 24 * 3600, mean24[i], &min24[i], &max24[i]);
+            rescan(i, 8 * 3600, mean8[i], nullptr, nullptr);
+        }
+        naiveMs = std::min(naiveMs, elapsedMs(start));
+    }
+
+    //szersze okno (--wide GODZINY, domyslnie 30 dob) - tu przeglad od nowa kosztuje O(szerokosc) na pomiar
+    const int64_t wide = (int64_t)std::max(1, std::atoi(getOption(argc, argv, "--wide", "720").c_str())) * 3600;
+    std::vector<double> wideMean(n), wideMin(n), wideMax(n), rescanMean(n), rescanMin(n), rescanMax(n);
+    double wideMs = 1e300, wideNaiveMs = 1e300;
+    for (int r = 0; r < repeat; ++r) {
+        auto start = Clock::now();
+        RollingWindow window(wide);
+        for (size_t i = 0; i < n; ++i) {
+            window.push(ts[i], vals[i]);
+            wideMean[i] = window.mean();
+            wideMin[i] = window.minimum();
+            wideMax[i] = window.maximum();
+        }
+        wideMs = std::min(wideMs, elapsedMs(start));
+        start = Clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            double sum = 0.0, lo = vals[i], hi = vals[i];
+            size_t count = 0;
+            for (size_t j = i + 1; j-- > 0 && ts[j] > ts[i] - wide; ++count) {
+                sum += vals[j];
+                lo = std::min(lo, vals[j]);
+                hi = std::max(hi, vals[j]);
+            }
+            rescanMean[i] = sum / count;
+            rescanMin[i] = lo;
+            rescanMax[i] = hi;
+        }
+        wideNaiveMs = std::min(wideNaiveMs, elapsedMs(start));
+    }
+
+    auto sameMean = [](double a, double b) { return std::isnan(a) ? std::isnan(b) : std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(b)); };
+    size_t mismatches = 0;
+    for (size_t i = 0; i < n; ++i)
+        if (!sameMean(incremental.mean24h[i], mean24[i]) || !sameMean(incremental.mean8h[i], mean8[i]) ||
+            incremental.max24h[i] != max24[i] || incremental.min24h[i] != min24[i]) {
+            if (++mismatches <= 5) std::cerr << "Różnica w oknie kończącym się " << formatTimestamp(ts[i]) << "\n";
+        }
+    for (size_t i = 0; i < n; ++i)
+        if (!sameMean(wideMean[i], rescanMean[i]) || wideMin[i] != rescanMin[i] || wideMax[i] != rescanMax[i]) {
+            if (++mismatches <= 5) std::cerr << "Różnica w szerokim oknie kończącym się " << formatTimestamp(ts[i]) << "\n";
+        }
+    std::cout << std::fixed << std::setprecision(3) << "Seria: " << days << " dni, " << n << " pomiarów godzinowych, "
+        << incremental.daily.size() << " dób (najlepszy z " << repeat << ")\n"
+        << "  przyrostowo (computeWindows): " << incrementalMs << " ms (" << std::setprecision(1) << incrementalMs * 1e6 / n << " ns/pomiar)\n"
+        << std::setprecision(3)
+        << "  od nowa dla każdego okna:     " << naiveMs << " ms (" << std::setprecision(1) << naiveMs * 1e6 / n << " ns/pomiar, x"
+        << naiveMs / incrementalMs << ")\n"
+        << std::setprecision(3) << "Okno " << wide / 3600 << "h (RollingWindow):\n"
+        << "  przyrostowo:                  " << wideMs << " ms (" << std::setprecision(1) << wideMs * 1e6 / n << " ns/pomiar)\n"
+        << std::setprecision(3)
+        << "  od nowa dla każdego okna:     " << wideNaiveMs << " ms (" << std::setprecision(1) << wideNaiveMs * 1e6 / n << " ns/pomiar, x"
+        << wideNaiveMs / wideMs << ")\n"
+        << "Zgodność średnich, minimów i maksimów okien: " << (mismatches == 0 ? "tak" : "NIE (" + std::to_string(mismatches) + ")") << "\n";
+    return mismatches == 0 ? 0 : 1;
+}
+
+/// \brief Sprawdza redukcję serii: rosnące indeksy, zakres osi Y, globalne minimum i maksimum na wykresie,
+/// minimum i maksimum każdej kolumny pikseli osi czasu [t0, t1] (timeColumn, jak układ wykresu) oraz co najwyżej
+/// 2 punkty na kolumnę (pierwszy i ostatni punkt serii są dodawane ponad to). Zwraca opis pierwszego błędu lub pusty tekst.
+static std::string decimationError(const int64_t* timestamps, const double* values, size_t count, int64_t t0, int64_t t1, int columns,
+    const DecimatedSeries& d) {
+    if (count == 0) return d.indices.empty() ? "" : "punkty dla pustej serii";
+    for (size_t i = 1; i < d.indices.size(); ++i)
+        if (d.indices[i] <= d.indices[i - 1]) return "indeksy nie rosną";
+    if (d.indices.front() != 0 || d.indices.back() != count - 1) return "brak pierwszego lub ostatniego punktu";
+    const double lo = *std::min_element(values, values + count), hi = *std::max_element(values, values + count);
+    if (d.minValue != lo || d.maxValue != hi) return "zakres osi Y";
+    bool haveLo = false, haveHi = false;
+    for (size_t i : d.indices) {
+        haveLo = haveLo || values[i] == lo;
+        haveHi = haveHi || values[i] == hi;
+    }
+    if (!haveLo || !haveHi) return "brak globalnego minimum lub maksimum";
+    size_t k = 0; //pierwszy indeks wyniku w biezacej kolumnie
+    for (size_t first = 0; first < count;) {
+        const int column = timeColumn(timestamps[first], t0, t1, columns);
+        size_t last = first + 1; //punkty serii w tej samej kolumnie pikseli
+        while (last < count && timeColumn(timestamps[last], t0, t1, columns) == column) ++last;
+        const double cLo = *std::min_element(values + first, values + last), cHi = *std::max_element(values + first, values + last);
+        size_t own = 0; //punkty kolumny bez pierwszego i ostatniego punktu serii
+        bool columnLo = false, columnHi = false;
+        for (; k < d.indices.size() && d.indices[k] < last; ++k) {
+            columnLo = columnLo || values[d.indices[k]] == cLo;
+            columnHi = columnHi || values[d.indices[k]] == cHi;
+            if (d.indices[k] != 0 && d.indices[k] != count - 1) ++own;
+        }
+        if (own > 2) return "ponad 2 punkty w kolumnie " + std::to_string(column);
+        if (!columnLo || !columnHi) return "brak minimum lub maksimum kolumny " + std::to_string(column);
+        first = last;
+    }
+    return "";
+}
+
+/// \brief Polecenie "decimate": sprawdzenie redukcji serii wykresu (decimateMinMax) na losowych seriach
+/// i czas klatki z redukcją do szerokości wykresu wobec rysowania wszystkich punktów (--synthetic N).
+static int runDecimate(int argc, char* argv[]) {
+    typedef std::chrono::steady_clock Clock;
+    auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    const int points = std::atoi(getOption(argc, argv, "--synthetic", "0").c_str());
+    const int width = std::max(1, std::atoi(getOption(argc, argv, "--width", "800").c_str()));
+    const int height = std::max(1, std::atoi(getOption(argc, argv, "--height", "500").c_str()));
+    const int repeat = std::max(1, std::atoi(getOption(argc, argv, "--repeat", "20").c_str()));
+    if (points <= 0) {
+        printUsage();
+        return 1;
+    }
+    std::mt19937 rng(9); //powtarzalne dane
+    const int64_t first = syntheticStart();
+    SyntheticOptions options;
+    options.metrics = { "PM10" };
+    options.levels = { 30.0 };
+    options.seed = 9;
+    options.step = 3.5;
+    options.spikeRate = 0.002;  //pojedyncze piki i powtorzone wartosci
+    auto makeSeries = [&options](size_t n) {
+        options.hours = (int64_t)n;
+        ++options.seed; //kazda seria inna
+        return makeSyntheticSeries(options)[0];
+    };
+    auto makeTimes = [&rng, first](size_t n, bool uneven) { //nierowno: przerwy do 30 dni i zageszczone pomiary co minuty
+        std::vector<int64_t> ts(n);
+        int64_t t = first;
+        for (size_t i = 0; i < n; ++i) {
+            ts[i] = t;
+            const unsigned r = uneven ? rng() % 100 : 99;
+            t += r < 2 ? 3600 * (24 + (int64_t)(rng() % (24 * 30))) : r < 20 ? 60 + (int64_t)(rng() % 600) : 3600;
+        }
+        return ts;
+    };
+
+    //niezmienniki: dlugosci wokol 2 * szerokosc, malo kolumn, dlugie serie; krok rowny i nierowny,
+    //os czasu rowna serii i dluzsza (inna seria wykresu zaczyna sie wczesniej)
+    size_t checked = 0, failed = 0;
+    auto check = [&](const std::vector<int64_t>& ts, const std::vector<double>& values, int64_t t0, int64_t t1, int w, const char* kind) {
+        const size_t n = values.size();
+        std::string error = decimationError(ts.data(), values.data(), n, t0, t1, w, decimateMinMax(ts.data(), values.data(), n, t0, t1, w));
+        ++checked;
+        if (!error.empty() && ++failed <= 5) std::cerr << "n = " << n << ", kolumny = " << w << " (" << kind << "): " << error << "\n";
+    };
+    const int widths[] = { 1, 2, 3, 7, 64, 333, 800 };
+    for (int w : widths) {
+        const size_t lengths[] = { 1, 2, 3, (size_t)2 * w, (size_t)2 * w + 1, (size_t)5 * w + 3, 100000 };
+        for (size_t n : lengths) {
+            for (int uneven = 0; uneven < 2; ++uneven) {
+                std::vector<double> values = makeSeries(n);
+                std::vector<int64_t> ts = makeTimes(n, uneven != 0);
+                const int64_t t1 = std::max(ts.back(), ts.front() + 1);
+                check(ts, values, ts.front(), t1, w, uneven ? "nierówny krok" : "co godzinę");
+                check(ts, values, ts.front() - (t1 - ts.front()) / 2, t1 + 3600, w, uneven ? "nierówny krok, dłuższa oś" : "co godzinę, dłuższa oś");
+            }
+        }
+    }
+    std::vector<double> values = makeSeries((size_t)points);
+    std::vector<int64_t> times = makeTimes((size_t)points, false);
+    const int64_t last = std::max(times.back(), times.front() + 1);
+    check(times, values, times.front(), last, width, "co godzinę");
+    std::cout << "Niezmienniki redukcji (min/maks globalne i kolumn pikseli osi czasu, <= 2 punkty na kolumnę): "
+        << checked - failed << "/" << checked << "\n";
+
+    //czas: sama redukcja i klatka (uklad + rysowanie) z redukcja i bez
+    DecimatedSeries reduced;
+    auto start = Clock::now();
+    for (int r = 0; r < repeat; ++r) reduced = decimateMinMax(times.data(), values.data(), values.size(), times.front(), last, width);
+    const double decimateMs = elapsedMs(start) / repeat;
+
+    ChartSeries series;
+    series.metric = "PM10";
+    series.timestamps = times;
+    series.values = values;
+    ChartModel model;
+    model.setSeries(std::vector<ChartSeries>{ series });
+    start = Clock::now(); //zmiana rozmiaru co klatke - redukcja i uklad liczone za kazdym razem
+    for (int r = 0; r < repeat; ++r) {
+        int w = width - (r % 2);
+        RasterCanvas canvas(w, height);
+        renderChart(model.layout(w, height), canvas);
+    }
+    const double frameMs = elapsedMs(start) / repeat;
+    size_t drawn = 0;
+    for (const auto& line : model.layout(width, height).lines) drawn += line.points.size();
+
+    start = Clock::now(); //bez redukcji: kazdy punkt serii jako wierzcholek linii
+    for (int r = 0; r < repeat; ++r) {
+        RasterCanvas canvas(width, height);
+        std::vector<ChartPoint> line(values.size());
+        const double span = std::max(1e-9, reduced.maxValue - reduced.minValue);
+        for (size_t i = 0; i < values.size(); ++i) {
+            line[i].x = (int32_t)(i * (width - 1) / std::max<size_t>(1, values.size() - 1));
+            line[i].y = (int32_t)((height - 1) * (1.0 - (values[i] - reduced.minValue) / span));
+        }
+        canvas.fill(0xFFFFFF);
+        canvas.polyline(line.data(), line.size(), 0x1F77B4);
+    }
+    const double fullMs = elapsedMs(start) / repeat;
+
+    std::cout << std::fixed << std::setprecision(3) << "Seria " << points << " punktów, " << width << " kolumn: po redukcji "
+        << reduced.indices.size() << " punktów (rysowane " << drawn << ")\n"
+        << "  redukcja:                          " << decimateMs << " ms\n"
+        << "  klatka z redukcją (układ + rysowanie): " << frameMs << " ms\n"
+        << "  klatka bez redukcji (sama linia):  " << fullMs << " ms (x" << std::setprecision(1) << fullMs / frameMs << ")\n";
+    return failed == 0 ? 0 : 1;
+}
+
+/// \brief Polecenie "parse": parser strumieniowy (GiosReaders) wobec drzewa dokumentu nlohmann::json
+/// na syntetycznych odpowiedziach API: dane czujnika z N pomiarami i lista N / 50 stacji (--synthetic N).
+static int runParse(int argc, char* argv[]) {
+    typedef std::chrono::steady_clock Clock;
+    auto elapsedMs = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    const int count = std::atoi(getOption(argc, argv, "--synthetic", "0").c_str());
+    const int repeat = std::max(1, std::atoi(getOption(argc, argv, "--repeat", "5").c_str()));
+    const size_t chunk = (size_t)std::max(1, std::atoi(getOption(argc, argv, "--chunk", "16384").c_str()));
+    if (count <= 0) {
+        printUsage();
+        return 1;
+    }
+    //odpowiedzi w formacie API GIOŚ (data/getData, station/findAll)
+    SyntheticOptions options;
+    options.metrics = { "PM10" };
+    options.levels = { 40.0 };
+    options.hours = count;
+    options.gapRate = 1.0 / 30.0;   //brak pomiaru - w odpowiedzi API wartosc null
+    options.seed = 10; //powtarzalne dane
+    options.step = 10.0;
+    const std::vector<double> values = makeSyntheticSeries(options)[0];
+    const int64_t first = syntheticStart();
+    std::ostringstream data;
+    data << "{\"key\":\"PM10\",\"values\":[";
+    for (int i = 0; i < count; ++i) { //od najnowszych, jak API
+        const int64_t h = count - 1 - i;
+        data << (i ? "," : "") << "{\"date\":\"" << formatTimestamp(first + h * 3600) << "\",\"value\":";
+        if (std::isnan(values[h])) data << "null}";
+        else data << values[h] << "}";
+    }
+    data << "]}";
+    std::ostringstream list;
+    list << "[";
+    for (int i = 0; i < std::max(1, count / 50); ++i)
+        list << (i ? "," : "") << "{\"id\":" << i + 1 << ",\"stationName\":\"Stacja " << i + 1 << "\",\"gegrLat\":\"50.0\",\"gegrLon\":\"19.9\","
+            << "\"city\":{\"id\":" << i << ",\"name\":\"Miasto\",\"commune\":{\"communeName\":\"Gmina\",\"districtName\":\"Powiat\","
+            << "\"provinceName\":\"WOJEWÓDZTWO " << i % 16 << "\"}},\"addressStreet\":null}";
+    list << "]";
+    const std::string dataBody = data.str(), listBody = list.str();
+
+    //drzewo dokumentu: jak parsowanie przed czytnikami strumieniowymi
+    auto domData = [&](std::vector<Measurement>& out) {
+        nlohmann::json parsed = nlohmann::json::parse(dataBody);
+        std::string paramName = parsed.value("key", "Nieznany");
+        for (const auto& val : parsed["values"])
+            if (!val["value"].is_null()) {
+                Measurement m;
+                m.name = paramName;
+                m.date = val.value("date", "brak daty");
+                m.value = val.value("value", 0.0);
+                out.push_back(m);
+            }
+    };
+    auto domList = [&](std::vector<Station>& out) {
+        nlohmann::json parsed = nlohmann::json::parse(listBody);
+        for (const auto& s : parsed) {
+            Station station;
+            station.id = s.value("id", -1);
+            station.name = s.value("stationName", "Brak nazwy");
+            station.province = s["city"]["commune"].value("provinceName", "Nieznany");
+            out.push_back(station);
+        }
+    };
+    //strumieniowo w kawalkach, jak z odbiornika tresci HTTP
+    auto streamData = [&](std::vector<Measurement>& out) {
+        SensorDataStreamReader reader([&](const Measurement& m) { out.push_back(m); });
+        JsonStreamParser parser(reader);
+        for (size_t at = 0; at < dataBody.size(); at += chunk) parser.feed(dataBody.data() + at, std::min(chunk, dataBody.size() - at));
+        bool ok = parser.finish();
+        reader.flush();
+        return ok;
+    };
+    auto streamList = [&](std::vector<Station>& out) {
+        StationStreamReader reader([&](const Station& s) { out.push_back(s); });
+        JsonStreamParser parser(reader);
+        for (size_t at = 0; at < listBody.size(); at += chunk) parser.feed(listBody.data() + at, std::min(chunk, listBody.size() - at));
+        return parser.finish();
+    };
+
+    std::vector<Measurement> domMeasurements, streamMeasurements;
+    std::vector<Station> domStations, streamStations;
+    domData(domMeasurements);
+    domList(domStations);
+    bool same = streamData(streamMeasurements) && streamList(streamStations) && domMeasurements.size() == streamMeasurements.size() &&
+        domStations.size() == streamStations.size();
+    for (size_t i = 0; same && i < domMeasurements.size(); ++i)
+        same = domMeasurements[i].name == streamMeasurements[i].name && domMeasurements[i].date == streamMeasurements[i].date &&
+            domMeasurements[i].value == streamMeasurements[i].value;
+    for (size_t i = 0; same && i < domStations.size(); ++i)
+        same = domStations[i].id == streamStations[i].id && domStations[i].name == streamStations[i].name &&
+            domStations[i].province == streamStations[i].province;
+
+    auto best = [&](std::function<size_t()> run) {
+        double ms = 1e300;
+        for (int r = 0; r < repeat; ++r) {
+            auto start = Clock::now();
+            if (run() == 0) std::cerr << "Brak wyników parsowania\n";
+            ms = std::min(ms, elapsedMs(start));
+        }
+        return ms;
+    };
+    double domDataMs = best([&] { std::vector<Measurement> out; domData(out); return out.size(); });
+    double streamDataMs = best([&] { std::vector<Measurement> out; streamData(out); return out.size(); });
+    double domListMs = best([&] { std::vector<Station> out; domList(out); return out.size(); });
+    double streamListMs = best([&] { std::vector<Station> out; streamList(out); return out.size(); });
+
+    auto report = [&](const char* what, size_t bytes, size_t items, double domMs, double streamMs) {
+        std::cout << std::fixed << std::setprecision(2) << what << ": " << bytes / 1024 << " KB, " << items << " rekordów\n"
+            << "  drzewo dokumentu (nlohmann::json): " << domMs << " ms (" << std::setprecision(1) << bytes / 1048576.0 / (domMs / 1000.0) << " MB/s)\n"
+            << std::setprecision(2)
+            << "  strumieniowo (kawałki " << chunk << " B):    " << streamMs << " ms (" << std::setprecision(1)
+            << bytes / 1048576.0 / (streamMs / 1000.0) << " MB/s, x" << domMs / streamMs << ")\n";
+    };
+    std::cout << "Najlepszy z " << repeat << " przebiegów\n";
+    report("Dane czujnika (data/getData)", dataBody.size(), domMeasurements.size(), domDataMs, streamDataMs);
+    report("Lista stacji (station/findAll)", listBody.size(), domStations.size(), domListMs, streamListMs);
+    std::cout << "Zgodność wyników: " << (same ? "tak" : "NIE") << "\n";
+    return same ? 0 : 1;
+}
+
+/// \brief Wczytuje nagrane odpowiedzi API dla sprawdzeń (--stations, --data); false i komunikat, gdy brak pomiarów.
+static bool loadCheckFixtures(int argc, char* argv[], ReplayFixtures& fixtures) {
+    if (!fixtures.load(getOption(argc, argv, "--stations", "stations.json"), getOption(argc, argv, "--data", "dane.json"), 1) ||
+        fixtures.stationsWithData().empty()) {
+        std::cerr << "    brak nagranych stacji i pomiarów (stations.json, dane.json)\n";
+        return false;
+    }
+    return true;
+}
+
+/// \brief Sprawdzenie "connections": wczytanie stacji (lista czujników i dane każdego czujnika) idzie jednym
+/// połączeniem keep-alive, a kolejne wczytanie używa tego samego połączenia. Przy pobieraniu równoległym
+/// połączeń jest najwyżej tyle, ile wątków, i tyle samo liczy klient.
+static bool checkConnections(int argc, char* argv[]) {
+    ReplayFixtures fixtures;
+    if (!loadCheckFixtures(argc, argv, fixtures)) return false;
+    ReplayServer server(fixtures, ReplayOptions());
+    if (server.start() < 0) return false;
+    const int stationId = fixtures.stationsWithData().front();
+    const size_t expected = fixtures.measurementCount(stationId);
+
+    ApiClient sequential(server.url());
+    sequential.setMaxConcurrency(1);
+    size_t loaded = sequential.getMeasurementsForStation(stationId).size();
+    const size_t firstRequests = server.requests(), firstConnections = server.connections();
+    loaded += sequential.getMeasurementsForStation(stationId).size();
+    const size_t sequentialConnections = server.connections();
+    std::cout << "    stacja " << stationId << " po kolei: " << firstRequests << " żądań, połączenia: " << firstConnections
+        << ", po drugim wczytaniu: " << sequentialConnections << "\n";
+
+    const int concurrency = 4;
+    ApiClient parallel(server.url());
+    parallel.setMaxConcurrency(concurrency);
+    loaded += parallel.getMeasurementsForStation(stationId).size();
+    const size_t parallelConnections = server.connections() - sequentialConnections;
+    std::cout << "    równolegle (" << concurrency << " wątki): połączenia serwera " << parallelConnections << ", klienta "
+        << parallel.sessionStats().connectionsOpened << "\n";
+    return loaded == 3 * expected && firstRequests > 1 && firstConnections == 1 && sequentialConnections == 1 &&
+        parallelConnections >= 1 && parallelConnections <= (size_t)concurrency && parallelConnections == parallel.sessionStats().connectionsOpened;
+}
+
+/// Liczba pomiarów wszystkich czujników stacji w bieżącym oknie serwera.
+static size_t replayWindowPoints(const ReplayFixtures& fixtures, const ReplayServer& server, int stationId) {
+    size_t count = 0;
+    for (int sensorId : fixtures.sensorsOf(stationId)) {
+        int64_t from, to;
+        if (!server.window(sensorId, from, to)) continue;
+        for (const auto& point : fixtures.series(sensorId)->points)
+            count += point.first >= from && point.first <= to ? 1 : 0;
+    }
+    return count;
+}
+
+/// \brief Sprawdzenie "delta": synchronizacja przyrostowa na serwerze z przesuwanym oknem danych. Pierwsze pobranie
+/// zapisuje całe okno, powtórzone dostaje 304 dla każdego czujnika, po przesunięciu okna nowe są tylko pomiary
+/// z dopisanych godzin, a poprawione przez serwer ostatnie wartości trafiają do bazy jako korekty.
+static bool checkDelta(int argc, char* argv[]) {
+    ReplayFixtures fixtures;
+    if (!loadCheckFixtures(argc, argv, fixtures)) return false;
+    ReplayOptions options;
+    options.windowHours = 48;
+    options.windowLagHours = 12;
+    ReplayServer server(fixtures, options);
+    if (server.start() < 0) return false;
+    const int stationId = fixtures.stationsWithData().front();
+    const std::string key = std::to_string(stationId);
+
+    MeasurementStore store("check_dane"); //osobny katalog - sprawdzenie zaczyna od pustej stacji
+    std::remove(store.segmentPath(key).c_str());
+    ApiClient api(server.url());
+    struct Fetched {
+        DeltaSyncResult delta;
+        size_t corrected;   //pomiary z okna korekt zapisane przez baze (zmieniona wartosc)
+    };
+    auto fetch = [&](const char* label) {
+        Fetched result{ api.fetchStationDelta(stationId, store.newestDates(key)), 0 };
+        const DeltaSyncResult& delta = result.delta;
+        size_t written = store.append(key, delta.fresh);
+        result.corrected = store.append(key, delta.rechecked);
+        std::cout << "    " << label << ": nowe " << delta.newPoints << " (zapisane: " << written << "), znane " << delta.knownPoints
+            << " (poprawione: " << result.corrected << "), czujniki bez zmian " << delta.unchangedSensors << "/" << delta.sensors << "\n";
+        return result;
+    };
+
+    const size_t sensors = fixtures.sensorsOf(stationId).size();
+    const size_t windowPoints = replayWindowPoints(fixtures, server, stationId);
+    Fetched first = fetch("pierwsze pobranie");
+    bool ok = first.delta.online && first.delta.newPoints == windowPoints && first.delta.knownPoints == 0 && windowPoints > 0;
+
+    Fetched repeated = fetch("powtórzone");
+    ok = ok && repeated.delta.newPoints == 0 && repeated.delta.unchangedSensors == sensors;
+
+    std::map<int, int64_t> previousEnd; //koniec okna czujnika przed przesunieciem
+    for (int sensorId : fixtures.sensorsOf(stationId)) {
+        int64_t from, to;
+        server.window(sensorId, from, to);
+        previousEnd[sensorId] = to;
+    }
+    server.advanceWindow(5);
+    size_t added = 0;
+    for (int sensorId : fixtures.sensorsOf(stationId)) {
+        int64_t from, to;
+        server.window(sensorId, from, to);
+        for (const auto& point : fixtures.series(sensorId)->points)
+            added += point.first > previousEnd[sensorId] && point.first <= to ? 1 : 0;
+    }
+    const size_t shiftedPoints = replayWindowPoints(fixtures, server, stationId);
+    Fetched shifted = fetch("okno +5 h");
+    ok = ok && added > 0 && shifted.delta.newPoints == added && shifted.delta.knownPoints == shiftedPoints - added && shifted.corrected == 0;
+
+    server.reviseLatest(0.5);
+    Fetched revised = fetch("po korekcie");
+    return ok && revised.delta.newPoints == 0 && revised.corrected == sensors && revised.delta.unchangedSensors == 0;
+}
+
+/// \brief Sprawdzenie "breaker": bezpiecznik klienta przy serwerze przełączanym przez GET /replay/mode/...
+/// Odpowiedzi 503 ze stroną HTML otwierają go mimo przerwanego parsowania treści, otwarty odrzuca żądania
+/// bez łączenia, próba po przerwie (półotwarty) przekracza limit czasu w trybie slow, a po powrocie
+/// serwera (up) kolejna próba zamyka bezpiecznik.
+static bool checkBreaker(int argc, char* argv[]) {
+    ReplayFixtures fixtures;
+    if (!loadCheckFixtures(argc, argv, fixtures)) return false;
+    ReplayOptions options;
+    options.slowMs = 1500;
+    ReplayServer server(fixtures, options);
+    if (server.start() < 0) return false;
+    const int stationId = fixtures.stationsWithData().front();
+    const size_t expected = fixtures.measurementCount(stationId);
+
+    CircuitBreakerOptions breaker;
+    breaker.failureThreshold = 3;
+    breaker.baseBackoff = std::chrono::milliseconds(300);
+    breaker.jitter = 0.0;
+    ApiClient api(server.url());
+    api.setCircuitBreaker(breaker);
+    api.setReadTimeout(500);
+    HttpSessionPool control(server.url()); //przelaczanie trybu serwera osobnym polaczeniem
+    auto switchMode = [&](const char* mode) {
+        std::string body;
+        return control.get(std::string("/replay/mode/") + mode, body);
+    };
+    static const char* states[] = { "zamknięty", "otwarty", "półotwarty" };
+    auto report = [&](const char* label, size_t loaded) {
+        CircuitBreakerStats health = api.connectionHealth();
+        std::cout << "    " << label << ": pomiarów " << loaded << ", bezpiecznik " << states[health.state] << " (otwarcia: "
+            << health.trips << ", odrzucone: " << health.shortCircuited << ", próby: " << health.probes << ")\n";
+        return health;
+    };
+
+    bool ok = report("up", api.getMeasurementsForStation(stationId).size()).state == 0;
+    ok = switchMode("down") && ok;
+    for (int i = 0; i < breaker.failureThreshold; ++i) api.getMeasurementsForStation(stationId);
+    const size_t requestsWhenOpened = server.requests();
+    size_t loaded = api.getMeasurementsForStation(stationId).size();
+    CircuitBreakerStats opened = report("down (503 HTML)", loaded);
+    ok = ok && opened.state == 1 && opened.trips == 1 && opened.shortCircuited > 0 && server.requests() == requestsWhenOpened;
+
+    ok = switchMode("slow") && ok;
+    std::this_thread::sleep_for(breaker.baseBackoff + std::chrono::milliseconds(50));
+    std::thread probe([&] { api.getMeasurementsForStation(stationId); }); //proba czeka na limit czasu odczytu
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    CircuitBreakerStats probing = report("slow, w trakcie próby", 0);
+    probe.join();
+    CircuitBreakerStats reopened = report("slow, po limicie czasu", 0);
+    ok = ok && probing.state == 2 && probing.probes == 1 && reopened.state == 1 && reopened.trips == 2;
+
+    ok = switchMode("up") && ok;
+    std::this_thread::sleep_for(2 * breaker.baseBackoff + std::chrono::milliseconds(50)); //druga przerwa jest dwa razy dluzsza
+    loaded = api.getMeasurementsForStation(stationId).size();
+    CircuitBreakerStats closed = report("up", loaded);
+    return ok && closed.state == 0 && loaded == expected;
+}
+
+/// \brief Sprawdzenie "chart": obraz wykresu z makeSyntheticChart(8760) w rozmiarze 800x500 ma sumę kontrolną
+/// wzorca (goldenChartChecksum), także po przeliczeniu układu dla innego rozmiaru i powrocie do 800x500.
+static bool checkChart(int, char*[]) {
+    ChartModel model;
+    model.setSeries(makeSyntheticChart(8760));
+    RasterCanvas canvas(800, 500), other(640, 480);
+    renderChart(model.layout(800, 500), canvas);
+    const std::string first = checksumText(canvas);
+    renderChart(model.layout(640, 480), other);
+    renderChart(model.layout(800, 500), canvas);
+    const std::string again = checksumText(canvas);
+    std::cout << "    suma kontrolna " << first << ", po zmianie rozmiaru " << again << ", wzorzec " << goldenChartChecksum << "\n";
+    return first == goldenChartChecksum && again == goldenChartChecksum;
+}
+
+/// \brief Sprawdzenie "dates": granice zakresu dat (parseRangeBound, pola "Data od/do" w GUI) odrzucają
+/// nieistniejące dni i znaki za datą zamiast przenosić datę na inny dzień.
+static bool checkDates(int, char*[]) {
+    struct Case {
+        const char* text;
+        bool endOfRange;
+        const char* expected; //oczekiwana granica (formatTimestamp) lub nullptr = blad
+    };
+    static const Case cases[] = {
+        { "2025-02-30", false, nullptr },
+        { "2023-02-29", false, nullptr },
+        { "1900-02-29", false, nullptr },
+        { "2025-04-31 10:00", false, nullptr },
+        { "2025-04-22 01:00abc", false, nullptr },
+        { "2025-04-22T01:00 garbage", false, nullptr },
+        { "2025-04-22 01:00:0", false, nullptr },
+        { "2025-04-22 01:00;00", false, nullptr },
+        { "2025-04-22 24:00", false, nullptr },
+        { "2025-13", false, nullptr },
+        { "2025-4-22", false, nullptr },
+        { "2024-02-29", true, "2024-02-29 23:59:59" },
+        { "2000-02-29", false, "2000-02-29 00:00:00" },
+        { "2025-04-30 10:00", true, "2025-04-30 10:00:59" },
+        { "2025-04-22T01:00:30", false, "2025-04-22 01:00:30" },
+        { " 2024-02 ", true, "2024-02-29 23:59:59" },
+        { "2025-04", true, "2025-04-30 23:59:59" },
+        { "2025", true, "2025-12-31 23:59:59" },
+    };
+    bool ok = true;
+    for (const auto& c : cases) {
+        int64_t bound;
+        const bool parsed = parseRangeBound(c.text, c.endOfRange, bound);
+        const std::string got = parsed ? formatTimestamp(bound) : "błąd";
+        const bool match = c.expected ? parsed && got == c.expected : !parsed;
+        if (!match) std::cout << "    \"" << c.text << "\" -> " << got << ", oczekiwano " << (c.expected ? c.expected : "błąd") << "\n";
+        ok = ok && match;
+    }
+    std::cout << "    przypadków: " << sizeof(cases) / sizeof(cases[0]) << "\n";
+    return ok;
+}
+
+/// \brief Sprawdzenie "migrate": import starego dane.json z uszkodzonymi stacjami i wpisami pomija je
+/// zamiast przerywać migrację wyjątkiem.
+static bool checkMigrate(int, char*[]) {
+    const char* legacy = "check_migrate.json";
+    {
+        std::ofstream out(legacy);
+        out << "{ \"1\": [ { \"name\": \"PM10\", \"date\": \"2025-04-22 01:00:00\", \"value\": 12.5 },"
+               " 7, \"tekst\", [ 1, 2 ], { \"name\": \"PM10\", \"date\": \"2025-04-22 02:00:00\", \"value\": \"abc\" },"
+               " { \"name\": \"PM10\", \"date\": \"2025-04-22 03:00:00\", \"value\": 14.0 } ],"
+               " \"2\": 5, \"3\": \"brak\", \"4\": { \"name\": \"NO2\" }, \"5\": null,"
+               " \"6\": [ { \"name\": \"NO2\", \"date\": \"2025-04-22 01:00:00\", \"value\": 20.0 } ] }";
+    }
+    MeasurementStore store("check_dane"); //osobny katalog - stacje 1 i 6 od zera
+    for (const char* id : { "1", "6" }) std::remove(store.segmentPath(id).c_str());
+    const size_t imported = store.migrateFromJson(legacy);
+    const size_t first = store.load("1").size();
+    const size_t sixth = store.load("6").size();
+    std::remove(legacy);
+    std::cout << "    zaimportowano: " << imported << " (stacja 1: " << first << ", stacja 6: " << sixth << "), oczekiwano 3 (2, 1)\n";
+    return imported == 3 && first == 2 && sixth == 1;
+}
+
+/// \brief Polecenie "check": sprawdzenia zachowania programu (m.in. klienta HTTP na lokalnym serwerze odtwarzającym
+/// z stations.json i dane.json). Bez nazw uruchamia wszystkie sprawdzenia.
+static int runCheck(int argc, char* argv[]) {
+    struct NamedCheck {
+        const char* name;
+        const char* description;
+        bool (*run)(int argc, char* argv[]);
+    };
+    static const NamedCheck checks[] = {
+        { "connections", "wczytanie stacji jednym połączeniem keep-alive", checkConnections },
+        { "delta", "synchronizacja przyrostowa przy przesuwanym oknie, 304 i korektach", checkDelta },
+        { "breaker", "bezpiecznik przy serwerze down/slow/up (zamknięty, otwarty, półotwarty, zamknięty)", checkBreaker },
+        { "chart", "obraz wykresu roku danych syntetycznych zgodny ze wzorcem", checkChart },
+        { "dates", "odrzucanie nieistniejących dat i znaków za datą w zakresie dat", checkDates },
+        { "migrate", "import starego dane.json z pominięciem uszkodzonych stacji i wpisów", checkMigrate },
+    };
+    std::vector<std::string> selected;
+    for (int i = 2; i < argc; ++i) { //nazwy sprawdzen - argumenty bez "--" (pomijajac wartosci opcji)
+        if (std::string(argv[i]).compare(0, 2, "--") == 0) { ++i; continue; }
+        selected.push_back(argv[i]);
+    }
+    for (const auto& name : selected)
+        if (std::none_of(std::begin(checks), std::end(checks), [&](const NamedCheck& c) { return name == c.name; })) {
+            std::cerr << "Nieznane sprawdzenie: " << name << "\n";
+            return 1;
+        }
+    int failed = 0;
+    for (const auto& c : checks) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), c.name) == selected.end()) continue;
+        std::cout << c.name << " - " << c.description << "\n";
+        bool ok = c.run(argc, argv);
+        std::cout << "  " << (ok ? "OK" : "BŁĄD") << "\n";
+        failed += ok ? 0 : 1;
+    }
+    return failed == 0 ? 0 : 1;
+}
+
+/// \brief Wykonuje polecenie command.
+/// \return Kod zakończenia programu.
+static int runCommand(const std::string& command, int argc, char* argv[]) {
+    if (command == "sync") return runSync(argc, argv);
+    if (command == "refresh") return runRefresh(argc, argv);
+    if (command == "select") return runSelect(argc, argv);
+    if (command == "startup") return runStartup(argc, argv);
+    if (command == "migrate") return runMigrate(argc, argv);
+    if (command == "cache") return runCache(argc, argv);
+    if (command == "stats") return runStats(argc, argv);
+    if (command == "rollup") return runRollup(argc, argv);
+    if (command == "search") return runSearch(argc, argv);
+    if (command == "alerts") return runAlerts(argc, argv);
+    if (command == "archive") return runArchive(argc, argv);
+    if (command == "export") return runExport(argc, argv);
+    if (command == "chart") return runChart(argc, argv);
+    if (command == "correlate") return runCorrelate(argc, argv);
+    if (command == "query") return runQuery(argc, argv);
+    if (command == "windows") return runWindows(argc, argv);
+    if (command == "decimate") return runDecimate(argc, argv);
+    if (command == "parse") return runParse(argc, argv);
+    if (command == "check") return runCheck(argc, argv);
+    if (command == "serve") return runServe(argc, argv);
+    if (command == "bench") return runBench(argc, argv);
+
+    printUsage();   //nieznane polecenie
+    return 1;
+}
+
+/// \brief Punkt wejścia narzędzia konsolowego.
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);    // Polskie znaki w konsoli
+#endif
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    std::string traceFile = getOption(argc, argv, "--trace", "");
+    Trace::setEnabled(!traceFile.empty());
+    int result = runCommand(argv[1], argc, argv);
+    if (!traceFile.empty()) {
+        std::cout << Trace::summary();
+        if (Trace::writeChromeTrace(traceFile)) std::cout << "Ślad zapisany do " << traceFile << "\n";
+    }
+    return result;
+}
@@ -5,11 +5,29 @@
 #include <windows.h>    //biblioteka od GUI
 #include <string>
 #include <vector>
-#include <set>          //potrafi automatycznie usuwac duplikaty
 #include <sstream>      //budowanie tekstow w pamieci
 #include <iomanip>      
 #include <algorithm>    //w projekcie tym do sortowania pomiarow wedlug daty
+#include <memory>
+#include <thread>       //odswiezanie listy stacji w tle
 #include "ApiClient.h"
+#include "MeasurementStore.h"
+#include "MeasurementSeries.h"
+#include "Statistics.h"
+#include "RollingWindow.h"
+#include "ChartLayout.h"
+#include "ChartGdi.h"
+#include "StationCache.h"
+#include "StationDiff.h"
+#include "StationIndex.h"
+#include "AlertEngine.h"
+#include "HistoryArchive.h"
+#include "FetchPipeline.h"
+#include "TimeUtils.h"
+#include "Trace.h"
+#include <fstream>
+#include <cstring>      //strstr
+#include <deque>
 
 #define IDC_COMBO_STATIONS     1001     //lista rozwijana stacji
 #define IDC_COMBO_METRICS      1002     //lista rozwijana miernikow
@@ -18,18 +36,69 @@
 #define IDC_BUTTON_CHART       1006     //przycisk pokaż wykres
 #define IDC_EDIT_START_DATE    1007     //pole edycji daty poczatkowej
 #define IDC_EDIT_END_DATE      1008     //pole edycji daty koncowej
+#define IDC_EDIT_SEARCH        1009     //pole wyszukiwania stacji
+#define IDC_CHECK_ALL_METRICS  1010     //pole wyboru "wszystkie mierniki na wykresie"
+#define WM_APP_STATION_REFRESHED (WM_APP + 1)   //odswiezenie stacji w tle zakonczone (lParam = id stacji)
+#define WM_APP_STATIONS_REFRESHED (WM_APP + 2)  //lista stacji z API pobrana w tle (lParam = std::vector<Station>*)
+#define WM_APP_STATION_LOADED (WM_APP + 3)      //dane wybranej stacji wczytane w tle (lParam = StationLoad*)
+#define WM_APP_ALERTS (WM_APP + 4)              //nowe alerty w kolejce silnika alertow
+#define IDT_TRACE_SUMMARY      2001     //zegar okresowego podsumowania pomiarow (uruchomienie z --trace)
 
 /// \brief Obiekt do komunikacji z API GIOŚ.
 ApiClient api;      //tworzy obiekt API
 
+/// \brief Silnik alertów zasilany pomiarami pobieranymi przez api (progi, skoki, anomalie).
+AlertEngine alerts;     //przed watkami tla, ktore do niego pisza - niszczony po nich
+
+/// \brief Ostatnie alerty odebrane w wątku okna (pokazywane w analizie stacji).
+std::deque<Alert> recentAlerts;
+
+/// \brief Lokalna baza pomiarów (segmenty stacji w katalogu "dane").
+MeasurementStore store("dane");     //zastepuje przepisywanie calego dane.json
+
+/// \brief Długoterminowe archiwum pomiarów (katalog "archiwum", starsze niż 90 dni jako zestawienia dobowe).
+HistoryArchive archive("archiwum");
+
 /// \brief Lista dostępnych stacji pomiarowych.
 std::vector<Station> stations;  //tworzy wektor do przechowywania
 
-/// \brief Lista wszystkich pomiarów dla wybranej stacji.
-std::vector<Measurement> allMeasurements;   //przechowuje dla dane dla stacji
+/// \brief Indeks wyszukiwania stacji (pozycje w wektorze stations, przebudowywany po zmianie listy).
+StationIndex stationIndex;
+
+/// \brief Pamięć podręczna pomiarów stacji (LRU do 64 MB, wpis świeży przez 10 minut, potem odświeżany w tle).
+StationCache stationCache(64u << 20, std::chrono::minutes(10));  //ponowny wybor stacji bez sieci i dysku
+
+/// \brief Pomiary wybranej stacji: lista pomiarów, serie mierników i nazwy mierników (np. PM10, PM2.5).
+StationCache::Entry currentStation;     //wspoldzielony z pamiecia podreczna (bez kopiowania)
+
+/// \brief Id wybranej stacji.
+std::string currentStationId;
+
+/// \brief Uchwyt głównego okna (adresat powiadomień z wątku odświeżania).
+HWND hMainWindow = NULL;
+
+/// \brief Wątek pobierający listę stacji z API po starcie (okno nie czeka na sieć).
+std::thread stationsRefresh;
+
+/// \brief Ustawiany przy zamykaniu okna - wątek odświeżania nie wysyła już wyniku (okno nie czeka na sieć).
+CancelToken stationsRefreshCancel;
+
+/// \brief Wątek importu starego dane.json przy pierwszym uruchomieniu (okno nie czeka na migrację).
+std::thread storeMigration;
+
+/// \brief Wynik wczytania stacji w tle przekazywany do wątku okna.
+struct StationLoad {
+    FetchPipeline::Ticket ticket = 0;   //numer zlecenia (spoznione wyniki sa odrzucane)
+    std::string key;                    //id stacji
+    StationCache::Entry entry;          //dane stacji
+    bool online = false;                //czy API odpowiedzialo
+};
 
-/// \brief Lista dostępnych nazw mierników (np. PM10, PM2.5).
-std::vector<std::string> availableMetrics;  //przechowuje liste miernikow
+/// \brief Wczytywanie wybranej stacji w tle: nowszy wybór anuluje poprzednie pobieranie.
+FetchPipeline stationLoads;     //po api, store i stationCache - niszczony przed nimi
+
+/// \brief Czy komunikat o trybie offline był już pokazany (raz na każdą przerwę w dostępie do API).
+bool offlineWarningShown = false;
 
 /// \brief Konwertuje std::string (UTF-8) na std::wstring (Unicode).
 /// \param str Tekst wejściowy w UTF-8.
@@ -41,39 +110,164 @@ std::wstring stringToWstring(const std::string& str) {  //funkcja konwertująca
     return wstr;    //zwraca przekonwertowany ciąg
 }
 
-/// \brief Sprawdza, czy dana data mieści się w zakresie podanym przez start i end.
-/// \param date Data pomiaru.
-/// \param start Data początkowa.
-/// \param end Data końcowa.
-/// \return true, jeśli data mieści się w zakresie.
-bool isWithinRange(const std::string& date, const std::string& start, const std::string& end) {     // sprawdza czy data mieści się w zakresie start–end
-    return (start.empty() || date >= start) && (end.empty() || date <= end);        // true jeśli data jest w zakresie lub jeśli brak ograniczenia (puste pola)
+/// \brief Konwertuje std::wstring (Unicode) na std::string (UTF-8).
+/// \param wstr Tekst wejściowy (np. z pola edycji).
+/// \return Tekst w UTF-8.
+std::string wstringToString(const std::wstring& wstr) {
+    int len = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, nullptr, 0, nullptr, nullptr);   // długość z końcowym zerem
+    std::string str(len, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, &str[0], len, nullptr, nullptr);
+    str.resize(len > 0 ? len - 1 : 0);  // bez końcowego zera
+    return str;
 }
 
 /// \brief Filtruje pomiary na podstawie nazwy miernika i zakresu dat.
 /// \param metric Nazwa miernika (np. PM10).
-/// \param startDate Data początkowa.
-/// \param endDate Data końcowa.
-/// \return Wektor przefiltrowanych pomiarów.
-std::vector<Measurement> FilterMeasurements(const std::string& metric, const std::string& startDate, const std::string& endDate) {      // Funkcja filtruje pomiary wg miernika i daty
-    std::vector<Measurement> filtered;      // Wektor na przefiltrowane pomiary
-    for (const auto& m : allMeasurements)   // Iteracja po wszystkich pomiarach stacji
-        if (m.name == metric && isWithinRange(m.date, startDate, endDate))      // Sprawdza nazwę miernika i czy mieści się w zakresie dat
-            filtered.push_back(m);      // Dodaj pomiar do listy wyników
-    std::sort(filtered.begin(), filtered.end(), [](const Measurement& a, const Measurement& b) {        // Sortuj pomiary rosnąco według daty
-        return a.date < b.date;
-        });
-    return filtered;  //zwraca pomiary
+/// \param start Początek zakresu (parseRangeBound).
+/// \param end Koniec zakresu (jw.).
+/// \return Widok pomiarów z zakresu (bez kopiowania) posortowany po czasie.
+SeriesView FilterMeasurements(const std::string& metric, int64_t start, int64_t end) {      // Funkcja filtruje pomiary wg miernika i daty
+    AQ_TRACE_SCOPE("gui.filter");
+    if (!currentStation) return SeriesView();
+    return currentStation->series.range(metric, start, end);    // wyszukiwanie binarne w indeksie czasowym
+}
+
+/// \brief Odczytuje zakres dat z pól "Data od" i "Data do".
+/// \param hEditStart Pole "Data od".
+/// \param hEditEnd Pole "Data do".
+/// \return false (po komunikacie dla użytkownika), jeśli którejś daty nie da się odczytać.
+bool ReadDateRange(HWND hEditStart, HWND hEditEnd, int64_t& start, int64_t& end) {     // Funkcja sprawdza wpisane daty
+    char startBuf[32], endBuf[32];      //bufory na daty
+    GetWindowTextA(hEditStart, startBuf, 32);       // Pobierz tekst z pola "Data od"
+    GetWindowTextA(hEditEnd, endBuf, 32);       // Pobierz tekst z pola "Data do"
+    if (parseRangeBound(startBuf, false, start) && parseRangeBound(endBuf, true, end)) return true;
+    MessageBox(NULL,            //okno z informacja o blednej dacie
+        L"Nie rozpoznano daty.\nDozwolone formaty: RRRR, RRRR-MM, RRRR-MM-DD lub RRRR-MM-DD GG:MM.\nPuste pole oznacza brak ograniczenia.",
+        L"Niepoprawna data",
+        MB_ICONWARNING | MB_OK);
+    return false;
+}
+
+/// \brief Pobiera nowe pomiary stacji (synchronizacja przyrostowa) i buduje wpis pamięci podręcznej.
+/// \param key Id stacji.
+/// \param previous Dotychczasowy wpis (nowe pomiary są do niego dokładane) lub nullptr.
+/// \param online Ustawiane na false, gdy API nie odpowiedziało.
+/// \param cancel Znacznik anulowania (nowszy wybór stacji) lub nullptr.
+/// \return Dane stacji (przy braku API - z lokalnej bazy); nullptr po anulowaniu.
+StationCache::Entry LoadStation(const std::string& key, const StationCache::Entry& previous, bool& online, const CancelToken* cancel = nullptr) {   // Wywoływana w wątkach tła
+    AQ_TRACE_SCOPE("gui.loadStation");
+    DeltaSyncResult delta = api.fetchStationDelta(std::atoi(key.c_str()), store.newestDates(key), cancel);  // Pobierz z API tylko pomiary nowsze niż zapisane
+    online = delta.online;
+    if (!delta.fresh.empty()) {
+        store.append(key, delta.fresh);     // Dopisz do bazy tylko nowe pomiary (także z przerwanego pobierania)
+        archive.append(key, delta.fresh);   // i do archiwum (API zwraca tylko ostatnie dni)
+    }
+    size_t corrected = delta.rechecked.empty() ? 0 : store.append(key, delta.rechecked);  // Wartości z ostatnich godzin poprawione przez GIOŚ (zapisywane tylko zmienione)
+    if (delta.cancelled) return nullptr;    // Wybrano inną stację - bez wczytywania historii
+
+    if (!previous || corrected > 0) return makeCachedStation(store.load(key));  // Historia z lokalnej bazy (razem z nowymi i poprawionymi pomiarami)
+    if (delta.fresh.empty()) return previous;   // Nic nowego - ten sam wpis z nowym czasem ważności
+    std::vector<Measurement> all = previous->measurements;     // Dotychczasowe pomiary i nowe
+    all.insert(all.end(), delta.fresh.begin(), delta.fresh.end());
+    return makeCachedStation(std::move(all));
+}
+
+/// \brief Wypełnia listę mierników wybranej stacji, zachowując wybrany miernik, jeśli nadal istnieje.
+/// \param hComboMetrics Uchwyt listy mierników.
+/// \param selected Nazwa miernika do zaznaczenia (pusta = pierwszy).
+void FillMetrics(HWND hComboMetrics, const std::string& selected) {
+    SendMessage(hComboMetrics, CB_RESETCONTENT, 0, 0);  // Wyczyść listę mierników w comboboxie
+    if (!currentStation) return;
+    int selIdx = 0;
+    for (size_t i = 0; i < currentStation->metrics.size(); ++i) {
+        SendMessage(hComboMetrics, CB_ADDSTRING, 0, (LPARAM)stringToWstring(currentStation->metrics[i]).c_str());    // Dodaj każdy miernik do listy
+        if (currentStation->metrics[i] == selected) selIdx = (int)i;
+    }
+    SendMessage(hComboMetrics, CB_SETCURSEL, selIdx, 0);      // Ustaw miernik jako wybrany
+}
+
+/// \brief Tekst stacji na liście rozwijanej.
+std::wstring StationLabel(const Station& s) {
+    return stringToWstring(s.name + " (" + s.province + ")");
 }
 
-/// \brief Wyświetla komunikat o pracy w trybie offline.
+/// \brief Pozycja stacji o podanym id na liście rozwijanej (id w danych pozycji) lub -1.
+int ComboIndexOf(HWND hComboStations, int id) {
+    int count = (int)SendMessage(hComboStations, CB_GETCOUNT, 0, 0);
+    for (int i = 0; i < count; ++i)
+        if ((int)SendMessage(hComboStations, CB_GETITEMDATA, i, 0) == id) return i;
+    return -1;
+}
+
+/// \brief Id stacji wybranej na liście rozwijanej lub -1.
+int SelectedStationId(HWND hComboStations) {
+    int sel = (int)SendMessage(hComboStations, CB_GETCURSEL, 0, 0);
+    return sel >= 0 ? (int)SendMessage(hComboStations, CB_GETITEMDATA, sel, 0) : -1;
+}
+
+/// \brief Wstawia stację na listę rozwijaną (pos = -1: na końcu) razem z jej id.
+void InsertStation(HWND hComboStations, int pos, const Station& s) {
+    int idx = (int)SendMessage(hComboStations, pos < 0 ? CB_ADDSTRING : CB_INSERTSTRING, pos < 0 ? 0 : pos, (LPARAM)StationLabel(s).c_str());
+    SendMessage(hComboStations, CB_SETITEMDATA, idx, (LPARAM)s.id);
+}
+
+/// \brief Wypełnia listę stacji wynikami wyszukiwania, zachowując wybraną stację, jeśli nadal pasuje.
+/// \param hComboStations Uchwyt listy stacji.
+/// \param query Tekst z pola "Szukaj" (pusty = wszystkie stacje).
+void FillStations(HWND hComboStations, const std::string& query) {
+    AQ_TRACE_SCOPE("gui.search");
+    int selectedId = currentStationId.empty() ? SelectedStationId(hComboStations) : std::atoi(currentStationId.c_str());  // Wczytana stacja wraca po poszerzeniu wyszukiwania
+    SendMessage(hComboStations, WM_SETREDRAW, FALSE, 0);    // Bez odmalowywania po każdej pozycji
+    SendMessage(hComboStations, CB_RESETCONTENT, 0, 0);
+    for (size_t pos : stationIndex.search(query)) InsertStation(hComboStations, -1, stations[pos]);
+    SendMessage(hComboStations, CB_SETCURSEL, ComboIndexOf(hComboStations, selectedId), 0);   // -1 = wybrana stacja nie pasuje
+    SendMessage(hComboStations, WM_SETREDRAW, TRUE, 0);
+    InvalidateRect(hComboStations, NULL, TRUE);
+}
+
+/// \brief Nakłada różnicę list stacji na listę rozwijaną bez jej przebudowy i zachowuje wybraną stację.
+/// \param hComboStations Uchwyt listy stacji.
+/// \param diff Różnica między wyświetlaną a pobraną listą.
+/// \param query Bieżący tekst wyszukiwania (nowe i zmienione stacje pokazywane tylko, jeśli pasują).
+void ApplyStationsUpdate(HWND hComboStations, const StationDiff& diff, const std::string& query) {
+    int selectedId = SelectedStationId(hComboStations);     // Id wybranej stacji
+    applyStationDiff(stations, diff);
+    stationIndex.build(stations);   // Pozycje w wektorze mogły się przesunąć
+
+    for (int id : diff.removed) {   // Usunięte stacje
+        int idx = ComboIndexOf(hComboStations, id);
+        if (idx >= 0) SendMessage(hComboStations, CB_DELETESTRING, idx, 0);
+    }
+    for (const auto& s : diff.renamed) {    // Zmienione nazwy - podmiana jednej pozycji
+        int idx = ComboIndexOf(hComboStations, s.id);
+        if (idx >= 0) SendMessage(hComboStations, CB_DELETESTRING, idx, 0);
+        if (stationMatches(s, query)) InsertStation(hComboStations, idx, s);
+    }
+    for (const auto& s : diff.added)      // Nowe stacje na końcu listy
+        if (stationMatches(s, query)) InsertStation(hComboStations, -1, s);
+
+    int newSel = ComboIndexOf(hComboStations, selectedId);
+    SendMessage(hComboStations, CB_SETCURSEL, newSel >= 0 || !query.empty() ? newSel : 0, 0);     // Ta sama stacja nadal wybrana
+}
+
+/// \brief Wyświetla komunikat o pracy w trybie offline (tylko przy pierwszym błędzie po utracie połączenia).
 void ShowOfflineWarning() {     // Funkcja pokazuje komunikat o trybie offline
+    if (offlineWarningShown) return;    // Kolejne stacje w trybie offline bez okna komunikatu
+    offlineWarningShown = true;
     MessageBox(NULL,            //tworzy okno z komunikatem ostrzeżenia
         L"Nie udało się pobrać danych z internetu.\nZostaną użyte dane z lokalnej bazy.\n\nTryb offline: niektóre funkcje mogą być ograniczone.",
         L"Tryb offline",
         MB_ICONWARNING | MB_OK);    //typ okna: ikonka ostrzezenia i przycisk ok
 }
 
+/// \brief Stan jednego okna wykresu (wskaźnik w GWLP_USERDATA okna, więc okien może być wiele).
+struct ChartWindow {
+    ChartModel model;           ///< Serie i układ wykresu (przeliczany tylko po zmianie danych lub rozmiaru)
+    HBITMAP bitmap = NULL;      ///< Narysowany wykres (WM_PAINT tylko go kopiuje)
+    int width = 0;              ///< Rozmiar bitmapy
+    int height = 0;
+};
+
 /// \brief Procedura obsługi okna wykresu.
 /// \param hwnd Uchwyt do okna.
 /// \param msg Typ komunikatu.
@@ -81,105 +275,85 @@ void ShowOfflineWarning() {     // Funkcja pokazuje komunikat o trybie offline
 /// \param lParam Parametr komunikatu.
 /// \return Wynik obsługi komunikatu.
 LRESULT CALLBACK ChartWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {  // Procedura obsługi i budowania wykresu
-    static std::vector<Measurement>* data; //wskaźnik do danych pomiarów do wykresu
-    static std::string metricName;  //nazwa miernika do tytułu wykresu
-
-    if (msg == WM_CREATE) {  //sprawdzenie czy tworzymy okno 
+    if (msg == WM_NCCREATE) {   // Pierwszy komunikat okna - zapamiętanie jego stanu
         CREATESTRUCT* cs = (CREATESTRUCT*)lParam;       //dostęp do danych przekazanych przy tworzeniu okna
-        data = (std::vector<Measurement>*)cs->lpCreateParams;       //pobiera dane pomiarowe przekazane przy tworzeniu okna
-        metricName = data->empty() ? "Wykres" : data->at(0).name;   //jesli nie ma miernika to Wykres
+        SetWindowLongPtr(hwnd, GWLP_USERDATA, (LONG_PTR)cs->lpCreateParams);
+        return DefWindowProc(hwnd, msg, wParam, lParam);
+    }
+    ChartWindow* chart = (ChartWindow*)GetWindowLongPtr(hwnd, GWLP_USERDATA);
+    if (!chart) return DefWindowProc(hwnd, msg, wParam, lParam);
+
+    if (msg == WM_SIZE) {   //zmiana rozmiaru - uklad i bitmapa do przeliczenia przy rysowaniu
+        InvalidateRect(hwnd, NULL, FALSE);
         return 0;
     }
 
+    if (msg == WM_ERASEBKGND) return 1;     // Tło rysuje bitmapa - bez migotania
+
     if (msg == WM_PAINT) {      // Obsługa rysowania wykresu
+        AQ_TRACE_SCOPE("gui.chartPaint");
         PAINTSTRUCT ps;     // Struktura do przechowywania info o rysowaniu
         HDC hdc = BeginPaint(hwnd, &ps);    // Start rysowania
         RECT rect;      //struktura przechowująca prostokąt gdzie bedzie rysowany wykres
         GetClientRect(hwnd, &rect);     // Pobierz rozmiar obszaru roboczego okna
-
-        const int padding = 60;     // Margines wewnętrzny od krawędzi okna
-        int width = rect.right - rect.left - 2 * padding;   // Szerokość obszaru wykresu (z marginesami)
-        int height = rect.bottom - rect.top - 2 * padding;  // Wysokość obszaru wykresu (z marginesami)
-
-        if (data->size() < 2) {     //sprawdza czy wystarczy danych do rysowania wykresu 
-            TextOut(hdc, padding, padding, L"Za mało danych do wyświetlenia wykresu.", 37);
-            EndPaint(hwnd, &ps);
-            return 0;
-        }
-
-        double minVal = data->at(0).value, maxVal = data->at(0).value;  // Inicjalizacja wartości min i max
-        for (const auto& m : *data) {       // Przejdź po wszystkich pomiarach
-            if (m.value < minVal) minVal = m.value;
-            if (m.value > maxVal) maxVal = m.value;
-        }
-
-        MoveToEx(hdc, padding, padding + height, NULL);     // Ustaw początek osi X
-        LineTo(hdc, padding + width, padding + height);     // Rysuj oś X (poziomą)
-        LineTo(hdc, padding + width, padding);              // Rysuj oś Y (pionową)
-
-        int count = data->size();       // Liczba punktów pomiarowych
-        for (int i = 0; i < count - 1; ++i) {       //rysowanie linii wykresu
-            int x1 = padding + (i * width) / (count - 1);   // Pozycja X pierwszego punktu
-            int y1 = padding + height - (int)((data->at(i).value - minVal) * height / (maxVal - minVal));       // Pozycja Y pierwszego punktu
-            int x2 = padding + ((i + 1) * width) / (count - 1);     // Pozycja X kolejnego punktu
-            int y2 = padding + height - (int)((data->at(i + 1).value - minVal) * height / (maxVal - minVal));   // Pozycja Y kolejnego punktu
-            MoveToEx(hdc, x1, y1, NULL);    // Ustaw start rysowania linii
-            LineTo(hdc, x2, y2);    // Rysuj linię do kolejnego punktu
-        }
-
-        for (int i = 0; i <= 5; ++i) {      //rysowanie linii pomocniczych
-            int y = padding + i * height / 5;   // Oblicz pozycję Y dla linii siatki
-            MoveToEx(hdc, padding, y, NULL);    // Ustaw początek linii siatki
-            LineTo(hdc, padding + width, y);    // Rysuj poziomą linię siatki
-            double val = maxVal - i * (maxVal - minVal) / 5;    // Oblicz wartość liczbową dla linii siatki
-            std::wstringstream ss;  // Strumień do budowy tekstu (na osi Y)
-            ss << std::fixed << std::setprecision(1) << val;        //zaokrąglenie
-            TextOut(hdc, 5, y - 10, ss.str().c_str(), ss.str().length());   // Wyświetl wartość
-        }
-
-        int step = (count > 10) ? count / 10 : 1;   // Co ile punktów pokazywać godziny
-        for (int i = 0; i < count; i += step) {     // Pętla do rysowania etykiet czasu na osi X
-            int x = padding + (i * width) / (count - 1);        // Oblicz pozycję X dla etykiety godziny
-            std::wstring hour = stringToWstring(data->at(i).date.substr(11, 5));        //godzina i data na wstring
-            TextOut(hdc, x - 15, padding + height + 5, hour.c_str(), hour.length());    // Wyświetl godzinę
+        int width = rect.right - rect.left, height = rect.bottom - rect.top;
+        HDC memory = CreateCompatibleDC(hdc);   // Rysowanie poza ekranem
+        if (!chart->bitmap || chart->width != width || chart->height != height) {   // Nowy rozmiar - nowy układ i obraz
+            if (chart->bitmap) DeleteObject(chart->bitmap);
+            chart->bitmap = CreateCompatibleBitmap(hdc, width, height);
+            chart->width = width;
+            chart->height = height;
+            HGDIOBJ old = SelectObject(memory, chart->bitmap);
+            {
+                GdiCanvas canvas(memory, width, height);
+                renderChart(chart->model.layout(width, height), canvas);
+            }
+            SelectObject(memory, old);
         }
-
-        std::string startDate = data->front().date;     //data pierwszego pomiaru
-        std::string endDate = data->back().date;        //data ostatniego pomiaru
-        std::wstring title = stringToWstring("Wykres " + metricName + " [" + startDate + " - " + endDate + "]"); // Stwórz tytuł wykresu z nazwą miernika i datami
-        TextOut(hdc, padding + 80, 10, title.c_str(), title.length());      // Wyświetl tytuł wykresu
-
-        TextOut(hdc, 10, padding - 30, L"Stężenie [µg/m³]", 17);    // Wyświetl etykietę osi Y (jednostki)
-        TextOut(hdc, padding + width / 2 - 15, padding + height + 30, L"Czas", 4);  // Wyświetl etykietę osi X (Czas)
-
+        HGDIOBJ old = SelectObject(memory, chart->bitmap);
+        BitBlt(hdc, ps.rcPaint.left, ps.rcPaint.top, ps.rcPaint.right - ps.rcPaint.left, ps.rcPaint.bottom - ps.rcPaint.top,
+            memory, ps.rcPaint.left, ps.rcPaint.top, SRCCOPY);     // Tylko odsłonięty fragment
+        SelectObject(memory, old);
+        DeleteDC(memory);
         EndPaint(hwnd, &ps);    //koniec rysowania
         return 0;
     }
 
+    if (msg == WM_NCDESTROY) {  // Ostatni komunikat okna - zwolnienie jego stanu
+        SetWindowLongPtr(hwnd, GWLP_USERDATA, 0);
+        if (chart->bitmap) DeleteObject(chart->bitmap);
+        delete chart;
+        return DefWindowProc(hwnd, msg, wParam, lParam);
+    }
+
     return DefWindowProc(hwnd, msg, wParam, lParam);    // Przekazuje komunikat do domyślnej procedury okna
 }
 
-/// \brief Tworzy i wyświetla okno wykresu z danymi pomiarowymi.
-/// \param data Wektor pomiarów do przedstawienia na wykresie.
-void ShowChartWindow(const std::vector<Measurement>& data) {    // Funkcja do wyświetlania okna z wykresem
-    WNDCLASS wc = {}; // Zerowanie wszystkich pól struktury klasy okna przed wypełnieniem
-    wc.lpfnWndProc = ChartWndProc;      // Ustaw procedurę obsługi zdarzeń okna wykresu
-    wc.hInstance = GetModuleHandle(NULL);
-    wc.lpszClassName = L"ChartWindowClass";     // Ustaw nazwę klasy okna
-    RegisterClass(&wc);     // Rejestruje klasę okna w systemi
+/// \brief Tworzy i wyświetla okno wykresu (komunikaty obsługuje pętla głównego okna).
+/// \param series Serie mierników do przedstawienia na wykresie (kilka = wspólne osie i legenda).
+void ShowChartWindow(std::vector<ChartSeries> series) {    // Funkcja do wyświetlania okna z wykresem
+    static bool registered = false;
+    if (!registered) {
+        WNDCLASS wc = {}; // Zerowanie wszystkich pól struktury klasy okna przed wypełnieniem
+        wc.lpfnWndProc = ChartWndProc;      // Ustaw procedurę obsługi zdarzeń okna wykresu
+        wc.hInstance = GetModuleHandle(NULL);
+        wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+        wc.lpszClassName = L"ChartWindowClass";     // Ustaw nazwę klasy okna
+        registered = RegisterClass(&wc) != 0;     // Rejestruje klasę okna w systemie (raz)
+    }
 
+    ChartWindow* chart = new ChartWindow();     // Zwalniany w WM_NCDESTROY
+    chart->model.setSeries(std::move(series));
     HWND hwnd = CreateWindowEx(0, L"ChartWindowClass", L"Wykres pomiarów",
         WS_OVERLAPPEDWINDOW, CW_USEDEFAULT, CW_USEDEFAULT, 800, 500,
-        NULL, NULL, GetModuleHandle(NULL), (LPVOID)&data);      //tworzy nowe okno, ustawia szerokosc i wysokosc, styl, nadaje tytul
+        NULL, NULL, GetModuleHandle(NULL), (LPVOID)chart);      //tworzy nowe okno, ustawia szerokosc i wysokosc, styl, nadaje tytul
+    if (!hwnd) {
+        delete chart;
+        return;
+    }
 
     ShowWindow(hwnd, SW_SHOW);      // Pokaż okno wykresu
     UpdateWindow(hwnd);       // Wymuś odświeżenie okna
-
-    MSG msg;       //przechownie komunikatu
-    while (GetMessage(&msg, nullptr, 0, 0)) {   //Petla komunikatow (czeka na komunikat od systemu np. kliknieciie, odswiezenie)
-        TranslateMessage(&msg);     //tlumaczy komunikaty klawiatury na czytelne znaki
-        DispatchMessage(&msg);      // wysyla komunikat do pordecury ChartWndProc
-    }
 }
 
 /// \brief Procedura obsługi głównego okna aplikacji.
@@ -189,10 +363,14 @@ void ShowChartWindow(const std::vector<Measurement>& data) {    // Funkcja do wy
 /// \param lParam Parametr komunikatu.
 /// \return Wynik obsługi komunikatu.
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) { //odpowiada za wszystkie zdarzenia glownego okna, tworzenie przyciskow kontrolek
-    static HWND hComboStations, hComboMetrics, hButtonAnalyze, hButtonChart, hEditAnalysis, hEditStartDate, hEditEndDate;   //deklaracja zmiennych
+    static HWND hEditSearch, hComboStations, hComboMetrics, hButtonAnalyze, hButtonChart, hCheckAllMetrics, hEditAnalysis, hEditStartDate, hEditEndDate;   //deklaracja zmiennych
 
     switch (msg) {  //rozpoczęcie obslugi roznych typow komunikatow
     case WM_CREATE:
+        //pole wyszukiwania stacji (nazwa lub wojewodztwo, bez polskich znakow)
+        CreateWindow(L"STATIC", L"Szukaj:", WS_CHILD | WS_VISIBLE, 50, 5, 80, 20, hwnd, NULL, NULL, NULL);
+        hEditSearch = CreateWindowEx(WS_EX_CLIENTEDGE, L"EDIT", NULL, WS_CHILD | WS_VISIBLE | ES_AUTOHSCROLL,
+            150, 5, 400, 20, hwnd, (HMENU)IDC_EDIT_SEARCH, NULL, NULL);
         //lista rozwijana stacji
         hComboStations = CreateWindow(L"COMBOBOX", NULL, WS_CHILD | WS_VISIBLE | CBS_DROPDOWNLIST | WS_VSCROLL,
             50, 30, 500, 200, hwnd, (HMENU)IDC_COMBO_STATIONS, NULL, NULL);
@@ -213,103 +391,182 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) { //
         //Przycisk "Pokaz wykres"
         hButtonChart = CreateWindow(L"BUTTON", L"Pokaż wykres", WS_TABSTOP | WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
             220, 160, 150, 30, hwnd, (HMENU)IDC_BUTTON_CHART, NULL, NULL);
+        //pole wyboru - wszystkie mierniki stacji na jednym wykresie
+        hCheckAllMetrics = CreateWindow(L"BUTTON", L"Wszystkie mierniki", WS_TABSTOP | WS_VISIBLE | WS_CHILD | BS_AUTOCHECKBOX,
+            390, 165, 160, 20, hwnd, (HMENU)IDC_CHECK_ALL_METRICS, NULL, NULL);
         //Pole tekstowe z wynikami analizy
         hEditAnalysis = CreateWindowEx(WS_EX_CLIENTEDGE, L"EDIT", NULL,
-            WS_CHILD | WS_VISIBLE | ES_MULTILINE | ES_AUTOVSCROLL | ES_READONLY,
+            WS_CHILD | WS_VISIBLE | WS_VSCROLL | ES_MULTILINE | ES_AUTOVSCROLL | ES_READONLY,
             50, 210, 500, 200, hwnd, (HMENU)IDC_EDIT_ANALYSIS, NULL, NULL);
 
-        stations = api.getAllStations();    // Pobierz listę wszystkich stacji z API GIOŚ
-        if (stations.empty()) { //Jesli nie udalo sie pobrac z API to wczytujemy z bazy
-            stations = api.loadStationsFromFile("stations.json");
-            ShowOfflineWarning();
-        }
-        else {      //Gdy pobranie się powiodlo
-            api.saveStationsToFile(stations, "stations.json");
-        }
+        hMainWindow = hwnd;
+        api.setMeasurementListener([](int stationId, const std::vector<Measurement>& measurements) {   // Każde pobranie zasila alerty
+            if (alerts.ingest(stationId, measurements) > 0) PostMessage(hMainWindow, WM_APP_ALERTS, 0, 0);
+        });
+        stations = api.loadStationsFromFile("stations.json");   // Lokalna lista stacji od razu - bez czekania na API
+        stationsRefresh = std::thread([]() {    // Lista z API GIOŚ pobierana w tle
+            std::vector<Station>* fresh = new std::vector<Station>(api.getAllStations());
+            if (stationsRefreshCancel.cancelled() || !PostMessage(hMainWindow, WM_APP_STATIONS_REFRESHED, 0, (LPARAM)fresh))
+                delete fresh;   // Okno już zamknięte
+        });
+        if (store.stationIds().empty())     //pierwsze uruchomienie z nowa baza - import starego dane.json w tle
+            storeMigration = std::thread([]() { store.migrateFromJson("dane.json"); });     // append pomija pomiary juz pobrane z API
         
-        for (const auto& s : stations) { //Petla ktora wypełnia liste nazwami i wojewodztwami danej stacji
-            std::wstring name = stringToWstring(s.name + " (" + s.province + ")");
-            SendMessage(hComboStations, CB_ADDSTRING, 0, (LPARAM)name.c_str());
-        }
+        stationIndex.build(stations);   // Indeks wyszukiwania budowany raz po wczytaniu listy
+        FillStations(hComboStations, "");   // Wszystkie stacje z id w danych pozycji
         SendMessage(hComboStations, CB_SETCURSEL, 0, 0);  //domyślnie ustawia pierwszą stacje
         break;
 
     case WM_COMMAND:    //Obsługa zdarzeń kontrolek (np. zmiana wyboru, kliknięcie przycisku)
+        if (LOWORD(wParam) == IDC_EDIT_SEARCH && HIWORD(wParam) == EN_CHANGE) {     // Każda wpisana litera zawęża listę stacji
+            wchar_t searchBuf[128];
+            GetWindowTextW(hEditSearch, searchBuf, 128);
+            FillStations(hComboStations, wstringToString(searchBuf));
+            break;
+        }
+
         if (LOWORD(wParam) == IDC_COMBO_STATIONS && HIWORD(wParam) == CBN_SELCHANGE) {      // Obsługa zdarzenia zmiany wyboru stacji
-            int idx = SendMessage(hComboStations, CB_GETCURSEL, 0, 0);   // Pobierz indeks wybranej stacji
-            if (idx < 0) break;     // Jeśli nic nie wybrano, przerwij obsługę
-            int stationId = stations[idx].id;       // Pobierz ID wybranej stacji
-            allMeasurements = api.getMeasurementsForStation(stationId); // Pobierz pomiary dla wybranej stacji z API
-            if (allMeasurements.empty()) {  // Wczytaj dane lokalnie jesli nie udalo sie z API
-                allMeasurements = api.loadMeasurementsFromFile(std::to_string(stationId), "dane.json");
-                ShowOfflineWarning();   // Pokaż komunikat, że działamy w trybie offline
+            int stationId = SelectedStationId(hComboStations);   // Pobierz ID wybranej stacji (dane pozycji listy)
+            if (stationId < 0) break;     // Jeśli nic nie wybrano, przerwij obsługę
+            std::string key = std::to_string(stationId);
+            StationCache::Lookup hit = stationCache.lookup(key);    // Najpierw pamięć podręczna
+            currentStationId = key;
+            if (hit.state == StationCache::State::Miss) {   // Pierwszy wybór stacji - pobranie w tle, okno działa dalej
+                currentStation = nullptr;
+                FillMetrics(hComboMetrics, "");     // Pusta lista mierników do czasu wczytania
+                SetWindowTextA(hEditAnalysis, "Wczytywanie danych stacji...");
+                stationLoads.submit<StationLoad>(
+                    [key](const CancelToken& cancel) {
+                        StationLoad load;
+                        load.key = key;
+                        load.entry = LoadStation(key, nullptr, load.online, &cancel);
+                        return load;
+                    },
+                    [](FetchPipeline::Ticket ticket, StationLoad& load) {
+                        load.ticket = ticket;
+                        StationLoad* result = new StationLoad(std::move(load));
+                        if (!PostMessage(hMainWindow, WM_APP_STATION_LOADED, 0, (LPARAM)result)) delete result;     // Okno już zamknięte
+                    });
+                break;
             }
-            else {      //jesli API działa
-                api.saveMeasurementsToFile(allMeasurements, std::to_string(stationId), "dane.json");    // Zapisz pobrane dane do pliku
+            stationLoads.cancelAll();   // Stacja z pamięci podręcznej - wcześniejsze pobieranie jest już zbędne
+            if (hit.state == StationCache::State::Stale) {    // Przeterminowany wpis - pokazany od razu, odświeżany w tle
+                stationCache.refreshAsync(key,
+                    [](const std::string& id, const StationCache::Entry& previous) {
+                        bool online = true;
+                        StationCache::Entry entry = LoadStation(id, previous, online);
+                        return online ? entry : StationCache::Entry();  // Bez API wpis zostaje przeterminowany
+                    },
+                    [](const std::string& id) {
+                        PostMessage(hMainWindow, WM_APP_STATION_REFRESHED, 0, (LPARAM)std::atoi(id.c_str()));  // Aktualizacja w wątku okna
+                    });
             }
-
-            std::set<std::string> unique;   //unikalne nazwy merników
-            for (const auto& m : allMeasurements) unique.insert(m.name);    // Zbierz unikalne nazwy mierników
-            availableMetrics.assign(unique.begin(), unique.end());  // Przenieś unikalne mierniki do wektora
-
-            SendMessage(hComboMetrics, CB_RESETCONTENT, 0, 0);  // Wyczyść listę mierników w comboboxie
-            for (const auto& m : availableMetrics)
-                SendMessage(hComboMetrics, CB_ADDSTRING, 0, (LPARAM)stringToWstring(m).c_str());    // Dodaj każdy miernik do listy
-            SendMessage(hComboMetrics, CB_SETCURSEL, 0, 0);      // Ustaw pierwszy miernik jako domyślnie wybrany
+            currentStation = hit.entry;
+            FillMetrics(hComboMetrics, "");     // Pierwszy miernik jako domyślnie wybrany
         }
 
         if (LOWORD(wParam) == IDC_BUTTON_ANALYZE || LOWORD(wParam) == IDC_BUTTON_CHART) {  //sprawdza czy uzytkownik kiknal w jeden z dwoch przyciskow
             int mIdx = SendMessage(hComboMetrics, CB_GETCURSEL, 0, 0);      // Pobierz indeks wybranego miernika
-            if (mIdx < 0 || mIdx >= availableMetrics.size()) break;     //sprawdza czy uzytkownik na pewno wybral jakis miernik
-            char startBuf[32], endBuf[32];      //bufory na daty
-            GetWindowTextA(hEditStartDate, startBuf, 32);       // Pobierz tekst z pola "Data od"
-            GetWindowTextA(hEditEndDate, endBuf, 32);       // Pobierz tekst z pola "Data do"
+            if (!currentStation || mIdx < 0 || mIdx >= (int)currentStation->metrics.size()) break;     //sprawdza czy uzytkownik na pewno wybral jakis miernik
+            int64_t start, end;     //zakres dat z pol edycji
+            if (!ReadDateRange(hEditStartDate, hEditEndDate, start, end)) break;      // Niepoprawna data - komunikat zamiast pelnego zakresu
 
-            auto filtered = FilterMeasurements(availableMetrics[mIdx], startBuf, endBuf);       // Filtrowanie danych wg miernika i zakresu dat
+            auto filtered = FilterMeasurements(currentStation->metrics[mIdx], start, end);       // Filtrowanie danych wg miernika i zakresu dat
 
             if (LOWORD(wParam) == IDC_BUTTON_ANALYZE) {     //sprawdza czy uzytkownik klkinal analize
+                AQ_TRACE_SCOPE("gui.analysis");
                 if (filtered.size() < 2) {      //Sprawdza czy wystarczy danych
                     SetWindowTextA(hEditAnalysis, "Za mało danych.");
                     break;
                 }
 
-                double sum = 0, min = filtered[0].value, max = filtered[0].value;       //srednia, min, max
-                std::string dmin = filtered[0].date, dmax = filtered[0].date;           //daty do min i max
-                for (const auto& m : filtered) {  //przygotowanie powyzszych danych do analizy
-                    sum += m.value;
-                    if (m.value < min) { min = m.value; dmin = m.date; }
-                    if (m.value > max) { max = m.value; dmax = m.date; }
-                }
-
-                std::string firstDate = filtered.front().date;  //data pierwszego pomiaru
-                std::string lastDate = filtered.back().date;    //data ostatniego pomiaru  
-                std::string trend;
-                //Oblicza tendencję zmian stężenia na podstawie pierwszego i ostatniego pomiaru
-                if (filtered.front().value < filtered.back().value)
-                    trend = "Tendencja: wzrostowa ";
-                else if (filtered.front().value > filtered.back().value)
-                    trend = "Tendencja: malejąca ";
-                else
-                    trend = "Tendencja: brak zmian";
-
-                std::ostringstream oss;
-                oss << std::fixed << std::setprecision(2);
-                oss << "Analiza - " << availableMetrics[mIdx] << "\r\n"
-                    << "Zakres: " << firstDate << " - " << lastDate << "\r\n"
-                    << "Średnia: " << sum / filtered.size() << " µg/m^3\r\n"
-                    << "Min: " << min << " (" << dmin << ")\r\n"
-                    << "Max: " << max << " (" << dmax << ")\r\n"
-                    << trend << "\r\n";
-
-                SetWindowTextA(hEditAnalysis, oss.str().c_str());   //Wyświetl analizę w polu tekstowym
+                SeriesStatistics stats = computeStatistics(filtered, defaultLimits(currentStation->metrics[mIdx]));   //srednia, min/max z datami, percentyle, przekroczenia, trend
+                std::string report = formatStatisticsReport(currentStation->metrics[mIdx], stats, "\r\n");
+                report += formatWindowReport(computeWindows(filtered), defaultDailyLimit(currentStation->metrics[mIdx]), "\r\n");   //srednie kroczace 24h/8h i doby powyzej normy
+                std::string alertLines;     // Alerty tej stacji i miernika
+                for (const auto& a : recentAlerts)
+                    if (std::to_string(a.stationId) == currentStationId && MetricRegistry::name(a.metric) == currentStation->metrics[mIdx])
+                        alertLines += formatAlert(a) + "\r\n";
+                if (!alertLines.empty()) report += "\r\nAlerty:\r\n" + alertLines;
+                SetWindowTextA(hEditAnalysis, report.c_str());   //Wyświetl analizę w polu tekstowym
             }
             else {
-                if (filtered.size() >= 2) ShowChartWindow(filtered);// Jeśli kliknięto „Pokaż wykres” i są dane, otwórz okno
+                std::vector<ChartSeries> series;
+                if (SendMessage(hCheckAllMetrics, BM_GETCHECK, 0, 0) == BST_CHECKED) {     // Wszystkie mierniki na wspólnych osiach
+                    for (const auto& metric : currentStation->metrics) {
+                        SeriesView view = FilterMeasurements(metric, start, end);
+                        if (view.size() >= 2) series.push_back(makeChartSeries(view));
+                    }
+                }
+                else if (filtered.size() >= 2) series.push_back(makeChartSeries(filtered));
+                if (!series.empty()) ShowChartWindow(std::move(series));   // Jeśli kliknięto „Pokaż wykres” i są dane, otwórz okno
             }
         }
         break;
 
+    case WM_APP_STATION_LOADED: {   // Dane wybranej stacji wczytane w tle
+        std::unique_ptr<StationLoad> load((StationLoad*)lParam);     // Przejęcie danych z wątku
+        if (!stationLoads.isCurrent(load->ticket) || load->key != currentStationId || !load->entry) break;  // Wybrano już inną stację
+        if (load->online) {
+            stationCache.put(load->key, load->entry);
+            offlineWarningShown = false;    // Połączenie wróciło - następna przerwa znów z komunikatem
+        }
+        currentStation = load->entry;
+        FillMetrics(hComboMetrics, "");     // Pierwszy miernik jako domyślnie wybrany
+        SetWindowTextA(hEditAnalysis, "");
+        if (!load->online) ShowOfflineWarning();  // Pokaż komunikat, że działamy w trybie offline (dane z bazy)
+        break;
+    }
+
+    case WM_APP_ALERTS: {   // Odbiór alertów z kolejki (bez blokad) w wątku okna
+        Alert alert;
+        while (alerts.poll(alert)) {
+            recentAlerts.push_back(alert);
+            if (recentAlerts.size() > 200) recentAlerts.pop_front();    // Tylko ostatnie alerty
+        }
+        std::wstring title = L"Air Quality Monitor - alerty: " + std::to_wstring(alerts.stats().alerts);
+        SetWindowText(hwnd, title.c_str());
+        break;
+    }
+
+    case WM_TIMER:
+        if (wParam == IDT_TRACE_SUMMARY) {  // Okresowe podsumowanie pomiarów do pliku
+            std::ofstream out("trace_summary.txt", std::ios::app);
+            out << "--- " << Trace::nowUs() / 1000000 << " s ---\n" << Trace::summary("\n");
+        }
+        break;
+
+    case WM_APP_STATION_REFRESHED:     // Odświeżenie w tle zakończone
+        if (std::to_string((int)lParam) == currentStationId) {    // Tylko jeśli stacja jest nadal wybrana
+            StationCache::Lookup hit = stationCache.lookup(currentStationId);
+            if (hit.entry && hit.entry != currentStation) {
+                int mIdx = SendMessage(hComboMetrics, CB_GETCURSEL, 0, 0);
+                std::string selected = (currentStation && mIdx >= 0 && mIdx < (int)currentStation->metrics.size()) ? currentStation->metrics[mIdx] : "";
+                currentStation = hit.entry;
+                FillMetrics(hComboMetrics, selected);   // Nowe mierniki, ten sam wybór
+            }
+        }
+        break;
+
+    case WM_APP_STATIONS_REFRESHED: {   // Lista stacji z API gotowa
+        std::unique_ptr<std::vector<Station>> fresh((std::vector<Station>*)lParam);    // Przejęcie danych z wątku
+        if (fresh->empty()) {   // Nie udało się pobrać z API - zostaje lista lokalna
+            ShowOfflineWarning();
+            break;
+        }
+        offlineWarningShown = false;
+        StationDiff diff = diffStations(stations, *fresh);
+        if (diff.empty()) break;    // Lista bez zmian - nic do przebudowy ani zapisu
+        wchar_t searchBuf[128];
+        GetWindowTextW(hEditSearch, searchBuf, 128);
+        ApplyStationsUpdate(hComboStations, diff, wstringToString(searchBuf));  // Tylko dodane, usunięte i zmienione pozycje
+        api.saveStationsToFile(*fresh, "stations.json");
+        break;
+    }
+
     case WM_DESTROY:
+        stationLoads.cancelAll();   // Przerwij pobieranie wybranej stacji
+        stationsRefreshCancel.cancel();     // Bez czekania na sieć - wątek dołączany po pętli komunikatów
         PostQuitMessage(0); break;      // Zakończ aplikację, wyślij komunikat WM_QUIT
     }
 
@@ -322,8 +579,10 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) { //
 /// \param lpCmdLine Argumenty z linii poleceń.
 /// \param nCmdShow Parametr określający sposób wyświetlania okna.
 /// \return Kod zakończenia programu.
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {   // Główna funkcja uruchamiająca aplikację Windows
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR lpCmdLine, int nCmdShow) {   // Główna funkcja uruchamiająca aplikację Windows
     SetConsoleOutputCP(CP_UTF8);    // Ustaw kodowanie konsoli na UTF-8
+    bool trace = lpCmdLine && strstr(lpCmdLine, "--trace") != nullptr;     // Pomiary etapów: trace_summary.txt co minutę, trace.json po zamknięciu
+    Trace::setEnabled(trace);
     WNDCLASS wc = { };      // Zainicjalizuj strukturę klasy okna zerami
     wc.lpfnWndProc = WndProc;   //odpowiedzialna za przetwarzanie wszystkich komunikatów 
     wc.hInstance = hInstance;   // Ustaw uchwyt bieżącej aplikacji
@@ -334,6 +593,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {   // G
         WS_OVERLAPPEDWINDOW, CW_USEDEFAULT, CW_USEDEFAULT, 640, 500,
         NULL, NULL, hInstance, NULL);       //tworzy glowne okno aplikacji
 
+    if (trace) SetTimer(hwnd, IDT_TRACE_SUMMARY, 60 * 1000, NULL);
     ShowWindow(hwnd, nCmdShow);     // Pokaż główne okno aplikacji na ekranie
     UpdateWindow(hwnd);     // Wymuś natychmiastowe odmalowanie okna (wywołuje WM_PAINT)
 
@@ -342,5 +602,10 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {   // G
         TranslateMessage(&msg);     //przeksztalca surowe dane z klawiatury na dane tekstowe
         DispatchMessage(&msg);      //wysyla komunikat do funkcji WndProc
     }
+    if (storeMigration.joinable()) storeMigration.join();     // Migracja dopisuje do bazy - nie przerywamy jej w połowie
+    if (stationsRefresh.joinable()) stationsRefresh.join();     // Okno już zamknięte - czeka tylko proces
+    while (PeekMessage(&msg, nullptr, WM_APP_STATIONS_REFRESHED, WM_APP_STATIONS_REFRESHED, PM_REMOVE))
+        delete (std::vector<Station>*)msg.lParam;    // Wynik wysłany tuż przed zamknięciem okna
+    if (trace) Trace::writeChromeTrace("trace.json");   // Do otwarcia w chrome://tracing lub Perfetto
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,231 @@
+﻿#include "AlertEngine.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include "Statistics.h"     //defaultLimits
+#include "TimeUtils.h"
+#include "Trace.h"
+
+std::string formatAlert(const Alert& alert) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "Stacja " << alert.stationId << ", " << MetricRegistry::name(alert.metric) << ", "
+        << formatTimestamp(alert.timestamp).substr(0, 16) << ": " << alert.value;
+    switch (alert.kind) {
+    case AlertKind::Threshold: out << " - przekroczony próg " << alert.reference; break;
+    case AlertKind::RateOfChange: out << " - skok o " << alert.score << "/h (poprzednio " << alert.reference << ")"; break;
+    case AlertKind::Anomaly: out << " - odchylenie " << alert.score << " sigma od średniej " << alert.reference; break;
+    }
+    return out.str();
+}
+
+std::vector<AlertRule> defaultAlertRules() {
+    std::vector<AlertRule> result;
+    const struct { const char* metric; double rise; } defaults[] = { { "PM10", 150.0 }, { "PM2.5", 100.0 }, { "NO2", 150.0 } };
+    for (const auto& d : defaults) {
+        AlertRule rule;
+        rule.metric = d.metric;
+        rule.threshold = defaultLimits(d.metric).front();   //pierwsza norma (poziom dopuszczalny)
+        rule.maxRisePerHour = d.rise;
+        rule.zScore = 6.0;
+        result.push_back(rule);
+    }
+    return result;
+}
+
+AlertQueue::AlertQueue(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    cells.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+    mask = size - 1;
+}
+
+bool AlertQueue::push(const Alert& alert) {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = cells[pos & mask];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) { //komorka wolna - rezerwacja pozycji
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.alert = alert;
+                cell.sequence.store(pos + 1, std::memory_order_release); //widoczna dla konsumenta
+                return true;
+            }
+        }
+        else if (diff < 0) return false; //pelna
+        else pos = enqueuePos.load(std::memory_order_relaxed); //inny producent byl szybszy
+    }
+}
+
+bool AlertQueue::pop(Alert& alert) {
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = cells[pos & mask];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                alert = cell.alert;
+                cell.sequence.store(pos + mask + 1, std::memory_order_release); //wolna w nastepnym okrazeniu
+                return true;
+            }
+        }
+        else if (diff < 0) return false; //pusta
+        else pos = dequeuePos.load(std::memory_order_relaxed);
+    }
+}
+
+AlertEngine::AlertEngine(size_t queueCapacity) : queue(queueCapacity) {
+    setRules(defaultAlertRules());
+}
+
+void AlertEngine::setRules(const std::vector<AlertRule>& newRules) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    rules = newRules;
+    ruleByMetric.clear();
+    for (size_t i = 0; i < rules.size(); ++i) {
+        uint16_t id = MetricRegistry::intern(rules[i].metric);
+        if (id == MetricRegistry::invalid) continue; //rejestr pelny - regula bez miernika
+        if (id >= ruleByMetric.size()) ruleByMetric.resize(id + 1, -1);
+        ruleByMetric[id] = (int)i;
+    }
+    states.clear();
+}
+
+size_t AlertEngine::ingest(int stationId, const std::vector<Measurement>& measurements) {
+    std::vector<CompactMeasurement> compact;
+    compact.reserve(measurements.size());
+    const std::string* lastName = nullptr;
+    uint16_t lastId = 0;
+    for (const auto& m : measurements) {
+        CompactMeasurement c;
+        if (!parseTimestamp(m.date, c.timestamp)) {
+            skipped++;
+            continue;
+        }
+        if (!lastName || *lastName != m.name) { //pomiary czujnika przychodza razem - jedno wyszukanie na serie
+            lastName = &m.name;
+            lastId = MetricRegistry::intern(m.name);
+        }
+        if (lastId == MetricRegistry::invalid) { //rejestr pelny
+            skipped++;
+            continue;
+        }
+        c.metric = lastId;
+        c.value = m.value;
+        compact.push_back(c);
+    }
+    std::stable_sort(compact.begin(), compact.end(), [](const CompactMeasurement& a, const CompactMeasurement& b) {
+        return a.metric != b.metric ? a.metric < b.metric : a.timestamp < b.timestamp; //API zwraca od najnowszych
+    });
+    return ingest(stationId, compact.data(), compact.size());
+}
+
+size_t AlertEngine::ingest(int stationId, const CompactMeasurement* data, size_t count) {
+    AQ_TRACE_SCOPE("alerts.ingest");
+    size_t produced = 0, evaluated = 0, ignored = 0;
+    std::lock_guard<std::mutex> lock(stateMutex);
+    SeriesState* state = nullptr;
+    int stateMetric = -1;
+    for (size_t i = 0; i < count; ++i) {
+        const CompactMeasurement& m = data[i];
+        int rule = m.metric < ruleByMetric.size() ? ruleByMetric[m.metric] : -1;
+        if (rule < 0) {
+            ignored++;
+            continue;
+        }
+        if (m.metric != stateMetric) { //stan serii szukany raz na miernik
+            state = &states[(uint64_t)(uint32_t)stationId << 16 | m.metric];
+            if (state->ring.size() != rules[rule].window) state->ring.assign(rules[rule].window, 0.0);
+            stateMetric = m.metric;
+        }
+        if (m.timestamp <= state->lastTime) { //juz oceniony (powtorzone pobranie) lub spozniony
+            ignored++;
+            continue;
+        }
+        produced += evaluate(stationId, rules[rule], *state, m);
+        evaluated++;
+    }
+    points += evaluated;
+    skipped += ignored;
+    return produced;
+}
+
+void AlertEngine::emit(const Alert& alert, size_t& produced) {
+    if (queue.push(alert)) {
+        alerts++;
+        produced++;
+    }
+    else dropped++;
+}
+
+size_t AlertEngine::evaluate(int stationId, const AlertRule& rule, SeriesState& state, const CompactMeasurement& m) {
+    size_t produced = 0;
+    Alert alert;
+    alert.stationId = stationId;
+    alert.metric = m.metric;
+    alert.timestamp = m.timestamp;
+    alert.value = m.value;
+
+    if (rule.threshold > 0) { //tylko przejscie przez prog, nie kazdy pomiar powyzej
+        if (!state.above && m.value > rule.threshold) {
+            alert.kind = AlertKind::Threshold;
+            alert.reference = rule.threshold;
+            emit(alert, produced);
+            state.above = true;
+        }
+        else if (state.above && m.value < rule.threshold * (1.0 - rule.hysteresis)) state.above = false;
+    }
+
+    if (rule.maxRisePerHour > 0 && state.lastTime != (std::numeric_limits<int64_t>::min)()) {
+        double hours = std::max((m.timestamp - state.lastTime) / 3600.0, 1.0); //pomiary godzinowe
+        double rise = (m.value - state.lastValue) / hours;
+        if (rise > rule.maxRisePerHour) {
+            alert.kind = AlertKind::RateOfChange;
+            alert.reference = state.lastValue;
+            alert.score = rise;
+            emit(alert, produced);
+        }
+    }
+
+    if (rule.zScore > 0 && !state.ring.empty()) {
+        if (state.filled >= rule.minPoints) { //srednia i odchylenie z sum okna
+            double mean = state.sum / state.filled;
+            double variance = std::max(state.sumSq / state.filled - mean * mean, 0.0);
+            double deviation = std::max(std::sqrt(variance), rule.minDeviation);
+            double z = (m.value - mean) / deviation;
+            if (std::fabs(z) > rule.zScore) {
+                alert.kind = AlertKind::Anomaly;
+                alert.reference = mean;
+                alert.score = z;
+                emit(alert, produced);
+            }
+        }
+        if (state.filled == state.ring.size()) { //najstarsza wartosc wypada z okna
+            double old = state.ring[state.next];
+            state.sum -= old;
+            state.sumSq -= old * old;
+        }
+        else state.filled++;
+        state.ring[state.next] = m.value;
+        state.sum += m.value;
+        state.sumSq += m.value * m.value;
+        state.next = (state.next + 1) % state.ring.size();
+    }
+
+    state.lastTime = m.timestamp;
+    state.lastValue = m.value;
+    return produced;
+}
+
+AlertEngineStats AlertEngine::stats() const {
+    AlertEngineStats s;
+    s.points = points;
+    s.skipped = skipped;
+    s.alerts = alerts;
+    s.dropped = dropped;
+    return s;
+}
@@ -0,0 +1,129 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ApiClient.h"          //Measurement
+#include "MeasurementSeries.h"  //CompactMeasurement, MetricRegistry
+
+/// Rodzaj alertu.
+enum class AlertKind {
+    Threshold,      ///< Wartość przekroczyła próg (po wcześniejszym pomiarze poniżej progu)
+    RateOfChange,   ///< Wzrost szybszy niż dopuszczalny na godzinę (fizycznie mało prawdopodobny skok)
+    Anomaly         ///< Wartość odległa od średniej ostatnich pomiarów o więcej niż zScore odchyleń
+};
+
+/// Alert dla jednego pomiaru.
+struct Alert {
+    int stationId = -1;
+    uint16_t metric = 0;        ///< Id miernika z MetricRegistry
+    AlertKind kind = AlertKind::Threshold;
+    int64_t timestamp = 0;      ///< Czas pomiaru (sekundy, TimeUtils.h)
+    double value = 0.0;         ///< Wartość pomiaru
+    double reference = 0.0;     ///< Próg / poprzednia wartość / średnia okna (zależnie od rodzaju)
+    double score = 0.0;         ///< Przyrost na godzinę (RateOfChange) lub z-score (Anomaly)
+};
+
+/// Opis alertu po polsku (stacja, miernik, data, wartość, przyczyna).
+std::string formatAlert(const Alert& alert);
+
+/// Reguły jednego miernika. Wartość <= 0 wyłącza daną regułę.
+struct AlertRule {
+    std::string metric;             ///< Nazwa miernika (np. "PM10")
+    double threshold = 0.0;         ///< Próg [µg/m³]; alert przy przejściu powyżej, ponownie dopiero po spadku poniżej progu
+    double hysteresis = 0.1;        ///< Jaki ułamek progu trzeba zejść poniżej, zanim próg znów da alert (bez migotania)
+    double maxRisePerHour = 0.0;    ///< Największy wiarygodny wzrost na godzinę [µg/m³/h]
+    double zScore = 0.0;            ///< Próg odchylenia od średniej kroczącej (w odchyleniach standardowych)
+    size_t window = 24;             ///< Liczba ostatnich pomiarów do średniej i odchylenia
+    size_t minPoints = 12;          ///< Najmniej pomiarów w oknie, zanim reguła z-score zacznie działać
+    double minDeviation = 5.0;      ///< Dolna granica odchylenia [µg/m³] (prawie stała seria nie daje alertu przy drobnej zmianie)
+};
+
+/// Domyślne reguły: progi z defaultLimits dla PM10, PM2.5 i NO2, skoki i z-score 6.
+std::vector<AlertRule> defaultAlertRules();
+
+/// Ograniczona kolejka alertów bez blokad (wielu producentów i konsumentów, komórki z numerem sekwencji).
+/// Pełna kolejka odrzuca nowy alert zamiast czekać.
+class AlertQueue {
+public:
+    /// Pojemność zaokrąglana w górę do potęgi dwójki.
+    explicit AlertQueue(size_t capacity);
+
+    /// Dodaje alert; false, gdy kolejka jest pełna.
+    bool push(const Alert& alert);
+
+    /// Pobiera najstarszy alert; false, gdy kolejka jest pusta.
+    bool pop(Alert& alert);
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        Alert alert;
+    };
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    std::atomic<size_t> enqueuePos{ 0 };
+    char padding[64];   //producenci i konsumenci na osobnych liniach pamieci podrecznej
+    std::atomic<size_t> dequeuePos{ 0 };
+};
+
+/// Liczniki silnika alertów.
+struct AlertEngineStats {
+    size_t points = 0;      ///< Pomiary ocenione regułami
+    size_t skipped = 0;     ///< Pomiary bez reguły, starsze niż ostatni ocenione lub z błędną datą
+    size_t alerts = 0;      ///< Wygenerowane alerty
+    size_t dropped = 0;     ///< Alerty odrzucone przy pełnej kolejce
+};
+
+/// Przyrostowy silnik alertów: każdy nowy pomiar jest oceniany w czasie O(1) względem stanu serii
+/// (stacja, miernik) - ostatniej wartości, stanu progu i sum okna kroczącego. Alerty trafiają do AlertQueue.
+/// Pomiary serii muszą przychodzić w kolejności czasu; starsze lub powtórzone są pomijane,
+/// więc można podawać tę samą historię wiele razy (np. pełne pobranie stacji).
+class AlertEngine {
+public:
+    explicit AlertEngine(size_t queueCapacity = 4096);
+
+    /// Zastępuje reguły (stan serii jest czyszczony).
+    void setRules(const std::vector<AlertRule>& rules);
+
+    /// Ocenia pomiary stacji (np. nowe pomiary z ApiClient); sortuje je po mierniku i czasie.
+    /// \return Liczba nowych alertów.
+    size_t ingest(int stationId, const std::vector<Measurement>& measurements);
+
+    /// Ocenia pomiary w postaci zwartej (posortowane po czasie w obrębie miernika).
+    /// \return Liczba nowych alertów.
+    size_t ingest(int stationId, const CompactMeasurement* data, size_t count);
+
+    /// Pobiera najstarszy alert z kolejki; false, gdy brak alertów.
+    bool poll(Alert& alert) { return queue.pop(alert); }
+
+    AlertEngineStats stats() const;
+
+private:
+    /// Stan jednej serii (stacja, miernik).
+    struct SeriesState {
+        int64_t lastTime = (std::numeric_limits<int64_t>::min)();
+        double lastValue = 0.0;
+        bool above = false;         //po alercie progu, do spadku ponizej progu z histereza
+        std::vector<double> ring;   //ostatnie wartosci (okno z-score)
+        size_t next = 0;            //miejsce nastepnej wartosci w ring
+        size_t filled = 0;
+        double sum = 0.0;
+        double sumSq = 0.0;
+    };
+
+    size_t evaluate(int stationId, const AlertRule& rule, SeriesState& state, const CompactMeasurement& m); //wywolywane pod stateMutex
+    void emit(const Alert& alert, size_t& produced);
+
+    std::mutex stateMutex;                                  ///< Chroni reguły i stan serii (blokada raz na paczkę pomiarów)
+    std::vector<AlertRule> rules;
+    std::vector<int> ruleByMetric;                          ///< Id miernika -> indeks reguły (-1 = brak)
+    std::unordered_map<uint64_t, SeriesState> states;       ///< (stacja << 16 | miernik) -> stan
+    AlertQueue queue;
+    std::atomic<size_t> points{ 0 }, skipped{ 0 }, alerts{ 0 }, dropped{ 0 };
+};
@@ -1,21 +1,82 @@
 ﻿#include "ApiClient.h"  //dołączenie pliku naglowkowego
-#include <httplib.h>              // Do łączenia się z API GIOŚ
 #include <nlohmann/json.hpp>     // Biblioteka do obsługi JSON
 #include <iostream>
 #include <fstream>
+#include <thread>                // Wątki puli połączeń
+#include <atomic>                // Wspólny licznik kolejki czujników
+#include <algorithm>
+#include <iterator>
+#include <chrono>
+#include "WorkStealingPool.h"   // Pula wątków dla synchronizacji wszystkich stacji
+#include "GiosReaders.h"        // Strumieniowe czytniki odpowiedzi API
+#include "HttpSession.h"        // Połączenia z API GIOŚ (keep-alive)
+#include "Trace.h"              // Pomiary czasu etapów
 
 using json = nlohmann::json;     // Skrót (zamiast całej nazwy wystarcza json)
 
+ApiClient::ApiClient(const std::string& baseUrl) : baseUrl(baseUrl), session(new HttpSessionPool(baseUrl)) {}
+
+ApiClient::~ApiClient() = default;
+
+void ApiClient::setMaxConcurrency(int limit) {
+    maxConcurrency = std::max(1, limit); //co najmniej jedno połączenie
+    session->setMaxIdle(std::max<size_t>(8, (size_t)maxConcurrency)); //kazdy watek moze oddac polaczenie do puli
+}
+
+void ApiClient::setRequestTimeout(int milliseconds) {
+    session->setConnectTimeout(milliseconds);
+    session->setReadTimeout(milliseconds);
+}
+
+void ApiClient::setConnectTimeout(int milliseconds) {
+    session->setConnectTimeout(milliseconds);
+}
+
+void ApiClient::setCorrectionWindow(int hours) {
+    correctionHours = std::max(0, hours);
+}
+
+void ApiClient::setReadTimeout(int milliseconds) {
+    session->setReadTimeout(milliseconds);
+}
+
+void ApiClient::setCompression(bool enabled) {
+    session->setCompression(enabled);
+}
+
+HttpSessionStats ApiClient::sessionStats() const {
+    return session->stats();
+}
+
+bool ApiClient::isOnline() const {
+    return session->serverAvailable();
+}
+
+CircuitBreakerStats ApiClient::connectionHealth() const {
+    return session->health();
+}
+
+void ApiClient::setCircuitBreaker(const CircuitBreakerOptions& options) {
+    session->setBreakerOptions(options);
+}
+
+void ApiClient::retryConnection() {
+    session->resetBreaker();
+}
+
+void ApiClient::setMeasurementListener(MeasurementListener listener) {
+    measurementListener = std::move(listener);
+}
+
 //Pierwsze metody w kodzie są odpowiedzialne za poprawne pobranie danych dzięki API
 
 
 /// Pobiera surową odpowiedź JSON ze wszystkimi stacjami.
 std::string ApiClient::getAllStationsRaw() {  //zawierać bedzie wszystkie dane stacji pomiarowych
-    httplib::Client cli(baseUrl.c_str());                     // Tworzy klienta HTTP
-    auto res = cli.Get("/pjp-api/rest/station/findAll");      // Żądanie GET
-
-    if (res && res->status == 200) {                            //Sprawdza czy nie ma błedu
-        return res->body;                                     // Zwraca treść odpowiedzi
+    AQ_TRACE_SCOPE("api.getAllStationsRaw");
+    std::string body;
+    if (session->get("/pjp-api/rest/station/findAll", body)) {  // Żądanie GET przez otwarte połączenie
+        return body;                                          // Zwraca treść odpowiedzi
     }
     else {
         std::cout << "Brak odpowiedzi z serwera!\n";
@@ -23,81 +84,240 @@ std::string ApiClient::getAllStationsRaw() {  //zawierać bedzie wszystkie dane
     }
 }
 
+/// Pobiera listę stacji strumieniowo - każda stacja trafia do odbiorcy zaraz po wczytaniu.
+bool ApiClient::streamAllStations(const std::function<void(const Station&)>& onStation) {
+    AQ_TRACE_SCOPE("api.streamAllStations");
+    StationStreamReader reader(onStation);                    // Czytnik stacji (bez drzewa JSON)
+    return fetchJson("/pjp-api/rest/station/findAll", reader, nullptr);
+}
+
 /// Parsuje listę stacji z JSON do obiektów Station.
 std::vector<Station> ApiClient::getAllStations() { //zwraca liste stacji jako wektor obiektów Station
-    std::string data = getAllStationsRaw(); //pobiera surowy JSON
     std::vector<Station> stations;  //tworzy wektor obiektow typu Station
-
-    try {
-        json parsed = json::parse(data);                      // Parsuje JSON
-        for (const auto& s : parsed) { //petla przechodzi przez wszystkie elementy JSON parsed
-            Station station;
-            station.id = s.value("id", -1);                   // Bezpieczne odczytywanie pól
-            station.name = s.value("stationName", "Brak nazwy");
-            station.province = s["city"]["commune"].value("provinceName", "Nieznany");  //wojewodztwa lub nieznany
-            stations.push_back(station);                      // Dodaje stacje do listy
-        }
-    }
-    catch (const std::exception& e) { //wychwytuje błąd parsowania JSON
-        std::cerr << "Błąd JSON: " << e.what() << "\n";
+    if (!streamAllStations([&](const Station& s) { stations.push_back(s); })) {
+        std::cout << "Brak odpowiedzi z serwera!\n";
+        stations.clear(); //niekompletna lista jest odrzucana
     }
-
     return stations; //zwraca liste stacji
 }
 
+/// Wykonuje żądanie GET przez sesję i przekazuje treść odpowiedzi kawałkami do parsera, bez buforowania całości.
+bool ApiClient::fetchJson(const std::string& path, JsonHandler& handler, size_t* bytes) {
+    AQ_TRACE_SCOPE("http.get");
+    Trace::SplitTimer parseTime("json.parse");  //czas parsowania oddzielnie od czasu sieci
+    JsonStreamParser parser(handler);
+    bool ok = session->get(path, [&](const char* data, size_t size) { //odbiornik tresci - dane prosto do parsera
+        if (bytes) *bytes += size;
+        AQ_TRACE_COUNT("http.bytes", size);
+        parseTime.start();
+        bool parsed = parser.feed(data, size); //blad skladni przerywa pobieranie
+        parseTime.stop();
+        return parsed;
+    });
+    if (!ok) return false; //brak odpowiedzi lub blad serwera
+    if (!parser.finish()) {
+        std::cerr << "Błąd JSON: " << parser.error() << "\n";
+        return false;
+    }
+    return true;
+}
+
 /// Pobiera ID czujników dla wybranej stacji.
 std::vector<int> ApiClient::getSensorIdsForStation(int stationId) { // Funkcja pobierająca ID czujników dla danej stacji
-    httplib::Client cli(baseUrl.c_str());
+    AQ_TRACE_SCOPE("api.getSensorIdsForStation");
     std::string path = "/pjp-api/rest/station/sensors/" + std::to_string(stationId); //tworzy sciezke do czujnikow
     std::vector<int> sensorIds; //wektor na id  czujnikow
-
-    auto res = cli.Get(path.c_str());                         // Zapytanie o czujniki GET
-
-    if (res && res->status == 200) { //sprawdzanie czy odpowiedz jest poprawna
-        try {
-            auto jsonData = json::parse(res->body); //parsowanie do obiektu
-            for (const auto& sensor : jsonData) //petla po wszystkich
-                sensorIds.push_back(sensor.value("id", -1));  // Dodaj ID czujnika
-        }
-        catch (...) {
-            std::cerr << "Błąd parsowania czujników.\n";
-        }
-    }
-
+    SensorListStreamReader reader(sensorIds);
+    if (!fetchJson(path, reader, nullptr)) return {}; //sprawdzanie czy odpowiedz jest poprawna
     return sensorIds;
 }
 
 /// Pobiera pomiary ze wszystkich czujników danej stacji.
 std::vector<Measurement> ApiClient::getMeasurementsForStation(int stationId) { //pobiera wszystkie pomiary dla danej stacji 
-    std::vector<Measurement> results; //wektor na ppomiary stacji
+    AQ_TRACE_SCOPE("api.getMeasurementsForStation");
     std::vector<int> sensorIds = getSensorIdsForStation(stationId);
-    httplib::Client cli(baseUrl.c_str());
-
-    for (int sensorId : sensorIds) { //iteracja po ID wszystkich czujnikow danej stacji
-        std::string path = "/pjp-api/rest/data/getData/" + std::to_string(sensorId);
-        auto res = cli.Get(path.c_str()); //zapytanie do API dla czujnika
-
-        if (res && res->status == 200) { //sprawdzenie czy ok
-            try {
-                auto jsonData = json::parse(res->body); //parsowanie 
-                std::string paramName = jsonData.value("key", "Nieznany"); //(key = PM10, Co, NO2)
-
-                for (const auto& val : jsonData["values"]) { //petla przez kazdy obiekt
-                    if (!val["value"].is_null()) { //sprawdza czy pole nie jest puste
-                        Measurement m;
-                        m.name = paramName; //nazwa parametru
-                        m.date = val.value("date", "brak daty"); 
-                        m.value = val.value("value", 0.0);
-                        results.push_back(m); //dodanie pomiaru o wynikow
-                    }
+    std::vector<std::vector<Measurement>> perSensor(sensorIds.size()); //osobny wynik dla kazdego czujnika (zachowuje kolejnosc)
+
+    forEachParallel(sensorIds.size(), [&](size_t i) {
+        std::string path = "/pjp-api/rest/data/getData/" + std::to_string(sensorIds[i]);
+        std::vector<Measurement> sensor;
+        SensorDataStreamReader reader([&](const Measurement& m) { sensor.push_back(m); });
+        if (fetchJson(path, reader, nullptr)) { //zapytanie do API dla czujnika
+            reader.flush();
+            perSensor[i] = std::move(sensor);
+        }
+    });
+
+    std::vector<Measurement> results; //wektor na ppomiary stacji
+    for (auto& sensor : perSensor) //laczenie wynikow w kolejnosci czujnikow
+        results.insert(results.end(), std::make_move_iterator(sensor.begin()), std::make_move_iterator(sensor.end()));
+    AQ_TRACE_COUNT("api.records", results.size());
+    if (measurementListener && !results.empty()) measurementListener(stationId, results);
+    return results;
+}
+
+/// Wykonuje fn(0..count-1) na co najwyżej maxConcurrency wątkach pobierających indeksy ze wspólnej kolejki.
+void ApiClient::forEachParallel(size_t count, const std::function<void(size_t)>& fn) {
+    std::atomic<size_t> next(0); //wspolna kolejka - indeks kolejnego czujnika do pobrania
+    auto worker = [&]() { //jeden watek = jedno polaczenie HTTP naraz (z puli sesji)
+        for (size_t i = next++; i < count; i = next++) fn(i); //dopoki kolejka nie jest pusta
+    };
+
+    size_t workerCount = std::min(count, (size_t)maxConcurrency); //nie wiecej watkow niz czujnikow
+    if (workerCount <= 1) {
+        worker(); //tryb sekwencyjny - bez tworzenia watkow
+        return;
+    }
+    std::vector<std::thread> pool;
+    for (size_t i = 0; i < workerCount; ++i) pool.emplace_back(worker);
+    for (auto& t : pool) t.join(); //czekamy na wszystkie polaczenia
+}
+
+/// Żądanie warunkowe z walidatorami zapamiętanymi dla ścieżki; treść parsowana strumieniowo.
+HttpFetch ApiClient::fetchJsonConditional(const std::string& path, JsonHandler& handler, const CancelToken* cancel) {
+    HttpValidators validators;
+    {
+        std::lock_guard<std::mutex> lock(deltaMutex);
+        auto it = pathValidators.find(path);
+        if (it != pathValidators.end()) validators = it->second;
+    }
+    AQ_TRACE_SCOPE("http.getConditional");
+    Trace::SplitTimer parseTime("json.parse");
+    JsonStreamParser parser(handler);
+    HttpFetch result = session->getConditional(path, validators, [&](const char* data, size_t size) {
+        if (cancel && cancel->cancelled()) return false; //przerwanie transferu - wynik nieaktualny
+        AQ_TRACE_COUNT("http.bytes", size);
+        parseTime.start();
+        bool parsed = parser.feed(data, size);
+        parseTime.stop();
+        return parsed;
+    });
+    if (result == HttpFetch::Ok && !parser.finish()) {
+        std::cerr << "Błąd JSON: " << parser.error() << "\n";
+        return HttpFetch::Failed;
+    }
+    if (result == HttpFetch::Ok) {
+        std::lock_guard<std::mutex> lock(deltaMutex);
+        pathValidators[path] = validators; //kolejne zadanie moze dostac 304
+    }
+    return result;
+}
+
+/// Pobiera tylko pomiary nowsze niż zapisane w bazie.
+DeltaSyncResult ApiClient::fetchStationDelta(int stationId, const std::map<std::string, std::string>& newestDates, const CancelToken* cancel) {
+    AQ_TRACE_SCOPE("api.fetchStationDelta");
+    DeltaSyncResult result;
+    std::string listPath = "/pjp-api/rest/station/sensors/" + std::to_string(stationId);
+    std::vector<int> sensorIds;
+    SensorListStreamReader listReader(sensorIds);
+    HttpFetch listFetch = fetchJsonConditional(listPath, listReader, cancel);
+    {
+        std::lock_guard<std::mutex> lock(deltaMutex);
+        if (listFetch == HttpFetch::Ok) sensorCache[stationId] = sensorIds;
+        else if (listFetch == HttpFetch::NotModified) sensorIds = sensorCache[stationId]; //lista czujnikow bez zmian
+    }
+    if (listFetch == HttpFetch::Failed || (listFetch == HttpFetch::NotModified && sensorIds.empty())) {
+        std::lock_guard<std::mutex> lock(deltaMutex);
+        pathValidators.erase(listPath); //nastepnym razem pelne zadanie
+        result.cancelled = cancel && cancel->cancelled();
+        return result; //brak polaczenia - tryb offline
+    }
+    result.online = true;
+    result.sensors = sensorIds.size();
+
+    struct SensorDelta {
+        std::vector<Measurement> fresh;
+        std::vector<Measurement> rechecked;
+        size_t known = 0;
+        HttpFetch fetch = HttpFetch::Failed;
+    };
+    std::vector<SensorDelta> perSensor(sensorIds.size());
+    forEachParallel(sensorIds.size(), [&](size_t i) {
+        SensorDelta& out = perSensor[i];
+        if (cancel && cancel->cancelled()) return; //pozostale czujniki bez laczenia
+        SensorDataStreamReader reader([&](const Measurement& m) { out.fresh.push_back(m); });
+        reader.setWatermarks(&newestDates); //starsze pomiary nie sa nawet kopiowane
+        //GIOŚ poprawia wartosci z ostatnich godzin bez zmiany daty - sam znacznik "data <= najnowsza" by je pominal
+        reader.setRecheckWindow((int64_t)correctionHours * 3600, [&](const Measurement& m) { out.rechecked.push_back(m); });
+        out.fetch = fetchJsonConditional("/pjp-api/rest/data/getData/" + std::to_string(sensorIds[i]), reader, cancel);
+        if (out.fetch != HttpFetch::Ok) { out.fresh.clear(); out.rechecked.clear(); return; }
+        reader.flush();
+        out.known = reader.skipped();
+    });
+
+    for (auto& sensor : perSensor) { //laczenie wynikow w kolejnosci czujnikow
+        if (sensor.fetch == HttpFetch::NotModified) result.unchangedSensors++;
+        else if (sensor.fetch == HttpFetch::Failed) result.failedSensors++;
+        result.knownPoints += sensor.known;
+        result.fresh.insert(result.fresh.end(), std::make_move_iterator(sensor.fresh.begin()), std::make_move_iterator(sensor.fresh.end()));
+        result.rechecked.insert(result.rechecked.end(), std::make_move_iterator(sensor.rechecked.begin()), std::make_move_iterator(sensor.rechecked.end()));
+    }
+    result.newPoints = result.fresh.size();
+    result.cancelled = cancel && cancel->cancelled();
+    AQ_TRACE_COUNT("api.records", result.newPoints);
+    AQ_TRACE_COUNT("api.knownRecords", result.knownPoints);
+    if (measurementListener && !result.fresh.empty()) measurementListener(stationId, result.fresh); //takze z przerwanego pobierania
+    return result;
+}
+
+/// Pobiera pomiary wszystkich stacji z użyciem puli wątków z podkradaniem zadań.
+std::map<int, std::vector<Measurement>> ApiClient::syncAllStations(const std::vector<Station>& stations, SyncStats& stats, unsigned threadCount) {
+    AQ_TRACE_SCOPE("api.syncAllStations");
+    struct StationJob {                                   //stan pobierania jednej stacji
+        int stationId = -1;
+        std::vector<std::vector<Measurement>> perSensor;  //wyniki w kolejnosci czujnikow
+    };
+    std::vector<StationJob> jobs(stations.size());
+    std::atomic<size_t> sensors(0), measurements(0), bytes(0), failed(0); //liczniki wspoldzielone przez watki
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        WorkStealingPool pool(threadCount);
+        for (size_t i = 0; i < stations.size(); ++i) {
+            jobs[i].stationId = stations[i].id;
+            pool.submit([&, i]() { //zadanie 1: lista czujnikow stacji
+                StationJob& job = jobs[i];
+                std::vector<int> sensorIds;
+                SensorListStreamReader sensorReader(sensorIds);
+                size_t received = 0;
+                bool ok = fetchJson("/pjp-api/rest/station/sensors/" + std::to_string(job.stationId), sensorReader, &received);
+                bytes += received;
+                if (!ok) { failed++; return; }
+                job.perSensor.resize(sensorIds.size()); //rozmiar ustalony przed zleceniem zadan czujnikow
+
+                for (size_t s = 0; s < sensorIds.size(); ++s) {
+                    int sensorId = sensorIds[s];
+                    pool.submit([&, i, s, sensorId]() { //zadanie 2: dane jednego czujnika (moga byc podkradzione)
+                        std::vector<Measurement>& out = jobs[i].perSensor[s];
+                        SensorDataStreamReader dataReader([&](const Measurement& m) { out.push_back(m); });
+                        size_t received = 0;
+                        bool ok = fetchJson("/pjp-api/rest/data/getData/" + std::to_string(sensorId), dataReader, &received);
+                        bytes += received;
+                        if (!ok) { out.clear(); failed++; return; }
+                        dataReader.flush();
+                        measurements += jobs[i].perSensor[s].size();
+                        sensors++;
+                    });
                 }
-            }
-            catch (...) {
-                std::cerr << "Błąd danych pomiarowych.\n"; 
-            }
+            });
         }
+        pool.wait(); //czeka na caly lancuch zaleznosci
+    }
+
+    std::map<int, std::vector<Measurement>> results;
+    for (auto& job : jobs) { //skladanie wynikow stacji
+        std::vector<Measurement>& out = results[job.stationId];
+        for (auto& sensor : job.perSensor)
+            out.insert(out.end(), std::make_move_iterator(sensor.begin()), std::make_move_iterator(sensor.end()));
+        if (measurementListener && !out.empty()) measurementListener(job.stationId, out);
     }
 
+    stats.stations = stations.size();
+    stats.sensors = sensors;
+    stats.measurements = measurements;
+    stats.bytes = bytes;
+    stats.failedRequests = failed;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
     return results;
 }
 
@@ -105,6 +325,7 @@ std::vector<Measurement> ApiClient::getMeasurementsForStation(int stationId) { /
 
 /// Zapisuje pomiary do pliku JSON w podkluczu stacji.
 bool ApiClient::saveMeasurementsToFile(const std::vector<Measurement>& measurements, const std::string& stationId, const std::string& filename) {
+    AQ_TRACE_SCOPE("file.saveMeasurements");
     json allData;
 
     // Wczytaj plik, jeśli istnieje
@@ -139,8 +360,40 @@ bool ApiClient::saveMeasurementsToFile(const std::vector<Measurement>& measureme
     }
 }
 
+/// Zapisuje pomiary wielu stacji jednym odczytem i zapisem pliku.
+bool ApiClient::saveAllMeasurementsToFile(const std::map<int, std::vector<Measurement>>& measurements, const std::string& filename) {
+    AQ_TRACE_SCOPE("file.saveAllMeasurements");
+    json allData;
+
+    std::ifstream inFile(filename); // Wczytaj plik, jeśli istnieje
+    if (inFile.is_open()) {
+        try { inFile >> allData; }
+        catch (...) { allData = json::object(); }
+        inFile.close();
+    }
+
+    for (const auto& station : measurements) { //kazda stacja pod wlasnym kluczem
+        if (station.second.empty()) continue;  //nie nadpisujemy danych stacji, ktorej nie udalo sie pobrac
+        json measurementArray = json::array();
+        for (const auto& m : station.second)
+            measurementArray.push_back({ {"name", m.name}, {"date", m.date}, {"value", m.value} });
+        allData[std::to_string(station.first)] = measurementArray;
+    }
+
+    try {
+        std::ofstream outFile(filename);
+        if (!outFile.is_open()) return false;
+        outFile << allData.dump(4);
+        return true;
+    }
+    catch (...) {
+        return false;
+    }
+}
+
 /// Wczytuje pomiary z pliku JSON (po kluczu stacji).
 std::vector<Measurement> ApiClient::loadMeasurementsFromFile(const std::string& stationId, const std::string& filename) {
+    AQ_TRACE_SCOPE("file.loadMeasurements");
     std::vector<Measurement> measurements; //wektor przechowujaca pomiary z pliku
     json j; //zmienna przechowujaca dane JSON
 
@@ -168,6 +421,7 @@ std::vector<Measurement> ApiClient::loadMeasurementsFromFile(const std::string&
 
 /// Zapisuje listę stacji do pliku JSON.
 bool ApiClient::saveStationsToFile(const std::vector<Station>& stations, const std::string& filename) {
+    AQ_TRACE_SCOPE("file.saveStations");
     json j; //przechowuje dane JSON dla stacji
 
     for (const auto& s : stations) { //konwersja na plik json
@@ -192,27 +446,24 @@ bool ApiClient::saveStationsToFile(const std::vector<Station>& stations, const s
 
 /// Wczytuje stacje z pliku JSON.
 std::vector<Station> ApiClient::loadStationsFromFile(const std::string& filename) {
+    AQ_TRACE_SCOPE("file.loadStations");
     std::vector<Station> stations;
 
-    try {
-        //proba otwarcia pliku
-        std::ifstream file(filename);
-        if (!file.is_open()) return stations;
-
-        json j;
-        file >> j; //wczytanie zawartosci pliku do j
-
-        for (const auto& s : j) { //iteracja po kazdym elemencie
-            Station st; //tworzy zmienna do wypelnienia danymi
-            st.id = s.value("id", -1);
-            st.name = s.value("name", "Brak");
-            st.province = s.value("province", "Nieznany");
-            stations.push_back(st); //dodaje obiekt st do wektora stations
-        }
+    //proba otwarcia pliku
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) return stations;
+
+    StationStreamReader reader([&](const Station& s) { stations.push_back(s); }); //ten sam czytnik co dla API, bez drzewa JSON
+    JsonStreamParser parser(reader);
+    char buffer[64 * 1024];
+    bool ok = true;
+    while (ok && file) { //plik czytany kawalkami
+        file.read(buffer, sizeof(buffer));
+        ok = parser.feed(buffer, (size_t)file.gcount());
     }
-    catch (...) {
+    if (!ok || !parser.finish()) {
         std::cerr << "Błąd wczytywania stacji z pliku JSON.\n";
+        stations.clear();
     }
-
     return stations;
 }
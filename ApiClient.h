@@ -2,6 +2,14 @@
 
 #include <string> //biblioteka tekstów i znaków
 #include <vector> //bliblioteka dynamicznej listy
+#include <map>    //mapa stacja -> pomiary
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "HttpSession.h"   //sesja HTTP z ponownym uzyciem polaczen
+#include "FetchPipeline.h"  //CancelToken
+
+class JsonHandler;
 
 /// Reprezentuje stację pomiarową.
 struct Station {   //struktura stacji popmiarowej 
@@ -17,12 +25,91 @@ struct Measurement { //struktura jednego czujnika(PM10,CO2)
     double value = 0.0;  //wartosc zmierzonego parametru                       ///< Wartość pomiaru w µg/m³
 };
 
+/// Statystyki masowej synchronizacji wszystkich stacji.
+struct SyncStats {
+    size_t stations = 0;        ///< Liczba przetworzonych stacji
+    size_t sensors = 0;         ///< Liczba pobranych czujników
+    size_t measurements = 0;    ///< Liczba pobranych pomiarów
+    size_t bytes = 0;           ///< Liczba bajtów odebranych z API
+    size_t failedRequests = 0;  ///< Liczba nieudanych żądań HTTP
+    double seconds = 0.0;       ///< Całkowity czas synchronizacji [s]
+
+    double stationsPerSecond() const { return seconds > 0 ? stations / seconds : 0.0; }  ///< Przepustowość w stacjach/s
+    double sensorsPerSecond() const { return seconds > 0 ? sensors / seconds : 0.0; }    ///< Przepustowość w czujnikach/s
+    double bytesPerSecond() const { return seconds > 0 ? bytes / seconds : 0.0; }        ///< Przepustowość w bajtach/s
+};
+
+/// Wynik synchronizacji przyrostowej jednej stacji.
+struct DeltaSyncResult {
+    std::vector<Measurement> fresh; ///< Pomiary nowsze niż zapisane w bazie
+    std::vector<Measurement> rechecked; ///< Pomiary z okna korekt (ApiClient::setCorrectionWindow) - już zapisane daty,
+                                        ///< których wartość GIOŚ mógł poprawić; MeasurementStore::append zapisze tylko zmienione
+    size_t newPoints = 0;           ///< Liczba nowych pomiarów
+    size_t knownPoints = 0;         ///< Pomiary z datami już zapisanymi (pominięte lub w rechecked)
+    size_t sensors = 0;             ///< Liczba czujników stacji
+    size_t unchangedSensors = 0;    ///< Czujniki bez zmian od poprzedniego pobrania (odpowiedź 304, bez danych)
+    size_t failedSensors = 0;       ///< Czujniki, których nie udało się pobrać
+    bool online = false;            ///< Czy API odpowiedziało (false = tryb offline)
+    bool cancelled = false;         ///< Przerwane znacznikiem anulowania (fresh zawiera tylko pobrane do tej pory czujniki)
+};
+
+/// Odbiorca pomiarów pobranych z API (id stacji, pomiary) - np. AlertEngine::ingest.
+/// Wywoływany w wątku pobierającym, więc musi być bezpieczny wątkowo.
+using MeasurementListener = std::function<void(int stationId, const std::vector<Measurement>& measurements)>;
+
 /// Klasa do komunikacji z API GIOŚ oraz obsługi danych lokalnych.
 class ApiClient {  //klasa odpowiedzialna za komunikacje API z GIOŚ, zapisywanie do bazy lokalnej
 public:
+    /// Tworzy klienta dla podanego adresu API (domyślnie serwer GIOŚ, np. lokalny serwer testowy).
+    explicit ApiClient(const std::string& baseUrl = "http://api.gios.gov.pl");
+    ~ApiClient();
+
+    /// Ustawia maksymalną liczbę równoległych połączeń przy pobieraniu pomiarów (1 = pobieranie po kolei).
+    void setMaxConcurrency(int limit);
+
+    /// Ustawia limit czasu pojedynczego żądania HTTP w milisekundach (nawiązanie połączenia i odczyt).
+    void setRequestTimeout(int milliseconds);
+
+    /// Ustawia limit czasu nawiązania połączenia [ms].
+    void setConnectTimeout(int milliseconds);
+
+    /// Ustawia limit czasu odczytu odpowiedzi [ms].
+    void setReadTimeout(int milliseconds);
+
+    /// Włącza pobieranie odpowiedzi skompresowanych gzip (jeśli httplib ma obsługę zlib).
+    void setCompression(bool enabled);
+
+    /// Zwraca liczniki sesji HTTP (otwarte połączenia, wykonane żądania).
+    HttpSessionStats sessionStats() const;
+
+    /// Czy serwer GIOŚ uznawany jest za dostępny. Po kilku kolejnych błędach połączenia (patrz CircuitBreaker)
+    /// zwraca false, a żądania kończą się od razu błędem - wywołujący czyta wtedy dane lokalne bez czekania.
+    bool isOnline() const;
+
+    /// Zwraca stan i liczniki bezpiecznika połączeń.
+    CircuitBreakerStats connectionHealth() const;
+
+    /// Zmienia ustawienia bezpiecznika (próg kolejnych błędów, przerwy między próbami).
+    void setCircuitBreaker(const CircuitBreakerOptions& options);
+
+    /// Wymusza ponowną próbę połączenia przy następnym żądaniu.
+    void retryConnection();
+
+    /// Ustawia okno korekt synchronizacji przyrostowej [h]: pomiary z ostatnich hours godzin przed najnowszą
+    /// zapisaną datą miernika są zwracane ponownie w DeltaSyncResult::rechecked (0 = tylko nowsze daty).
+    void setCorrectionWindow(int hours);
+
+    /// Ustawia odbiorcę pomiarów pobranych przez getMeasurementsForStation, fetchStationDelta (tylko nowe)
+    /// i syncAllStations. Należy ustawić przed rozpoczęciem pobierania.
+    void setMeasurementListener(MeasurementListener listener);
+
     /// Pobiera wszystkie stacje jako surowy JSON (string).
     std::string getAllStationsRaw(); //pobieranie surowych danych do JSON
 
+    /// Pobiera listę stacji strumieniowo: JSON jest parsowany w trakcie odbierania,
+    /// a każda stacja trafia do onStation zaraz po wczytaniu. Zwraca false przy błędzie sieci lub JSON.
+    bool streamAllStations(const std::function<void(const Station&)>& onStation);
+
     /// Pobiera listę stacji pomiarowych z API jako obiekty.
     std::vector<Station> getAllStations(); //parsowanie surowych danych na gotowe obiekty Station
 
@@ -30,8 +117,23 @@ public:
     std::vector<int> getSensorIdsForStation(int stationId); //pobiera identyfikatory czujnikow
 
     /// Pobiera wszystkie dane pomiarowe dla czujników danej stacji.
+    /// Czujniki są pobierane równolegle przez pulę połączeń (patrz setMaxConcurrency),
+    /// a wynik zachowuje kolejność czujników zwróconą przez API.
     std::vector<Measurement> getMeasurementsForStation(int stationId); //
 
+    /// Synchronizacja przyrostowa stacji: zwraca tylko pomiary nowsze niż newestDates (miernik -> najnowsza
+    /// zapisana data, np. MeasurementStore::newestDates). Ponowne zapytania o tę samą stację są warunkowe
+    /// (ETag / Last-Modified), więc niezmienione czujniki nie przesyłają danych. Pomiary z okna korekt
+    /// (setCorrectionWindow) wracają w rechecked; korekty starszych wartości nie są wykrywane.
+    /// Anulowanie cancel przerywa pobieranie przy następnym kawałku odpowiedzi; pomiary czujników pobranych
+    /// w całości są zwracane (ich walidatory są już zapamiętane, więc trzeba je zapisać).
+    DeltaSyncResult fetchStationDelta(int stationId, const std::map<std::string, std::string>& newestDates, const CancelToken* cancel = nullptr);
+
+    /// Pobiera pomiary wszystkich podanych stacji naraz ("synchronizuj wszystkie stacje").
+    /// Łańcuch stacja -> czujniki -> dane jest rozkładany na pulę wątków z podkradaniem zadań,
+    /// więc wolne stacje nie wstrzymują szybkich. threadCount = 0 oznacza liczbę rdzeni.
+    std::map<int, std::vector<Measurement>> syncAllStations(const std::vector<Station>& stations, SyncStats& stats, unsigned threadCount = 0);
+
     /// Zapisuje listę stacji do pliku JSON.
     bool saveStationsToFile(const std::vector<Station>& stations, const std::string& filename);
 
@@ -41,9 +143,29 @@ public:
     /// Zapisuje dane pomiarowe (dla jednej stacji) do pliku JSON.
     bool saveMeasurementsToFile(const std::vector<Measurement>& measurements, const std::string& stationId, const std::string& filename);
 
+    /// Zapisuje dane pomiarowe wielu stacji do pliku JSON jednym zapisem.
+    bool saveAllMeasurementsToFile(const std::map<int, std::vector<Measurement>>& measurements, const std::string& filename);
+
     /// Wczytuje dane pomiarowe (dla jednej stacji) z pliku JSON.
     std::vector<Measurement> loadMeasurementsFromFile(const std::string& stationId, const std::string& filename);
 
 private:
-    const std::string baseUrl = "http://api.gios.gov.pl"; ///< Bazowy adres API GIOŚ
+    /// Wykonuje żądanie GET i parsuje odpowiedź strumieniowo (bez bufora na całą treść);
+    /// false przy błędzie połączenia, statusie innym niż 200 lub błędzie JSON. bytes może być nullptr.
+    bool fetchJson(const std::string& path, JsonHandler& handler, size_t* bytes);
+
+    /// Wykonuje fn dla indeksów 0..count-1 na co najwyżej maxConcurrency wątkach.
+    void forEachParallel(size_t count, const std::function<void(size_t)>& fn);
+
+    /// Żądanie warunkowe z walidatorami zapamiętanymi dla ścieżki (patrz fetchStationDelta).
+    HttpFetch fetchJsonConditional(const std::string& path, JsonHandler& handler, const CancelToken* cancel);
+
+    std::string baseUrl;            ///< Bazowy adres API GIOŚ
+    int maxConcurrency = 4;         ///< Maksymalna liczba równoległych połączeń dla czujników
+    int correctionHours = 24;       ///< Okno korekt synchronizacji przyrostowej [h]
+    std::unique_ptr<HttpSessionPool> session;   ///< Połączenia keep-alive współdzielone przez wszystkie wywołania
+    std::mutex deltaMutex;                              ///< Chroni walidatory i listy czujników
+    std::map<std::string, HttpValidators> pathValidators;   ///< Ścieżka -> ETag/Last-Modified ostatniej odpowiedzi
+    std::map<int, std::vector<int>> sensorCache;        ///< Stacja -> czujniki (dla odpowiedzi 304)
+    MeasurementListener measurementListener;            ///< Odbiorca pobranych pomiarów (może być pusty)
 };
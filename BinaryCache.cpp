@@ -0,0 +1,288 @@
+﻿#include "BinaryCache.h"
+#include "TimeUtils.h"
+#include <nlohmann/json.hpp>     // Biblioteka do obsługi JSON
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>    //CreateFileMapping, MapViewOfFile
+#else
+#include <fcntl.h>      //open
+#include <sys/mman.h>   //mmap
+#include <sys/stat.h>   //fstat
+#include <unistd.h>     //close
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+    const char cacheMagic[4] = { 'A', 'Q', 'B', 'C' };  //sygnatura pliku
+    const uint32_t cacheVersion = 1;                    //wersja formatu
+
+    /// Nagłówek pliku pamięci podręcznej.
+    struct CacheHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t stationCount;
+        uint32_t metricCount;
+        uint64_t dictionaryOffset;
+        uint64_t indexOffset;
+    };
+
+    /// Zaokrągla położenie w górę do wielokrotności 8 bajtów (wyrównanie kolumn int64/double).
+    uint64_t align8(uint64_t offset) {
+        return (offset + 7) & ~(uint64_t)7;
+    }
+
+    /// Dopisuje surowe bajty wartości do bufora.
+    template <typename T>
+    void put(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+}
+
+BinaryCache::~BinaryCache() {
+    close();
+}
+
+bool BinaryCache::open(const std::string& filename) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) { CloseHandle(file); return false; }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) { CloseHandle(file); return false; }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) { CloseHandle(mapping); CloseHandle(file); return false; }
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = static_cast<const unsigned char*>(view);
+    size = (size_t)fileSize.QuadPart;
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+    void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); //mapowanie pozostaje wazne po zamknieciu deskryptora
+    if (view == MAP_FAILED) return false;
+    data = static_cast<const unsigned char*>(view);
+    size = (size_t)st.st_size;
+#endif
+
+    //walidacja naglowka, slownika i indeksu - blokow stacji nie dotykamy
+    CacheHeader header;
+    if (size < sizeof(header)) { close(); return false; }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, cacheMagic, 4) != 0 || header.version != cacheVersion ||
+        header.indexOffset + (uint64_t)header.stationCount * sizeof(IndexEntry) > size || header.indexOffset % 8 != 0) {
+        close();
+        return false;
+    }
+
+    uint64_t pos = header.dictionaryOffset;
+    for (uint32_t i = 0; i < header.metricCount; ++i) { //slownik: dlugosc (uint16) + znaki
+        uint16_t length;
+        if (pos + sizeof(length) > size) { close(); return false; }
+        std::memcpy(&length, data + pos, sizeof(length));
+        pos += sizeof(length);
+        if (pos + length > size) { close(); return false; }
+        metricNames.emplace_back(reinterpret_cast<const char*>(data + pos), length);
+        pos += length;
+    }
+
+    index = reinterpret_cast<const IndexEntry*>(data + header.indexOffset);
+    stationCount = header.stationCount;
+    return true;
+}
+
+void BinaryCache::close() {
+    if (data) {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle((HANDLE)mappingHandle);
+        CloseHandle((HANDLE)fileHandle);
+#else
+        munmap(const_cast<unsigned char*>(data), size);
+#endif
+    }
+    data = nullptr;
+    size = 0;
+    index = nullptr;
+    stationCount = 0;
+    metricNames.clear();
+    fileHandle = mappingHandle = nullptr;
+}
+
+bool BinaryCache::find(int stationId, StationColumns& columns) const {
+    if (!data) return false;
+    const IndexEntry* end = index + stationCount;
+    const IndexEntry* it = std::lower_bound(index, end, stationId, [](const IndexEntry& e, int id) { return e.stationId < id; });
+    if (it == end || it->stationId != stationId) return false;
+
+    uint64_t blockSize = (uint64_t)it->count * (sizeof(int64_t) + sizeof(double) + sizeof(uint8_t));
+    if (it->offset + blockSize > size) return false; //uszkodzony plik
+
+    const unsigned char* block = data + it->offset;
+    columns.count = it->count;
+    columns.timestamps = reinterpret_cast<const int64_t*>(block);
+    columns.values = reinterpret_cast<const double*>(block + it->count * sizeof(int64_t));
+    columns.metrics = block + it->count * (sizeof(int64_t) + sizeof(double));
+    return true;
+}
+
+const std::string& BinaryCache::metricName(uint8_t metricId) const {
+    static const std::string unknown = "Nieznany";
+    return metricId < metricNames.size() ? metricNames[metricId] : unknown;
+}
+
+std::vector<int> BinaryCache::stationIds() const {
+    std::vector<int> ids;
+    for (uint32_t i = 0; i < stationCount; ++i) ids.push_back(index[i].stationId);
+    return ids;
+}
+
+std::vector<Measurement> BinaryCache::load(int stationId) const {
+    std::vector<Measurement> measurements;
+    StationColumns columns;
+    if (!find(stationId, columns)) return measurements;
+
+    measurements.resize(columns.count);
+    for (size_t i = 0; i < columns.count; ++i) {
+        measurements[i].name = metricName(columns.metrics[i]);
+        measurements[i].date = formatTimestamp(columns.timestamps[i]);
+        measurements[i].value = columns.values[i];
+    }
+    return measurements;
+}
+
+bool BinaryCache::write(const std::map<int, std::vector<Measurement>>& stations, const std::string& filename) {
+    std::vector<std::string> dictionary;    //nazwy miernikow w kolejnosci nadawania id
+    std::map<std::string, uint8_t> metricIds;
+    for (const auto& station : stations)
+        for (const auto& m : station.second)
+            if (!metricIds.count(m.name)) {
+                if (dictionary.size() == 256) { std::cerr << "Zbyt wiele mierników dla pamięci podręcznej.\n"; return false; }
+                metricIds[m.name] = (uint8_t)dictionary.size();
+                dictionary.push_back(m.name);
+            }
+
+    BinaryCacheWriter writer;
+    if (!writer.open(filename)) return false;
+    std::vector<int64_t> timestamps;
+    std::vector<double> values;
+    std::vector<uint8_t> metrics;
+    for (const auto& station : stations) { //mapa jest posortowana po id, wiec indeks tez
+        timestamps.clear();
+        values.clear();
+        metrics.clear();
+        for (const auto& m : station.second) {
+            int64_t ts;
+            if (!parseTimestamp(m.date, ts)) continue; //np. "brak daty"
+            timestamps.push_back(ts);
+            values.push_back(m.value);
+            metrics.push_back(metricIds[m.name]);
+        }
+        if (!writer.addStation(station.first, timestamps.data(), values.data(), metrics.data(), timestamps.size())) return false;
+    }
+    return writer.finish(dictionary);
+}
+
+int BinaryCache::convertFromJson(const std::string& jsonFile, const std::string& cacheFile) {
+    json allData;
+    try {
+        std::ifstream file(jsonFile);
+        if (!file.is_open()) return -1;
+        file >> allData;
+    }
+    catch (...) {
+        std::cerr << "Błąd wczytywania pliku " << jsonFile << ".\n";
+        return -1;
+    }
+    if (!allData.is_object()) return -1;
+
+    std::map<int, std::vector<Measurement>> stations;
+    for (auto it = allData.begin(); it != allData.end(); ++it) {
+        char* endPtr = nullptr;
+        long id = std::strtol(it.key().c_str(), &endPtr, 10);
+        if (*endPtr != '\0') continue; //klucz nie jest numerem stacji
+        auto& measurements = stations[(int)id];
+        for (const auto& m : it.value()) {
+            Measurement meas;
+            meas.name = m.value("name", "Brak");
+            meas.date = m.value("date", "brak daty");
+            meas.value = m.value("value", 0.0);
+            measurements.push_back(meas);
+        }
+    }
+
+    return write(stations, cacheFile) ? (int)stations.size() : -1;
+}
+
+bool BinaryCacheWriter::open(const std::string& filename) {
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    CacheHeader header = {}; //uzupelniany w finish
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    offset = sizeof(header);
+    entries.clear();
+    return (bool)file;
+}
+
+void BinaryCacheWriter::pad() {
+    static const char zeros[8] = {};
+    uint64_t aligned = align8(offset);
+    file.write(zeros, (std::streamsize)(aligned - offset));
+    offset = aligned;
+}
+
+bool BinaryCacheWriter::addStation(int stationId, const int64_t* timestamps, const double* values, const uint8_t* metrics, size_t count) {
+    if (!entries.empty() && entries.back().stationId >= stationId) {
+        std::cerr << "Stacje pamięci podręcznej muszą być zapisywane rosnąco po id.\n";
+        return false;
+    }
+    IndexEntry entry;
+    entry.stationId = stationId;
+    entry.count = (uint32_t)count;
+    entry.offset = offset;
+    entries.push_back(entry);
+    file.write(reinterpret_cast<const char*>(timestamps), (std::streamsize)(count * sizeof(int64_t)));
+    file.write(reinterpret_cast<const char*>(values), (std::streamsize)(count * sizeof(double)));
+    file.write(reinterpret_cast<const char*>(metrics), (std::streamsize)count);
+    offset += count * (sizeof(int64_t) + sizeof(double) + sizeof(uint8_t));
+    pad(); //wyrownanie nastepnego bloku
+    return (bool)file;
+}
+
+bool BinaryCacheWriter::finish(const std::vector<std::string>& metricNames) {
+    if (metricNames.size() > 256) { std::cerr << "Zbyt wiele mierników dla pamięci podręcznej.\n"; return false; }
+    CacheHeader header;
+    std::memcpy(header.magic, cacheMagic, 4);
+    header.version = cacheVersion;
+    header.stationCount = (uint32_t)entries.size();
+    header.metricCount = (uint32_t)metricNames.size();
+    header.dictionaryOffset = offset;
+    std::string dictBytes;
+    for (const auto& name : metricNames) {
+        uint16_t length = (uint16_t)std::min<size_t>(name.size(), 0xFFFF);
+        put(dictBytes, length);
+        dictBytes.append(name, 0, length);
+    }
+    file.write(dictBytes.data(), (std::streamsize)dictBytes.size());
+    offset += dictBytes.size();
+    pad();
+    header.indexOffset = offset;
+    file.write(reinterpret_cast<const char*>(entries.data()), (std::streamsize)(entries.size() * sizeof(IndexEntry)));
+    offset += entries.size() * sizeof(IndexEntry);
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+    return !file.fail();
+}
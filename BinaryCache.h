@@ -0,0 +1,111 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include "ApiClient.h"  //struktura Measurement
+
+/// Binarna, kolumnowa pamięć podręczna pomiarów do pracy offline.
+/// Układ pliku:
+///  - nagłówek ("AQBC", wersja, liczba stacji i mierników, położenie słownika i indeksu),
+///  - bloki stacji: int64 znaczniki czasu[n], double wartości[n], uint8 id miernika[n],
+///  - słownik nazw mierników (id miernika = pozycja w słowniku),
+///  - indeks stacji posortowany po id (id stacji, liczba pomiarów, położenie bloku).
+/// Położenie słownika i indeksu jest zapisane w nagłówku, więc plik może być zapisywany strumieniowo (BinaryCacheWriter).
+/// Plik jest otwierany przez mapowanie do pamięci, więc wczytanie jednej stacji dotyka tylko jej stron.
+/// Format eksportu i migawki offline (AirQualityCli cache/export, StoreExport) - aplikacja okienkowa go nie czyta,
+/// w trybie offline korzysta z dane.json i lokalnej bazy (MeasurementStore).
+class BinaryCache {
+public:
+    /// Kolumny jednej stacji wskazujące bezpośrednio na zmapowany plik.
+    struct StationColumns {
+        const int64_t* timestamps = nullptr;    ///< Sekundy od 1970-01-01 (patrz TimeUtils.h)
+        const double* values = nullptr;         ///< Wartości pomiarów
+        const uint8_t* metrics = nullptr;       ///< Id miernika ze słownika
+        size_t count = 0;                       ///< Liczba pomiarów
+    };
+
+    BinaryCache() = default;
+    ~BinaryCache();
+
+    BinaryCache(const BinaryCache&) = delete;
+    BinaryCache& operator=(const BinaryCache&) = delete;
+
+    /// Mapuje plik pamięci podręcznej i sprawdza jego nagłówek.
+    bool open(const std::string& filename);
+
+    /// Zwalnia mapowanie pliku.
+    void close();
+
+    /// Czy plik jest otwarty.
+    bool isOpen() const { return data != nullptr; }
+
+    /// Wyszukuje stację w indeksie (wyszukiwanie binarne) i zwraca jej kolumny.
+    bool find(int stationId, StationColumns& columns) const;
+
+    /// Zwraca nazwę miernika o podanym id.
+    const std::string& metricName(uint8_t metricId) const;
+
+    /// Zwraca identyfikatory wszystkich stacji z indeksu.
+    std::vector<int> stationIds() const;
+
+    /// Wczytuje pomiary stacji jako obiekty Measurement (zgodnie z ApiClient::loadMeasurementsFromFile).
+    std::vector<Measurement> load(int stationId) const;
+
+    /// Zapisuje pomiary stacji (id -> pomiary) do pliku pamięci podręcznej.
+    /// Pomiary z niepoprawną datą są pomijane.
+    static bool write(const std::map<int, std::vector<Measurement>>& stations, const std::string& filename);
+
+    /// Konwertuje plik w formacie dane.json do pliku pamięci podręcznej.
+    /// \return Liczba zapisanych stacji lub -1 przy błędzie.
+    static int convertFromJson(const std::string& jsonFile, const std::string& cacheFile);
+
+private:
+    /// Wpis indeksu stacji w pliku.
+    struct IndexEntry {
+        int32_t stationId;      ///< Id stacji
+        uint32_t count;         ///< Liczba pomiarów
+        uint64_t offset;        ///< Położenie bloku stacji od początku pliku
+    };
+
+    const unsigned char* data = nullptr;    ///< Początek zmapowanego pliku
+    size_t size = 0;                        ///< Rozmiar pliku
+    const IndexEntry* index = nullptr;      ///< Indeks stacji (wewnątrz mapowania)
+    uint32_t stationCount = 0;              ///< Liczba wpisów indeksu
+    std::vector<std::string> metricNames;   ///< Słownik mierników
+    void* fileHandle = nullptr;             ///< Uchwyt pliku (Windows)
+    void* mappingHandle = nullptr;          ///< Uchwyt mapowania (Windows)
+};
+
+/// Strumieniowy zapis pliku BinaryCache: bloki stacji trafiają do pliku od razu, a słownik, indeks
+/// i nagłówek są dopisywane w finish. W pamięci zostaje tylko indeks (16 B na stację).
+class BinaryCacheWriter {
+public:
+    /// Tworzy plik i rezerwuje miejsce na nagłówek.
+    bool open(const std::string& filename);
+
+    /// Dopisuje blok stacji (id stacji muszą rosnąć).
+    bool addStation(int stationId, const int64_t* timestamps, const double* values, const uint8_t* metrics, size_t count);
+
+    /// Zapisuje słownik mierników (id = pozycja), indeks i nagłówek, po czym zamyka plik.
+    bool finish(const std::vector<std::string>& metricNames);
+
+    /// Liczba zapisanych bajtów.
+    uint64_t bytesWritten() const { return offset; }
+
+private:
+    /// Wpis indeksu (jak BinaryCache::IndexEntry).
+    struct IndexEntry {
+        int32_t stationId;
+        uint32_t count;
+        uint64_t offset;
+    };
+
+    void pad();     //wyrownanie do 8 bajtow
+
+    std::ofstream file;
+    uint64_t offset = 0;
+    std::vector<IndexEntry> entries;
+};
@@ -0,0 +1,55 @@
+﻿#include "ChartDecimation.h"
+#include "Trace.h"
+#include <algorithm>
+
+DecimatedSeries decimateMinMax(const int64_t* timestamps, const double* values, size_t count, int64_t t0, int64_t t1, int columns) {
+    AQ_TRACE_SCOPE("chart.decimate");
+    DecimatedSeries out;
+    out.sourceCount = count;
+    out.columns = columns;
+    out.t0 = t0;
+    out.t1 = t1;
+    if (count == 0) return out;
+
+    out.minValue = out.maxValue = values[0];
+    for (size_t i = 1; i < count; ++i) { //zakres osi Y liczony raz, a nie przy kazdym WM_PAINT
+        if (values[i] < out.minValue) out.minValue = values[i];
+        if (values[i] > out.maxValue) out.maxValue = values[i];
+    }
+
+    if (columns < 0) columns = 0;
+    out.indices.reserve(std::min(count, 2 * (size_t)columns + 4));
+    out.indices.push_back(0);
+    size_t first = 1; //pierwszy i ostatni punkt sa dodawane osobno
+    while (first < count - 1) {
+        const int column = timeColumn(timestamps[first], t0, t1, columns);
+        size_t last = first + 1; //kubelek = kolejne punkty trafiajace w te sama kolumne pikseli (czasy rosnaco)
+        while (last < count - 1 && timeColumn(timestamps[last], t0, t1, columns) == column) ++last;
+
+        size_t lo = first, hi = first;
+        for (size_t i = first + 1; i < last; ++i) {
+            if (values[i] < values[lo]) lo = i;
+            if (values[i] > values[hi]) hi = i;
+        }
+        if (lo == hi) out.indices.push_back(lo);
+        else if (lo < hi) { out.indices.push_back(lo); out.indices.push_back(hi); } //kolejnosc w czasie
+        else { out.indices.push_back(hi); out.indices.push_back(lo); }
+        first = last;
+    }
+    if (count > 1) out.indices.push_back(count - 1);
+    return out;
+}
+
+const DecimatedSeries& ChartDecimator::get(const int64_t* timestamps, const double* values, size_t count, int64_t t0, int64_t t1, int columns) {
+    if (!valid || values != cachedValues || count != cached.sourceCount || columns != cached.columns || t0 != cached.t0 || t1 != cached.t1) {
+        cached = decimateMinMax(timestamps, values, count, t0, t1, columns);
+        cachedValues = values;
+        valid = true;
+        ++rebuildCount;
+    }
+    return cached;
+}
+
+void ChartDecimator::invalidate() {
+    valid = false;
+}
@@ -0,0 +1,57 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Seria zredukowana do rysowania - indeksy wybranych punktów oryginalnej serii (rosnąco)
+/// oraz zakres wartości całej serii, potrzebny do skalowania osi Y.
+struct DecimatedSeries {
+    std::vector<size_t> indices;    ///< Indeksy punktów do narysowania (zawsze z pierwszym i ostatnim)
+    double minValue = 0.0;          ///< Minimum wartości całej serii
+    double maxValue = 0.0;          ///< Maksimum wartości całej serii
+    size_t sourceCount = 0;         ///< Liczba punktów serii wejściowej
+    int columns = 0;                ///< Liczba kolumn pikseli, dla których liczono redukcję
+    int64_t t0 = 0;                 ///< Zakres osi czasu, dla którego liczono redukcję
+    int64_t t1 = 0;
+};
+
+/// Kolumna pikseli (0..columns) czasu t na osi czasu [t0, t1] szerokiej na columns pikseli.
+/// Tej samej funkcji używa układ wykresu, więc kubełki redukcji to dokładnie kolumny rysowanych punktów.
+inline int timeColumn(int64_t t, int64_t t0, int64_t t1, int columns) {
+    if (t1 <= t0) return 0;
+    if (t <= t0) return 0;
+    if (t >= t1) return columns;
+    return (int)((t - t0) * columns / (t1 - t0));
+}
+
+/// Redukuje serię do co najwyżej 2 punktów na kolumnę pikseli osi czasu (minimum i maksimum punktów
+/// z tej kolumny) oraz pierwszego i ostatniego punktu serii, zachowując kolejność punktów,
+/// więc piki i spadki nie znikają z wykresu także przy przerwach w danych i nierównym kroku pomiarów.
+/// \param timestamps Czasy punktów (rosnąco).
+/// \param values Wartości serii.
+/// \param count Liczba punktów.
+/// \param t0 Początek osi czasu wykresu (może być wcześniejszy niż seria, gdy wykres ma kilka serii).
+/// \param t1 Koniec osi czasu wykresu.
+/// \param columns Szerokość obszaru wykresu w pikselach (kolumny 0..columns, patrz timeColumn).
+DecimatedSeries decimateMinMax(const int64_t* timestamps, const double* values, size_t count, int64_t t0, int64_t t1, int columns);
+
+/// Pamięć podręczna redukcji dla okna wykresu - przelicza serię tylko przy zmianie danych lub szerokości.
+/// Nie zależy od WinAPI (okno wywołuje invalidate przy WM_SIZE).
+class ChartDecimator {
+public:
+    /// Zwraca zredukowaną serię dla podanej osi czasu i szerokości (z pamięci podręcznej, jeśli aktualna).
+    const DecimatedSeries& get(const int64_t* timestamps, const double* values, size_t count, int64_t t0, int64_t t1, int columns);
+
+    /// Unieważnia zapamiętany wynik (np. po zmianie rozmiaru okna).
+    void invalidate();
+
+    /// Liczba przeliczeń od utworzenia (do pomiaru skuteczności pamięci podręcznej).
+    size_t rebuilds() const { return rebuildCount; }
+
+private:
+    DecimatedSeries cached;             ///< Ostatni wynik
+    const double* cachedValues = nullptr;   ///< Dane, dla których liczono wynik
+    bool valid = false;                 ///< Czy wynik jest aktualny
+    size_t rebuildCount = 0;            ///< Liczba przeliczeń
+};
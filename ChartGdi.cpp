@@ -0,0 +1,48 @@
+﻿#include "ChartGdi.h"
+
+static_assert(sizeof(ChartPoint) == sizeof(POINT), "ChartPoint musi miec uklad POINT (Polyline bez kopiowania)");
+
+namespace {
+    COLORREF toColorRef(uint32_t color) {
+        return RGB((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF);   //0xRRGGBB -> 0x00BBGGRR
+    }
+}
+
+GdiCanvas::GdiCanvas(HDC hdc, int width, int height) : hdc(hdc), width(width), height(height) {
+    originalPen = GetCurrentObject(hdc, OBJ_PEN);
+    SetBkMode(hdc, TRANSPARENT);
+}
+
+GdiCanvas::~GdiCanvas() {
+    SelectObject(hdc, originalPen);     //pioro nie moze byc usuniete, gdy jest wybrane w kontekscie
+    for (auto& p : pens) DeleteObject(p.second);
+}
+
+void GdiCanvas::usePen(uint32_t color) {
+    HPEN& pen = pens[color];
+    if (!pen) pen = CreatePen(PS_SOLID, 1, toColorRef(color));
+    SelectObject(hdc, pen);
+}
+
+void GdiCanvas::fill(uint32_t color) {
+    RECT rect = { 0, 0, width, height };
+    HBRUSH brush = CreateSolidBrush(toColorRef(color));
+    FillRect(hdc, &rect, brush);
+    DeleteObject(brush);
+}
+
+void GdiCanvas::line(ChartPoint from, ChartPoint to, uint32_t color) {
+    usePen(color);
+    MoveToEx(hdc, from.x, from.y, NULL);
+    LineTo(hdc, to.x, to.y);
+}
+
+void GdiCanvas::polyline(const ChartPoint* points, size_t count, uint32_t color) {
+    usePen(color);
+    Polyline(hdc, reinterpret_cast<const POINT*>(points), (int)count);  // Cała linia jednym wywołaniem GDI
+}
+
+void GdiCanvas::text(int x, int y, const std::wstring& text, uint32_t color) {
+    SetTextColor(hdc, toColorRef(color));
+    TextOutW(hdc, x, y, text.c_str(), (int)text.size());
+}
@@ -0,0 +1,30 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <windows.h>
+#include <map>
+#include "ChartLayout.h"
+
+/// Backend wykresu rysujący na kontekście GDI (w oknie wykresu - na bitmapie w pamięci).
+/// Pióra są tworzone raz na kolor i zwalniane w destruktorze.
+class GdiCanvas : public ChartCanvas {
+public:
+    GdiCanvas(HDC hdc, int width, int height);
+    ~GdiCanvas();
+
+    GdiCanvas(const GdiCanvas&) = delete;
+    GdiCanvas& operator=(const GdiCanvas&) = delete;
+
+    void fill(uint32_t color) override;
+    void line(ChartPoint from, ChartPoint to, uint32_t color) override;
+    void polyline(const ChartPoint* points, size_t count, uint32_t color) override;
+    void text(int x, int y, const std::wstring& text, uint32_t color) override;
+
+private:
+    void usePen(uint32_t color);
+
+    HDC hdc;
+    int width;
+    int height;
+    HGDIOBJ originalPen;
+    std::map<uint32_t, HPEN> pens;
+};
@@ -0,0 +1,159 @@
+﻿#include "ChartLayout.h"
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include "TimeUtils.h"
+#include "Trace.h"
+
+namespace {
+    const uint32_t palette[] = { 0x1F77B4, 0xD62728, 0x2CA02C, 0xFF7F0E, 0x9467BD, 0x8C564B };  //kolory kolejnych serii
+    const uint32_t axisColor = 0x000000;
+    const uint32_t gridColor = 0xD0D0D0;
+    const uint32_t textColor = 0x000000;
+    const int padding = 60;         //margines obszaru wykresu (miejsce na osie i napisy)
+    const int charWidth = 7;        //przyblizona szerokosc znaku do centrowania etykiet
+
+    /// UTF-8 -> wstring (znaki do U+FFFF) bez WinAPI.
+    std::wstring widen(const std::string& text) {
+        std::wstring out;
+        out.reserve(text.size());
+        for (size_t i = 0; i < text.size(); ++i) {
+            unsigned char c = (unsigned char)text[i];
+            if (c < 0x80) out += (wchar_t)c;
+            else if ((c & 0xE0) == 0xC0 && i + 1 < text.size()) {
+                out += (wchar_t)((c & 0x1F) << 6 | (text[i + 1] & 0x3F));
+                i += 1;
+            }
+            else if ((c & 0xF0) == 0xE0 && i + 2 < text.size()) {
+                out += (wchar_t)((c & 0x0F) << 12 | (text[i + 1] & 0x3F) << 6 | (text[i + 2] & 0x3F));
+                i += 2;
+            }
+            else out += L'?';
+        }
+        return out;
+    }
+
+    int scaleX(int64_t t, int64_t t0, int64_t t1, int width) {
+        return padding + timeColumn(t, t0, t1, width); //te same kolumny co kubelki redukcji serii
+    }
+}
+
+ChartSeries makeChartSeries(const SeriesView& view) {
+    ChartSeries s;
+    s.metric = MetricRegistry::name(view.metric);
+    s.timestamps.assign(view.timestamps, view.timestamps + view.count);
+    s.values.assign(view.values, view.values + view.count);
+    return s;
+}
+
+void ChartModel::setSeries(std::vector<ChartSeries> series) {
+    data = std::move(series);
+    decimators.assign(data.size(), ChartDecimator());
+    valid = false;
+}
+
+const ChartLayout& ChartModel::layout(int width, int height) {
+    if (!valid || width != cached.width || height != cached.height) {
+        build(width, height);
+        valid = true;
+        ++rebuildCount;
+    }
+    return cached;
+}
+
+void ChartModel::build(int width, int height) {
+    AQ_TRACE_SCOPE("chart.layout");
+    ChartLayout out;
+    out.width = width;
+    out.height = height;
+    int plotWidth = width - 2 * padding;    //obszar wykresu bez marginesow
+    int plotHeight = height - 2 * padding;
+
+    size_t points = 0;
+    int64_t t0 = (std::numeric_limits<int64_t>::max)(), t1 = (std::numeric_limits<int64_t>::min)();
+    for (const auto& s : data) {
+        if (s.timestamps.empty()) continue;
+        points += s.timestamps.size();
+        t0 = std::min(t0, s.timestamps.front());
+        t1 = std::max(t1, s.timestamps.back());
+    }
+    if (points < 2 || plotWidth < 10 || plotHeight < 10) {
+        out.labels.push_back({ padding, padding, L"Za mało danych do wyświetlenia wykresu.", textColor });
+        cached = std::move(out);
+        return;
+    }
+    if (t1 == t0) t1 = t0 + 1;
+
+    double minVal = 0.0, maxVal = 0.0;
+    bool first = true;
+    std::vector<const DecimatedSeries*> visible(data.size(), nullptr);
+    for (size_t k = 0; k < data.size(); ++k) { //najwyzej 2 punkty serii na kolumne pikseli (min i max)
+        if (data[k].values.empty()) continue;
+        visible[k] = &decimators[k].get(data[k].timestamps.data(), data[k].values.data(), data[k].values.size(), t0, t1, plotWidth);
+        minVal = first ? visible[k]->minValue : std::min(minVal, visible[k]->minValue);
+        maxVal = first ? visible[k]->maxValue : std::max(maxVal, visible[k]->maxValue);
+        first = false;
+    }
+    if (maxVal == minVal) maxVal = minVal + 1.0;    //stala seria - unikamy dzielenia przez zero
+
+    char text[32];
+    for (int i = 0; i <= 5; ++i) { //linie pomocnicze i wartosci osi Y
+        int y = padding + i * plotHeight / 5;
+        out.segments.push_back({ { padding, y }, { padding + plotWidth, y }, gridColor });
+        std::snprintf(text, sizeof(text), "%.1f", maxVal - i * (maxVal - minVal) / 5);
+        out.labels.push_back({ 5, y - 10, widen(text), textColor });
+    }
+    out.segments.push_back({ { padding, padding + plotHeight }, { padding + plotWidth, padding + plotHeight }, axisColor }); //os X
+    out.segments.push_back({ { padding, padding }, { padding, padding + plotHeight }, axisColor });                         //os Y
+
+    for (size_t k = 0; k < data.size(); ++k) {
+        if (!visible[k]) continue;
+        ChartPolyline line;
+        line.color = palette[k % (sizeof(palette) / sizeof(palette[0]))];
+        line.points.reserve(visible[k]->indices.size());
+        for (size_t i : visible[k]->indices) {
+            ChartPoint p;
+            p.x = scaleX(data[k].timestamps[i], t0, t1, plotWidth);
+            p.y = padding + plotHeight - (int)((data[k].values[i] - minVal) * plotHeight / (maxVal - minVal));
+            line.points.push_back(p);
+        }
+        out.lines.push_back(std::move(line));
+    }
+
+    int ticks = std::max(2, std::min(10, plotWidth / 90));  //etykiety czasu bez nachodzenia na siebie
+    bool multiDay = t1 - t0 > 86400;
+    for (int i = 0; i < ticks; ++i) {
+        int64_t t = t0 + (t1 - t0) * i / (ticks - 1);
+        int x = scaleX(t, t0, t1, plotWidth);
+        formatTimestamp(t, text);
+        std::string label = multiDay ? std::string(text + 5, 11) : std::string(text + 11, 5);   //"MM-DD HH:MM" lub "HH:MM"
+        out.segments.push_back({ { x, padding + plotHeight }, { x, padding + plotHeight + 4 }, axisColor });
+        out.labels.push_back({ x - (int)label.size() * charWidth / 2, padding + plotHeight + 5, widen(label), textColor });
+    }
+
+    std::string title = "Wykres ";
+    for (size_t k = 0; k < data.size(); ++k) title += (k ? ", " : "") + data[k].metric;
+    title += " [" + formatTimestamp(t0) + " - " + formatTimestamp(t1) + "]";
+    out.labels.push_back({ padding + 80, 10, widen(title), textColor });
+    out.labels.push_back({ 10, padding - 30, L"Stężenie [µg/m³]", textColor });
+    out.labels.push_back({ padding + plotWidth / 2 - 15, padding + plotHeight + 30, L"Czas", textColor });
+
+    if (data.size() > 1) { //legenda nad prawym gornym rogiem wykresu
+        int x = padding + plotWidth;
+        for (size_t k = data.size(); k-- > 0;) {
+            x -= (int)data[k].metric.size() * charWidth + 34;
+            uint32_t color = palette[k % (sizeof(palette) / sizeof(palette[0]))];
+            for (int dy = -1; dy <= 1; ++dy) out.segments.push_back({ { x, padding - 12 + dy }, { x + 20, padding - 12 + dy }, color });
+            out.labels.push_back({ x + 24, padding - 20, widen(data[k].metric), textColor });
+        }
+    }
+    cached = std::move(out);
+}
+
+void renderChart(const ChartLayout& layout, ChartCanvas& canvas) {
+    AQ_TRACE_SCOPE("chart.render");
+    canvas.fill(layout.background);
+    for (const auto& s : layout.segments) canvas.line(s.from, s.to, s.color);
+    for (const auto& l : layout.lines) canvas.polyline(l.points.data(), l.points.size(), l.color);
+    for (const auto& l : layout.labels) canvas.text(l.x, l.y, l.text, l.color);
+}
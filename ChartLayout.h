@@ -0,0 +1,95 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ChartDecimation.h"
+#include "MeasurementSeries.h"  //SeriesView
+
+/// Seria jednego miernika na wykresie.
+struct ChartSeries {
+    std::string metric;                 ///< Nazwa miernika (legenda i tytuł)
+    std::vector<int64_t> timestamps;    ///< Czasy pomiarów (rosnąco, sekundy, TimeUtils.h)
+    std::vector<double> values;
+};
+
+/// Kopia widoku serii do wykresu (okno wykresu żyje dłużej niż dane wybranej stacji).
+ChartSeries makeChartSeries(const SeriesView& view);
+
+/// Punkt w pikselach (układ zgodny z POINT z WinAPI).
+struct ChartPoint {
+    int32_t x;
+    int32_t y;
+};
+
+/// Odcinek (oś, linia siatki, znacznik legendy).
+struct ChartSegment {
+    ChartPoint from;
+    ChartPoint to;
+    uint32_t color;     ///< 0xRRGGBB
+};
+
+/// Linia serii po redukcji do szerokości wykresu.
+struct ChartPolyline {
+    std::vector<ChartPoint> points;
+    uint32_t color;
+};
+
+/// Napis (lewy górny róg w x, y).
+struct ChartLabel {
+    int x;
+    int y;
+    std::wstring text;
+    uint32_t color;
+};
+
+/// Gotowa geometria wykresu - wszystko, co rysuje backend (GDI, obraz w pamięci), w kolejności rysowania:
+/// tło, odcinki, linie serii, napisy.
+struct ChartLayout {
+    int width = 0;
+    int height = 0;
+    uint32_t background = 0xFFFFFF;
+    std::vector<ChartSegment> segments;
+    std::vector<ChartPolyline> lines;
+    std::vector<ChartLabel> labels;
+};
+
+/// Dane i układ jednego wykresu. Skale, etykiety osi i punkty linii są liczone przy pierwszym
+/// rysowaniu i pamiętane do zmiany danych lub rozmiaru, więc odmalowanie okna nie formatuje tekstów.
+/// Kilka serii (np. PM10 i PM2.5) dzieli oś czasu i oś wartości. Nie zależy od WinAPI.
+class ChartModel {
+public:
+    /// Zastępuje serie wykresu (unieważnia układ).
+    void setSeries(std::vector<ChartSeries> series);
+
+    /// Układ dla obszaru width x height pikseli (z pamięci podręcznej, jeśli aktualny).
+    const ChartLayout& layout(int width, int height);
+
+    const std::vector<ChartSeries>& series() const { return data; }
+
+    /// Liczba przeliczeń układu od utworzenia (do pomiaru skuteczności pamięci podręcznej).
+    size_t rebuilds() const { return rebuildCount; }
+
+private:
+    void build(int width, int height);
+
+    std::vector<ChartSeries> data;
+    std::vector<ChartDecimator> decimators;     ///< Redukcja każdej serii do szerokości wykresu
+    ChartLayout cached;
+    bool valid = false;
+    size_t rebuildCount = 0;
+};
+
+/// Backend rysujący gotowy układ (kontekst GDI, obraz w pamięci).
+class ChartCanvas {
+public:
+    virtual ~ChartCanvas() {}
+    virtual void fill(uint32_t color) = 0;
+    virtual void line(ChartPoint from, ChartPoint to, uint32_t color) = 0;
+    virtual void polyline(const ChartPoint* points, size_t count, uint32_t color) = 0;
+    virtual void text(int x, int y, const std::wstring& text, uint32_t color) = 0;
+};
+
+/// Rysuje układ na płótnie (ta sama kolejność dla każdego backendu).
+void renderChart(const ChartLayout& layout, ChartCanvas& canvas);
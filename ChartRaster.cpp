@@ -0,0 +1,123 @@
+﻿#include "ChartRaster.h"
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+    /// Czcionka 5x7 dla znaków ASCII 32..126: 5 kolumn na znak, bit 0 = górny wiersz.
+    const uint8_t font5x7[95][5] = {
+        { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 },
+        { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 },
+        { 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x08, 0x2A, 0x1C, 0x2A, 0x08 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },
+        { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },
+        { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 },
+        { 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+        { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 },
+        { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 },
+        { 0x32, 0x49, 0x79, 0x41, 0x3E }, { 0x7E, 0x11, 0x11, 0x11, 0x7E }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },
+        { 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x09, 0x01 }, { 0x3E, 0x41, 0x49, 0x49, 0x7A },
+        { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 },
+        { 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },
+        { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 },
+        { 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F },
+        { 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 },
+        { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },
+        { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 },
+        { 0x38, 0x44, 0x44, 0x48, 0x7F }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x0C, 0x52, 0x52, 0x52, 0x3E },
+        { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3D, 0x00 }, { 0x7F, 0x10, 0x28, 0x44, 0x00 },
+        { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 }, { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 },
+        { 0x7C, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7C }, { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+        { 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, { 0x1C, 0x20, 0x40, 0x20, 0x1C }, { 0x3C, 0x40, 0x30, 0x40, 0x3C },
+        { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C }, { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 },
+        { 0x00, 0x00, 0x7F, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x08, 0x04, 0x08, 0x10, 0x08 },
+    };
+
+    /// Znak ASCII dla znaku spoza czcionki (polskie litery, µ, ³); '?' gdy brak odpowiednika.
+    wchar_t asciiFallback(wchar_t c) {
+        switch (c) {
+        case 0x104: return L'A'; case 0x105: return L'a';
+        case 0x106: return L'C'; case 0x107: return L'c';
+        case 0x118: return L'E'; case 0x119: return L'e';
+        case 0x141: return L'L'; case 0x142: return L'l';
+        case 0x143: return L'N'; case 0x144: return L'n';
+        case 0xD3: return L'O'; case 0xF3: return L'o';
+        case 0x15A: return L'S'; case 0x15B: return L's';
+        case 0x179: case 0x17B: return L'Z';
+        case 0x17A: case 0x17C: return L'z';
+        case 0xB5: return L'u';     //mikro
+        case 0xB3: return L'3';     //indeks gorny 3
+        }
+        return L'?';
+    }
+}
+
+RasterCanvas::RasterCanvas(int width, int height)
+    : w(width > 0 ? width : 0), h(height > 0 ? height : 0), pixels((size_t)w * h * 3, 0) {
+}
+
+void RasterCanvas::plot(int x, int y, uint32_t color) {
+    if (x < 0 || y < 0 || x >= w || y >= h) return; //przyciecie do obrazu
+    uint8_t* p = &pixels[((size_t)y * w + x) * 3];
+    p[0] = (uint8_t)(color >> 16);
+    p[1] = (uint8_t)(color >> 8);
+    p[2] = (uint8_t)color;
+}
+
+void RasterCanvas::fill(uint32_t color) {
+    for (size_t i = 0; i < pixels.size(); i += 3) {
+        pixels[i] = (uint8_t)(color >> 16);
+        pixels[i + 1] = (uint8_t)(color >> 8);
+        pixels[i + 2] = (uint8_t)color;
+    }
+}
+
+void RasterCanvas::line(ChartPoint from, ChartPoint to, uint32_t color) {
+    int dx = std::abs(to.x - from.x), dy = -std::abs(to.y - from.y);    //Bresenham, jak GDI bez ostatniego piksela
+    int sx = from.x < to.x ? 1 : -1, sy = from.y < to.y ? 1 : -1;
+    int err = dx + dy;
+    int x = from.x, y = from.y;
+    while (x != to.x || y != to.y) {
+        plot(x, y, color);
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x += sx; }
+        if (e2 <= dx) { err += dx; y += sy; }
+    }
+}
+
+void RasterCanvas::polyline(const ChartPoint* points, size_t count, uint32_t color) {
+    for (size_t i = 1; i < count; ++i) line(points[i - 1], points[i], color);
+    if (count > 0) plot(points[count - 1].x, points[count - 1].y, color);
+}
+
+void RasterCanvas::text(int x, int y, const std::wstring& text, uint32_t color) {
+    for (wchar_t c : text) {
+        if (c < 32 || c > 126) c = asciiFallback(c);
+        const uint8_t* glyph = font5x7[c - 32];
+        for (int col = 0; col < 5; ++col)
+            for (int row = 0; row < 7; ++row)
+                if (glyph[col] >> row & 1) plot(x + col, y + 4 + row, color); //wysrodkowanie jak tekst GDI (16 pikseli)
+        x += 6;
+    }
+}
+
+uint32_t RasterCanvas::pixel(int x, int y) const {
+    if (x < 0 || y < 0 || x >= w || y >= h) return 0;
+    const uint8_t* p = &pixels[((size_t)y * w + x) * 3];
+    return (uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2];
+}
+
+uint64_t RasterCanvas::checksum() const {
+    uint64_t hash = 14695981039346656037ull;
+    for (uint8_t b : pixels) {
+        hash ^= b;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool RasterCanvas::writePpm(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    file << "P6\n" << w << " " << h << "\n255\n";
+    file.write(reinterpret_cast<const char*>(pixels.data()), (std::streamsize)pixels.size());
+    return (bool)file;
+}
@@ -0,0 +1,38 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ChartLayout.h"
+
+/// Płótno w pamięci (RGB, 8 bitów na kanał) - backend wykresu bez WinAPI do benchmarków
+/// i porównywania obrazów z wzorcem. Linie bez wygładzania, napisy czcionką 5x7
+/// (polskie litery bez znaków diakrytycznych).
+class RasterCanvas : public ChartCanvas {
+public:
+    RasterCanvas(int width, int height);
+
+    void fill(uint32_t color) override;
+    void line(ChartPoint from, ChartPoint to, uint32_t color) override;
+    void polyline(const ChartPoint* points, size_t count, uint32_t color) override;
+    void text(int x, int y, const std::wstring& text, uint32_t color) override;
+
+    int width() const { return w; }
+    int height() const { return h; }
+
+    /// Kolor piksela 0xRRGGBB (poza obrazem 0).
+    uint32_t pixel(int x, int y) const;
+
+    /// Suma kontrolna FNV-1a pikseli (porównanie z wzorcem bez przechowywania obrazu).
+    uint64_t checksum() const;
+
+    /// Zapisuje obraz jako binarny PPM (P6).
+    bool writePpm(const std::string& filename) const;
+
+private:
+    void plot(int x, int y, uint32_t color);
+
+    int w;
+    int h;
+    std::vector<uint8_t> pixels;    ///< Wiersze od góry, 3 bajty na piksel
+};
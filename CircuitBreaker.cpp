@@ -0,0 +1,93 @@
+﻿#include "CircuitBreaker.h"
+
+CircuitBreaker::CircuitBreaker(const CircuitBreakerOptions& options) : options(options) {}
+
+bool CircuitBreaker::allowRequest() {
+    std::lock_guard<std::mutex> lock(mutex);
+    switch (current) {
+    case State::Closed:
+        return true;
+    case State::Open:
+        if (now() < retryAt) break; //przerwa trwa - bez laczenia z serwerem
+        current = State::HalfOpen;
+        probeInFlight = true;
+        counters.probes++;
+        return true; //jedno zadanie probne
+    case State::HalfOpen:
+        if (probeInFlight) break; //proba juz trwa
+        probeInFlight = true;
+        counters.probes++;
+        return true;
+    }
+    counters.shortCircuited++;
+    return false;
+}
+
+void CircuitBreaker::recordSuccess() {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = State::Closed;
+    failures = 0;
+    backoffLevel = 0;
+    probeInFlight = false;
+}
+
+void CircuitBreaker::recordFailure() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++failures;
+    if (current == State::HalfOpen) { //proba nieudana - dluzsza przerwa
+        probeInFlight = false;
+        open();
+    }
+    else if (current == State::Closed && failures >= options.failureThreshold) {
+        open();
+    }
+}
+
+void CircuitBreaker::open() {
+    using std::chrono::milliseconds;
+    long long delay = options.baseBackoff.count();
+    for (int i = 0; i < backoffLevel && delay < options.maxBackoff.count(); ++i) delay *= 2; //przerwa rosnie wykladniczo
+    if (delay > options.maxBackoff.count()) delay = options.maxBackoff.count();
+    std::uniform_real_distribution<double> spread(1.0 - options.jitter, 1.0);
+    delay = (long long)(delay * spread(random)); //losowe skrocenie - klienci nie wracaja jednoczesnie
+
+    current = State::Open;
+    retryAt = now() + milliseconds(delay);
+    ++backoffLevel;
+    counters.trips++;
+}
+
+CircuitBreaker::State CircuitBreaker::state() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+}
+
+CircuitBreakerStats CircuitBreaker::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    CircuitBreakerStats s = counters;
+    s.state = (int)current;
+    s.consecutiveFailures = failures;
+    if (current == State::Open) {
+        long long left = std::chrono::duration_cast<std::chrono::milliseconds>(retryAt - now()).count();
+        s.retryInMs = left > 0 ? left : 0;
+    }
+    return s;
+}
+
+void CircuitBreaker::setOptions(const CircuitBreakerOptions& newOptions) {
+    std::lock_guard<std::mutex> lock(mutex);
+    options = newOptions;
+}
+
+void CircuitBreaker::setClock(std::function<Clock::time_point()> clock) {
+    std::lock_guard<std::mutex> lock(mutex);
+    now = clock;
+}
+
+void CircuitBreaker::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = State::Closed;
+    failures = 0;
+    backoffLevel = 0;
+    probeInFlight = false;
+}
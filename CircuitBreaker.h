@@ -0,0 +1,79 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <random>
+
+/// Ustawienia bezpiecznika połączeń.
+struct CircuitBreakerOptions {
+    int failureThreshold = 3;                               ///< Tyle kolejnych błędów otwiera bezpiecznik
+    std::chrono::milliseconds baseBackoff{ 2000 };          ///< Pierwsza przerwa przed próbą
+    std::chrono::milliseconds maxBackoff{ 5 * 60 * 1000 };  ///< Najdłuższa przerwa (kolejne rosną 2x)
+    double jitter = 0.5;                                    ///< Losowe skrócenie przerwy o 0..jitter (rozprasza próby)
+};
+
+/// Liczniki i stan bezpiecznika.
+struct CircuitBreakerStats {
+    int state = 0;                  ///< 0 - zamknięty, 1 - otwarty, 2 - półotwarty (CircuitBreaker::State)
+    int consecutiveFailures = 0;    ///< Kolejne błędy od ostatniego sukcesu
+    size_t trips = 0;               ///< Ile razy bezpiecznik się otworzył
+    size_t shortCircuited = 0;      ///< Żądania odrzucone bez łączenia z serwerem
+    size_t probes = 0;              ///< Próby wykonane w stanie półotwartym
+    long long retryInMs = 0;        ///< Czas do następnej próby (gdy otwarty)
+};
+
+/// Bezpiecznik połączeń z serwerem (circuit breaker).
+/// Zamknięty: żądania idą normalnie. Po failureThreshold kolejnych błędach otwiera się i przez czas
+/// przerwy żądania kończą się od razu błędem (dane z lokalnej bazy zamiast czekania na limit czasu).
+/// Po przerwie przepuszcza jedno żądanie próbne (półotwarty): sukces zamyka bezpiecznik,
+/// błąd otwiera go ponownie z dwukrotnie dłuższą, losowo skróconą przerwą.
+/// Nie zależy od sieci ani WinAPI - wynik żądań zgłasza wywołujący.
+class CircuitBreaker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Stan bezpiecznika.
+    enum class State { Closed = 0, Open = 1, HalfOpen = 2 };
+
+    explicit CircuitBreaker(const CircuitBreakerOptions& options = CircuitBreakerOptions());
+
+    /// Czy wolno wykonać żądanie. W stanie półotwartym zgoda dotyczy tylko jednego żądania próbnego.
+    bool allowRequest();
+
+    /// Zgłasza udane żądanie (serwer odpowiedział).
+    void recordSuccess();
+
+    /// Zgłasza nieudane żądanie (brak połączenia, przekroczony czas, błąd 5xx).
+    void recordFailure();
+
+    /// Zwraca bieżący stan.
+    State state() const;
+
+    /// Zwraca kopię liczników.
+    CircuitBreakerStats stats() const;
+
+    /// Zmienia ustawienia (stan i liczniki zostają).
+    void setOptions(const CircuitBreakerOptions& options);
+
+    /// Podmienia zegar (np. do sprawdzenia przejść stanów bez czekania).
+    void setClock(std::function<Clock::time_point()> clock);
+
+    /// Przywraca stan zamknięty (np. po ręcznym "Spróbuj ponownie").
+    void reset();
+
+private:
+    void open(); //otwiera bezpiecznik z kolejna przerwa (pod blokada)
+
+    mutable std::mutex mutex;
+    CircuitBreakerOptions options;
+    State current = State::Closed;
+    int failures = 0;
+    int backoffLevel = 0;               ///< Numer kolejnego otwarcia bez sukcesu (wykładnik przerwy)
+    bool probeInFlight = false;
+    Clock::time_point retryAt;
+    CircuitBreakerStats counters;
+    std::mt19937 random{ std::random_device{}() };
+    std::function<Clock::time_point()> now = [] { return Clock::now(); };
+};
@@ -0,0 +1,80 @@
+﻿#include "FetchPipeline.h"
+
+FetchPipeline::~FetchPipeline() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        pending = nullptr;
+        runningToken.cancel(); //siec przerywa pobieranie przy nastepnym kawalku
+    }
+    pendingCv.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+FetchPipeline::Ticket FetchPipeline::enqueue(Task task) {
+    Ticket ticket;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ticket = ++latest;
+        counters.submitted++;
+        if (pending) counters.superseded++; //starsze zlecenie nie zdazylo sie zaczac
+        pending = std::move(task);
+        pendingTicket = ticket;
+        if (running && !runningToken.cancelled()) {
+            runningToken.cancel(); //wykonywane zadanie jest juz nieaktualne
+            counters.cancelled++;
+        }
+        if (!worker.joinable()) worker = std::thread(&FetchPipeline::run, this);
+    }
+    pendingCv.notify_one();
+    return ticket;
+}
+
+void FetchPipeline::run() {
+    for (;;) {
+        Task task;
+        Ticket ticket;
+        CancelToken token;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            pendingCv.wait(lock, [this] { return stopping || pending; });
+            if (stopping) return;
+            task = std::move(pending);
+            pending = nullptr;
+            ticket = pendingTicket;
+            runningToken = token; //nowy znacznik dla kazdego zadania
+            running = true;
+        }
+        task(ticket, token);
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+}
+
+void FetchPipeline::publish(Ticket ticket, const CancelToken& token, const std::function<void()>& deliver) {
+    std::lock_guard<std::mutex> lock(mutex); //nowe zlecenie nie wejdzie miedzy sprawdzenie a przekazanie
+    if (token.cancelled() || ticket != latest) return;
+    counters.delivered++;
+    deliver();
+}
+
+bool FetchPipeline::isCurrent(Ticket ticket) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ticket == latest;
+}
+
+void FetchPipeline::cancelAll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++latest; //zaden wczesniejszy wynik nie jest juz aktualny
+    if (pending) counters.superseded++;
+    pending = nullptr;
+    if (running && !runningToken.cancelled()) {
+        runningToken.cancel();
+        counters.cancelled++;
+    }
+}
+
+FetchPipelineStats FetchPipeline::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
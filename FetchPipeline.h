@@ -0,0 +1,88 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/// Znacznik anulowania zadania. Kopie dzielą ten sam stan, więc anulowanie jest widoczne we wszystkich
+/// miejscach, które dostały kopię (np. w wątkach pobierających czujniki).
+class CancelToken {
+public:
+    CancelToken() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+    /// Czy zadanie zostało anulowane (tanie - można sprawdzać przy każdym kawałku odpowiedzi).
+    bool cancelled() const { return flag->load(std::memory_order_relaxed); }
+
+    /// Anuluje zadanie.
+    void cancel() const { flag->store(true, std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag;
+};
+
+/// Liczniki potoku pobierania.
+struct FetchPipelineStats {
+    size_t submitted = 0;   ///< Zlecone zadania
+    size_t superseded = 0;  ///< Zastąpione nowszym zleceniem, zanim się zaczęły (nie wykonane)
+    size_t cancelled = 0;   ///< Anulowane w trakcie wykonywania (wynik nie jest przekazywany)
+    size_t delivered = 0;   ///< Wyniki przekazane do odbiorcy
+};
+
+/// Potok pobierania "wygrywa najnowsze" w osobnym wątku: każde nowe zlecenie zastępuje oczekujące
+/// i anuluje wykonywane, a wynik trafia do odbiorcy tylko wtedy, gdy nadal jest najnowszy.
+/// Szybkie przełączanie stacji nie kolejkuje więc zbędnych pobrań, a wątek okna nie czeka na sieć.
+/// Nie zależy od WinAPI - GUI przekazuje wynik do okna w funkcji deliver (np. przez PostMessage).
+class FetchPipeline {
+public:
+    using Ticket = unsigned long long;
+
+    FetchPipeline() = default;
+
+    /// Anuluje bieżące zadanie i czeka na zakończenie wątku.
+    ~FetchPipeline();
+
+    FetchPipeline(const FetchPipeline&) = delete;
+    FetchPipeline& operator=(const FetchPipeline&) = delete;
+
+    /// Zleca zadanie: work wykonuje się w wątku potoku i powinno przerywać pracę po anulowaniu znacznika.
+    /// deliver dostaje wynik (w wątku potoku) tylko, jeśli w międzyczasie nie zlecono nowszego zadania.
+    /// Zwraca numer zlecenia (rosnący).
+    template <class T>
+    Ticket submit(std::function<T(const CancelToken&)> work, std::function<void(Ticket, T&)> deliver) {
+        return enqueue([this, work, deliver](Ticket ticket, const CancelToken& token) {
+            T result = work(token);
+            publish(ticket, token, [&] { deliver(ticket, result); });
+        });
+    }
+
+    /// Czy zlecenie jest najnowsze (GUI może dodatkowo odrzucić spóźnione komunikaty).
+    bool isCurrent(Ticket ticket) const;
+
+    /// Anuluje bieżące i oczekujące zadanie.
+    void cancelAll();
+
+    /// Zwraca kopię liczników.
+    FetchPipelineStats stats() const;
+
+private:
+    using Task = std::function<void(Ticket, const CancelToken&)>;
+
+    Ticket enqueue(Task task);
+    void publish(Ticket ticket, const CancelToken& token, const std::function<void()>& deliver);
+    void run(); //petla watku potoku
+
+    mutable std::mutex mutex;
+    std::condition_variable pendingCv;  ///< Budzi wątek potoku
+    Task pending;                       ///< Oczekujące zadanie (najwyżej jedno)
+    Ticket pendingTicket = 0;
+    CancelToken runningToken;           ///< Znacznik wykonywanego zadania
+    bool running = false;               ///< Czy zadanie jest wykonywane
+    Ticket latest = 0;                  ///< Numer najnowszego zlecenia
+    FetchPipelineStats counters;
+    std::thread worker;                 ///< Wątek potoku (uruchamiany przy pierwszym zleceniu)
+    bool stopping = false;
+};
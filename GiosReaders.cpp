@@ -0,0 +1,127 @@
+﻿#include "GiosReaders.h"
+#include "TimeUtils.h"
+
+StationStreamReader::StationStreamReader(std::function<void(const Station&)> onStation) : onStation(onStation) {}
+
+void StationStreamReader::startObject() {
+    GiosReaderBase::startObject();
+    if (depth == 2) { //nowa stacja - wartosci domyslne jak w wersji z drzewem JSON
+        current = Station();
+        current.name = "Brak nazwy";
+        current.province = "Nieznany";
+    }
+}
+
+void StationStreamReader::endObject() {
+    if (depth == 2 && onStation) onStation(current);
+    GiosReaderBase::endObject();
+}
+
+void StationStreamReader::string(const std::string& value) {
+    if (depth == 2 && (keyAt(2) == "stationName" || keyAt(2) == "name")) current.name = value; //"name" - format stations.json
+    else if (depth == 2 && keyAt(2) == "province") current.province = value;
+    else if (depth == 4 && keyAt(2) == "city" && keyAt(3) == "commune" && keyAt(4) == "provinceName") current.province = value;
+}
+
+void StationStreamReader::number(double value) {
+    if (depth == 2 && keyAt(2) == "id") current.id = (int)value;
+}
+
+SensorListStreamReader::SensorListStreamReader(std::vector<int>& sensorIds) : sensorIds(sensorIds) {}
+
+void SensorListStreamReader::startObject() {
+    GiosReaderBase::startObject();
+    if (depth == 2) current = -1;
+}
+
+void SensorListStreamReader::endObject() {
+    if (depth == 2) sensorIds.push_back(current);
+    GiosReaderBase::endObject();
+}
+
+void SensorListStreamReader::number(double value) {
+    if (depth == 2 && keyAt(2) == "id") current = (int)value;
+}
+
+SensorDataStreamReader::SensorDataStreamReader(std::function<void(const Measurement&)> onMeasurement)
+    : onMeasurement(onMeasurement) {}
+
+void SensorDataStreamReader::startObject() {
+    GiosReaderBase::startObject();
+    if (depth == 3 && keyAt(1) == "values") { //obiekt {"date": ..., "value": ...}
+        current = Measurement();
+        current.date = "brak daty";
+        hasValue = false;
+    }
+}
+
+void SensorDataStreamReader::endObject() {
+    if (depth == 3 && keyAt(1) == "values" && hasValue) emit(current); //wartosci null sa pomijane
+    GiosReaderBase::endObject();
+}
+
+void SensorDataStreamReader::string(const std::string& value) {
+    if (depth == 1 && keyAt(1) == "key") {
+        paramName = value;
+        if (watermarks) {
+            auto it = watermarks->find(paramName);
+            threshold = it != watermarks->end() ? &it->second : nullptr;
+            int64_t newest;
+            recheckFrom.clear();
+            if (threshold && recheckSeconds > 0 && parseTimestamp(*threshold, newest)) recheckFrom = formatTimestamp(newest - recheckSeconds);
+        }
+        for (auto& m : pending) emit(m); //pomiary wczytane przed nazwa miernika
+        pending.clear();
+    }
+    else if (depth == 3 && keyAt(3) == "date") current.date = value;
+}
+
+void SensorDataStreamReader::number(double value) {
+    if (depth == 3 && keyAt(3) == "value") {
+        current.value = value;
+        hasValue = true;
+    }
+}
+
+void SensorDataStreamReader::flush() {
+    if (paramName.empty()) paramName = "Nieznany";
+    for (auto& m : pending) emit(m);
+    pending.clear();
+}
+
+void SensorDataStreamReader::emit(Measurement& m) {
+    if (paramName.empty()) { pending.push_back(m); return; }
+    if (threshold && m.date <= *threshold) { //juz zapisany - daty porownywane jako tekst
+        ++skippedCount;
+        if (onRecheck && !recheckFrom.empty() && m.date > recheckFrom) {
+            m.name = paramName;
+            onRecheck(m); //mozliwa korekta wartosci
+        }
+        return;
+    }
+    m.name = paramName;
+    if (onMeasurement) onMeasurement(m);
+}
+
+/// Przepuszcza cały tekst przez parser strumieniowy.
+static bool parseWhole(const std::string& body, JsonHandler& handler) {
+    JsonStreamParser parser(handler);
+    return parser.feed(body.data(), body.size()) && parser.finish();
+}
+
+bool parseStationsJson(const std::string& body, std::vector<Station>& stations) {
+    StationStreamReader reader([&](const Station& s) { stations.push_back(s); });
+    return parseWhole(body, reader);
+}
+
+bool parseSensorIdsJson(const std::string& body, std::vector<int>& sensorIds) {
+    SensorListStreamReader reader(sensorIds);
+    return parseWhole(body, reader);
+}
+
+bool parseSensorDataJson(const std::string& body, std::vector<Measurement>& measurements) {
+    SensorDataStreamReader reader([&](const Measurement& m) { measurements.push_back(m); });
+    bool ok = parseWhole(body, reader);
+    reader.flush();
+    return ok;
+}
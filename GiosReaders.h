@@ -0,0 +1,115 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "ApiClient.h"      //Station, Measurement
+#include "JsonStream.h"
+
+/// Wspólna część czytników odpowiedzi GIOŚ - śledzi głębokość zagnieżdżenia i klucz na każdym poziomie.
+class GiosReaderBase : public JsonHandler {
+public:
+    void startObject() override { open(); }
+    void endObject() override { close(); }
+    void startArray() override { open(); }
+    void endArray() override { close(); }
+    void key(const std::string& name) override { keys[depth] = name; }
+
+protected:
+    /// Klucz, pod którym leży wartość na podanej głębokości (1 = element główny).
+    const std::string& keyAt(size_t level) const { return keys[level]; }
+
+    size_t depth = 0;   ///< Bieżąca głębokość (0 = poza dokumentem)
+
+private:
+    void open() { ++depth; if (keys.size() <= depth) keys.resize(depth + 1); keys[depth].clear(); }
+    void close() { keys[depth].clear(); --depth; }
+
+    std::vector<std::string> keys = std::vector<std::string>(1); ///< Ostatni klucz na każdym poziomie
+};
+
+/// Czytnik listy stacji (station/findAll) - przekazuje każdą stację zaraz po wczytaniu jej obiektu.
+/// Czyta też lokalny plik stations.json (pola "id", "name", "province").
+class StationStreamReader : public GiosReaderBase {
+public:
+    explicit StationStreamReader(std::function<void(const Station&)> onStation);
+
+    void startObject() override;
+    void endObject() override;
+    void string(const std::string& value) override;
+    void number(double value) override;
+
+private:
+    std::function<void(const Station&)> onStation;
+    Station current;
+};
+
+/// Czytnik listy czujników stacji (station/sensors/<id>).
+class SensorListStreamReader : public GiosReaderBase {
+public:
+    explicit SensorListStreamReader(std::vector<int>& sensorIds);
+
+    void startObject() override;
+    void endObject() override;
+    void number(double value) override;
+
+private:
+    std::vector<int>& sensorIds;
+    int current = -1;
+};
+
+/// Czytnik danych czujnika (data/getData/<id>) - pomija wartości null, tak jak wersja oparta na drzewie JSON.
+/// Pomiary są przekazywane od razu, gdy znana jest nazwa miernika ("key" przychodzi przed "values").
+class SensorDataStreamReader : public GiosReaderBase {
+public:
+    explicit SensorDataStreamReader(std::function<void(const Measurement&)> onMeasurement);
+
+    void startObject() override;
+    void endObject() override;
+    void string(const std::string& value) override;
+    void number(double value) override;
+
+    /// Przekazuje pomiary wstrzymane do czasu poznania nazwy miernika (wywoływane po końcu dokumentu).
+    void flush();
+
+    /// Włącza pomijanie pomiarów nie nowszych niż zapisane (miernik -> najnowsza data); nullptr wyłącza filtr.
+    /// Mapa musi istnieć do końca parsowania.
+    void setWatermarks(const std::map<std::string, std::string>* newestDates) { watermarks = newestDates; }
+
+    /// Pomiary z okna korekt - ostatnich windowSeconds przed najnowszą zapisaną datą miernika - trafiają
+    /// do onRecheck zamiast być pomijane (GIOŚ poprawia niedawne wartości, a daty się nie zmieniają).
+    /// Liczą się do skipped(). windowSeconds = 0 wyłącza okno.
+    void setRecheckWindow(int64_t windowSeconds, std::function<void(const Measurement&)> onRecheck) {
+        recheckSeconds = windowSeconds;
+        this->onRecheck = onRecheck;
+    }
+
+    /// Liczba pomiarów pominiętych jako już zapisane (także przekazanych do onRecheck).
+    size_t skipped() const { return skippedCount; }
+
+private:
+    void emit(Measurement& m);
+
+    std::function<void(const Measurement&)> onMeasurement;
+    std::string paramName;              ///< Nazwa miernika ("key")
+    std::vector<Measurement> pending;   ///< Pomiary sprzed "key" (nietypowa kolejność pól)
+    Measurement current;
+    bool hasValue = false;              ///< Czy bieżący pomiar ma wartość inną niż null
+    const std::map<std::string, std::string>* watermarks = nullptr; ///< Najnowsze zapisane daty
+    const std::string* threshold = nullptr; ///< Najnowsza zapisana data bieżącego miernika
+    std::function<void(const Measurement&)> onRecheck;
+    int64_t recheckSeconds = 0;         ///< Szerokość okna korekt
+    std::string recheckFrom;            ///< Pomiary nowsze niż ta data (i nie nowsze niż threshold) idą do onRecheck
+    size_t skippedCount = 0;
+};
+
+/// Parsuje listę stacji w formacie API z gotowego tekstu (ta sama ścieżka co strumień HTTP).
+bool parseStationsJson(const std::string& body, std::vector<Station>& stations);
+
+/// Parsuje listę identyfikatorów czujników z gotowego tekstu.
+bool parseSensorIdsJson(const std::string& body, std::vector<int>& sensorIds);
+
+/// Parsuje dane czujnika z gotowego tekstu.
+bool parseSensorDataJson(const std::string& body, std::vector<Measurement>& measurements);
@@ -0,0 +1,547 @@
+﻿#include "HistoryArchive.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include "Trace.h"
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>    //MoveFileExA
+#include <direct.h>     //_mkdir
+#else
+#include <sys/stat.h>   //mkdir, stat
+#endif
+
+namespace {
+    const char archiveMagic[4] = { 'A', 'Q', 'H', 'A' };    //sygnatura pliku
+    const uint32_t archiveVersion = 1;
+    const uint8_t kindRaw = 0;
+    const uint8_t kindDaily = 1;
+    const uint8_t xorColumn = 0xFF;     //kolumna zapisana jako XOR liczb double
+    const int64_t secondsPerDay = 86400;
+    const double powers10[] = { 1.0, 10.0, 100.0, 1000.0, 10000.0 };
+
+    bool fileExists(const std::string& path) {
+#ifdef _WIN32
+        return GetFileAttributesA(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+#else
+        struct stat info;
+        return stat(path.c_str(), &info) == 0;
+#endif
+    }
+
+    bool moveFile(const std::string& from, const std::string& to, bool replace) {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), replace ? MOVEFILE_REPLACE_EXISTING : 0) != 0;
+#else
+        if (!replace && fileExists(to)) return false;
+        return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+
+    /// Zapis bitów od najstarszego (akumulator 64-bitowy, najwyżej 32 bity na wywołanie).
+    class BitWriter {
+    public:
+        void write(uint64_t value, int bits) {
+            if (bits > 32) {
+                write(value >> 32, bits - 32);
+                value &= 0xFFFFFFFFu;
+                bits = 32;
+            }
+            acc = (acc << bits) | (value & ((1ull << bits) - 1));
+            accBits += bits;
+            while (accBits >= 8) {
+                bytes += (char)(acc >> (accBits - 8));
+                accBits -= 8;
+            }
+            acc &= (1ull << accBits) - 1;
+        }
+
+        std::string finish() {
+            if (accBits > 0) bytes += (char)(acc << (8 - accBits));
+            accBits = 0;
+            acc = 0;
+            return std::move(bytes);
+        }
+
+    private:
+        std::string bytes;
+        uint64_t acc = 0;
+        int accBits = 0;
+    };
+
+    /// Odczyt bitów zapisanych przez BitWriter (po końcu danych zwraca zera).
+    class BitReader {
+    public:
+        BitReader(const std::string& data) : data((const unsigned char*)data.data()), size(data.size()) {}
+
+        uint64_t read(int bits) {
+            if (bits > 32) {
+                uint64_t high = read(bits - 32);
+                return high << 32 | read(32);
+            }
+            while (accBits < bits) {
+                acc = (acc << 8) | (pos < size ? data[pos] : 0);
+                ++pos;
+                accBits += 8;
+            }
+            accBits -= bits;
+            uint64_t value = (acc >> accBits) & ((1ull << bits) - 1);
+            acc &= (1ull << accBits) - 1;
+            return value;
+        }
+
+        bool bit() { return read(1) != 0; }
+
+    private:
+        const unsigned char* data;
+        size_t size;
+        size_t pos = 0;
+        uint64_t acc = 0;
+        int accBits = 0;
+    };
+
+    uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+    int64_t unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+    /// Liczba ze znakiem w przedziałach prefiksowych: 0 -> "0", potem 6/12/20 bitów, na końcu 64 bity.
+    void writeVarSigned(BitWriter& out, int64_t v) {
+        uint64_t z = zigzag(v);
+        if (z == 0) out.write(0, 1);
+        else if (z < (1u << 6)) { out.write(2, 2); out.write(z, 6); }
+        else if (z < (1u << 12)) { out.write(6, 3); out.write(z, 12); }
+        else if (z < (1u << 20)) { out.write(14, 4); out.write(z, 20); }
+        else { out.write(15, 4); out.write(z, 64); }
+    }
+
+    int64_t readVarSigned(BitReader& in) {
+        if (!in.bit()) return 0;
+        if (!in.bit()) return unzigzag(in.read(6));
+        if (!in.bit()) return unzigzag(in.read(12));
+        if (!in.bit()) return unzigzag(in.read(20));
+        return unzigzag(in.read(64));
+    }
+
+    /// Czasy: pierwszy w całości, potem różnica różnic (stały krok = 1 bit).
+    void encodeTimestamps(BitWriter& out, const int64_t* ts, size_t n) {
+        if (n == 0) return;
+        out.write((uint64_t)ts[0], 64);
+        int64_t prevDelta = 0;
+        for (size_t i = 1; i < n; ++i) {
+            int64_t delta = ts[i] - ts[i - 1];
+            writeVarSigned(out, delta - prevDelta);
+            prevDelta = delta;
+        }
+    }
+
+    void decodeTimestamps(BitReader& in, int64_t* ts, size_t n) {
+        if (n == 0) return;
+        ts[0] = (int64_t)in.read(64);
+        int64_t delta = 0;
+        for (size_t i = 1; i < n; ++i) {
+            delta += readVarSigned(in);
+            ts[i] = ts[i - 1] + delta;
+        }
+    }
+
+    /// Najmniejsza liczba miejsc po przecinku (0..4), przy której wszystkie wartości odtwarzają się dokładnie.
+    uint8_t decimalScale(const double* v, size_t n) {
+        for (uint8_t d = 0; d < 5; ++d) {
+            bool exact = true;
+            for (size_t i = 0; i < n && exact; ++i) {
+                double scaled = v[i] * powers10[d];
+                exact = std::fabs(scaled) < 9.0e15 && (double)std::llround(scaled) / powers10[d] == v[i];
+            }
+            if (exact) return d;
+        }
+        return xorColumn;
+    }
+
+    /// Kolumna wartości: liczby całkowite po przeskalowaniu (różnice) albo XOR kolejnych liczb double.
+    void encodeColumn(BitWriter& out, const double* v, size_t n) {
+        uint8_t scale = decimalScale(v, n);
+        out.write(scale, 8);
+        if (n == 0) return;
+        if (scale != xorColumn) {
+            int64_t prev = 0;
+            for (size_t i = 0; i < n; ++i) {
+                int64_t x = std::llround(v[i] * powers10[scale]);
+                writeVarSigned(out, x - prev);
+                prev = x;
+            }
+            return;
+        }
+        uint64_t prev;
+        std::memcpy(&prev, &v[0], 8);
+        out.write(prev, 64);
+        int prevLeading = -1, prevTrailing = 0;
+        for (size_t i = 1; i < n; ++i) {
+            uint64_t bits;
+            std::memcpy(&bits, &v[i], 8);
+            uint64_t x = bits ^ prev;
+            prev = bits;
+            if (x == 0) { out.write(0, 1); continue; }
+            int leading = 0, trailing = 0;
+            while (!(x & (1ull << (63 - leading)))) ++leading;
+            while (!(x & (1ull << trailing))) ++trailing;
+            if (leading > 31) leading = 31;
+            if (prevLeading >= 0 && leading >= prevLeading && trailing >= prevTrailing) { //miesci sie w poprzednim oknie
+                out.write(2, 2);
+                out.write(x >> prevTrailing, 64 - prevLeading - prevTrailing);
+            }
+            else {
+                int length = 64 - leading - trailing;
+                out.write(3, 2);
+                out.write(leading, 5);
+                out.write(length == 64 ? 0 : length, 6);
+                out.write(x >> trailing, length);
+                prevLeading = leading;
+                prevTrailing = trailing;
+            }
+        }
+    }
+
+    void decodeColumn(BitReader& in, double* v, size_t n) {
+        uint8_t scale = (uint8_t)in.read(8);
+        if (n == 0) return;
+        if (scale != xorColumn) {
+            int64_t x = 0;
+            for (size_t i = 0; i < n; ++i) {
+                x += readVarSigned(in);
+                v[i] = (double)x / powers10[scale];
+            }
+            return;
+        }
+        uint64_t prev = in.read(64);
+        std::memcpy(&v[0], &prev, 8);
+        int leading = 0, trailing = 0;
+        for (size_t i = 1; i < n; ++i) {
+            if (in.bit()) {
+                if (in.bit()) { //nowe okno bitow
+                    leading = (int)in.read(5);
+                    int length = (int)in.read(6);
+                    if (length == 0) length = 64;
+                    trailing = 64 - leading - length;
+                }
+                prev ^= in.read(64 - leading - trailing) << trailing;
+            }
+            std::memcpy(&v[i], &prev, 8);
+        }
+    }
+
+    /// Pakuje blok: czasy, potem kolejne kolumny.
+    std::string encodeBlock(const int64_t* ts, const std::vector<const double*>& columns, size_t n) {
+        BitWriter out;
+        encodeTimestamps(out, ts, n);
+        for (const double* column : columns) encodeColumn(out, column, n);
+        return out.finish();
+    }
+
+    /// Rozpakowuje blok (kolumny muszą mieć miejsce na n wartości).
+    void decodeBlock(const std::string& payload, int64_t* ts, const std::vector<double*>& columns, size_t n) {
+        BitReader in(payload);
+        decodeTimestamps(in, ts, n);
+        for (double* column : columns) decodeColumn(in, column, n);
+    }
+
+    void decodeDaily(const std::string& payload, size_t n, std::vector<DailyRollup>& out) {
+        std::vector<int64_t> days(n);
+        std::vector<double> mins(n), means(n), maxs(n), counts(n);
+        decodeBlock(payload, days.data(), { mins.data(), means.data(), maxs.data(), counts.data() }, n);
+        for (size_t i = 0; i < n; ++i) {
+            DailyRollup r;
+            r.day = days[i];
+            r.min = mins[i];
+            r.mean = means[i];
+            r.max = maxs[i];
+            r.count = (uint32_t)counts[i];
+            out.push_back(r);
+        }
+    }
+
+    /// Dołącza dobę do zestawienia (średnia ważona liczbą pomiarów).
+    void mergeDay(DailyRollup& into, const DailyRollup& day) {
+        if (into.count == 0) { into = day; return; }
+        into.min = std::min(into.min, day.min);
+        into.max = std::max(into.max, day.max);
+        into.mean = (into.mean * into.count + day.mean * day.count) / (into.count + day.count);
+        into.count += day.count;
+    }
+
+    template <typename T>
+    void put(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool get(const std::string& in, size_t& pos, T& value) {
+        if (pos + sizeof(T) > in.size()) return false;
+        std::memcpy(&value, in.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+}
+
+HistoryArchive::HistoryArchive(const std::string& directory, const ArchiveOptions& options)
+    : directory(directory), options(options) {
+    if (this->options.blockPoints == 0) this->options.blockPoints = 1024;
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+}
+
+std::string HistoryArchive::stationPath(const std::string& stationId) const {
+    return directory + "/" + stationId + ".aqh";
+}
+
+bool HistoryArchive::readBlocks(const std::string& stationId, std::vector<Block>& blocks) const {
+    std::ifstream file(stationPath(stationId), std::ios::binary);
+    if (!file.is_open()) return false;
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t pos = sizeof(archiveMagic);
+    uint32_t version = 0, count = 0;
+    if (data.size() < pos || std::memcmp(data.data(), archiveMagic, sizeof(archiveMagic)) != 0
+        || !get(data, pos, version) || version != archiveVersion || !get(data, pos, count)) {
+        std::cerr << "Niepoprawny plik archiwum stacji " << stationId << "\n";
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        Block b;
+        uint8_t nameLength = 0;
+        uint32_t bytes = 0;
+        if (!get(data, pos, nameLength) || pos + nameLength > data.size()) return false;
+        b.metric.assign(data, pos, nameLength);
+        pos += nameLength;
+        if (!get(data, pos, b.kind) || !get(data, pos, b.count) || !get(data, pos, b.first) || !get(data, pos, b.last)
+            || !get(data, pos, bytes) || pos + bytes > data.size()) {
+            std::cerr << "Ucięty plik archiwum stacji " << stationId << "\n";
+            return false;
+        }
+        b.payload.assign(data, pos, bytes);
+        pos += bytes;
+        blocks.push_back(std::move(b));
+    }
+    return true;
+}
+
+bool HistoryArchive::writeBlocks(const std::string& stationId, const std::vector<Block>& blocks) const {
+    std::string data(archiveMagic, sizeof(archiveMagic));
+    put(data, archiveVersion);
+    put(data, (uint32_t)blocks.size());
+    for (const auto& b : blocks) {
+        put(data, (uint8_t)b.metric.size());
+        data += b.metric;
+        put(data, b.kind);
+        put(data, b.count);
+        put(data, b.first);
+        put(data, b.last);
+        put(data, (uint32_t)b.payload.size());
+        data += b.payload;
+    }
+
+    std::string path = stationPath(stationId), tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc | std::ios::binary);
+        if (!out.is_open()) return false;
+        out << data;
+        if (!out) return false;
+    }
+    bool replaced = moveFile(tmpPath, path, true);
+    if (!replaced) std::remove(tmpPath.c_str());
+    return replaced;
+}
+
+bool HistoryArchive::setAside(const std::string& stationId) const {
+    const std::string path = stationPath(stationId);
+    for (int n = 1; n < 1000; ++n) { //kolejne uszkodzone pliki nie nadpisuja poprzednich
+        std::string badPath = path + (n == 1 ? ".bad" : "." + std::to_string(n) + ".bad");
+        if (moveFile(path, badPath, false)) {
+            std::cerr << "Uszkodzone archiwum stacji " << stationId << " przeniesiono do " << badPath << "\n";
+            return true;
+        }
+        if (!fileExists(badPath)) break; //blad inny niz zajeta nazwa
+    }
+    std::cerr << "Nie można odłożyć uszkodzonego archiwum stacji " << stationId << "\n";
+    return false;
+}
+
+size_t HistoryArchive::append(const std::string& stationId, const std::vector<Measurement>& measurements) {
+    return append(stationId, SeriesSet::fromMeasurements(measurements));
+}
+
+size_t HistoryArchive::append(const std::string& stationId, const SeriesSet& series) {
+    AQ_TRACE_SCOPE("archive.append");
+    std::lock_guard<std::mutex> lock(fileMutex);
+    std::vector<Block> blocks;
+    if (!readBlocks(stationId, blocks) && fileExists(stationPath(stationId))) { //brak pliku = pusta stacja
+        setAside(stationId); //uszkodzony plik nie jest nadpisywany czesciowym archiwum
+        return 0;
+    }
+
+    size_t appended = 0;
+    for (const auto& s : series.allSeries()) {
+        const std::string& metric = MetricRegistry::name(s.metric);
+        int64_t archivedUntil = (std::numeric_limits<int64_t>::min)();
+        int openBlock = -1; //ostatni niepelny blok godzinowy miernika
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            if (blocks[i].metric != metric) continue;
+            int64_t end = blocks[i].kind == kindDaily ? blocks[i].last + secondsPerDay - 1 : blocks[i].last;
+            archivedUntil = std::max(archivedUntil, end);
+            if (blocks[i].kind == kindRaw && (openBlock < 0 || blocks[i].last > blocks[openBlock].last)) openBlock = (int)i;
+        }
+
+        std::vector<int64_t> ts;
+        std::vector<double> values;
+        if (openBlock >= 0 && blocks[openBlock].count < options.blockPoints) { //dopisanie do niepelnego bloku
+            ts.resize(blocks[openBlock].count);
+            values.resize(blocks[openBlock].count);
+            decodeBlock(blocks[openBlock].payload, ts.data(), { values.data() }, ts.size());
+            blocks.erase(blocks.begin() + openBlock);
+        }
+        size_t before = ts.size();
+        for (size_t i = 0; i < s.size(); ++i) {
+            if (s.timestamps[i] <= archivedUntil || (!ts.empty() && s.timestamps[i] <= ts.back())) continue; //juz w archiwum
+            ts.push_back(s.timestamps[i]);
+            values.push_back(s.values[i]);
+        }
+        appended += ts.size() - before;
+
+        for (size_t start = 0; start < ts.size(); start += options.blockPoints) {
+            size_t n = std::min(options.blockPoints, ts.size() - start);
+            Block b;
+            b.metric = metric;
+            b.kind = kindRaw;
+            b.count = (uint32_t)n;
+            b.first = ts[start];
+            b.last = ts[start + n - 1];
+            b.payload = encodeBlock(&ts[start], { &values[start] }, n);
+            blocks.push_back(std::move(b));
+        }
+    }
+    if (appended == 0) return 0; //plik bez zmian
+
+    rollupOldBlocks(blocks);
+    if (!writeBlocks(stationId, blocks)) {
+        std::cerr << "Błąd zapisu archiwum stacji " << stationId << "\n";
+        return 0;
+    }
+    return appended;
+}
+
+void HistoryArchive::rollupOldBlocks(std::vector<Block>& blocks) const {
+    if (options.rawDays <= 0) return; //bez zestawien
+    int64_t newest = (std::numeric_limits<int64_t>::min)();
+    for (const auto& b : blocks)
+        if (b.kind == kindRaw) newest = std::max(newest, b.last);
+    if (newest == (std::numeric_limits<int64_t>::min)()) return;
+    int64_t cutoff = newest - (int64_t)options.rawDays * secondsPerDay;
+    cutoff -= ((cutoff % secondsPerDay) + secondsPerDay) % secondsPerDay; //poczatek doby - w zestawieniach tylko cale doby
+
+    std::map<std::string, std::map<int64_t, DailyRollup>> days; //miernik -> doba -> zestawienie
+    std::vector<Block> kept;
+    for (auto& b : blocks) {
+        if (b.kind != kindRaw || b.last >= cutoff) {
+            kept.push_back(std::move(b));
+            continue;
+        }
+        std::vector<int64_t> ts(b.count);
+        std::vector<double> values(b.count);
+        decodeBlock(b.payload, ts.data(), { values.data() }, b.count);
+        auto& metricDays = days[b.metric];
+        for (size_t i = 0; i < ts.size(); ++i) {
+            DailyRollup point;
+            point.day = ts[i] - ((ts[i] % secondsPerDay) + secondsPerDay) % secondsPerDay;
+            point.min = point.mean = point.max = values[i];
+            point.count = 1;
+            mergeDay(metricDays[point.day], point);
+        }
+    }
+    blocks.clear();
+    for (auto& b : kept) { //istniejace zestawienia mierzonych mierników sa pakowane od nowa razem z nowymi dobami
+        if (b.kind != kindDaily || !days.count(b.metric)) {
+            blocks.push_back(std::move(b));
+            continue;
+        }
+        std::vector<DailyRollup> existing;
+        decodeDaily(b.payload, b.count, existing);
+        for (const auto& d : existing) mergeDay(days[b.metric][d.day], d);
+    }
+    for (const auto& kv : days) {
+        std::vector<int64_t> dayStarts;
+        std::vector<double> mins, means, maxs, counts;
+        for (const auto& d : kv.second) {
+            dayStarts.push_back(d.first);
+            mins.push_back(d.second.min);
+            means.push_back(d.second.mean);
+            maxs.push_back(d.second.max);
+            counts.push_back(d.second.count);
+        }
+        for (size_t start = 0; start < dayStarts.size(); start += options.blockPoints) {
+            size_t n = std::min(options.blockPoints, dayStarts.size() - start);
+            Block b;
+            b.metric = kv.first;
+            b.kind = kindDaily;
+            b.count = (uint32_t)n;
+            b.first = dayStarts[start];
+            b.last = dayStarts[start + n - 1];
+            b.payload = encodeBlock(&dayStarts[start], { &mins[start], &means[start], &maxs[start], &counts[start] }, n);
+            blocks.push_back(std::move(b));
+        }
+    }
+}
+
+ArchiveRange HistoryArchive::query(const std::string& stationId, const std::string& metric, int64_t start, int64_t end) const {
+    AQ_TRACE_SCOPE("archive.query");
+    ArchiveRange range;
+    std::vector<Block> blocks;
+    {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        if (!readBlocks(stationId, blocks)) return range;
+    }
+    std::vector<int64_t> ts;
+    std::vector<double> values;
+    for (const auto& b : blocks) {
+        if (b.metric != metric) continue;
+        int64_t blockEnd = b.kind == kindDaily ? b.last + secondsPerDay - 1 : b.last;
+        if (blockEnd < start || b.first > end) { //blok poza zakresem - bez rozpakowania
+            range.blocksSkipped++;
+            continue;
+        }
+        range.blocksDecoded++;
+        if (b.kind == kindDaily) {
+            std::vector<DailyRollup> daily;
+            decodeDaily(b.payload, b.count, daily);
+            for (const auto& d : daily)
+                if (d.day + secondsPerDay - 1 >= start && d.day <= end) range.daily.push_back(d);
+            continue;
+        }
+        ts.resize(b.count);
+        values.resize(b.count);
+        decodeBlock(b.payload, ts.data(), { values.data() }, b.count);
+        auto from = std::lower_bound(ts.begin(), ts.end(), start) - ts.begin();
+        auto to = std::upper_bound(ts.begin(), ts.end(), end) - ts.begin();
+        range.timestamps.insert(range.timestamps.end(), ts.begin() + from, ts.begin() + to);
+        range.values.insert(range.values.end(), values.begin() + from, values.begin() + to);
+    }
+    std::sort(range.daily.begin(), range.daily.end(), [](const DailyRollup& a, const DailyRollup& b) { return a.day < b.day; });
+    return range;
+}
+
+ArchiveStats HistoryArchive::stats(const std::string& stationId) const {
+    ArchiveStats s;
+    std::vector<Block> blocks;
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if (!readBlocks(stationId, blocks)) return s;
+    for (const auto& b : blocks) (b.kind == kindDaily ? s.dailyPoints : s.rawPoints) += b.count;
+    s.blocks = blocks.size();
+    std::ifstream file(stationPath(stationId), std::ios::binary | std::ios::ate);
+    s.bytes = (size_t)file.tellg();
+    return s;
+}
@@ -0,0 +1,89 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ApiClient.h"          //Measurement
+#include "MeasurementSeries.h"  //SeriesSet
+
+/// Ustawienia archiwum.
+struct ArchiveOptions {
+    size_t blockPoints = 1024;  ///< Najwięcej punktów w bloku (jednostka dekompresji przy zapytaniu)
+    int rawDays = 90;           ///< Ile dni przed najnowszym pomiarem stacji trzymać pomiary godzinowe; starsze -> zestawienia dobowe (0 = bez zestawień)
+};
+
+/// Zestawienie jednej doby (dla pomiarów starszych niż ArchiveOptions::rawDays).
+struct DailyRollup {
+    int64_t day = 0;        ///< Początek doby (sekundy, TimeUtils.h)
+    double min = 0.0;
+    double mean = 0.0;
+    double max = 0.0;
+    uint32_t count = 0;     ///< Liczba pomiarów godzinowych
+};
+
+/// Wynik zapytania o zakres.
+struct ArchiveRange {
+    std::vector<int64_t> timestamps;    ///< Pomiary godzinowe w zakresie (rosnąco)
+    std::vector<double> values;
+    std::vector<DailyRollup> daily;     ///< Doby w zakresie zapisane już tylko jako zestawienia (rosnąco)
+    size_t blocksDecoded = 0;           ///< Bloki rozpakowane (nachodzące na zakres)
+    size_t blocksSkipped = 0;           ///< Bloki miernika pominięte bez rozpakowania
+};
+
+/// Rozmiar archiwum stacji.
+struct ArchiveStats {
+    size_t rawPoints = 0;       ///< Pomiary godzinowe
+    size_t dailyPoints = 0;     ///< Zestawienia dobowe
+    size_t blocks = 0;
+    size_t bytes = 0;           ///< Rozmiar pliku
+};
+
+/// Długoterminowe archiwum pomiarów: jeden plik na stację (katalog/<id>.aqh), bloki po blockPoints punktów
+/// jednego miernika. Czasy zapisywane są jako różnice różnic (stały krok godzinowy = 1 bit), a wartości
+/// jako różnice liczb całkowitych, gdy mają co najwyżej 4 miejsca po przecinku (dane GIOŚ), w przeciwnym
+/// razie jako XOR kolejnych liczb double. Pomiary starsze niż rawDays przed najnowszym pomiarem stacji
+/// są zastępowane całymi blokami zestawieniami dobowymi (min, średnia, maks., liczba). Zapytanie rozpakowuje tylko bloki
+/// nachodzące na zakres.
+class HistoryArchive {
+public:
+    explicit HistoryArchive(const std::string& directory, const ArchiveOptions& options = ArchiveOptions());
+
+    /// Dopisuje pomiary nowsze niż zarchiwizowane (osobno dla każdego miernika) i przenosi stare bloki
+    /// do zestawień dobowych. Plik stacji jest zapisywany w całości i podmieniany atomowo.
+    /// Plik, którego nie da się odczytać (uszkodzony, inna wersja), nie jest nadpisywany: zostaje przeniesiony
+    /// do "<id>.aqh.bad" (kolejne: "<id>.aqh.2.bad"...), a wywołanie zwraca 0; następne zaczyna nowe archiwum.
+    /// \return Liczba dopisanych pomiarów.
+    size_t append(const std::string& stationId, const SeriesSet& series);
+
+    /// Wersja append dla pomiarów w formacie API (np. DeltaSyncResult::fresh).
+    size_t append(const std::string& stationId, const std::vector<Measurement>& measurements);
+
+    /// Pomiary i zestawienia dobowe miernika z zakresu [start, end].
+    ArchiveRange query(const std::string& stationId, const std::string& metric, int64_t start, int64_t end) const;
+
+    /// Rozmiar archiwum stacji.
+    ArchiveStats stats(const std::string& stationId) const;
+
+private:
+    /// Blok w pamięci (nagłówek i spakowane dane).
+    struct Block {
+        std::string metric;
+        uint8_t kind = 0;       //0 = pomiary godzinowe, 1 = zestawienia dobowe
+        uint32_t count = 0;
+        int64_t first = 0;      //czas pierwszego i ostatniego punktu
+        int64_t last = 0;
+        std::string payload;
+    };
+
+    std::string stationPath(const std::string& stationId) const;
+    bool readBlocks(const std::string& stationId, std::vector<Block>& blocks) const;
+    bool writeBlocks(const std::string& stationId, const std::vector<Block>& blocks) const;
+    bool setAside(const std::string& stationId) const; //przenosi nieczytelny plik stacji do .bad
+    void rollupOldBlocks(std::vector<Block>& blocks) const;
+
+    std::string directory;
+    ArchiveOptions options;
+    mutable std::mutex fileMutex;   ///< Jeden zapis lub odczyt pliku stacji naraz
+};
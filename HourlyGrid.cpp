@@ -0,0 +1,263 @@
+﻿#include "HourlyGrid.h"
+#include "Statistics.h"     //statisticsUseAvx2
+#include "Trace.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define AQ_HAVE_X86 1
+#include <immintrin.h>  //AVX2
+#if defined(_MSC_VER)
+#define AQ_TARGET_AVX2                                      //MSVC pozwala na intrinsics AVX2 bez /arch
+#else
+#define AQ_TARGET_AVX2 __attribute__((target("avx2")))     //tylko ta funkcja kompilowana pod AVX2
+#endif
+#endif
+
+namespace {
+    const int64_t hourSeconds = 3600;
+
+    /// Początek godziny zawierającej t (także dla czasów sprzed 1970).
+    int64_t floorHour(int64_t t) {
+        int64_t r = t % hourSeconds;
+        return r < 0 ? t - r - hourSeconds : t - r;
+    }
+
+    /// Uzupełnia przerwy jednego wiersza siatki; zwraca liczbę uzupełnionych komórek.
+    size_t fillGaps(double* row, size_t hours, const ResampleOptions& options) {
+        if (options.gaps == GapPolicy::Leave) return 0;
+        size_t filled = 0;
+        size_t prev = hours;    //ostatnia godzina z pomiarem (hours = jeszcze brak)
+        for (size_t h = 0; h < hours; ++h) {
+            if (std::isnan(row[h])) continue;
+            size_t gap = prev < hours ? h - prev - 1 : 0;
+            if (gap > 0 && (options.maxGap == 0 || gap <= options.maxGap)) {
+                double a = row[prev], b = row[h];
+                for (size_t k = prev + 1; k < h; ++k)
+                    row[k] = options.gaps == GapPolicy::Linear ? a + (b - a) * (double)(k - prev) / (double)(h - prev) : a;
+                filled += gap;
+            }
+            prev = h;
+        }
+        if (options.gaps == GapPolicy::Hold && prev < hours) { //za ostatnim pomiarem
+            size_t last = options.maxGap == 0 ? hours : std::min(hours, prev + 1 + options.maxGap);
+            for (size_t k = prev + 1; k < last; ++k) row[k] = row[prev];
+            filled += last - prev - 1;
+        }
+        return filled;
+    }
+
+    /// Sumy jednej pary mierników (i, j) względem przesunięć: x = v - shift, 0 dla braku pomiaru.
+    struct PairSums {
+        double n = 0.0;     //wspolne godziny
+        double si = 0.0;    //suma x_i (tam, gdzie jest j)
+        double sj = 0.0;
+        double sii = 0.0;   //suma x_i^2 (tam, gdzie jest j)
+        double sjj = 0.0;
+        double sij = 0.0;   //suma x_i * x_j
+    };
+
+    /// Blok siatki przygotowany do jądra: dla każdego miernika wartości przesunięte i wagi 0/1.
+    struct Block {
+        size_t length = 0;
+        std::vector<double> x;  //metrics x blockHours
+        std::vector<double> w;
+    };
+
+    void pairScalar(const double* xi, const double* wi, const double* xj, const double* wj, size_t begin, size_t n, PairSums& s) {
+        for (size_t h = begin; h < n; ++h) {
+            double aw = xi[h] * wj[h], bw = xj[h] * wi[h];
+            s.n += wi[h] * wj[h];
+            s.si += aw;
+            s.sj += bw;
+            s.sii += aw * xi[h];
+            s.sjj += bw * xj[h];
+            s.sij += xi[h] * xj[h];
+        }
+    }
+
+#ifdef AQ_HAVE_X86
+    /// Suma czterech elementów rejestru.
+    AQ_TARGET_AVX2 inline double horizontalSum(__m256d x) {
+        __m128d lo = _mm256_castpd256_pd128(x);
+        __m128d hi = _mm256_extractf128_pd(x, 1);
+        lo = _mm_add_pd(lo, hi);
+        return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+    }
+
+    AQ_TARGET_AVX2 void pairAvx2(const double* xi, const double* wi, const double* xj, const double* wj, size_t n, PairSums& s) {
+        __m256d cnt = _mm256_setzero_pd(), si = cnt, sj = cnt, sii = cnt, sjj = cnt, sij = cnt;
+        size_t h = 0;
+        for (; h + 4 <= n; h += 4) {
+            __m256d a = _mm256_loadu_pd(xi + h), b = _mm256_loadu_pd(xj + h);
+            __m256d wa = _mm256_loadu_pd(wi + h), wb = _mm256_loadu_pd(wj + h);
+            __m256d aw = _mm256_mul_pd(a, wb), bw = _mm256_mul_pd(b, wa);   //bez FMA - wynik jak w wersji skalarnej
+            cnt = _mm256_add_pd(cnt, _mm256_mul_pd(wa, wb));
+            si = _mm256_add_pd(si, aw);
+            sj = _mm256_add_pd(sj, bw);
+            sii = _mm256_add_pd(sii, _mm256_mul_pd(aw, a));
+            sjj = _mm256_add_pd(sjj, _mm256_mul_pd(bw, b));
+            sij = _mm256_add_pd(sij, _mm256_mul_pd(a, b));
+        }
+        s.n += horizontalSum(cnt);
+        s.si += horizontalSum(si);
+        s.sj += horizontalSum(sj);
+        s.sii += horizontalSum(sii);
+        s.sjj += horizontalSum(sjj);
+        s.sij += horizontalSum(sij);
+        pairScalar(xi, wi, xj, wj, h, n, s); //koncowka
+    }
+#endif
+
+    /// Sumy pary dla jednego bloku w wersji AVX2 lub skalarnej.
+    void runPair(const double* xi, const double* wi, const double* xj, const double* wj, size_t n, PairSums& s) {
+#ifdef AQ_HAVE_X86
+        if (statisticsUseAvx2()) { pairAvx2(xi, wi, xj, wj, n, s); return; }
+#endif
+        pairScalar(xi, wi, xj, wj, 0, n, s);
+    }
+}
+
+bool parseGapPolicy(const std::string& text, GapPolicy& policy) {
+    if (text == "leave") policy = GapPolicy::Leave;
+    else if (text == "linear") policy = GapPolicy::Linear;
+    else if (text == "hold") policy = GapPolicy::Hold;
+    else return false;
+    return true;
+}
+
+HourlyGrid resampleHourly(const SeriesSet& series, const ResampleOptions& options) {
+    AQ_TRACE_SCOPE("grid.resample");
+    HourlyGrid grid;
+    std::vector<SeriesView> views;
+    int64_t first = (std::numeric_limits<int64_t>::max)(), last = (std::numeric_limits<int64_t>::min)();
+    for (const std::string& name : series.metricNames()) { //wiersze po nazwie - ta sama kolejnosc dla kazdej stacji
+        SeriesView view = series.range(name, options.start, options.end);
+        if (view.empty()) continue;
+        grid.metrics.push_back(name);
+        views.push_back(view);
+        first = std::min(first, view.timestamps[0]);
+        last = std::max(last, view.timestamps[view.count - 1]);
+    }
+    if (views.empty()) return grid;
+
+    grid.start = floorHour(first);
+    grid.hours = (size_t)((floorHour(last) - grid.start) / hourSeconds) + 1;
+    grid.values.assign(views.size() * grid.hours, std::numeric_limits<double>::quiet_NaN());
+    for (size_t m = 0; m < views.size(); ++m) {
+        const SeriesView& view = views[m];
+        double* row = grid.values.data() + m * grid.hours;
+        size_t hour = grid.hours;   //biezaca godzina (czasy rosnaco - pomiary jednej godziny sa obok siebie)
+        double sum = 0.0;
+        uint32_t count = 0;
+        for (size_t i = 0; i < view.count; ++i) {
+            size_t h = (size_t)((view.timestamps[i] - grid.start) / hourSeconds);
+            if (h != hour) {
+                if (count) row[hour] = count > 1 ? sum / count : sum; //kilka pomiarow w jednej godzinie - srednia
+                hour = h;
+                sum = 0.0;
+                count = 0;
+                grid.observed++;
+            }
+            sum += view.values[i];
+            count++;
+        }
+        if (count) row[hour] = count > 1 ? sum / count : sum;
+        grid.filled += fillGaps(row, grid.hours, options);
+    }
+    grid.missing = grid.values.size() - grid.observed - grid.filled;
+    AQ_TRACE_COUNT("grid.cells", grid.values.size());
+    return grid;
+}
+
+CorrelationMatrix correlateMetrics(const HourlyGrid& grid, size_t blockHours) {
+    AQ_TRACE_SCOPE("grid.correlate");
+    const size_t n = grid.metrics.size();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    CorrelationMatrix result;
+    result.metrics = grid.metrics;
+    result.covariance.assign(n * n, nan);
+    result.correlation.assign(n * n, nan);
+    result.overlap.assign(n * n, 0);
+    if (n == 0 || grid.hours == 0) return result;
+    if (blockHours == 0) blockHours = 256;
+
+    std::vector<double> shift(n, 0.0);  //pierwsza wartosc miernika - sumy bez utraty dokladnosci
+    for (size_t m = 0; m < n; ++m) {
+        const double* row = grid.row(m);
+        for (size_t h = 0; h < grid.hours; ++h)
+            if (!std::isnan(row[h])) { shift[m] = row[h]; break; }
+    }
+
+    std::vector<PairSums> sums(n * (n + 1) / 2);    //gorny trojkat z przekatna
+    Block block;
+    block.x.resize(n * blockHours);
+    block.w.resize(n * blockHours);
+    for (size_t begin = 0; begin < grid.hours; begin += blockHours) { //jeden przebieg po siatce
+        block.length = std::min(blockHours, grid.hours - begin);
+        for (size_t m = 0; m < n; ++m) {
+            const double* row = grid.row(m) + begin;
+            double* x = &block.x[m * blockHours];
+            double* w = &block.w[m * blockHours];
+            for (size_t h = 0; h < block.length; ++h) {
+                bool present = !std::isnan(row[h]);
+                x[h] = present ? row[h] - shift[m] : 0.0;
+                w[h] = present ? 1.0 : 0.0;
+            }
+        }
+        size_t pair = 0;
+        for (size_t i = 0; i < n; ++i) //blok wszystkich miernikow jest w L1 dla kazdej pary
+            for (size_t j = i; j < n; ++j)
+                runPair(&block.x[i * blockHours], &block.w[i * blockHours], &block.x[j * blockHours], &block.w[j * blockHours],
+                    block.length, sums[pair++]);
+    }
+
+    size_t pair = 0;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i; j < n; ++j) {
+            const PairSums& s = sums[pair++];
+            size_t count = (size_t)s.n;
+            result.overlap[i * n + j] = result.overlap[j * n + i] = count;
+            if (count < 3) continue;
+            double cij = s.sij - s.si * s.sj / s.n;    //sumy odchylen od sredniej wspolnych godzin
+            double cii = s.sii - s.si * s.si / s.n;
+            double cjj = s.sjj - s.sj * s.sj / s.n;
+            result.covariance[i * n + j] = result.covariance[j * n + i] = cij / (s.n - 1);
+            if (cii > 0.0 && cjj > 0.0)
+                result.correlation[i * n + j] = result.correlation[j * n + i] = std::max(-1.0, std::min(1.0, cij / std::sqrt(cii * cjj)));
+        }
+    }
+    return result;
+}
+
+std::vector<StationCorrelation> correlateStations(const std::vector<std::string>& stationIds, const CorrelationSource& source,
+    const ResampleOptions& options, unsigned threadCount) {
+    AQ_TRACE_SCOPE("grid.stations");
+    std::vector<StationCorrelation> slots(stationIds.size());  //miejsce na wynik kazdej stacji - bez blokad
+    std::vector<char> loaded(stationIds.size(), 0);
+    {
+        WorkStealingPool pool(threadCount);
+        for (size_t k = 0; k < stationIds.size(); ++k) {
+            pool.submit([&, k]() { //zadanie = jedna stacja (wczytanie, siatka, macierz)
+                SeriesSet series;
+                if (!source(stationIds[k], series)) return;
+                HourlyGrid grid = resampleHourly(series, options);
+                if (grid.metrics.empty()) return;
+                StationCorrelation& out = slots[k];
+                out.stationId = stationIds[k];
+                out.hours = grid.hours;
+                out.observed = grid.observed;
+                out.filled = grid.filled;
+                out.matrix = correlateMetrics(grid);
+                loaded[k] = 1;
+            });
+        }
+        pool.wait();
+    }
+
+    std::vector<StationCorrelation> result;
+    for (size_t k = 0; k < slots.size(); ++k)
+        if (loaded[k]) result.push_back(std::move(slots[k]));
+    return result;
+}
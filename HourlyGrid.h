@@ -0,0 +1,77 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+#include "MeasurementSeries.h"  //SeriesSet
+
+/// Co zrobić z godziną bez pomiaru między dwoma pomiarami.
+enum class GapPolicy {
+    Leave,      ///< Zostaje pusta (NaN)
+    Linear,     ///< Interpolacja liniowa między sąsiednimi pomiarami
+    Hold        ///< Ostatnia znana wartość (także za ostatnim pomiarem miernika)
+};
+
+/// Polityka z nazwy ("leave", "linear", "hold"); false dla nieznanej nazwy.
+bool parseGapPolicy(const std::string& text, GapPolicy& policy);
+
+/// Ustawienia przeliczenia na siatkę godzinową.
+struct ResampleOptions {
+    GapPolicy gaps = GapPolicy::Leave;
+    size_t maxGap = 6;      ///< Najdłuższa wypełniana przerwa [h] (0 = bez ograniczenia); dłuższe zostają puste
+    int64_t start = (std::numeric_limits<int64_t>::min)();  ///< Zakres pomiarów [start, end] (sekundy, TimeUtils.h)
+    int64_t end = (std::numeric_limits<int64_t>::max)();
+};
+
+/// Wszystkie mierniki stacji na wspólnej siatce godzinowej: wiersz na miernik (po nazwie rosnąco),
+/// kolumna na godzinę. Pomiary z tej samej godziny są uśredniane, brak pomiaru to NaN.
+struct HourlyGrid {
+    int64_t start = 0;                  ///< Początek pierwszej godziny
+    size_t hours = 0;                   ///< Liczba kolumn
+    std::vector<std::string> metrics;   ///< Nazwy mierników (wiersze)
+    std::vector<double> values;         ///< metrics.size() x hours, wierszami
+    size_t observed = 0;                ///< Komórki z pomiarem
+    size_t filled = 0;                  ///< Komórki uzupełnione wg GapPolicy
+    size_t missing = 0;                 ///< Komórki puste
+
+    const double* row(size_t metric) const { return values.data() + metric * hours; }
+};
+
+/// Przelicza serie stacji na siatkę godzinową: komórka to średnia pomiarów z danej godziny, godzina bez
+/// pomiaru ma NaN, a przerwy są uzupełniane wg options.
+HourlyGrid resampleHourly(const SeriesSet& series, const ResampleOptions& options);
+
+/// Macierz kowariancji i korelacji mierników (dla każdej pary tylko godziny z pomiarem obu mierników).
+struct CorrelationMatrix {
+    std::vector<std::string> metrics;
+    std::vector<double> covariance;     ///< n x n; NaN, gdy para ma mniej niż 3 wspólne godziny
+    std::vector<double> correlation;    ///< n x n (Pearson); NaN także dla stałej serii
+    std::vector<size_t> overlap;        ///< n x n - liczba wspólnych godzin
+
+    double at(const std::vector<double>& matrix, size_t i, size_t j) const { return matrix[i * metrics.size() + j]; }
+};
+
+/// Liczy macierz w jednym przebiegu po siatce, blokami blockHours godzin: blok wszystkich mierników
+/// mieści się w pamięci podręcznej L1, a dla każdej pary zbierane są sumy (liczba, sumy, kwadraty,
+/// iloczyny) względem pierwszej wartości miernika (bez utraty dokładności przy dużych wartościach).
+/// Pętla po godzinach bloku używa AVX2, jeśli statisticsUseAvx2() (w przeciwnym razie wersja skalarna).
+CorrelationMatrix correlateMetrics(const HourlyGrid& grid, size_t blockHours = 256);
+
+/// Wynik jednej stacji.
+struct StationCorrelation {
+    std::string stationId;
+    size_t hours = 0;           ///< Długość siatki
+    size_t observed = 0;        ///< Komórki z pomiarem (jak HourlyGrid)
+    size_t filled = 0;
+    CorrelationMatrix matrix;
+};
+
+/// Źródło danych stacji (np. MeasurementStore); false = brak danych.
+using CorrelationSource = std::function<bool(const std::string& stationId, SeriesSet& series)>;
+
+/// Siatka i macierz dla każdej stacji równolegle (zadanie puli WorkStealingPool = stacja).
+/// threadCount = 0 oznacza liczbę rdzeni. Wyniki w kolejności stationIds (stacje bez danych pominięte).
+std::vector<StationCorrelation> correlateStations(const std::vector<std::string>& stationIds, const CorrelationSource& source,
+    const ResampleOptions& options, unsigned threadCount = 0);
@@ -0,0 +1,179 @@
+﻿#include "HttpSession.h"
+#include <httplib.h>
+#include <iostream>
+
+HttpSessionPool::HttpSessionPool(const std::string& baseUrl) : baseUrl(baseUrl) {}
+
+HttpSessionPool::~HttpSessionPool() = default; //httplib::Client jest tu kompletnym typem
+
+void HttpSessionPool::setConnectTimeout(int milliseconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    connectTimeoutMs = milliseconds > 1 ? milliseconds : 1;
+    clearIdle(); //nowe polaczenia dostana nowe ustawienia
+}
+
+void HttpSessionPool::setReadTimeout(int milliseconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    readTimeoutMs = milliseconds > 1 ? milliseconds : 1;
+    clearIdle();
+}
+
+void HttpSessionPool::setCompression(bool enabled) {
+#ifndef CPPHTTPLIB_ZLIB_SUPPORT
+    if (enabled) {
+        std::cerr << "Kompresja HTTP niedostępna (httplib bez zlib).\n";
+        return;
+    }
+#endif
+    std::lock_guard<std::mutex> lock(mutex);
+    compression = enabled;
+    clearIdle();
+}
+
+bool HttpSessionPool::compressionEnabled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return compression;
+}
+
+void HttpSessionPool::setMaxIdle(size_t count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    maxIdle = count;
+    if (idle.size() > maxIdle) idle.resize(maxIdle);
+}
+
+void HttpSessionPool::closeIdle() {
+    std::lock_guard<std::mutex> lock(mutex);
+    clearIdle();
+}
+
+void HttpSessionPool::clearIdle() {
+    idle.clear(); //destruktor klienta zamyka gniazdo
+}
+
+void HttpSessionPool::configure(httplib::Client& cli) {
+    cli.set_keep_alive(true); //polaczenie zostaje otwarte miedzy zadaniami
+    cli.set_connection_timeout(connectTimeoutMs / 1000, (connectTimeoutMs % 1000) * 1000);
+    cli.set_read_timeout(readTimeoutMs / 1000, (readTimeoutMs % 1000) * 1000);
+    cli.set_socket_options([this](httplib::socket_t) { connectionsOpened++; }); //wywolywane dla kazdego nowego gniazda
+    if (compression) {
+        cli.set_decompress(true);
+        cli.set_default_headers({ { "Accept-Encoding", "gzip, deflate" } });
+    }
+}
+
+std::unique_ptr<httplib::Client> HttpSessionPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty()) { //ponowne uzycie otwartego polaczenia
+            std::unique_ptr<httplib::Client> cli = std::move(idle.back());
+            idle.pop_back();
+            return cli;
+        }
+    }
+    std::unique_ptr<httplib::Client> cli(new httplib::Client(baseUrl));
+    std::lock_guard<std::mutex> lock(mutex); //ustawienia czytane pod blokada
+    configure(*cli);
+    return cli;
+}
+
+void HttpSessionPool::release(std::unique_ptr<httplib::Client> cli, bool reusable) {
+    if (!reusable) return; //zerwane polaczenie nie wraca do puli
+    std::lock_guard<std::mutex> lock(mutex);
+    if (idle.size() < maxIdle) idle.push_back(std::move(cli));
+}
+
+bool HttpSessionPool::admit() {
+    if (breaker.allowRequest()) return true;
+    failedRequests++; //serwer niedostepny - bez czekania na limit czasu
+    return false;
+}
+
+void HttpSessionPool::recordHealth(bool serverResponded) {
+    if (serverResponded) breaker.recordSuccess();
+    else breaker.recordFailure(); //brak polaczenia, limit czasu lub status 5xx (takze z przerwana trescia)
+}
+
+bool HttpSessionPool::get(const std::string& path, const ContentReceiver& receiver) {
+    if (!admit()) return false;
+    std::unique_ptr<httplib::Client> cli = acquire();
+    int status = 0; //odczytany przed trescia - znany takze wtedy, gdy odbiornik przerwie pobieranie
+    auto res = cli->Get(path.c_str(), [&](const httplib::Response& response) {
+        status = response.status;
+        return true;
+    }, [&](const char* data, size_t size) {
+        bytesReceived += size;
+        return status != 200 || receiver(data, size); //tresc bledu (np. strona 503) nie trafia do odbiornika
+    });
+    requestsServed++;
+    recordHealth(status > 0 && status < 500); //404 to nie awaria serwera
+    const bool ok = res && status == 200;
+    if (!ok) failedRequests++;
+    release(std::move(cli), (bool)res);
+    return ok;
+}
+
+HttpFetch HttpSessionPool::getConditional(const std::string& path, HttpValidators& validators, const ContentReceiver& receiver) {
+    httplib::Headers headers;
+    if (!validators.etag.empty()) headers.emplace("If-None-Match", validators.etag);
+    if (!validators.lastModified.empty()) headers.emplace("If-Modified-Since", validators.lastModified);
+
+    if (!admit()) return HttpFetch::Failed;
+    std::unique_ptr<httplib::Client> cli = acquire();
+    int status = 0;
+    auto res = cli->Get(path.c_str(), headers, [&](const httplib::Response& response) {
+        status = response.status;
+        return true;
+    }, [&](const char* data, size_t size) {
+        bytesReceived += size;
+        return status != 200 || receiver(data, size);
+    });
+    requestsServed++;
+    recordHealth(status > 0 && status < 500);
+    HttpFetch result = HttpFetch::Failed;
+    if (res && status == 304) {
+        notModified++;
+        result = HttpFetch::NotModified;
+    }
+    else if (res && status == 200) {
+        validators.etag = res->get_header_value("ETag");
+        validators.lastModified = res->get_header_value("Last-Modified");
+        result = HttpFetch::Ok;
+    }
+    else failedRequests++;
+    release(std::move(cli), (bool)res);
+    return result;
+}
+
+bool HttpSessionPool::get(const std::string& path, std::string& body) {
+    body.clear();
+    return get(path, [&](const char* data, size_t size) {
+        body.append(data, size);
+        return true;
+    });
+}
+
+HttpSessionStats HttpSessionPool::stats() const {
+    HttpSessionStats s;
+    s.connectionsOpened = connectionsOpened;
+    s.requestsServed = requestsServed;
+    s.failedRequests = failedRequests;
+    s.notModified = notModified;
+    s.bytesReceived = bytesReceived;
+    return s;
+}
+
+bool HttpSessionPool::serverAvailable() const {
+    return breaker.state() == CircuitBreaker::State::Closed;
+}
+
+CircuitBreakerStats HttpSessionPool::health() const {
+    return breaker.stats();
+}
+
+void HttpSessionPool::setBreakerOptions(const CircuitBreakerOptions& options) {
+    breaker.setOptions(options);
+}
+
+void HttpSessionPool::resetBreaker() {
+    breaker.reset();
+}
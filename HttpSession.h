@@ -0,0 +1,125 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "CircuitBreaker.h"
+
+namespace httplib { class Client; }    //httplib.h tylko w pliku .cpp (koliduje z windows.h w GUI)
+
+/// Liczniki sesji HTTP.
+struct HttpSessionStats {
+    size_t connectionsOpened = 0;   ///< Liczba nawiązanych połączeń TCP
+    size_t requestsServed = 0;      ///< Liczba wykonanych żądań (udanych i nieudanych)
+    size_t failedRequests = 0;      ///< Żądania bez odpowiedzi lub ze statusem innym niż 200/304
+    size_t notModified = 0;         ///< Odpowiedzi 304 na żądania warunkowe (bez treści)
+    size_t bytesReceived = 0;       ///< Odebrane bajty treści (po dekompresji)
+
+    /// Średnia liczba żądań na jedno połączenie (miara ponownego użycia połączeń).
+    double requestsPerConnection() const { return connectionsOpened ? (double)requestsServed / connectionsOpened : 0.0; }
+};
+
+/// Walidatory ostatniej odpowiedzi do żądań warunkowych (If-None-Match / If-Modified-Since).
+struct HttpValidators {
+    std::string etag;           ///< Nagłówek ETag
+    std::string lastModified;   ///< Nagłówek Last-Modified
+};
+
+/// Wynik żądania warunkowego.
+enum class HttpFetch {
+    Ok,             ///< 200 - treść przekazana do odbiornika
+    NotModified,    ///< 304 - zasób bez zmian, treść nie została przesłana
+    Failed          ///< Brak odpowiedzi lub inny status
+};
+
+/// Długożyjąca sesja HTTP dla jednego serwera: pula klientów z keep-alive, używana przez wszystkie
+/// wywołania ApiClient. Połączenie zwolnione po udanym żądaniu wraca do puli i obsługuje kolejne,
+/// więc wybór stacji nie płaci za kilka nowych połączeń TCP. Każdy wątek dostaje na czas żądania
+/// osobnego klienta (httplib::Client nie jest bezpieczny przy współbieżnym użyciu).
+/// Sesja pilnuje dostępności serwera bezpiecznikiem (CircuitBreaker): gdy serwer nie odpowiada,
+/// kolejne żądania kończą się od razu błędem zamiast czekać na limit czasu połączenia.
+class HttpSessionPool {
+public:
+    /// Funkcja odbierająca kolejne kawałki treści odpowiedzi; false przerywa pobieranie.
+    using ContentReceiver = std::function<bool(const char* data, size_t size)>;
+
+    /// Tworzy sesję dla podanego adresu (np. "http://api.gios.gov.pl").
+    explicit HttpSessionPool(const std::string& baseUrl);
+    ~HttpSessionPool();
+
+    HttpSessionPool(const HttpSessionPool&) = delete;
+    HttpSessionPool& operator=(const HttpSessionPool&) = delete;
+
+    /// Ustawia limit czasu nawiązania połączenia [ms]. Zmiana ustawień zamyka bezczynne połączenia.
+    void setConnectTimeout(int milliseconds);
+
+    /// Ustawia limit czasu odczytu odpowiedzi [ms].
+    void setReadTimeout(int milliseconds);
+
+    /// Włącza prośbę o kompresję odpowiedzi (gzip/deflate). Wymaga httplib z CPPHTTPLIB_ZLIB_SUPPORT,
+    /// w przeciwnym razie ustawienie jest ignorowane.
+    void setCompression(bool enabled);
+
+    /// Czy odpowiedzi są pobierane w postaci skompresowanej.
+    bool compressionEnabled() const;
+
+    /// Ogranicza liczbę bezczynnych połączeń trzymanych w puli.
+    void setMaxIdle(size_t count);
+
+    /// Wykonuje GET i przekazuje treść odpowiedzi kawałkami do receiver (tylko przy statusie 200).
+    /// Zwraca false przy braku odpowiedzi lub statusie innym niż 200. Bezpiecznik ocenia serwer po statusie
+    /// odczytanym przed treścią, więc przerwanie pobierania przez receiver nie ukrywa odpowiedzi 5xx.
+    bool get(const std::string& path, const ContentReceiver& receiver);
+
+    /// Wykonuje GET warunkowy: wysyła walidatory z poprzedniej odpowiedzi, a po odpowiedzi 200 zapisuje nowe.
+    /// Przy odpowiedzi 304 odbiornik nie jest wywoływany.
+    HttpFetch getConditional(const std::string& path, HttpValidators& validators, const ContentReceiver& receiver);
+
+    /// Wykonuje GET i zwraca całą treść odpowiedzi.
+    bool get(const std::string& path, std::string& body);
+
+    /// Zamyka bezczynne połączenia.
+    void closeIdle();
+
+    /// Zwraca kopię liczników.
+    HttpSessionStats stats() const;
+
+    /// Czy serwer uznawany jest za dostępny (bezpiecznik zamknięty).
+    bool serverAvailable() const;
+
+    /// Zwraca stan i liczniki bezpiecznika.
+    CircuitBreakerStats health() const;
+
+    /// Zmienia ustawienia bezpiecznika (próg błędów, przerwy).
+    void setBreakerOptions(const CircuitBreakerOptions& options);
+
+    /// Zamyka bezpiecznik - następne żądanie znów łączy się z serwerem.
+    void resetBreaker();
+
+private:
+    std::unique_ptr<httplib::Client> acquire();
+    void release(std::unique_ptr<httplib::Client> client, bool reusable);
+    void configure(httplib::Client& client);
+    void clearIdle();
+    bool admit(); //zgoda bezpiecznika; odrzucone zadanie liczy sie jako nieudane
+    void recordHealth(bool serverResponded);
+
+    std::string baseUrl;
+    mutable std::mutex mutex;                               ///< Chroni pulę i ustawienia
+    std::vector<std::unique_ptr<httplib::Client>> idle;     ///< Połączenia gotowe do ponownego użycia
+    size_t maxIdle = 8;
+    int connectTimeoutMs = 5000;
+    int readTimeoutMs = 5000;
+    bool compression = false;
+    CircuitBreaker breaker;                                 ///< Stan dostępności serwera
+
+    std::atomic<size_t> connectionsOpened{ 0 };
+    std::atomic<size_t> requestsServed{ 0 };
+    std::atomic<size_t> failedRequests{ 0 };
+    std::atomic<size_t> notModified{ 0 };
+    std::atomic<size_t> bytesReceived{ 0 };
+};
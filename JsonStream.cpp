@@ -0,0 +1,228 @@
+﻿#include "JsonStream.h"
+#include <cstdlib>
+
+JsonStreamParser::JsonStreamParser(JsonHandler& handler) : handler(handler) {}
+
+bool JsonStreamParser::fail(const char* message) {
+    hasError = true;
+    errorText = std::string(message) + " (bajt " + std::to_string(consumed) + ")";
+    return false;
+}
+
+bool JsonStreamParser::feed(const char* data, size_t size) {
+    static const unsigned char bom[3] = { 0xEF, 0xBB, 0xBF };
+    if (hasError) return false;
+
+    for (size_t i = 0; i < size; ++i, ++consumed) {
+        const char c = data[i];
+        if (consumed == bomBytes && bomBytes < 3 && (unsigned char)c == bom[bomBytes]) { //pliki zapisane z BOM
+            ++bomBytes;
+            continue;
+        }
+
+        switch (token) { //dokonczenie rozpoczetego tokenu
+        case Token::String:
+            if (!stringChar(c)) return false;
+            continue;
+        case Token::Literal:
+            if (!literalChar(c)) return false;
+            continue;
+        case Token::Number:
+            if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+                text.push_back(c);
+                continue;
+            }
+            if (!finishNumber()) return false; //znak konczacy liczbe jest przetwarzany dalej
+            break;
+        case Token::None:
+            break;
+        }
+
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') continue;
+
+        switch (expect) {
+        case Expect::FirstValueOrEnd:
+            if (c == ']') { if (!closeContainer(c)) return false; break; }
+            if (!startValue(c)) return false;
+            break;
+        case Expect::Value:
+            if (!startValue(c)) return false;
+            break;
+        case Expect::FirstKeyOrEnd:
+            if (c == '}') { if (!closeContainer(c)) return false; break; }
+            if (c != '"') return fail("Oczekiwano klucza");
+            token = Token::String;
+            stringIsKey = true;
+            text.clear();
+            break;
+        case Expect::Key:
+            if (c != '"') return fail("Oczekiwano klucza");
+            token = Token::String;
+            stringIsKey = true;
+            text.clear();
+            break;
+        case Expect::Colon:
+            if (c != ':') return fail("Oczekiwano ':'");
+            expect = Expect::Value;
+            break;
+        case Expect::CommaOrEnd:
+            if (c == ',') expect = stack.back() == '{' ? Expect::Key : Expect::Value;
+            else if (!closeContainer(c)) return false;
+            break;
+        case Expect::Done:
+            return fail("Dane za koncem dokumentu");
+        }
+    }
+    return true;
+}
+
+bool JsonStreamParser::finish() {
+    if (hasError) return false;
+    if (token == Token::Number && !finishNumber()) return false; //liczba na koncu dokumentu
+    if (token != Token::None || expect != Expect::Done) return fail("Niekompletny dokument");
+    return true;
+}
+
+bool JsonStreamParser::startValue(char c) {
+    switch (c) {
+    case '{':
+        stack.push_back('{');
+        expect = Expect::FirstKeyOrEnd;
+        handler.startObject();
+        return true;
+    case '[':
+        stack.push_back('[');
+        expect = Expect::FirstValueOrEnd;
+        handler.startArray();
+        return true;
+    case '"':
+        token = Token::String;
+        stringIsKey = false;
+        text.clear();
+        return true;
+    case 't': literal = "true"; break;
+    case 'f': literal = "false"; break;
+    case 'n': literal = "null"; break;
+    default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            token = Token::Number;
+            text.assign(1, c);
+            return true;
+        }
+        return fail("Nieoczekiwany znak");
+    }
+    token = Token::Literal;
+    text.assign(1, c);
+    return true;
+}
+
+void JsonStreamParser::valueDone() {
+    expect = stack.empty() ? Expect::Done : Expect::CommaOrEnd;
+}
+
+bool JsonStreamParser::closeContainer(char c) {
+    if (stack.empty() || (c == '}' && stack.back() != '{') || (c == ']' && stack.back() != '['))
+        return fail("Niepasujacy nawias");
+    stack.pop_back();
+    if (c == '}') handler.endObject();
+    else handler.endArray();
+    valueDone();
+    return true;
+}
+
+bool JsonStreamParser::stringChar(char c) {
+    if (hexDigits >= 0) { //sekwencja \uXXXX
+        unsigned digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return fail("Niepoprawna sekwencja \\u");
+        hexValue = hexValue * 16 + digit;
+        if (++hexDigits < 4) return true;
+        hexDigits = -1;
+        if (hexValue >= 0xD800 && hexValue <= 0xDBFF) { //pierwsza polowa pary - czekamy na druga
+            highSurrogate = hexValue;
+            return true;
+        }
+        if (hexValue >= 0xDC00 && hexValue <= 0xDFFF && highSurrogate) {
+            appendUtf8(0x10000 + ((highSurrogate - 0xD800) << 10) + (hexValue - 0xDC00));
+            highSurrogate = 0;
+            return true;
+        }
+        appendUtf8(hexValue);
+        return true;
+    }
+    if (escape) {
+        escape = false;
+        switch (c) {
+        case '"': text.push_back('"'); break;
+        case '\\': text.push_back('\\'); break;
+        case '/': text.push_back('/'); break;
+        case 'b': text.push_back('\b'); break;
+        case 'f': text.push_back('\f'); break;
+        case 'n': text.push_back('\n'); break;
+        case 'r': text.push_back('\r'); break;
+        case 't': text.push_back('\t'); break;
+        case 'u': hexDigits = 0; hexValue = 0; break;
+        default: return fail("Niepoprawna sekwencja ucieczki");
+        }
+        return true;
+    }
+    if (c == '\\') { escape = true; return true; }
+    if (c != '"') { text.push_back(c); return true; } //bajty UTF-8 przepisywane bez zmian
+
+    token = Token::None;
+    if (stringIsKey) {
+        handler.key(text);
+        expect = Expect::Colon;
+    }
+    else {
+        handler.string(text);
+        valueDone();
+    }
+    return true;
+}
+
+bool JsonStreamParser::finishNumber() {
+    token = Token::None;
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end != text.c_str() + text.size()) return fail("Niepoprawna liczba");
+    handler.number(value);
+    valueDone();
+    return true;
+}
+
+bool JsonStreamParser::literalChar(char c) {
+    text.push_back(c);
+    const size_t n = text.size();
+    if (literal[n - 1] != c) return fail("Niepoprawny literal");
+    if (literal[n] != '\0') return true; //literal jeszcze niekompletny
+
+    token = Token::None;
+    if (literal[0] == 'n') handler.null();
+    else handler.boolean(literal[0] == 't');
+    valueDone();
+    return true;
+}
+
+void JsonStreamParser::appendUtf8(unsigned cp) {
+    if (cp < 0x80) {
+        text.push_back((char)cp);
+    }
+    else if (cp < 0x800) {
+        text.push_back((char)(0xC0 | (cp >> 6)));
+        text.push_back((char)(0x80 | (cp & 0x3F)));
+    }
+    else if (cp < 0x10000) {
+        text.push_back((char)(0xE0 | (cp >> 12)));
+        text.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+        text.push_back((char)(0x80 | (cp & 0x3F)));
+    }
+    else {
+        text.push_back((char)(0xF0 | (cp >> 18)));
+        text.push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+        text.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+        text.push_back((char)(0x80 | (cp & 0x3F)));
+    }
+}
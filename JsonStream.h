@@ -0,0 +1,73 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// Odbiorca zdarzeń parsera strumieniowego (styl SAX, jak json_sax w nlohmann::json).
+/// Domyślne implementacje ignorują zdarzenie - wystarczy nadpisać potrzebne.
+class JsonHandler {
+public:
+    virtual ~JsonHandler() {}
+    virtual void startObject() {}                       ///< Początek obiektu "{"
+    virtual void endObject() {}                         ///< Koniec obiektu "}"
+    virtual void startArray() {}                        ///< Początek tablicy "["
+    virtual void endArray() {}                          ///< Koniec tablicy "]"
+    virtual void key(const std::string& /*name*/) {}    ///< Klucz w obiekcie
+    virtual void string(const std::string& /*value*/) {}///< Wartość tekstowa
+    virtual void number(double /*value*/) {}            ///< Liczba
+    virtual void boolean(bool /*value*/) {}             ///< true / false
+    virtual void null() {}                              ///< null
+};
+
+/// Przyrostowy parser JSON zasilany kawałkami danych (np. prosto z odbiornika treści HTTP).
+/// Nie buduje drzewa dokumentu - każdy element jest od razu przekazywany do JsonHandler,
+/// a w pamięci trzymany jest tylko niedokończony token i stos zagnieżdżeń.
+/// Token może być rozcięty w dowolnym miejscu między kolejnymi wywołaniami feed.
+class JsonStreamParser {
+public:
+    /// Tworzy parser przekazujący zdarzenia do podanego odbiorcy.
+    explicit JsonStreamParser(JsonHandler& handler);
+
+    /// Przetwarza kolejny kawałek danych. Zwraca false po błędzie składni (dalsze dane są ignorowane).
+    bool feed(const char* data, size_t size);
+
+    /// Kończy dokument. Zwraca true, jeśli wczytano dokładnie jedną kompletną wartość JSON.
+    bool finish();
+
+    bool failed() const { return hasError; }                ///< Czy wystąpił błąd składni
+    const std::string& error() const { return errorText; }  ///< Opis błędu
+    size_t bytesConsumed() const { return consumed; }       ///< Liczba przetworzonych bajtów
+
+private:
+    /// Czego parser oczekuje po zakończeniu ostatniego tokenu.
+    enum class Expect { Value, FirstValueOrEnd, FirstKeyOrEnd, Key, Colon, CommaOrEnd, Done };
+
+    /// Rodzaj niedokończonego tokenu.
+    enum class Token { None, String, Number, Literal };
+
+    bool fail(const char* message);
+    bool startValue(char c);
+    void valueDone();
+    bool closeContainer(char c);
+    bool stringChar(char c);
+    bool finishNumber();
+    bool literalChar(char c);
+    void appendUtf8(unsigned codePoint);
+
+    JsonHandler& handler;
+    Expect expect = Expect::Value;
+    Token token = Token::None;
+    std::vector<char> stack;        ///< Otwarte kontenery: '{' lub '['
+    std::string text;               ///< Treść niedokończonego tokenu
+    const char* literal = nullptr;  ///< Oczekiwany literał ("true", "false", "null")
+    bool stringIsKey = false;       ///< Czy bieżący napis jest kluczem
+    bool escape = false;            ///< Po znaku '\'
+    int hexDigits = -1;             ///< Liczba wczytanych cyfr \uXXXX (-1 = poza sekwencją)
+    unsigned hexValue = 0;          ///< Wartość sekwencji \uXXXX
+    unsigned highSurrogate = 0;     ///< Pierwsza połowa pary UTF-16
+    size_t consumed = 0;            ///< Przetworzone bajty
+    size_t bomBytes = 0;            ///< Pominięte bajty BOM na początku
+    bool hasError = false;
+    std::string errorText;
+};
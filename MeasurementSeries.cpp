@@ -0,0 +1,261 @@
+﻿#include "MeasurementSeries.h"
+#include "TimeUtils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+    /// Wspólny stan rejestru mierników.
+    struct RegistryState {
+        std::mutex mutex;
+        std::unordered_map<std::string, uint16_t> ids;
+        std::deque<std::string> names; //deque - referencje do nazw nie tracą ważności
+        bool full = false;             //komunikat o pelnym rejestrze tylko raz
+    };
+
+    RegistryState& registry() {
+        static RegistryState state; //inicjalizacja przy pierwszym uzyciu (bezpieczna watkowo)
+        return state;
+    }
+}
+
+const uint16_t MetricRegistry::invalid;
+
+uint16_t MetricRegistry::intern(const std::string& name) {
+    RegistryState& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto it = r.ids.find(name);
+    if (it != r.ids.end()) return it->second;
+    if (r.names.size() >= invalid) { //ostatnie id zarezerwowane - bez zawijania numeracji
+        if (!r.full) std::cerr << "Rejestr mierników jest pełny (" << invalid << " nazw), pomijam miernik " << name << "\n";
+        r.full = true;
+        return invalid;
+    }
+    uint16_t id = (uint16_t)r.names.size();
+    r.names.push_back(name);
+    r.ids.emplace(name, id);
+    return id;
+}
+
+bool MetricRegistry::lookup(const std::string& name, uint16_t& id) {
+    RegistryState& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto it = r.ids.find(name);
+    id = it != r.ids.end() ? it->second : invalid;
+    return it != r.ids.end();
+}
+
+const std::string& MetricRegistry::name(uint16_t id) {
+    static const std::string unknown = "Nieznany";
+    RegistryState& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    return id < r.names.size() ? r.names[id] : unknown;
+}
+
+void MetricSeries::sortByTime() {
+    if (std::is_sorted(timestamps.begin(), timestamps.end())) return;
+    if (std::is_sorted(timestamps.rbegin(), timestamps.rend())) { //API zwraca dane od najnowszych
+        std::reverse(timestamps.begin(), timestamps.end());
+        std::reverse(values.begin(), values.end());
+        return;
+    }
+    std::vector<size_t> order(timestamps.size()); //permutacja sortujaca
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return timestamps[a] < timestamps[b]; });
+    std::vector<int64_t> ts(order.size());
+    std::vector<double> vals(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        ts[i] = timestamps[order[i]];
+        vals[i] = values[order[i]];
+    }
+    timestamps.swap(ts);
+    values.swap(vals);
+}
+
+SeriesView MetricSeries::view() const {
+    SeriesView v;
+    v.metric = metric;
+    v.timestamps = timestamps.data();
+    v.values = values.data();
+    v.count = timestamps.size();
+    return v;
+}
+
+SeriesView MetricSeries::range(int64_t start, int64_t end) const {
+    SeriesView v;
+    v.metric = metric;
+    if (start > end) return v;
+    auto first = std::lower_bound(timestamps.begin(), timestamps.end(), start); //pierwszy >= start
+    auto last = std::upper_bound(first, timestamps.end(), end);                 //pierwszy > end
+    size_t offset = first - timestamps.begin();
+    v.timestamps = timestamps.data() + offset;
+    v.values = values.data() + offset;
+    v.count = last - first;
+    return v;
+}
+
+SeriesSet SeriesSet::fromMeasurements(const std::vector<Measurement>& measurements) {
+    SeriesSet set;
+    std::string lastName;   //pomiary jednego miernika przychodza kolejno - unikamy wyszukiwania w rejestrze
+    uint16_t lastId = 0;
+    for (const auto& m : measurements) {
+        CompactMeasurement c;
+        if (!parseTimestamp(m.date, c.timestamp)) continue; //"brak daty"
+        if (set.series.empty() || m.name != lastName) {
+            lastName = m.name;
+            lastId = MetricRegistry::intern(m.name);
+        }
+        if (lastId == MetricRegistry::invalid) continue; //rejestr pelny
+        c.metric = lastId;
+        c.value = m.value;
+        set.add(c);
+    }
+    set.buildIndex(); //indeks czasowy budowany raz, przy wczytaniu stacji
+    return set;
+}
+
+void SeriesSet::buildIndex() {
+    for (auto& s : series) s.sortByTime();
+}
+
+void SeriesSet::add(const CompactMeasurement& m) {
+    MetricSeries* target = nullptr;
+    for (auto& s : series) //stacja ma kilka mierników - przeszukanie liniowe wystarcza
+        if (s.metric == m.metric) { target = &s; break; }
+    if (!target) {
+        series.emplace_back();
+        target = &series.back();
+        target->metric = m.metric;
+    }
+    target->timestamps.push_back(m.timestamp);
+    target->values.push_back(m.value);
+}
+
+std::vector<Measurement> SeriesSet::toMeasurements() const {
+    std::vector<Measurement> result;
+    result.reserve(size());
+    for (const auto& s : series) {
+        std::vector<Measurement> part = ::toMeasurements(s.view());
+        result.insert(result.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+    }
+    return result;
+}
+
+const MetricSeries* SeriesSet::find(const std::string& metric) const {
+    uint16_t id;
+    if (!MetricRegistry::lookup(metric, id)) return nullptr; //nazwa nieznana - zadna stacja jej nie mierzy
+    for (const auto& s : series)
+        if (s.metric == id) return &s;
+    return nullptr;
+}
+
+std::vector<std::string> SeriesSet::metricNames() const {
+    std::vector<std::string> names;
+    for (const auto& s : series) names.push_back(MetricRegistry::name(s.metric));
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+SeriesView SeriesSet::range(const std::string& metric, int64_t start, int64_t end) const {
+    uint16_t id;
+    MetricRegistry::lookup(metric, id); //nieznana nazwa - id invalid i pusty widok
+    return range(id, start, end);
+}
+
+SeriesView SeriesSet::range(uint16_t metric, int64_t start, int64_t end) const {
+    for (const auto& s : series)
+        if (s.metric == metric) return s.range(start, end);
+    SeriesView empty;
+    empty.metric = metric;
+    return empty;
+}
+
+size_t SeriesSet::size() const {
+    size_t total = 0;
+    for (const auto& s : series) total += s.size();
+    return total;
+}
+
+size_t SeriesSet::memoryBytes() const {
+    size_t bytes = sizeof(*this) + series.capacity() * sizeof(MetricSeries);
+    for (const auto& s : series)
+        bytes += s.timestamps.capacity() * sizeof(int64_t) + s.values.capacity() * sizeof(double);
+    return bytes;
+}
+
+std::vector<Measurement> toMeasurements(const SeriesView& series) {
+    std::vector<Measurement> result(series.size());
+    const std::string& name = MetricRegistry::name(series.metric);
+    for (size_t i = 0; i < series.size(); ++i) {
+        result[i].name = name;
+        result[i].date = formatTimestamp(series.timestamps[i]);
+        result[i].value = series.values[i];
+    }
+    return result;
+}
+
+SeriesSummary summarize(const SeriesView& series) {
+    SeriesSummary summary;
+    summary.count = series.size();
+    if (summary.count == 0) return summary;
+
+    const double* v = series.values;
+    double sum = 0.0;
+    size_t minIdx = 0, maxIdx = 0;
+    for (size_t i = 0; i < summary.count; ++i) { //jeden przebieg po ciaglej tablicy
+        sum += v[i];
+        if (v[i] < v[minIdx]) minIdx = i;
+        if (v[i] > v[maxIdx]) maxIdx = i;
+    }
+    summary.mean = sum / summary.count;
+    summary.min = v[minIdx];
+    summary.max = v[maxIdx];
+    summary.minTimestamp = series.timestamps[minIdx];
+    summary.maxTimestamp = series.timestamps[maxIdx];
+    return summary;
+}
+
+bool parseRangeBound(const std::string& input, bool endOfRange, int64_t& bound) {
+    bound = endOfRange ? std::numeric_limits<int64_t>::max() : std::numeric_limits<int64_t>::min();
+    const size_t first = input.find_first_not_of(" \t"), last = input.find_last_not_of(" \t");
+    if (first == std::string::npos) return true; //puste pole - bez ograniczenia
+    const std::string text = input.substr(first, last - first + 1);
+    int64_t seconds, next;
+    if (parseTimestamp(text, seconds)) { //pelna data z godzina
+        bound = endOfRange && text.size() < 19 ? seconds + 59 : seconds; //"HH:MM" obejmuje cala minute
+        return true;
+    }
+    if (text.size() == 10 && parseTimestamp(text + " 00:00", seconds)) { //sam dzien
+        bound = endOfRange ? seconds + 86399 : seconds;
+        return true;
+    }
+    if (text.size() == 7 && parseTimestamp(text + "-01 00:00", seconds)) { //miesiac "YYYY-MM"
+        const int year = std::atoi(text.c_str()), month = std::atoi(text.c_str() + 5);
+        char following[32];
+        std::snprintf(following, sizeof(following), "%04d-%02d-01 00:00", month == 12 ? year + 1 : year, month == 12 ? 1 : month + 1);
+        if (!parseTimestamp(following, next)) return false;
+        bound = endOfRange ? next - 1 : seconds;
+        return true;
+    }
+    if (text.size() == 4 && parseTimestamp(text + "-01-01 00:00", seconds)) { //rok "YYYY"
+        char following[32];
+        std::snprintf(following, sizeof(following), "%04d-01-01 00:00", std::atoi(text.c_str()) + 1);
+        if (!parseTimestamp(following, next)) return false;
+        bound = endOfRange ? next - 1 : seconds;
+        return true;
+    }
+    return false;
+}
+
+int64_t parseRangeBound(const std::string& text, bool endOfRange) {
+    int64_t bound;
+    parseRangeBound(text, endOfRange, bound); //przy bledzie bound = brak ograniczenia
+    return bound;
+}
@@ -0,0 +1,131 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ApiClient.h"  //struktura Measurement
+
+/// Rejestr nazw mierników (interning): każda nazwa ("PM10", "NO2"...) jest przechowywana raz
+/// i zastępowana małym identyfikatorem. Rejestr jest globalny i bezpieczny wątkowo.
+class MetricRegistry {
+public:
+    /// Id, które nie odpowiada żadnej nazwie (rejestr pełny lub nieznana nazwa).
+    static const uint16_t invalid = 0xFFFF;
+
+    /// Zwraca id nazwy miernika (nadaje nowe przy pierwszym użyciu).
+    /// Gdy rejestr jest pełny (65535 nazw), zwraca invalid zamiast zawijać numerację.
+    static uint16_t intern(const std::string& name);
+
+    /// Wyszukuje id nazwy bez dodawania jej do rejestru.
+    /// \return false, jeśli nazwa nie była jeszcze zarejestrowana (id = invalid).
+    static bool lookup(const std::string& name, uint16_t& id);
+
+    /// Zwraca nazwę miernika o podanym id.
+    static const std::string& name(uint16_t id);
+};
+
+/// Zwarty pomiar: id miernika zamiast nazwy i sekundy od 1970-01-01 zamiast tekstu daty.
+struct CompactMeasurement {
+    int64_t timestamp = 0;  ///< Czas pomiaru (patrz TimeUtils.h)
+    double value = 0.0;     ///< Wartość pomiaru w µg/m³
+    uint16_t metric = 0;    ///< Id miernika z MetricRegistry
+};
+
+/// Widok fragmentu serii bez kopiowania (wskaźniki do tablic serii).
+/// Widok jest ważny, dopóki seria, z której pochodzi, nie zostanie zmieniona lub usunięta.
+struct SeriesView {
+    uint16_t metric = 0;                    ///< Id miernika z MetricRegistry
+    const int64_t* timestamps = nullptr;    ///< Czasy pomiarów (rosnąco)
+    const double* values = nullptr;         ///< Wartości pomiarów
+    size_t count = 0;                       ///< Liczba pomiarów w widoku
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+/// Seria jednego miernika w układzie kolumnowym (osobne tablice czasu i wartości).
+struct MetricSeries {
+    uint16_t metric = 0;                ///< Id miernika z MetricRegistry
+    std::vector<int64_t> timestamps;    ///< Czasy pomiarów
+    std::vector<double> values;         ///< Wartości pomiarów (ten sam indeks co timestamps)
+
+    size_t size() const { return timestamps.size(); }
+
+    /// Sortuje serię rosnąco po czasie.
+    void sortByTime();
+
+    /// Zwraca widok całej serii.
+    SeriesView view() const;
+
+    /// Zwraca widok pomiarów z zakresu [start, end] (wyszukiwanie binarne, seria musi być posortowana).
+    SeriesView range(int64_t start, int64_t end) const;
+};
+
+/// Podstawowe statystyki serii (średnia, minimum i maksimum z datami).
+struct SeriesSummary {
+    size_t count = 0;           ///< Liczba pomiarów
+    double mean = 0.0;          ///< Średnia
+    double min = 0.0;           ///< Minimum
+    double max = 0.0;           ///< Maksimum
+    int64_t minTimestamp = 0;   ///< Czas wystąpienia minimum
+    int64_t maxTimestamp = 0;   ///< Czas wystąpienia maksimum
+};
+
+/// Pomiary jednej stacji pogrupowane po miernikach (struct-of-arrays).
+/// Każda seria jest utrzymywana posortowana po czasie (indeks czasowy), więc zapytanie
+/// o zakres dat to dwa wyszukiwania binarne i widok bez kopiowania danych.
+class SeriesSet {
+public:
+    /// Buduje zbiór z listy pomiarów wraz z indeksem czasowym (pomiary z niepoprawną datą są pomijane).
+    static SeriesSet fromMeasurements(const std::vector<Measurement>& measurements);
+
+    /// Dodaje pojedynczy pomiar. Po serii wywołań add należy wywołać buildIndex().
+    void add(const CompactMeasurement& m);
+
+    /// Sortuje wszystkie serie po czasie (buduje indeks czasowy).
+    void buildIndex();
+
+    /// Zamienia zbiór z powrotem na listę Measurement (dla dotychczasowego kodu).
+    std::vector<Measurement> toMeasurements() const;
+
+    /// Zwraca serię miernika lub nullptr, jeśli stacja go nie mierzy (nie dodaje nazwy do rejestru).
+    const MetricSeries* find(const std::string& metric) const;
+
+    /// Zwraca nazwy mierników w kolejności alfabetycznej.
+    std::vector<std::string> metricNames() const;
+
+    /// Zwraca widok pomiarów miernika z zakresu [start, end] w kolejności czasu - O(log n), bez kopiowania.
+    /// Nieznana nazwa daje pusty widok (bez dodawania jej do rejestru).
+    SeriesView range(const std::string& metric, int64_t start, int64_t end) const;
+
+    /// Wersja range dla id miernika.
+    SeriesView range(uint16_t metric, int64_t start, int64_t end) const;
+
+    /// Liczba wszystkich pomiarów.
+    size_t size() const;
+
+    /// Przybliżona pamięć zajmowana przez dane serii [B].
+    size_t memoryBytes() const;
+
+    /// Zwraca wszystkie serie stacji.
+    const std::vector<MetricSeries>& allSeries() const { return series; }
+
+private:
+    std::vector<MetricSeries> series;   ///< Serie (po jednej na miernik)
+};
+
+/// Zamienia widok serii na listę Measurement (np. dla okna wykresu).
+std::vector<Measurement> toMeasurements(const SeriesView& series);
+
+/// Liczy średnią, minimum i maksimum jednym przebiegiem po tablicach serii.
+SeriesSummary summarize(const SeriesView& series);
+
+/// Zamienia datę wpisaną przez użytkownika na granicę zakresu.
+/// Przyjmuje "YYYY-MM-DD HH:MM[:SS]", "YYYY-MM-DD", "YYYY-MM" i "YYYY": niepełna data oznacza początek
+/// dnia/miesiąca/roku, a dla końca zakresu - jego ostatnią sekundę. Puste pole oznacza brak ograniczenia
+/// (INT64_MIN / INT64_MAX).
+/// \return false dla niepoprawnego tekstu (bound = brak ograniczenia).
+bool parseRangeBound(const std::string& text, bool endOfRange, int64_t& bound);
+
+/// Wersja dla dat ze stałych w kodzie: niepoprawny tekst oznacza brak ograniczenia.
+int64_t parseRangeBound(const std::string& text, bool endOfRange);
@@ -0,0 +1,318 @@
+﻿#include "MeasurementStore.h"
+#include <nlohmann/json.hpp>     // Biblioteka do obsługi JSON
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include "Trace.h"      //pomiary czasu zapisu i odczytu
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>    //MoveFileExA, FindFirstFileA
+#include <direct.h>     //_mkdir
+#else
+#include <dirent.h>     //opendir
+#include <sys/stat.h>   //mkdir
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+    const char* segmentExtension = ".jsonl"; //rozszerzenie plikow segmentow
+
+    /// Klucz deduplikacji: miernik i data pomiaru.
+    std::string makeKey(const std::string& name, const std::string& date) {
+        return name + '\t' + date;
+    }
+
+    /// Tworzy katalog (brak błędu, jeśli już istnieje).
+    void makeDirectory(const std::string& path) {
+#ifdef _WIN32
+        _mkdir(path.c_str());
+#else
+        mkdir(path.c_str(), 0755);
+#endif
+    }
+
+    /// Atomowo zastępuje plik docelowy plikiem tymczasowym.
+    bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+
+    /// Zwraca nazwy plików z katalogu kończące się podanym rozszerzeniem (bez rozszerzenia).
+    std::vector<std::string> listFiles(const std::string& directory, const std::string& extension) {
+        std::vector<std::string> names;
+        auto accept = [&](const std::string& file) { //dopasowanie rozszerzenia
+            if (file.size() > extension.size() && file.compare(file.size() - extension.size(), extension.size(), extension) == 0)
+                names.push_back(file.substr(0, file.size() - extension.size()));
+        };
+#ifdef _WIN32
+        WIN32_FIND_DATAA fd;
+        HANDLE h = FindFirstFileA((directory + "\\*").c_str(), &fd);
+        if (h == INVALID_HANDLE_VALUE) return names;
+        do { accept(fd.cFileName); } while (FindNextFileA(h, &fd));
+        FindClose(h);
+#else
+        DIR* dir = opendir(directory.c_str());
+        if (!dir) return names;
+        while (dirent* e = readdir(dir)) accept(e->d_name);
+        closedir(dir);
+#endif
+        return names;
+    }
+
+    /// Zamienia pomiar na jedną linię JSON segmentu.
+    std::string toLine(const Measurement& m) {
+        return json({ {"name", m.name}, {"date", m.date}, {"value", m.value} }).dump();
+    }
+
+    /// Czyta segment i wywołuje funkcję dla każdego poprawnego wpisu.
+    template <typename Fn>
+    size_t readSegment(const std::string& path, Fn fn) {
+        std::ifstream file(path);
+        std::string line;
+        size_t lines = 0;
+        while (std::getline(file, line)) {
+            if (line.empty()) continue;
+            try {
+                json j = json::parse(line);
+                Measurement m;
+                m.name = j.value("name", "Brak");
+                m.date = j.value("date", "brak daty");
+                m.value = j.value("value", 0.0);
+                fn(m);
+                ++lines;
+            }
+            catch (...) { //uciety wpis (np. po awarii w trakcie zapisu) jest pomijany
+                std::cerr << "Pominięto uszkodzony wpis w " << path << "\n";
+            }
+        }
+        return lines;
+    }
+}
+
+MeasurementStore::MeasurementStore(const std::string& directory) : directory(directory) {
+    makeDirectory(directory);
+}
+
+MeasurementStore::~MeasurementStore() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCv.notify_all();
+    if (compactor.joinable()) compactor.join(); //dokonczenie biezacego kompaktowania
+}
+
+std::string MeasurementStore::segmentPath(const std::string& stationId) const {
+    return directory + "/" + stationId + segmentExtension;
+}
+
+MeasurementStore::Segment& MeasurementStore::segment(const std::string& stationId) {
+    std::lock_guard<std::mutex> lock(segmentsMutex);
+    auto& seg = segments[stationId];
+    if (!seg) seg.reset(new Segment());
+    return *seg;
+}
+
+void MeasurementStore::buildIndex(const std::string& stationId, Segment& seg) {
+    if (seg.indexed) return; //indeks zbudowany wczesniej w tej sesji
+    seg.index.clear();
+    seg.newest.clear();
+    std::string path = segmentPath(stationId);
+    seg.recordsOnDisk = readSegment(path, [&](const Measurement& m) {
+        seg.index[makeKey(m.name, m.date)] = m.value; //pozniejszy wpis nadpisuje wczesniejszy
+        std::string& newest = seg.newest[m.name];
+        if (m.date > newest) newest = m.date; //daty "YYYY-MM-DD HH:MM:SS" porownywane jako tekst
+    });
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    seg.endsWithNewline = true;
+    if (file.is_open() && file.tellg() > 0) { //ostatni bajt pliku - po awarii zapisu linia moze byc ucieta
+        file.seekg(-1, std::ios::end);
+        seg.endsWithNewline = file.get() == '\n';
+    }
+    seg.indexed = true;
+}
+
+size_t MeasurementStore::append(const std::string& stationId, const std::vector<Measurement>& measurements) {
+    AQ_TRACE_SCOPE("store.append");
+    Segment& seg = segment(stationId);
+    size_t written = 0;
+    bool needsCompaction = false;
+    {
+        std::lock_guard<std::mutex> lock(seg.mutex);
+        buildIndex(stationId, seg);
+
+        std::string delta; //tylko nowe lub zmienione pomiary
+        if (!seg.endsWithNewline) delta += '\n'; //ucieta linia zostaje osobnym (pomijanym) wpisem
+        std::unordered_map<std::string, double> pending; //zmiany indeksu - wprowadzane dopiero po udanym zapisie
+        std::vector<const Measurement*> added;
+        for (const auto& m : measurements) {
+            std::string key = makeKey(m.name, m.date);
+            auto p = pending.find(key);
+            if (p != pending.end()) {
+                if (p->second == m.value) continue; //powtorzony w tej samej paczce
+            }
+            else {
+                auto it = seg.index.find(key);
+                if (it != seg.index.end() && it->second == m.value) continue; //juz zapisany
+            }
+            pending[key] = m.value;
+            added.push_back(&m);
+            delta += toLine(m);
+            delta += '\n';
+            ++written;
+        }
+        if (written == 0) return 0; //nic nowego - brak zapisu na dysk
+
+        std::ofstream out(segmentPath(stationId), std::ios::app | std::ios::binary);
+        if (out.is_open()) {
+            out << delta; //jeden zapis na koniec pliku
+            out.flush();
+        }
+        if (!out) {
+            std::cerr << "Nie udało się zapisać pomiarów stacji " << stationId << "\n";
+            seg.indexed = false; //czesc wpisow mogla trafic do pliku - indeks zostanie odbudowany z pliku
+            return 0;
+        }
+        AQ_TRACE_COUNT("store.bytesWritten", delta.size());
+        for (const auto& kv : pending) seg.index[kv.first] = kv.second;
+        for (const Measurement* m : added) {
+            std::string& newest = seg.newest[m->name];
+            if (m->date > newest) newest = m->date;
+        }
+        seg.endsWithNewline = true;
+        seg.recordsOnDisk += written;
+        needsCompaction = seg.recordsOnDisk > seg.index.size() * compactionRatio;
+    }
+
+    if (needsCompaction) scheduleCompaction(stationId);
+    return written;
+}
+
+std::map<std::string, std::string> MeasurementStore::newestDates(const std::string& stationId) {
+    Segment& seg = segment(stationId);
+    std::lock_guard<std::mutex> lock(seg.mutex);
+    buildIndex(stationId, seg);
+    return seg.newest;
+}
+
+std::vector<Measurement> MeasurementStore::load(const std::string& stationId) {
+    AQ_TRACE_SCOPE("store.load");
+    Segment& seg = segment(stationId);
+    std::lock_guard<std::mutex> lock(seg.mutex); //nie czytamy w trakcie kompaktowania
+
+    std::vector<Measurement> measurements;
+    std::unordered_map<std::string, size_t> position; //klucz -> pozycja w wyniku (kolejnosc pierwszego wystapienia)
+    readSegment(segmentPath(stationId), [&](const Measurement& m) {
+        std::string key = makeKey(m.name, m.date);
+        auto it = position.find(key);
+        if (it != position.end()) { measurements[it->second].value = m.value; return; } //ostatni wpis wygrywa
+        position.emplace(std::move(key), measurements.size());
+        measurements.push_back(m);
+    });
+    AQ_TRACE_COUNT("store.recordsRead", measurements.size());
+    return measurements;
+}
+
+std::vector<std::string> MeasurementStore::stationIds() const {
+    return listFiles(directory, segmentExtension);
+}
+
+size_t MeasurementStore::migrateFromJson(const std::string& filename) {
+    json allData;
+    try {
+        std::ifstream file(filename);
+        if (!file.is_open()) return 0;
+        file >> allData;
+    }
+    catch (...) {
+        std::cerr << "Błąd wczytywania pliku " << filename << " do migracji.\n";
+        return 0;
+    }
+    if (!allData.is_object()) return 0;
+
+    size_t imported = 0;
+    for (auto it = allData.begin(); it != allData.end(); ++it) { //kazda stacja ze starego pliku
+        if (!it.value().is_array()) {
+            std::cerr << "Pominięto stację " << it.key() << " w " << filename << " (pomiary nie są tablicą).\n";
+            continue;
+        }
+        std::vector<Measurement> measurements;
+        size_t skipped = 0;
+        for (const auto& m : it.value()) {
+            if (!m.is_object()) { ++skipped; continue; }
+            try {
+                Measurement meas;
+                meas.name = m.value("name", "Brak");
+                meas.date = m.value("date", "brak daty");
+                meas.value = m.value("value", 0.0);
+                measurements.push_back(meas);
+            }
+            catch (...) { ++skipped; } //pole o zlym typie, np. "value": "abc"
+        }
+        if (skipped > 0)
+            std::cerr << "Pominięto " << skipped << " uszkodzonych wpisów stacji " << it.key() << " w " << filename << "\n";
+        imported += append(it.key(), measurements); //istniejace pomiary sa pomijane
+    }
+    return imported;
+}
+
+void MeasurementStore::compact(const std::string& stationId) {
+    AQ_TRACE_SCOPE("store.compact");
+    Segment& seg = segment(stationId);
+    std::lock_guard<std::mutex> lock(seg.mutex);
+
+    std::string path = segmentPath(stationId);
+    std::vector<Measurement> live;
+    std::unordered_map<std::string, size_t> position;
+    readSegment(path, [&](const Measurement& m) { //ostatni wpis dla klucza wygrywa
+        std::string key = makeKey(m.name, m.date);
+        auto it = position.find(key);
+        if (it != position.end()) { live[it->second].value = m.value; return; }
+        position.emplace(std::move(key), live.size());
+        live.push_back(m);
+    });
+
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc | std::ios::binary);
+        if (!out.is_open()) return;
+        for (const auto& m : live) out << toLine(m) << '\n';
+        if (!out) return; //nie podmieniamy pliku po nieudanym zapisie
+    }
+    if (!replaceFile(tmpPath, path)) {
+        std::remove(tmpPath.c_str());
+        return;
+    }
+    seg.recordsOnDisk = live.size(); //indeks pozostaje aktualny - zmienia sie tylko plik
+    seg.endsWithNewline = true;
+}
+
+void MeasurementStore::scheduleCompaction(const std::string& stationId) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (stopping) return;
+    for (const auto& queued : compactQueue)
+        if (queued == stationId) return; //juz w kolejce
+    compactQueue.push_back(stationId);
+    if (!compactor.joinable()) compactor = std::thread(&MeasurementStore::compactionLoop, this);
+    queueCv.notify_one();
+}
+
+void MeasurementStore::compactionLoop() {
+    while (true) {
+        std::string stationId;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCv.wait(lock, [this] { return stopping || !compactQueue.empty(); });
+            if (stopping) return;
+            stationId = compactQueue.front();
+            compactQueue.pop_front();
+        }
+        compact(stationId); //praca w tle, bez blokowania zapisow innych stacji
+    }
+}
@@ -0,0 +1,83 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include "ApiClient.h"  //struktura Measurement
+
+/// Lokalna baza pomiarów w postaci segmentów dopisywanych na końcu (append-only).
+/// Każda stacja ma własny plik "<katalog>/<id stacji>.jsonl" z jednym pomiarem JSON w linii.
+/// Nowe pomiary są dopisywane tylko wtedy, gdy para (miernik, data) jest nowa lub zmieniła się jej wartość,
+/// więc koszt zapisu zależy od wielkości zmiany, a nie od liczby zapisanych stacji.
+/// Nieaktualne wpisy usuwa kompaktowanie wykonywane w tle.
+class MeasurementStore {
+public:
+    /// Otwiera (i w razie potrzeby tworzy) bazę w podanym katalogu.
+    explicit MeasurementStore(const std::string& directory);
+
+    /// Zatrzymuje wątek kompaktowania.
+    ~MeasurementStore();
+
+    MeasurementStore(const MeasurementStore&) = delete;
+    MeasurementStore& operator=(const MeasurementStore&) = delete;
+
+    /// Dopisuje pomiary stacji, pomijając już zapisane pary (miernik, data) o tej samej wartości.
+    /// \return Liczba faktycznie dopisanych pomiarów.
+    size_t append(const std::string& stationId, const std::vector<Measurement>& measurements);
+
+    /// Wczytuje wszystkie pomiary stacji (dla powtórzonej pary (miernik, data) wygrywa ostatni wpis).
+    std::vector<Measurement> load(const std::string& stationId);
+
+    /// Zwraca najnowszą zapisaną datę pomiaru dla każdego miernika stacji ("znak wodny" synchronizacji przyrostowej).
+    std::map<std::string, std::string> newestDates(const std::string& stationId);
+
+    /// Zwraca identyfikatory wszystkich stacji zapisanych w bazie.
+    std::vector<std::string> stationIds() const;
+
+    /// Importuje dane ze starego pliku dane.json (obiekt: id stacji -> tablica pomiarów).
+    /// Stacje bez tablicy pomiarów i wpisy o złej budowie są pomijane (z komunikatem na std::cerr).
+    /// \return Liczba zaimportowanych pomiarów.
+    size_t migrateFromJson(const std::string& filename);
+
+    /// Przepisuje segment stacji bez nieaktualnych wpisów (wywołanie synchroniczne).
+    void compact(const std::string& stationId);
+
+    /// Ustala, przy jakim stosunku wszystkich wpisów do aktualnych segment trafia do kompaktowania w tle.
+    void setCompactionRatio(double ratio) { compactionRatio = ratio; }
+
+    /// Zwraca ścieżkę pliku segmentu stacji.
+    std::string segmentPath(const std::string& stationId) const;
+
+private:
+    /// Stan jednego segmentu (stacji) w pamięci.
+    struct Segment {
+        std::mutex mutex;                               ///< Chroni segment przy zapisie i kompaktowaniu
+        bool indexed = false;                           ///< Czy indeks został zbudowany z pliku
+        std::unordered_map<std::string, double> index;  ///< Klucz (miernik, data) -> aktualna wartość
+        size_t recordsOnDisk = 0;                       ///< Liczba linii w pliku (z nieaktualnymi)
+        bool endsWithNewline = true;                    ///< Czy plik kończy się pełną linią (po awarii zapisu może nie)
+        std::map<std::string, std::string> newest;      ///< Miernik -> najnowsza data pomiaru
+    };
+
+    Segment& segment(const std::string& stationId);             //zwraca (tworzy) stan segmentu
+    void buildIndex(const std::string& stationId, Segment& seg); //wczytuje indeks segmentu z pliku
+    void scheduleCompaction(const std::string& stationId);      //zleca kompaktowanie w tle
+    void compactionLoop();                                      //petla watku kompaktujacego
+
+    std::string directory;                                      ///< Katalog bazy
+    double compactionRatio = 2.0;                               ///< Próg kompaktowania
+    mutable std::mutex segmentsMutex;                           ///< Chroni mapę segmentów
+    std::map<std::string, std::unique_ptr<Segment>> segments;   ///< Segmenty otwarte w tej sesji
+
+    std::mutex queueMutex;                  ///< Chroni kolejkę kompaktowania
+    std::condition_variable queueCv;        ///< Budzi wątek kompaktowania
+    std::deque<std::string> compactQueue;   ///< Stacje czekające na kompaktowanie
+    std::thread compactor;                  ///< Wątek kompaktowania (uruchamiany przy pierwszej potrzebie)
+    bool stopping = false;                  ///< Flaga zatrzymania wątku
+};
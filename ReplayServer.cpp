@@ -0,0 +1,278 @@
+﻿#include "ReplayServer.h"
+#include <httplib.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include "TimeUtils.h"
+
+using json = nlohmann::json;
+
+namespace {
+    const int kStationIdStep = 1000000; //id kopii stacji przy powielaniu listy
+
+    json stationJson(int id, const std::string& name, const std::string& province) { //format odpowiedzi findAll
+        return json{ { "id", id }, { "stationName", name }, { "city", { { "commune", { { "provinceName", province } } } } } };
+    }
+
+    /// Data w formacie nagłówka HTTP ("Thu, 01 Jan 1970 00:00:00 GMT").
+    std::string httpDate(int64_t seconds) {
+        static const char* days[] = { "Thu", "Fri", "Sat", "Sun", "Mon", "Tue", "Wed" }; //1970-01-01 to czwartek
+        static const char* months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+        const std::string t = formatTimestamp(seconds); //"YYYY-MM-DD HH:MM:SS"
+        const int64_t day = seconds >= 0 ? seconds / 86400 : (seconds - 86399) / 86400;
+        return std::string(days[(day % 7 + 7) % 7]) + ", " + t.substr(8, 2) + " " + months[std::atoi(t.substr(5, 2).c_str()) - 1] + " " +
+            t.substr(0, 4) + " " + t.substr(11, 8) + " GMT";
+    }
+}
+
+bool ReplayFixtures::load(const std::string& stationsFile, const std::string& measurementsFile, int scale) {
+    scale = std::max(scale, 1);
+    ApiClient files;
+    std::vector<Station> list = files.loadStationsFromFile(stationsFile);
+    if (list.empty()) return false;
+
+    json all = json::array();
+    for (int copy = 0; copy < scale; ++copy)
+        for (const auto& s : list)
+            all.push_back(stationJson(s.id + copy * kStationIdStep, s.name, s.province));
+    stations = all.dump();
+
+    std::ifstream in(measurementsFile);
+    json recorded = json::parse(in, nullptr, false); //dane.json: id stacji -> lista pomiarow
+    if (!recorded.is_object()) {
+        std::cerr << "Brak nagranych pomiarów w pliku: " << measurementsFile << "\n";
+        return true; //same stacje
+    }
+
+    for (auto it = recorded.begin(); it != recorded.end(); ++it) {
+        int stationId = std::atoi(it.key().c_str());
+        std::map<std::string, std::vector<std::pair<int64_t, double>>> series; //miernik -> (czas, wartosc)
+        for (const auto& m : it.value()) {
+            int64_t t;
+            if (!m.contains("date") || !m["date"].is_string() || !parseTimestamp(m["date"].get<std::string>(), t)) continue;
+            series[m.value("name", std::string("Nieznany"))].push_back(std::make_pair(t, m.value("value", 0.0)));
+        }
+
+        json sensors = json::array();
+        int index = 0;
+        size_t total = 0;
+        for (auto& kv : series) {
+            int sensorId = stationId * 100 + index++;
+            sensors.push_back(json{ { "id", sensorId }, { "stationId", stationId }, { "param", { { "paramCode", kv.first } } } });
+
+            auto bounds = std::minmax_element(kv.second.begin(), kv.second.end());
+            int64_t span = bounds.second->first - bounds.first->first + 3600; //dlugosc serii (pomiary godzinowe)
+            json values = json::array();
+            char date[24];
+            ReplaySeries& recordedSeries = sensorSeries[sensorId];
+            recordedSeries.metric = kv.first;
+            recordedSeries.newest = bounds.second->first;
+            recordedSeries.oldest = bounds.first->first - (scale - 1) * span;
+            for (int copy = 0; copy < scale; ++copy) { //kopie przesuniete wstecz - daty sie nie powtarzaja
+                for (const auto& point : kv.second) {
+                    formatTimestamp(point.first - copy * span, date);
+                    values.push_back(json{ { "date", date }, { "value", point.second } });
+                    recordedSeries.points.push_back(std::make_pair(point.first - copy * span, point.second));
+                }
+            }
+            total += values.size();
+            sensorData[sensorId] = json{ { "key", kv.first }, { "values", values } }.dump();
+        }
+        sensorLists[stationId] = sensors.dump();
+        counts[stationId] = total;
+    }
+    return true;
+}
+
+bool ReplayFixtures::sensorsJson(int stationId, std::string& body) const {
+    auto it = sensorLists.find(stationId);
+    if (it == sensorLists.end()) return false;
+    body = it->second;
+    return true;
+}
+
+bool ReplayFixtures::dataJson(int sensorId, std::string& body) const {
+    auto it = sensorData.find(sensorId);
+    if (it == sensorData.end()) return false;
+    body = it->second;
+    return true;
+}
+
+const ReplaySeries* ReplayFixtures::series(int sensorId) const {
+    auto it = sensorSeries.find(sensorId);
+    return it != sensorSeries.end() ? &it->second : nullptr;
+}
+
+std::vector<int> ReplayFixtures::sensorsOf(int stationId) const {
+    std::vector<int> ids;
+    for (auto it = sensorSeries.lower_bound(stationId * 100); it != sensorSeries.end() && it->first < (stationId + 1) * 100; ++it)
+        ids.push_back(it->first); //id czujnika = id stacji * 100 + numer miernika
+    return ids;
+}
+
+std::vector<int> ReplayFixtures::stationsWithData() const {
+    std::vector<int> ids;
+    for (const auto& kv : sensorLists) ids.push_back(kv.first);
+    return ids;
+}
+
+size_t ReplayFixtures::measurementCount(int stationId) const {
+    auto it = counts.find(stationId);
+    return it != counts.end() ? it->second : 0;
+}
+
+size_t ReplayFixtures::measurementCount() const {
+    size_t total = 0;
+    for (const auto& kv : counts) total += kv.second;
+    return total;
+}
+
+ReplayServer::ReplayServer(const ReplayFixtures& fixtures, const ReplayOptions& options)
+    : fixtures(fixtures), options(options), server(new httplib::Server), lagHours(std::max(0, options.windowLagHours)) {}
+
+ReplayServer::~ReplayServer() {
+    stop();
+}
+
+bool ReplayServer::respond(const std::string& client) {
+    requestCount++;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        clients.insert(client); //kazde polaczenie TCP ma inny port zrodlowy
+    }
+    ReplayMode current = (ReplayMode)mode.load();
+    if (current == ReplayMode::Down) return false;
+    int delay = current == ReplayMode::Slow ? options.slowMs : options.latencyMs;
+    if (delay > 0) std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+    return true;
+}
+
+bool ReplayServer::window(int sensorId, int64_t& from, int64_t& to) const {
+    const ReplaySeries* s = fixtures.series(sensorId);
+    if (!s) return false;
+    to = std::max(s->oldest, s->newest - (int64_t)lagHours.load() * 3600);
+    from = options.windowHours > 0 ? to - (int64_t)options.windowHours * 3600 + 1 : s->oldest; //okno (to - szerokosc, to]
+    return true;
+}
+
+bool ReplayServer::sensorData(int sensorId, std::string& body, std::string& etag, int64_t& modified) const {
+    int64_t from, to;
+    if (!window(sensorId, from, to)) return false;
+    std::map<int64_t, double> changes; //korekty czujnika
+    size_t version = 0;
+    {
+        std::lock_guard<std::mutex> lock(revisionsMutex);
+        auto count = revisionCounts.find(sensorId);
+        if (count != revisionCounts.end()) version = count->second;
+        for (auto it = revisions.lower_bound(std::make_pair(sensorId, from)); it != revisions.end() && it->first.first == sensorId; ++it)
+            changes[it->first.second] = it->second;
+    }
+    etag = "\"" + std::to_string(sensorId) + "-" + std::to_string(to) + "-" + std::to_string(version) + "\"";
+    modified = to;
+    if (options.windowHours <= 0 && lagHours == 0 && changes.empty()) return fixtures.dataJson(sensorId, body); //gotowa odpowiedz
+
+    const ReplaySeries* s = fixtures.series(sensorId);
+    json values = json::array();
+    char date[24];
+    for (const auto& point : s->points) {
+        if (point.first < from || point.first > to) continue;
+        auto change = changes.find(point.first);
+        formatTimestamp(point.first, date);
+        values.push_back(json{ { "date", date }, { "value", point.second + (change != changes.end() ? change->second : 0.0) } });
+    }
+    body = json{ { "key", s->metric }, { "values", values } }.dump();
+    return true;
+}
+
+void ReplayServer::advanceWindow(int hours) {
+    lagHours = std::max(0, lagHours.load() - hours);
+}
+
+void ReplayServer::reviseLatest(double delta) {
+    std::lock_guard<std::mutex> lock(revisionsMutex);
+    for (int stationId : fixtures.stationsWithData())
+        for (int sensorId : fixtures.sensorsOf(stationId)) {
+            int64_t from, to;
+            window(sensorId, from, to);
+            const ReplaySeries* s = fixtures.series(sensorId);
+            int64_t latest = from - 1; //najnowszy pomiar w oknie (seria moze miec przerwy)
+            for (const auto& point : s->points)
+                if (point.first <= to && point.first > latest) latest = point.first;
+            if (latest < from) continue;
+            revisions[std::make_pair(sensorId, latest)] += delta;
+            revisionCounts[sensorId]++;
+        }
+}
+
+int ReplayServer::start(int requestedPort) {
+    auto reply = [this](const httplib::Request& req, httplib::Response& res, bool found, const std::string& body,
+        const std::string& etag, const std::string& lastModified) {
+        if (!respond(req.remote_addr + ":" + std::to_string(req.remote_port))) { //jak przeciazony serwer przed API - strona HTML
+            res.status = 503;
+            res.set_content("<html><body><h1>503 Service Unavailable</h1></body></html>\n", "text/html");
+        }
+        else if (!found) res.status = 404;
+        else {
+            if (!etag.empty()) res.set_header("ETag", etag);
+            if (!lastModified.empty()) res.set_header("Last-Modified", lastModified);
+            bool unchanged = req.has_header("If-None-Match") ? !etag.empty() && req.get_header_value("If-None-Match") == etag
+                : !lastModified.empty() && req.get_header_value("If-Modified-Since") == lastModified;
+            if (unchanged) res.status = 304; //klient ma aktualna wersje - bez tresci
+            else res.set_content(body, "application/json");
+        }
+    };
+    server->Get("/pjp-api/rest/station/findAll", [this, reply](const httplib::Request& req, httplib::Response& res) {
+        reply(req, res, true, fixtures.stationsJson(), "", "");
+    });
+    server->Get(R"(/pjp-api/rest/station/sensors/(\d+))", [this, reply](const httplib::Request& req, httplib::Response& res) {
+        std::string body;
+        int stationId = std::atoi(req.matches[1].str().c_str());
+        bool found = fixtures.sensorsJson(stationId, body);
+        reply(req, res, found, body, "\"s" + std::to_string(stationId) + "\"", ""); //lista czujnikow sie nie zmienia
+    });
+    server->Get(R"(/pjp-api/rest/data/getData/(\d+))", [this, reply](const httplib::Request& req, httplib::Response& res) {
+        std::string body, etag;
+        int64_t modified = 0;
+        bool found = sensorData(std::atoi(req.matches[1].str().c_str()), body, etag, modified);
+        reply(req, res, found, body, etag, found ? httpDate(modified) : "");
+    });
+    server->Get(R"(/replay/mode/(up|down|slow))", [this](const httplib::Request& req, httplib::Response& res) { //przelaczanie z zewnatrz
+        std::string name = req.matches[1].str();
+        setMode(name == "down" ? ReplayMode::Down : name == "slow" ? ReplayMode::Slow : ReplayMode::Up);
+        res.set_content(name + "\n", "text/plain");
+    });
+
+    server->set_keep_alive_max_count(1000); //domyslnie httplib zamyka polaczenie po kilku zadaniach
+
+    if (requestedPort > 0) port = server->bind_to_port("127.0.0.1", requestedPort) ? requestedPort : -1;
+    else port = server->bind_to_any_port("127.0.0.1");
+    if (port <= 0) {
+        std::cerr << "Nie można uruchomić serwera odtwarzającego.\n";
+        port = -1;
+        return -1;
+    }
+    listener = std::thread([this] { server->listen_after_bind(); });
+    return port;
+}
+
+void ReplayServer::stop() {
+    if (!listener.joinable()) return;
+    server->stop();
+    listener.join();
+}
+
+size_t ReplayServer::connections() const {
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    return clients.size();
+}
+
+void ReplayServer::setMode(ReplayMode newMode) {
+    mode = (int)newMode;
+}
+
+std::string ReplayServer::url() const {
+    return "http://127.0.0.1:" + std::to_string(port);
+}
@@ -0,0 +1,139 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ApiClient.h"  //Station, Measurement
+
+namespace httplib { class Server; }    //httplib.h tylko w pliku .cpp
+
+/// Nagrana seria jednego czujnika.
+struct ReplaySeries {
+    std::string metric;                                 ///< Nazwa miernika ("key" w getData)
+    std::vector<std::pair<int64_t, double>> points;     ///< (czas, wartość) od najnowszych, jak w API
+    int64_t oldest = 0;                                 ///< Najstarszy czas serii
+    int64_t newest = 0;                                 ///< Najnowszy czas serii
+};
+
+/// Nagrane odpowiedzi API GIOŚ (findAll, sensors/<id>, getData/<id>) zbudowane z stations.json i dane.json.
+/// Czujniki mają sztuczne id: id stacji * 100 + numer miernika.
+class ReplayFixtures {
+public:
+    /// Buduje odpowiedzi z plików lokalnych. scale > 1 powiela dane: lista stacji dostaje kopie stacji
+    /// (z nowymi id), a każda seria pomiarów kopie przesunięte wstecz o długość serii (scale razy więcej punktów).
+    /// \return false, jeśli nie udało się wczytać listy stacji.
+    bool load(const std::string& stationsFile, const std::string& measurementsFile, int scale);
+
+    /// Odpowiedź /pjp-api/rest/station/findAll.
+    const std::string& stationsJson() const { return stations; }
+
+    /// Odpowiedź /pjp-api/rest/station/sensors/<stationId>; false, jeśli stacja nie ma nagranych danych.
+    bool sensorsJson(int stationId, std::string& body) const;
+
+    /// Odpowiedź /pjp-api/rest/data/getData/<sensorId>; false dla nieznanego czujnika.
+    bool dataJson(int sensorId, std::string& body) const;
+
+    /// Seria czujnika lub nullptr dla nieznanego czujnika.
+    const ReplaySeries* series(int sensorId) const;
+
+    /// Czujniki stacji (rosnąco po id).
+    std::vector<int> sensorsOf(int stationId) const;
+
+    /// Stacje z nagranymi pomiarami (rosnąco po id).
+    std::vector<int> stationsWithData() const;
+
+    /// Liczba pomiarów stacji (po powieleniu).
+    size_t measurementCount(int stationId) const;
+
+    /// Łączna liczba pomiarów (po powieleniu).
+    size_t measurementCount() const;
+
+private:
+    std::string stations;                       ///< findAll
+    std::map<int, std::string> sensorLists;     ///< Stacja -> sensors/<id>
+    std::map<int, std::string> sensorData;      ///< Czujnik -> getData/<id>
+    std::map<int, ReplaySeries> sensorSeries;   ///< Czujnik -> seria (odpowiedzi z oknem czasu)
+    std::map<int, size_t> counts;               ///< Stacja -> liczba pomiarów
+};
+
+/// Stan serwera odtwarzającego.
+enum class ReplayMode {
+    Up,     ///< Odpowiedzi z opóźnieniem latencyMs
+    Down,   ///< Każde żądanie kończy się statusem 503 ze stroną HTML zamiast JSON
+    Slow    ///< Odpowiedzi z opóźnieniem slowMs (np. dłuższym niż limit czasu klienta)
+};
+
+/// Ustawienia serwera odtwarzającego.
+struct ReplayOptions {
+    int latencyMs = 0;      ///< Opóźnienie każdej odpowiedzi w trybie Up
+    int slowMs = 10000;     ///< Opóźnienie w trybie Slow
+    int windowHours = 0;    ///< > 0: getData zwraca tylko ostatnie windowHours godzin serii (jak API - kilka ostatnich dni)
+    int windowLagHours = 0; ///< O ile godzin koniec okna jest początkowo wcześniejszy niż koniec serii (patrz advanceWindow)
+};
+
+/// Lokalny serwer HTTP udający API GIOŚ na podstawie nagranych odpowiedzi (benchmarki, tryb offline).
+/// Tryb można zmieniać w trakcie działania: setMode lub GET /replay/mode/up|down|slow.
+/// Odpowiedzi sensors i getData mają nagłówki ETag i Last-Modified; żądanie z aktualnym If-None-Match
+/// (lub If-Modified-Since bez If-None-Match) dostaje 304 bez treści.
+class ReplayServer {
+public:
+    ReplayServer(const ReplayFixtures& fixtures, const ReplayOptions& options);
+
+    /// Zatrzymuje serwer.
+    ~ReplayServer();
+
+    ReplayServer(const ReplayServer&) = delete;
+    ReplayServer& operator=(const ReplayServer&) = delete;
+
+    /// Uruchamia serwer w osobnym wątku na 127.0.0.1. port = 0 oznacza dowolny wolny port.
+    /// \return Numer portu lub -1 przy błędzie.
+    int start(int port = 0);
+
+    /// Zatrzymuje serwer i czeka na wątek.
+    void stop();
+
+    /// Zmienia tryb odpowiedzi.
+    void setMode(ReplayMode mode);
+
+    /// Przesuwa okno getData o hours godzin do przodu (nowe pomiary, najstarsze wypadają), najdalej do końca serii.
+    void advanceWindow(int hours);
+
+    /// Zmienia o delta wartość najnowszego pomiaru w oknie każdego czujnika (korekta GIOŚ bez zmiany daty).
+    void reviseLatest(double delta);
+
+    /// Zakres czasu [from, to] bieżącej odpowiedzi getData czujnika; false dla nieznanego czujnika.
+    bool window(int sensorId, int64_t& from, int64_t& to) const;
+
+    /// Adres do przekazania ApiClient (np. "http://127.0.0.1:8080").
+    std::string url() const;
+
+    /// Liczba obsłużonych żądań.
+    size_t requests() const { return requestCount; }
+
+    /// Liczba połączeń TCP, z których przyszły żądania API (różne pary adres:port klienta).
+    size_t connections() const;
+
+private:
+    bool respond(const std::string& client); //opoznienie wg trybu; false = serwer "nie dziala"
+    bool sensorData(int sensorId, std::string& body, std::string& etag, int64_t& modified) const;
+
+    const ReplayFixtures& fixtures;
+    ReplayOptions options;
+    std::unique_ptr<httplib::Server> server;
+    std::thread listener;
+    int port = -1;
+    std::atomic<int> mode{ (int)ReplayMode::Up };
+    std::atomic<size_t> requestCount{ 0 };
+    std::atomic<int> lagHours{ 0 };         ///< Bieżące przesunięcie końca okna względem końca serii
+    mutable std::mutex revisionsMutex;
+    std::map<std::pair<int, int64_t>, double> revisions;    ///< (czujnik, czas) -> zmiana wartości
+    std::map<int, size_t> revisionCounts;   ///< Czujnik -> liczba korekt (część ETag)
+    mutable std::mutex clientsMutex;
+    std::set<std::string> clients;          ///< Adresy "ip:port" połączeń klientów
+};
@@ -0,0 +1,154 @@
+﻿#include "RollingWindow.h"
+#include "TimeUtils.h"
+#include "Trace.h"
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace {
+    const double notANumber = std::numeric_limits<double>::quiet_NaN();
+    const int64_t hour = 3600;  //dane GIOS sa godzinowe
+    const int64_t day = 86400;
+
+    /// Początek doby zawierającej podany czas.
+    int64_t dayStart(int64_t t) {
+        return (t >= 0 ? t / day : (t - day + 1) / day) * day;
+    }
+}
+
+RollingWindow::RollingWindow(int64_t widthSeconds) : width(widthSeconds) {}
+
+void RollingWindow::push(int64_t timestamp, double value) {
+    //usuniecie pomiarow starszych niz (t - szerokosc]
+    const int64_t oldest = timestamp - width;
+    while (!points.empty() && points.front().timestamp <= oldest) {
+        total -= points.front().value;
+        points.pop_front();
+    }
+    while (!minQueue.empty() && minQueue.front().timestamp <= oldest) minQueue.pop_front();
+    while (!maxQueue.empty() && maxQueue.front().timestamp <= oldest) maxQueue.pop_front();
+    if (points.empty()) total = 0.0; //kasuje narosly blad zaokraglen
+
+    Point p = { timestamp, value };
+    points.push_back(p);
+    total += value;
+    while (!minQueue.empty() && minQueue.back().value >= value) minQueue.pop_back(); //nowy pomiar "zaslania" wieksze
+    minQueue.push_back(p);
+    while (!maxQueue.empty() && maxQueue.back().value <= value) maxQueue.pop_back(); //i mniejsze
+    maxQueue.push_back(p);
+}
+
+void RollingWindow::clear() {
+    points.clear();
+    minQueue.clear();
+    maxQueue.clear();
+    total = 0.0;
+}
+
+double RollingWindow::mean() const {
+    return points.empty() ? notANumber : total / points.size();
+}
+
+double RollingWindow::minimum() const {
+    return minQueue.empty() ? notANumber : minQueue.front().value;
+}
+
+double RollingWindow::maximum() const {
+    return maxQueue.empty() ? notANumber : maxQueue.front().value;
+}
+
+MetricWindows computeWindows(const SeriesView& series, const WindowOptions& options) {
+    AQ_TRACE_SCOPE("analysis.windows");
+    MetricWindows out;
+    out.metric = series.metric;
+    const size_t n = series.size();
+    out.timestamps.assign(series.timestamps, series.timestamps + n);
+    out.mean24h.resize(n);
+    out.mean8h.resize(n);
+    out.max24h.resize(n);
+    out.min24h.resize(n);
+
+    RollingWindow w24(24 * hour), w8(8 * hour);
+    const double need24 = options.minCoverage * 24; //minimalna liczba godzin z pomiarem
+    const double need8 = options.minCoverage * 8;
+    const double needDay = options.minCoverage * 24;
+
+    DailyAggregate current;
+    double daySum = 0.0;
+    bool haveDay = false;
+    auto closeDay = [&]() { //zamkniecie zestawienia doby
+        if (!haveDay) return;
+        current.mean = current.count >= needDay ? daySum / current.count : notANumber;
+        out.daily.push_back(current);
+    };
+
+    for (size_t i = 0; i < n; ++i) {
+        const int64_t t = series.timestamps[i];
+        const double v = series.values[i];
+        w24.push(t, v);
+        w8.push(t, v);
+        out.mean24h[i] = w24.count() >= need24 ? w24.mean() : notANumber;
+        out.mean8h[i] = w8.count() >= need8 ? w8.mean() : notANumber;
+        out.max24h[i] = w24.maximum();
+        out.min24h[i] = w24.minimum();
+
+        const int64_t d = dayStart(t);
+        if (!haveDay || d != current.day) { //nowa doba
+            closeDay();
+            current = DailyAggregate();
+            current.day = d;
+            current.min = current.max = v;
+            current.max8hMean = notANumber;
+            daySum = 0.0;
+            haveDay = true;
+        }
+        current.count++;
+        daySum += v;
+        if (v < current.min) current.min = v;
+        if (v > current.max) current.max = v;
+        if (!std::isnan(out.mean8h[i]) && (std::isnan(current.max8hMean) || out.mean8h[i] > current.max8hMean))
+            current.max8hMean = out.mean8h[i];
+    }
+    closeDay();
+    return out;
+}
+
+std::vector<MetricWindows> computeStationWindows(const SeriesSet& set, const WindowOptions& options) {
+    std::vector<MetricWindows> result;
+    for (const auto& series : set.allSeries()) //serie sa posortowane po czasie (indeks SeriesSet)
+        result.push_back(computeWindows(series.view(), options));
+    return result;
+}
+
+double defaultDailyLimit(const std::string& metric) {
+    if (metric == "PM10") return 50.0;
+    if (metric == "SO2") return 125.0;
+    return 0.0;
+}
+
+std::string formatWindowReport(const MetricWindows& w, double dailyLimit, const std::string& nl) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2);
+
+    double last24 = notANumber; //ostatnia poprawna srednia 24h
+    for (size_t i = w.mean24h.size(); i-- > 0;)
+        if (!std::isnan(w.mean24h[i])) { last24 = w.mean24h[i]; break; }
+    if (std::isnan(last24)) oss << "Średnia 24h: brak (za mało pomiarów)" << nl;
+    else oss << "Średnia 24h (ostatnia): " << last24 << " µg/m^3" << nl;
+
+    double best8 = notANumber;
+    int64_t best8Day = 0;
+    size_t daysOver = 0, validDays = 0;
+    for (const auto& d : w.daily) {
+        if (!std::isnan(d.max8hMean) && (std::isnan(best8) || d.max8hMean > best8)) { best8 = d.max8hMean; best8Day = d.day; }
+        if (std::isnan(d.mean)) continue;
+        ++validDays;
+        if (dailyLimit > 0 && d.mean > dailyLimit) ++daysOver;
+    }
+    if (!std::isnan(best8))
+        oss << "Maks. średnia 8h: " << best8 << " (" << formatTimestamp(best8Day).substr(0, 10) << ")" << nl;
+    if (dailyLimit > 0)
+        oss << "Doby ze średnią > " << dailyLimit << ": " << daysOver << " z " << validDays << nl;
+    return oss.str();
+}
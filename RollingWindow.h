@@ -0,0 +1,82 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include "MeasurementSeries.h"  //SeriesView, SeriesSet
+
+/// Okno kroczące po czasie, np. ostatnie 24 godziny, nad pomiarami dodawanymi w kolejności czasu.
+/// Okno obejmuje pomiary z przedziału (t - szerokość, t], gdzie t to czas ostatniego pomiaru,
+/// więc luki w danych godzinowych nie przesuwają okna o liczbę pomiarów, tylko o czas.
+/// Suma jest aktualizowana przyrostowo, a minimum i maksimum trzymane w kolejkach monotonicznych,
+/// dzięki czemu każdy push kosztuje zamortyzowane O(1).
+class RollingWindow {
+public:
+    /// Tworzy okno o podanej szerokości w sekundach.
+    explicit RollingWindow(int64_t widthSeconds);
+
+    /// Dodaje pomiar (czas nie może być mniejszy niż poprzedni) i usuwa pomiary spoza okna.
+    void push(int64_t timestamp, double value);
+
+    /// Usuwa wszystkie pomiary z okna.
+    void clear();
+
+    size_t count() const { return points.size(); }  ///< Liczba pomiarów w oknie
+    double sum() const { return total; }            ///< Suma wartości w oknie
+    double mean() const;                            ///< Średnia (NaN dla pustego okna)
+    double minimum() const;                         ///< Minimum (NaN dla pustego okna)
+    double maximum() const;                         ///< Maksimum (NaN dla pustego okna)
+
+private:
+    /// Pomiar w oknie.
+    struct Point {
+        int64_t timestamp;
+        double value;
+    };
+
+    int64_t width;              ///< Szerokość okna [s]
+    std::deque<Point> points;   ///< Pomiary w oknie (rosnąco po czasie)
+    std::deque<Point> minQueue; ///< Kandydaci na minimum (wartości rosnące)
+    std::deque<Point> maxQueue; ///< Kandydaci na maksimum (wartości malejące)
+    double total = 0.0;         ///< Suma wartości w oknie
+};
+
+/// Ustawienia obliczeń okien kroczących.
+struct WindowOptions {
+    double minCoverage = 0.75;  ///< Wymagany udział godzin z pomiarem w oknie (np. 18 z 24), inaczej wynik = NaN
+};
+
+/// Zestawienie jednej doby.
+struct DailyAggregate {
+    int64_t day = 0;            ///< Początek doby (sekundy od 1970-01-01)
+    size_t count = 0;           ///< Liczba pomiarów w dobie
+    double min = 0.0;           ///< Minimum
+    double mean = 0.0;          ///< Średnia dobowa (NaN przy zbyt małym pokryciu)
+    double max = 0.0;           ///< Maksimum
+    double max8hMean = 0.0;     ///< Maksimum kroczącej średniej 8-godzinnej (norma dla CO i O3), NaN gdy brak
+};
+
+/// Okna kroczące jednego miernika - wartości dla każdego pomiaru (koniec okna = czas pomiaru).
+struct MetricWindows {
+    uint16_t metric = 0;                ///< Id miernika z MetricRegistry
+    std::vector<int64_t> timestamps;    ///< Czas końca okna
+    std::vector<double> mean24h;        ///< Średnia 24-godzinna (NaN przy zbyt małym pokryciu)
+    std::vector<double> mean8h;         ///< Średnia 8-godzinna (NaN przy zbyt małym pokryciu)
+    std::vector<double> max24h;         ///< Maksimum z ostatnich 24 godzin
+    std::vector<double> min24h;         ///< Minimum z ostatnich 24 godzin
+    std::vector<DailyAggregate> daily;  ///< Zestawienia dobowe
+};
+
+/// Liczy wszystkie okna jednej serii w jednym przebiegu.
+MetricWindows computeWindows(const SeriesView& series, const WindowOptions& options = WindowOptions());
+
+/// Liczy wszystkie okna dla wszystkich mierników stacji (jeden przebieg na miernik).
+std::vector<MetricWindows> computeStationWindows(const SeriesSet& set, const WindowOptions& options = WindowOptions());
+
+/// Zwraca normę średniej dobowej dla miernika (PM10 -> 50, SO2 -> 125 µg/m³), 0 gdy brak normy dobowej.
+double defaultDailyLimit(const std::string& metric);
+
+/// Buduje tekstowe podsumowanie okien (ostatnia średnia 24h, maks. średnia 8h, doby powyżej normy).
+/// \param dailyLimit Norma średniej dobowej (0 = nie liczyć przekroczeń).
+std::string formatWindowReport(const MetricWindows& windows, double dailyLimit, const std::string& newline);
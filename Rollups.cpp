@@ -0,0 +1,262 @@
+﻿#include "Rollups.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include "StationIndex.h"       //foldSearchText
+#include "Statistics.h"         //defaultLimits
+#include "TimeUtils.h"
+#include "WorkStealingPool.h"
+
+QuantileSketch::QuantileSketch(double accuracy) {
+    gamma = (1.0 + accuracy) / (1.0 - accuracy);
+    logGamma = std::log(gamma);
+}
+
+void QuantileSketch::add(double value) {
+    ++total;
+    if (!(value > 0.0)) { ++zeros; return; }
+    int index = (int)std::ceil(std::log(value) / logGamma);
+    if (buckets.empty()) offset = index;
+    if (index < offset) { //rozszerzenie zakresu w dol
+        buckets.insert(buckets.begin(), offset - index, 0);
+        offset = index;
+    }
+    if (index - offset >= (int)buckets.size()) buckets.resize(index - offset + 1, 0);
+    buckets[index - offset]++;
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    total += other.total;
+    zeros += other.zeros;
+    if (other.buckets.empty()) return;
+    if (buckets.empty()) {
+        buckets = other.buckets;
+        offset = other.offset;
+        return;
+    }
+    int low = std::min(offset, other.offset);
+    int high = std::max(offset + (int)buckets.size(), other.offset + (int)other.buckets.size());
+    if (low < offset) {
+        buckets.insert(buckets.begin(), offset - low, 0);
+        offset = low;
+    }
+    if (high - offset > (int)buckets.size()) buckets.resize(high - offset, 0);
+    for (size_t i = 0; i < other.buckets.size(); ++i) buckets[other.offset - offset + i] += other.buckets[i];
+}
+
+double QuantileSketch::quantile(double q) const {
+    if (total == 0) return 0.0;
+    size_t rank = (size_t)(q * (total - 1)); //indeks wartosci w posortowanym ciagu
+    if (rank < zeros) return 0.0;
+    size_t seen = zeros;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen > rank) return 2.0 * std::pow(gamma, offset + (int)i) / (gamma + 1.0); //srodek przedzialu (gamma^(i-1), gamma^i]
+    }
+    return std::pow(gamma, offset + (int)buckets.size() - 1);
+}
+
+void RollupAggregate::merge(const RollupAggregate& other) {
+    count += other.count;
+    sum += other.sum;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    exceedances += other.exceedances;
+    sketch.merge(other.sketch);
+}
+
+namespace {
+    /// Agregat częściowy jednego wątku.
+    struct Partial {
+        std::vector<StationRollup> stations;
+        std::map<std::string, ProvinceRollup> provinces;
+        std::unordered_map<int64_t, RollupAggregate> hours;    //poczatek godziny -> wartosci stacji
+        RollupAggregate national;
+        size_t scanned = 0;
+    };
+}
+
+RollupResult computeRollups(const std::vector<Station>& stations, const RollupSource& source, const RollupQuery& query, unsigned threadCount) {
+    RollupResult result;
+    std::vector<double> limits = defaultLimits(query.metric);
+    result.limit = query.limit >= 0 ? query.limit : (limits.empty() ? (std::numeric_limits<double>::max)() : limits.front());
+    const std::string province = foldSearchText(query.province); //jak eksport: bez wielkosci liter i polskich znakow
+    std::vector<const Station*> selected;
+    for (const Station& station : stations)
+        if (province.empty() || foldSearchText(station.province) == province) selected.push_back(&station);
+
+    //Ostatnie N godzin liczone od najnowszego pomiaru wszystkich stacji (wspolne okno dla rankingu),
+    //wiec najpierw wczytanie wszystkich serii i znalezienie najnowszego czasu.
+    std::vector<SeriesSet> preloaded(query.lastHours > 0 ? selected.size() : 0);
+    std::vector<char> preloadedOk(preloaded.size(), 0);
+    int64_t windowStart = query.start, windowEnd = query.end;
+    if (query.lastHours > 0) {
+        std::mutex newestMutex;
+        int64_t newest = (std::numeric_limits<int64_t>::min)();
+        {
+            WorkStealingPool pool(threadCount);
+            for (size_t i = 0; i < selected.size(); ++i) {
+                pool.submit([&, i]() {
+                    preloadedOk[i] = source(*selected[i], preloaded[i]) ? 1 : 0;
+                    SeriesView view = preloadedOk[i] ? preloaded[i].range(query.metric, query.start, query.end) : SeriesView();
+                    if (view.empty()) return;
+                    std::lock_guard<std::mutex> lock(newestMutex);
+                    newest = std::max(newest, view.timestamps[view.count - 1]);
+                });
+            }
+            pool.wait();
+        }
+        if (newest != (std::numeric_limits<int64_t>::min)()) {
+            windowStart = std::max(query.start, newest - (int64_t)query.lastHours * 3600 + 1);
+            windowEnd = newest;
+        }
+    }
+    const double limit = result.limit;
+
+    std::mutex partialsMutex;
+    std::vector<std::unique_ptr<Partial>> partials; //najwyzej tyle, ile zadan dziala naraz (czyli watkow)
+    std::vector<Partial*> freePartials;
+    auto acquire = [&]() {
+        std::lock_guard<std::mutex> lock(partialsMutex);
+        if (freePartials.empty()) {
+            partials.emplace_back(new Partial);
+            return partials.back().get();
+        }
+        Partial* p = freePartials.back();
+        freePartials.pop_back();
+        return p;
+    };
+    auto release = [&](Partial* p) {
+        std::lock_guard<std::mutex> lock(partialsMutex);
+        freePartials.push_back(p);
+    };
+
+    {
+        WorkStealingPool pool(threadCount);
+        for (size_t index = 0; index < selected.size(); ++index) {
+            pool.submit([&, index]() { //zadanie = jedna stacja (wczytanie i redukcja)
+                const Station& station = *selected[index];
+                SeriesSet local;
+                const bool preloadedSeries = !preloaded.empty();
+                const SeriesSet& series = preloadedSeries ? preloaded[index] : local;
+                bool loaded = preloadedSeries ? preloadedOk[index] != 0 : source(station, local);
+                Partial* part = acquire(); //wlasny agregat watku do konca zadania
+                part->scanned++;
+                SeriesView view;
+                if (loaded) view = series.range(query.metric, windowStart, windowEnd);
+                if (view.empty()) {
+                    release(part);
+                    return;
+                }
+
+                StationRollup rollup;
+                rollup.station = station;
+                RollupAggregate& agg = rollup.aggregate;
+                for (size_t i = 0; i < view.count; ++i) { //jeden przebieg po tablicy wartosci
+                    double v = view.values[i];
+                    agg.count++;
+                    agg.sum += v;
+                    if (v < agg.min) agg.min = v;
+                    if (v > agg.max) agg.max = v;
+                    if (v > limit) agg.exceedances++;
+                    agg.sketch.add(v);
+                    if (query.hourly) {
+                        RollupAggregate& hour = part->hours[view.timestamps[i] - view.timestamps[i] % 3600];
+                        hour.count++;
+                        hour.sum += v;
+                        hour.sketch.add(v);
+                    }
+                }
+
+                ProvinceRollup& prov = part->provinces[station.province];
+                prov.province = station.province;
+                prov.stations++;
+                if (agg.exceedances) prov.stationsExceeding++;
+                prov.aggregate.merge(agg);
+                part->national.merge(agg);
+                part->stations.push_back(std::move(rollup));
+                release(part);
+            });
+        }
+        pool.wait();
+    }
+
+    std::map<std::string, ProvinceRollup> provinces; //laczenie agregatow czesciowych
+    std::unordered_map<int64_t, RollupAggregate> hours;
+    for (auto& part : partials) {
+        result.stationsScanned += part->scanned;
+        result.national.merge(part->national);
+        std::move(part->stations.begin(), part->stations.end(), std::back_inserter(result.stations));
+        for (auto& kv : part->provinces) {
+            ProvinceRollup& prov = provinces[kv.first];
+            prov.province = kv.first;
+            prov.stations += kv.second.stations;
+            prov.stationsExceeding += kv.second.stationsExceeding;
+            prov.aggregate.merge(kv.second.aggregate);
+        }
+        for (auto& kv : part->hours) hours[kv.first].merge(kv.second);
+    }
+    result.points = result.national.count;
+
+    for (auto& kv : provinces) result.provinces.push_back(std::move(kv.second));
+    std::sort(result.provinces.begin(), result.provinces.end(), [](const ProvinceRollup& a, const ProvinceRollup& b) {
+        if (a.stationsExceeding != b.stationsExceeding) return a.stationsExceeding > b.stationsExceeding;
+        return a.aggregate.sketch.quantile(0.95) > b.aggregate.sketch.quantile(0.95);
+    });
+    std::sort(result.stations.begin(), result.stations.end(), [](const StationRollup& a, const StationRollup& b) {
+        if (a.aggregate.exceedances != b.aggregate.exceedances) return a.aggregate.exceedances > b.aggregate.exceedances;
+        if (a.aggregate.max != b.aggregate.max) return a.aggregate.max > b.aggregate.max;
+        return a.station.id < b.station.id;
+    });
+    for (auto& kv : hours) {
+        HourlyRollup h;
+        h.hour = kv.first;
+        h.count = kv.second.count;
+        h.mean = kv.second.mean();
+        h.p50 = kv.second.sketch.quantile(0.50);
+        h.p95 = kv.second.sketch.quantile(0.95);
+        result.hourly.push_back(h);
+    }
+    std::sort(result.hourly.begin(), result.hourly.end(), [](const HourlyRollup& a, const HourlyRollup& b) { return a.hour < b.hour; });
+    return result;
+}
+
+std::string formatRollupReport(const RollupResult& result, const RollupQuery& query, size_t topStations, const char* newline) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "Zestawienie - " << query.metric << (query.province.empty() ? " (cała Polska)" : " (" + query.province + ")")
+        << ", próg " << result.limit << newline;
+    out << "Stacje: " << result.stations.size() << " z danymi / " << result.stationsScanned << " przejrzanych, pomiary: " << result.points << newline;
+    if (result.national.count) {
+        out << "Średnia: " << result.national.mean() << ", P50: " << result.national.sketch.quantile(0.5)
+            << ", P95: " << result.national.sketch.quantile(0.95) << ", maks.: " << result.national.max
+            << ", przekroczenia: " << result.national.exceedances << newline;
+    }
+
+    out << newline << "Województwa (stacje z przekroczeniem / stacje, średnia, P95, maks.):" << newline;
+    for (const auto& p : result.provinces) {
+        out << "  " << p.province << ": " << p.stationsExceeding << " / " << p.stations << ", " << p.aggregate.mean()
+            << ", " << p.aggregate.sketch.quantile(0.95) << ", " << p.aggregate.max << newline;
+    }
+
+    out << newline << "Stacje z największą liczbą przekroczeń:" << newline;
+    for (size_t i = 0; i < result.stations.size() && i < topStations; ++i) {
+        const StationRollup& s = result.stations[i];
+        out << "  " << i + 1 << ". " << s.station.name << " (" << s.station.province << "): " << s.aggregate.exceedances
+            << " przekroczeń, maks. " << s.aggregate.max << ", średnia " << s.aggregate.mean() << newline;
+    }
+
+    if (query.hourly && !result.hourly.empty()) {
+        out << newline << "Godziny (stacje, średnia, P50, P95):" << newline;
+        for (const auto& h : result.hourly) {
+            out << "  " << formatTimestamp(h.hour).substr(0, 16) << ": " << h.count << ", " << h.mean << ", " << h.p50
+                << ", " << h.p95 << newline;
+        }
+    }
+    return out.str();
+}
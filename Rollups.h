@@ -0,0 +1,112 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+#include "ApiClient.h"          //Station
+#include "MeasurementSeries.h"  //SeriesSet, SeriesView
+
+/// Szkic rozkładu do kwantyli (przedziały logarytmiczne): wartość v trafia do przedziału
+/// ceil(log(v) / log(gamma)), więc kwantyl ma błąd względny najwyżej accuracy.
+/// Szkice można łączyć (dodawanie liczników), co pozwala liczyć kwantyle częściowo w wielu wątkach.
+class QuantileSketch {
+public:
+    /// Tworzy szkic o podanej dokładności względnej (np. 0.01 = 1%).
+    explicit QuantileSketch(double accuracy = 0.02);
+
+    /// Dodaje wartość (wartości <= 0 liczone są osobno jako zero).
+    void add(double value);
+
+    /// Dołącza liczniki innego szkicu (o tej samej dokładności).
+    void merge(const QuantileSketch& other);
+
+    /// Zwraca przybliżony kwantyl q (0..1); 0 dla pustego szkicu.
+    double quantile(double q) const;
+
+    /// Liczba dodanych wartości.
+    size_t count() const { return total; }
+
+private:
+    double gamma;                   ///< (1 + accuracy) / (1 - accuracy)
+    double logGamma;
+    std::vector<uint32_t> buckets;  ///< Liczniki przedziałów od indeksu offset
+    int offset = 0;
+    size_t zeros = 0;               ///< Wartości <= 0
+    size_t total = 0;
+};
+
+/// Agregat częściowy: liczba, suma, minimum, maksimum, przekroczenia progu i szkic kwantyli.
+struct RollupAggregate {
+    size_t count = 0;
+    double sum = 0.0;
+    double min = (std::numeric_limits<double>::max)();    //nawiasy - makro max z windows.h
+    double max = std::numeric_limits<double>::lowest();
+    size_t exceedances = 0;         ///< Pomiary powyżej progu zapytania
+    QuantileSketch sketch;
+
+    /// Średnia (0 dla pustego agregatu).
+    double mean() const { return count ? sum / count : 0.0; }
+
+    /// Dołącza agregat innej części.
+    void merge(const RollupAggregate& other);
+};
+
+/// Zapytanie o zestawienie wielu stacji.
+struct RollupQuery {
+    std::string metric = "PM10";                            ///< Miernik
+    int64_t start = (std::numeric_limits<int64_t>::min)();  ///< Początek zakresu (sekundy, TimeUtils.h)
+    int64_t end = (std::numeric_limits<int64_t>::max)();    ///< Koniec zakresu
+    int lastHours = 0;          ///< > 0: tylko ostatnie N godzin przed najnowszym pomiarem wszystkich stacji (w start/end)
+    double limit = -1.0;        ///< Próg przekroczenia; < 0 = pierwsza norma z defaultLimits(metric)
+    std::string province;       ///< Tylko stacje z województwa (puste = cały kraj; porównanie foldSearchText - bez wielkości liter i polskich znaków)
+    bool hourly = false;        ///< Czy liczyć krajowe kwantyle dla każdej godziny
+};
+
+/// Wynik jednej stacji.
+struct StationRollup {
+    Station station;
+    RollupAggregate aggregate;
+};
+
+/// Wynik województwa.
+struct ProvinceRollup {
+    std::string province;
+    size_t stations = 0;            ///< Stacje z pomiarami w zakresie
+    size_t stationsExceeding = 0;   ///< Stacje z co najmniej jednym przekroczeniem
+    RollupAggregate aggregate;
+};
+
+/// Krajowe wartości jednej godziny.
+struct HourlyRollup {
+    int64_t hour = 0;       ///< Początek godziny (sekundy)
+    size_t count = 0;       ///< Liczba stacji z pomiarem
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+};
+
+/// Wynik zestawienia.
+struct RollupResult {
+    std::vector<StationRollup> stations;    ///< Malejąco wg przekroczeń, potem maksimum
+    std::vector<ProvinceRollup> provinces;  ///< Malejąco wg stacji z przekroczeniami, potem P95
+    std::vector<HourlyRollup> hourly;       ///< Rosnąco wg godziny (gdy query.hourly)
+    RollupAggregate national;               ///< Cały kraj (lub województwo z zapytania)
+    double limit = 0.0;                     ///< Użyty próg przekroczenia
+    size_t stationsScanned = 0;             ///< Stacje przejrzane (z danymi i bez)
+    size_t points = 0;                      ///< Pomiary w zakresie
+};
+
+/// Źródło danych stacji: wypełnia series (np. z MeasurementStore lub pamięci podręcznej); false = brak danych.
+using RollupSource = std::function<bool(const Station& station, SeriesSet& series)>;
+
+/// Liczy zestawienie wszystkich stacji równolegle: stacje są dzielone na zadania puli WorkStealingPool,
+/// każdy wątek dokłada wyniki do własnego agregatu częściowego (bez blokad na pomiar),
+/// a agregaty są łączone na końcu. threadCount = 0 oznacza liczbę rdzeni.
+/// Z query.lastHours serie są wczytywane w osobnym przebiegu przed redukcją (wspólne okno wymaga
+/// najnowszego czasu wszystkich stacji), więc wszystkie wybrane serie są naraz w pamięci.
+RollupResult computeRollups(const std::vector<Station>& stations, const RollupSource& source, const RollupQuery& query, unsigned threadCount = 0);
+
+/// Formatuje wynik jako tekst: ranking województw, top stacji i (opcjonalnie) godziny.
+std::string formatRollupReport(const RollupResult& result, const RollupQuery& query, size_t topStations, const char* newline);
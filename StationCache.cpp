@@ -0,0 +1,144 @@
+﻿#include "StationCache.h"
+
+std::shared_ptr<const CachedStation> makeCachedStation(std::vector<Measurement> measurements) {
+    std::shared_ptr<CachedStation> station = std::make_shared<CachedStation>();
+    station->series = SeriesSet::fromMeasurements(measurements);
+    station->metrics = station->series.metricNames();
+    station->measurements = std::move(measurements);
+    return station;
+}
+
+size_t estimateBytes(const CachedStation& station) {
+    size_t total = sizeof(CachedStation) + station.series.memoryBytes();
+    total += station.measurements.capacity() * sizeof(Measurement);
+    for (const auto& m : station.measurements) { //napisy dluzsze niz bufor SSO zajmuja pamiec na stercie
+        if (m.name.capacity() > 15) total += m.name.capacity() + 1;
+        if (m.date.capacity() > 15) total += m.date.capacity() + 1;
+    }
+    for (const auto& name : station.metrics) total += sizeof(std::string) + name.capacity();
+    return total;
+}
+
+StationCache::StationCache(size_t budgetBytes, std::chrono::milliseconds ttl) : budget(budgetBytes), ttl(ttl) {}
+
+StationCache::~StationCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        queue.clear();
+    }
+    queueCv.notify_all();
+    if (worker.joinable()) worker.join(); //czeka tylko na biezace odswiezenie
+}
+
+StationCache::Lookup StationCache::lookup(const std::string& stationId) {
+    Lookup result;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(stationId);
+    if (it == index.end()) {
+        counters.misses++;
+        return result;
+    }
+    lru.splice(lru.begin(), lru, it->second); //ostatnio uzyty na poczatek listy
+    result.entry = it->second->entry;
+    if (Clock::now() - it->second->loaded < ttl) {
+        result.state = State::Fresh;
+        counters.hits++;
+    }
+    else {
+        result.state = State::Stale;
+        counters.staleHits++;
+    }
+    return result;
+}
+
+void StationCache::put(const std::string& stationId, Entry entry) {
+    if (!entry) return;
+    const size_t size = estimateBytes(*entry); //liczone poza blokada
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(stationId);
+    if (it != index.end()) {
+        bytes -= it->second->bytes;
+        lru.erase(it->second);
+        index.erase(it);
+    }
+    Node node;
+    node.stationId = stationId;
+    node.entry = std::move(entry);
+    node.bytes = size;
+    node.loaded = Clock::now();
+    lru.push_front(std::move(node));
+    index[stationId] = lru.begin();
+    bytes += size;
+    evict();
+}
+
+void StationCache::evict() {
+    while (bytes > budget && lru.size() > 1) { //najnowszy wpis zostaje, nawet jesli sam przekracza limit
+        Node& last = lru.back();
+        bytes -= last.bytes;
+        index.erase(last.stationId);
+        lru.pop_back(); //dane zyja dalej, jesli ktos trzyma shared_ptr
+        counters.evictions++;
+    }
+}
+
+void StationCache::refreshAsync(const std::string& stationId, Loader loader, RefreshedCallback onRefreshed) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping || !refreshing.insert(stationId).second) return; //juz w kolejce lub w trakcie
+        Job job;
+        job.stationId = stationId;
+        job.loader = std::move(loader);
+        job.onRefreshed = std::move(onRefreshed);
+        queue.push_back(std::move(job));
+        if (!worker.joinable()) worker = std::thread(&StationCache::refreshLoop, this);
+    }
+    queueCv.notify_one();
+}
+
+void StationCache::refreshLoop() {
+    for (;;) {
+        Job job;
+        Entry previous;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queueCv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            job = std::move(queue.front());
+            queue.pop_front();
+            auto it = index.find(job.stationId);
+            if (it != index.end()) previous = it->second->entry;
+        }
+
+        Entry fresh = job.loader(job.stationId, previous); //siec i dysk bez blokady
+        if (fresh) put(job.stationId, fresh);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            refreshing.erase(job.stationId);
+            if (fresh) counters.refreshes++;
+        }
+        if (fresh && job.onRefreshed) job.onRefreshed(job.stationId);
+    }
+}
+
+void StationCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    lru.clear();
+    index.clear();
+    bytes = 0;
+}
+
+void StationCache::setBudget(size_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = budgetBytes;
+    evict();
+}
+
+StationCacheStats StationCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    StationCacheStats s = counters;
+    s.entries = lru.size();
+    s.bytes = bytes;
+    return s;
+}
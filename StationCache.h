@@ -0,0 +1,126 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "ApiClient.h"          //Measurement
+#include "MeasurementSeries.h"  //SeriesSet
+
+/// Dane jednej stacji trzymane w pamięci podręcznej (niezmienne po utworzeniu - współdzielone przez shared_ptr).
+struct CachedStation {
+    std::vector<Measurement> measurements;  ///< Wszystkie pomiary stacji
+    SeriesSet series;                       ///< Pomiary pogrupowane po miernikach (indeks czasowy)
+    std::vector<std::string> metrics;       ///< Posortowane nazwy mierników
+};
+
+/// Buduje wpis pamięci podręcznej z pomiarów stacji.
+std::shared_ptr<const CachedStation> makeCachedStation(std::vector<Measurement> measurements);
+
+/// Szacuje zajętość pamięci wpisu w bajtach (pomiary, serie, napisy).
+size_t estimateBytes(const CachedStation& station);
+
+/// Liczniki pamięci podręcznej stacji.
+struct StationCacheStats {
+    size_t hits = 0;            ///< Trafienia w świeży wpis
+    size_t staleHits = 0;       ///< Trafienia w przeterminowany wpis (zwrócony od razu, odświeżany w tle)
+    size_t misses = 0;          ///< Brak wpisu
+    size_t evictions = 0;       ///< Wpisy usunięte z powodu limitu pamięci
+    size_t refreshes = 0;       ///< Zakończone odświeżenia w tle
+    size_t entries = 0;         ///< Liczba wpisów
+    size_t bytes = 0;           ///< Szacowana zajętość pamięci
+};
+
+/// Pamięć podręczna pomiarów stacji: LRU z limitem pamięci i czasem ważności wpisu (TTL).
+/// Świeży wpis jest zwracany od razu. Przeterminowany też jest zwracany od razu,
+/// a odświeżenie wykonuje się w tle (stale-while-revalidate).
+/// Nie zależy od WinAPI - powiadomienie o odświeżeniu przekazuje funkcja zwrotna.
+class StationCache {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Entry = std::shared_ptr<const CachedStation>;
+
+    /// Funkcja pobierająca aktualne dane stacji (wywoływana w wątku tła). previous to dotychczasowy wpis
+    /// (może posłużyć do pobrania tylko nowych pomiarów). Zwrócenie nullptr oznacza błąd - wpis zostaje bez zmian.
+    using Loader = std::function<Entry(const std::string& stationId, const Entry& previous)>;
+
+    /// Wywoływana w wątku tła po udanym odświeżeniu wpisu.
+    using RefreshedCallback = std::function<void(const std::string& stationId)>;
+
+    /// Stan znalezionego wpisu.
+    enum class State { Miss, Fresh, Stale };
+
+    /// Wynik wyszukania.
+    struct Lookup {
+        State state = State::Miss;  ///< Czy wpis istnieje i czy jest świeży
+        Entry entry;                ///< Dane stacji (nullptr przy Miss)
+    };
+
+    /// Tworzy pamięć podręczną z limitem pamięci [B] i czasem ważności wpisu.
+    StationCache(size_t budgetBytes, std::chrono::milliseconds ttl);
+
+    /// Zatrzymuje wątek odświeżania (oczekujące odświeżenia są porzucane).
+    ~StationCache();
+
+    StationCache(const StationCache&) = delete;
+    StationCache& operator=(const StationCache&) = delete;
+
+    /// Wyszukuje wpis i oznacza go jako ostatnio użyty.
+    Lookup lookup(const std::string& stationId);
+
+    /// Wstawia lub zastępuje wpis (czas ważności liczony od teraz) i usuwa najdawniej używane ponad limit.
+    void put(const std::string& stationId, Entry entry);
+
+    /// Zleca odświeżenie wpisu w tle. Drugie zlecenie dla stacji, która już jest odświeżana, jest pomijane.
+    void refreshAsync(const std::string& stationId, Loader loader, RefreshedCallback onRefreshed);
+
+    /// Usuwa wszystkie wpisy.
+    void clear();
+
+    /// Zmienia limit pamięci (nadmiarowe wpisy są usuwane od razu).
+    void setBudget(size_t budgetBytes);
+
+    /// Zwraca kopię liczników.
+    StationCacheStats stats() const;
+
+private:
+    /// Wpis listy LRU.
+    struct Node {
+        std::string stationId;
+        Entry entry;
+        size_t bytes = 0;
+        Clock::time_point loaded;   ///< Czas wstawienia (do TTL)
+    };
+
+    /// Zlecone odświeżenie.
+    struct Job {
+        std::string stationId;
+        Loader loader;
+        RefreshedCallback onRefreshed;
+    };
+
+    void evict();           //usuwa najdawniej uzywane wpisy ponad limit (pod blokada)
+    void refreshLoop();     //petla watku odswiezania
+
+    mutable std::mutex mutex;
+    std::list<Node> lru;    ///< Na początku najświeżej użyte
+    std::unordered_map<std::string, std::list<Node>::iterator> index;
+    size_t budget;
+    std::chrono::milliseconds ttl;
+    size_t bytes = 0;
+    StationCacheStats counters;
+
+    std::condition_variable queueCv;    ///< Budzi wątek odświeżania
+    std::deque<Job> queue;              ///< Oczekujące odświeżenia
+    std::set<std::string> refreshing;   ///< Stacje zlecone lub odświeżane
+    std::thread worker;                 ///< Wątek odświeżania (uruchamiany przy pierwszej potrzebie)
+    bool stopping = false;
+};
@@ -0,0 +1,33 @@
+﻿#include "StationDiff.h"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+StationDiff diffStations(const std::vector<Station>& current, const std::vector<Station>& fresh) {
+    StationDiff diff;
+    std::unordered_map<int, const Station*> known; //id -> stacja z zapisanej listy
+    for (const auto& s : current) known[s.id] = &s;
+
+    std::unordered_set<int> seen;
+    for (const auto& s : fresh) {
+        seen.insert(s.id);
+        auto it = known.find(s.id);
+        if (it == known.end()) diff.added.push_back(s);
+        else if (it->second->name != s.name || it->second->province != s.province) diff.renamed.push_back(s);
+    }
+    for (const auto& s : current)
+        if (!seen.count(s.id)) diff.removed.push_back(s.id);
+    return diff;
+}
+
+void applyStationDiff(std::vector<Station>& stations, const StationDiff& diff) {
+    if (!diff.removed.empty()) {
+        std::unordered_set<int> removed(diff.removed.begin(), diff.removed.end());
+        stations.erase(std::remove_if(stations.begin(), stations.end(),
+            [&](const Station& s) { return removed.count(s.id) != 0; }), stations.end());
+    }
+    for (const auto& r : diff.renamed)
+        for (auto& s : stations)
+            if (s.id == r.id) { s = r; break; }
+    stations.insert(stations.end(), diff.added.begin(), diff.added.end());
+}
@@ -0,0 +1,21 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <vector>
+#include "ApiClient.h"  //Station
+
+/// Różnica między zapisaną a pobraną listą stacji.
+struct StationDiff {
+    std::vector<Station> added;     ///< Stacje nowe (w kolejności z nowej listy)
+    std::vector<int> removed;       ///< Id stacji, których nie ma w nowej liście
+    std::vector<Station> renamed;   ///< Stacje ze zmienioną nazwą lub województwem (nowe dane)
+
+    /// Czy listy są takie same (z dokładnością do kolejności).
+    bool empty() const { return added.empty() && removed.empty() && renamed.empty(); }
+};
+
+/// Porównuje listy stacji po id.
+StationDiff diffStations(const std::vector<Station>& current, const std::vector<Station>& fresh);
+
+/// Nakłada różnicę na listę: usuwa, podmienia nazwy, dopisuje nowe stacje na końcu.
+/// Pozostałe stacje zachowują kolejność (i pozycję w liście rozwijanej GUI).
+void applyStationDiff(std::vector<Station>& stations, const StationDiff& diff);
@@ -0,0 +1,171 @@
+﻿#include "StationIndex.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    /// Litera bez znaków diakrytycznych dla znaku Unicode z zakresu U+00C0..U+017F (0 = bez zamiany).
+    char foldCodePoint(unsigned cp) {
+        switch (cp) {
+        case 0x104: case 0x105: return 'a';     //polskie litery
+        case 0x106: case 0x107: return 'c';
+        case 0x118: case 0x119: return 'e';
+        case 0x141: case 0x142: return 'l';
+        case 0x143: case 0x144: return 'n';
+        case 0xD3: case 0xF3: return 'o';
+        case 0x15A: case 0x15B: return 's';
+        case 0x179: case 0x17A: case 0x17B: case 0x17C: return 'z';
+        }
+        if (cp >= 0xC0 && cp <= 0xFF) { //Latin-1 (np. nazwy z umlautami)
+            static const char latin1[] = "aaaaaaaceeeeiiii" "dnooooo ouuuuy s" "aaaaaaaceeeeiiii" "dnooooo ouuuuy y";
+            char c = latin1[cp - 0xC0];
+            return c == ' ' ? 0 : c;
+        }
+        return 0;
+    }
+
+    bool isWordChar(char c) {
+        return (unsigned char)c >= 0x80 || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9');
+    }
+
+    uint32_t packTrigram(const char* p) {
+        return (uint32_t)(unsigned char)p[0] << 16 | (uint32_t)(unsigned char)p[1] << 8 | (unsigned char)p[2];
+    }
+
+    /// Słowa zapytania po foldSearchText (separatory: spacja, przecinek, tabulator).
+    std::vector<std::string> splitQuery(const std::string& query) {
+        std::vector<std::string> tokens;
+        std::string folded = foldSearchText(query), token;
+        for (char c : folded) {
+            if (c == ' ' || c == ',' || c == '\t' || c == '\n') {
+                if (!token.empty()) tokens.push_back(token);
+                token.clear();
+            }
+            else token += c;
+        }
+        if (!token.empty()) tokens.push_back(token);
+        return tokens;
+    }
+
+    /// Ranga dopasowania pierwszego słowa: 0 = początek tekstu, 1 = początek słowa, 2 = fragment, -1 = brak.
+    int matchRank(const char* entry, const std::string& token) {
+        const char* hit = std::strstr(entry, token.c_str());
+        if (!hit) return -1;
+        if (hit == entry) return 0;
+        for (; hit; hit = std::strstr(hit + 1, token.c_str()))
+            if (!isWordChar(hit[-1])) return 1;
+        return 2;
+    }
+}
+
+std::string foldSearchText(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = (unsigned char)text[i];
+        if (c < 0x80) {
+            out += (char)(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+            continue;
+        }
+        if ((c & 0xE0) == 0xC0 && i + 1 < text.size()) { //znak dwubajtowy UTF-8
+            unsigned cp = (c & 0x1F) << 6 | ((unsigned char)text[i + 1] & 0x3F);
+            char folded = foldCodePoint(cp);
+            if (folded) {
+                out += folded;
+                ++i;
+                continue;
+            }
+        }
+        out += (char)c; //pozostale znaki bez zmian
+    }
+    return out;
+}
+
+bool stationMatches(const Station& station, const std::string& query) {
+    std::string entry = foldSearchText(station.name) + '\n' + foldSearchText(station.province);
+    for (const auto& token : splitQuery(query))
+        if (entry.find(token) == std::string::npos) return false;
+    return true;
+}
+
+void StationIndex::build(const std::vector<Station>& stations) {
+    text.clear();
+    offsets.clear();
+    std::vector<uint64_t> pairs; //(trigram << 32) | pozycja stacji
+    std::vector<uint32_t> own;
+    for (size_t i = 0; i < stations.size(); ++i) {
+        offsets.push_back((uint32_t)text.size());
+        std::string entry = foldSearchText(stations[i].name) + '\n' + foldSearchText(stations[i].province);
+        own.clear();
+        for (size_t j = 0; j + 3 <= entry.size(); ++j)
+            if (entry[j] != '\n' && entry[j + 1] != '\n' && entry[j + 2] != '\n') own.push_back(packTrigram(&entry[j]));
+        std::sort(own.begin(), own.end());
+        own.erase(std::unique(own.begin(), own.end()), own.end()); //stacja raz na liscie trigramu
+        for (uint32_t t : own) pairs.push_back((uint64_t)t << 32 | i);
+        text += entry;
+        text += '\0';
+    }
+    offsets.push_back((uint32_t)text.size());
+
+    std::sort(pairs.begin(), pairs.end()); //grupy trigramow, stacje rosnaco
+    trigrams.clear();
+    postingStart.clear();
+    postings.clear();
+    postings.reserve(pairs.size());
+    for (uint64_t p : pairs) {
+        uint32_t t = (uint32_t)(p >> 32);
+        if (trigrams.empty() || trigrams.back() != t) {
+            trigrams.push_back(t);
+            postingStart.push_back((uint32_t)postings.size());
+        }
+        postings.push_back((uint32_t)p);
+    }
+    postingStart.push_back((uint32_t)postings.size());
+    trigrams.shrink_to_fit();
+    postingStart.shrink_to_fit();
+}
+
+std::vector<size_t> StationIndex::search(const std::string& query, size_t limit) const {
+    std::vector<size_t> result;
+    std::vector<std::string> tokens = splitQuery(query);
+    if (tokens.empty()) {
+        for (size_t i = 0; i < size() && i < limit; ++i) result.push_back(i);
+        return result;
+    }
+
+    const uint32_t* first = nullptr; //najkrotsza lista trigramow (nullptr = wszystkie stacje)
+    const uint32_t* last = nullptr;
+    for (const auto& token : tokens) {
+        for (size_t j = 0; j + 3 <= token.size(); ++j) {
+            auto it = std::lower_bound(trigrams.begin(), trigrams.end(), packTrigram(&token[j]));
+            if (it == trigrams.end() || *it != packTrigram(&token[j])) return result; //trigram nie wystepuje nigdzie
+            size_t k = it - trigrams.begin();
+            if (!first || postingStart[k + 1] - postingStart[k] < (size_t)(last - first)) {
+                first = postings.data() + postingStart[k];
+                last = postings.data() + postingStart[k + 1];
+            }
+        }
+    }
+
+    std::vector<size_t> ranked[3];
+    auto consider = [&](size_t i) {
+        const char* e = entry(i);
+        int rank = matchRank(e, tokens[0]);
+        if (rank < 0) return;
+        for (size_t t = 1; t < tokens.size(); ++t)
+            if (!std::strstr(e, tokens[t].c_str())) return;
+        ranked[rank].push_back(i);
+    };
+    if (first) for (const uint32_t* p = first; p != last; ++p) consider(*p);
+    else for (size_t i = 0; i < size(); ++i) consider(i);     //same krotkie slowa - przeglad tekstow
+
+    for (const auto& group : ranked)
+        for (size_t i : group) {
+            if (result.size() >= limit) return result;
+            result.push_back(i);
+        }
+    return result;
+}
+
+size_t StationIndex::memoryBytes() const {
+    return text.capacity() + (offsets.capacity() + trigrams.capacity() + postingStart.capacity() + postings.capacity()) * sizeof(uint32_t);
+}
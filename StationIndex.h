@@ -0,0 +1,44 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "ApiClient.h"  //Station
+
+/// Sprowadza tekst UTF-8 do postaci wyszukiwania: małe litery, polskie znaki bez ogonków ("Łódź" -> "lodz").
+std::string foldSearchText(const std::string& text);
+
+/// Czy stacja pasuje do zapytania (każde słowo zapytania jest fragmentem nazwy lub województwa).
+/// Pełny przegląd bez indeksu - do pojedynczych stacji i sprawdzania wyników indeksu.
+bool stationMatches(const Station& station, const std::string& query);
+
+/// Indeks wyszukiwania stacji po nazwie i województwie (bez wielkości liter i polskich znaków).
+/// Budowany raz po wczytaniu listy: trójki znaków (trigramy) -> stacje, w których występują.
+/// Zapytanie wybiera kandydatów z najkrótszej listy trigramów i sprawdza je w tekście stacji.
+class StationIndex {
+public:
+    /// Buduje indeks listy stacji (pozycje w wyniku wyszukiwania odnoszą się do tej listy).
+    void build(const std::vector<Station>& stations);
+
+    /// Wyszukuje stacje pasujące do zapytania (słowa oddzielone spacjami, wszystkie muszą wystąpić).
+    /// Kolejność: początek nazwy, początek słowa (nazwy lub województwa), dowolny fragment; w grupie - kolejność listy.
+    /// Puste zapytanie zwraca wszystkie stacje.
+    /// \return Pozycje stacji na liście przekazanej do build.
+    std::vector<size_t> search(const std::string& query, size_t limit = (std::numeric_limits<size_t>::max)()) const;
+
+    /// Liczba stacji w indeksie.
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+    /// Przybliżony rozmiar indeksu w bajtach.
+    size_t memoryBytes() const;
+
+private:
+    const char* entry(size_t i) const { return text.data() + offsets[i]; }
+
+    std::string text;                   ///< Teksty stacji "nazwa\nwojewodztwo" po foldSearchText, zakończone '\0'
+    std::vector<uint32_t> offsets;      ///< Początek tekstu stacji (ostatni element = koniec)
+    std::vector<uint32_t> trigrams;     ///< Posortowane trigramy (3 bajty w liczbie)
+    std::vector<uint32_t> postingStart; ///< Początek listy stacji trigramu w postings (ostatni element = koniec)
+    std::vector<uint32_t> postings;     ///< Pozycje stacji (rosnąco w obrębie trigramu)
+};
@@ -0,0 +1,273 @@
+﻿#include "Statistics.h"
+#include "TimeUtils.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define AQ_HAVE_X86 1
+#include <immintrin.h>  //AVX2
+#if defined(_MSC_VER)
+#include <intrin.h>     //__cpuid, _xgetbv
+#define AQ_TARGET_AVX2                                      //MSVC pozwala na intrinsics AVX2 bez /arch
+#else
+#define AQ_TARGET_AVX2 __attribute__((target("avx2")))     //tylko ta funkcja kompilowana pod AVX2
+#endif
+#endif
+
+namespace {
+    std::atomic<bool> scalarOnly(false);    //wymuszenie wersji skalarnej
+
+    /// Wynik pierwszego przebiegu.
+    struct PassOne {
+        double sum = 0.0;       //suma wartosci
+        double min = 0.0;       //minimum
+        double max = 0.0;       //maksimum
+        double sumDx = 0.0;     //suma czasow wzgledem pierwszego pomiaru [s]
+    };
+
+    /// Wynik drugiego przebiegu.
+    struct PassTwo {
+        double sumSqDev = 0.0;  //suma (v - srednia)^2
+        double sumDxDv = 0.0;   //suma (x - sr. x)(v - srednia)
+        double sumSqDx = 0.0;   //suma (x - sr. x)^2
+    };
+
+    void passOneScalar(const double* v, const int64_t* ts, size_t begin, size_t n, int64_t t0, PassOne& r) {
+        for (size_t i = begin; i < n; ++i) {
+            r.sum += v[i];
+            if (v[i] < r.min) r.min = v[i];
+            if (v[i] > r.max) r.max = v[i];
+            r.sumDx += (double)(ts[i] - t0);
+        }
+    }
+
+    void passTwoScalar(const double* v, const int64_t* ts, size_t begin, size_t n, int64_t t0, double mean, double meanDx,
+        const std::vector<double>& limits, PassTwo& r, std::vector<size_t>& exceed) {
+        for (size_t i = begin; i < n; ++i) {
+            double dv = v[i] - mean;
+            double dx = (double)(ts[i] - t0) - meanDx;
+            r.sumSqDev += dv * dv;
+            r.sumDxDv += dx * dv;
+            r.sumSqDx += dx * dx;
+            for (size_t k = 0; k < limits.size(); ++k)
+                if (v[i] > limits[k]) ++exceed[k];
+        }
+    }
+
+#ifdef AQ_HAVE_X86
+    /// Sprawdza, czy procesor i system obsługują AVX2.
+    bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;  //system zapisuje rejestry YMM
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx) return false;
+        if ((_xgetbv(0) & 6) != 6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;           //bit AVX2
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    /// Zamienia 4 liczby int64 z zakresu +-2^51 na double (AVX2 nie ma takiej instrukcji).
+    AQ_TARGET_AVX2 inline __m256d int64ToDouble(__m256i x) {
+        const __m256i magicI = _mm256_set1_epi64x(0x4338000000000000LL);   //bity liczby 1.5 * 2^52
+        const __m256d magicD = _mm256_set1_pd(6755399441055744.0);          //1.5 * 2^52
+        return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(x, magicI)), magicD);
+    }
+
+    /// Suma czterech elementów rejestru.
+    AQ_TARGET_AVX2 inline double horizontalSum(__m256d x) {
+        __m128d lo = _mm256_castpd256_pd128(x);
+        __m128d hi = _mm256_extractf128_pd(x, 1);
+        lo = _mm_add_pd(lo, hi);
+        return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+    }
+
+    AQ_TARGET_AVX2 void passOneAvx2(const double* v, const int64_t* ts, size_t n, int64_t t0, PassOne& r) {
+        const __m256i base = _mm256_set1_epi64x(t0);
+        __m256d sum = _mm256_setzero_pd(), sumDx = _mm256_setzero_pd();
+        __m256d mn = _mm256_set1_pd(r.min), mx = _mm256_set1_pd(r.max);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) { //4 pomiary na iteracje
+            __m256d x = _mm256_loadu_pd(v + i);
+            sum = _mm256_add_pd(sum, x);
+            mn = _mm256_min_pd(mn, x);
+            mx = _mm256_max_pd(mx, x);
+            __m256i t = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ts + i)), base);
+            sumDx = _mm256_add_pd(sumDx, int64ToDouble(t));
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, mn);
+        r.min = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+        _mm256_storeu_pd(lanes, mx);
+        r.max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+        r.sum = horizontalSum(sum);
+        r.sumDx = horizontalSum(sumDx);
+        passOneScalar(v, ts, i, n, t0, r); //koncowka
+    }
+
+    AQ_TARGET_AVX2 void passTwoAvx2(const double* v, const int64_t* ts, size_t n, int64_t t0, double mean, double meanDx,
+        const std::vector<double>& limits, PassTwo& r, std::vector<size_t>& exceed) {
+        static const int bitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 }; //liczba bitow maski
+        const __m256i base = _mm256_set1_epi64x(t0);
+        const __m256d meanV = _mm256_set1_pd(mean), meanDxV = _mm256_set1_pd(meanDx);
+        __m256d sqDev = _mm256_setzero_pd(), dxDv = _mm256_setzero_pd(), sqDx = _mm256_setzero_pd();
+
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d x = _mm256_loadu_pd(v + i);
+            __m256d dv = _mm256_sub_pd(x, meanV);
+            __m256i t = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ts + i)), base);
+            __m256d dx = _mm256_sub_pd(int64ToDouble(t), meanDxV);
+            sqDev = _mm256_add_pd(sqDev, _mm256_mul_pd(dv, dv));
+            dxDv = _mm256_add_pd(dxDv, _mm256_mul_pd(dx, dv));
+            sqDx = _mm256_add_pd(sqDx, _mm256_mul_pd(dx, dx));
+            for (size_t k = 0; k < limits.size(); ++k) //przekroczenia: porownanie 4 wartosci naraz
+                exceed[k] += bitCount[_mm256_movemask_pd(_mm256_cmp_pd(x, _mm256_broadcast_sd(&limits[k]), _CMP_GT_OQ))];
+        }
+        r.sumSqDev = horizontalSum(sqDev);
+        r.sumDxDv = horizontalSum(dxDv);
+        r.sumSqDx = horizontalSum(sqDx);
+        passTwoScalar(v, ts, i, n, t0, mean, meanDx, limits, r, exceed); //koncowka
+    }
+
+    const bool avx2Available = cpuHasAvx2(); //sprawdzane raz przy starcie programu
+#else
+    const bool avx2Available = false;
+#endif
+
+    /// Pierwszy przebieg w wersji AVX2 lub skalarnej.
+    void runPassOne(const double* v, const int64_t* ts, size_t n, int64_t t0, PassOne& r) {
+#ifdef AQ_HAVE_X86
+        if (statisticsUseAvx2()) { passOneAvx2(v, ts, n, t0, r); return; }
+#endif
+        passOneScalar(v, ts, 0, n, t0, r);
+    }
+
+    /// Drugi przebieg w wersji AVX2 lub skalarnej.
+    void runPassTwo(const double* v, const int64_t* ts, size_t n, int64_t t0, double mean, double meanDx,
+        const std::vector<double>& limits, PassTwo& r, std::vector<size_t>& exceed) {
+#ifdef AQ_HAVE_X86
+        if (statisticsUseAvx2()) { passTwoAvx2(v, ts, n, t0, mean, meanDx, limits, r, exceed); return; }
+#endif
+        passTwoScalar(v, ts, 0, n, t0, mean, meanDx, limits, r, exceed);
+    }
+
+    /// Percentyle (interpolacja liniowa między sąsiednimi pozycjami) dla rosnących q.
+    /// Każdy kolejny nth_element działa tylko na części tablicy powyżej poprzedniego wyniku.
+    void percentiles(std::vector<double>& v, const double* q, double* out, size_t count) {
+        size_t lo = 0;
+        for (size_t j = 0; j < count; ++j) {
+            double pos = q[j] * (v.size() - 1);
+            size_t k = (size_t)pos;
+            double frac = pos - k;
+            std::nth_element(v.begin() + lo, v.begin() + k, v.end());
+            double a = v[k];
+            double b = (frac > 0 && k + 1 < v.size()) ? *std::min_element(v.begin() + k + 1, v.end()) : a; //nastepna wartosc
+            out[j] = a + frac * (b - a);
+            lo = k;
+        }
+    }
+}
+
+bool statisticsUseAvx2() {
+    return avx2Available && !scalarOnly;
+}
+
+void setStatisticsScalarOnly(bool value) {
+    scalarOnly = value;
+}
+
+std::vector<double> defaultLimits(const std::string& metric) {
+    //poziomy dopuszczalne / alarmowe [µg/m³]
+    if (metric == "PM10") return { 50.0, 200.0 };
+    if (metric == "PM2.5") return { 25.0 };
+    if (metric == "NO2") return { 200.0, 400.0 };
+    if (metric == "SO2") return { 125.0, 350.0, 500.0 };
+    if (metric == "O3") return { 120.0, 180.0, 240.0 };
+    if (metric == "CO") return { 10000.0 };
+    if (metric == "C6H6") return { 5.0 };
+    return {};
+}
+
+SeriesStatistics computeStatistics(const SeriesView& series, const std::vector<double>& limits) {
+    AQ_TRACE_SCOPE("analysis.statistics");
+    SeriesStatistics s;
+    s.limits = limits;
+    s.exceedances.assign(limits.size(), 0);
+    s.count = series.size();
+    if (s.count == 0) return s;
+
+    const double* v = series.values;
+    const int64_t* ts = series.timestamps;
+    const size_t n = series.size();
+    const int64_t t0 = ts[0]; //czas liczony od pierwszego pomiaru - male liczby, dokladne double
+    s.firstTimestamp = ts[0];
+    s.lastTimestamp = ts[n - 1];
+
+    //przebieg 1: suma, min, max, sredni czas
+    PassOne one;
+    one.min = one.max = v[0];
+    runPassOne(v, ts, n, t0, one);
+
+    s.mean = one.sum / n;
+    s.min = one.min;
+    s.max = one.max;
+    double meanDx = one.sumDx / n;
+
+    //przebieg 2: odchylenia od sredniej (stabilniejsze niz suma kwadratow) i przekroczenia
+    PassTwo two;
+    runPassTwo(v, ts, n, t0, s.mean, meanDx, limits, two, s.exceedances);
+
+    s.variance = two.sumSqDev / n;
+    s.stddev = std::sqrt(s.variance);
+    if (two.sumSqDx > 0) s.trendPerHour = two.sumDxDv / two.sumSqDx * 3600.0; //nachylenie na sekunde -> na godzine
+
+    //daty minimum i maksimum - pierwsze wystapienie
+    size_t minIdx = std::find(v, v + n, s.min) - v;
+    size_t maxIdx = std::find(v, v + n, s.max) - v;
+    s.minTimestamp = ts[minIdx];
+    s.maxTimestamp = ts[maxIdx];
+
+    std::vector<double> copy(v, v + n); //nth_element zmienia kolejnosc - pracujemy na kopii
+    const double q[3] = { 0.50, 0.95, 0.98 };
+    double p[3];
+    percentiles(copy, q, p, 3);
+    s.p50 = p[0];
+    s.p95 = p[1];
+    s.p98 = p[2];
+    return s;
+}
+
+std::string formatStatisticsReport(const std::string& metric, const SeriesStatistics& s, const std::string& nl) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2);
+    oss << "Analiza - " << metric << nl
+        << "Zakres: " << formatTimestamp(s.firstTimestamp) << " - " << formatTimestamp(s.lastTimestamp) << nl
+        << "Liczba pomiarów: " << s.count << nl
+        << "Średnia: " << s.mean << " µg/m^3" << nl
+        << "Min: " << s.min << " (" << formatTimestamp(s.minTimestamp) << ")" << nl
+        << "Max: " << s.max << " (" << formatTimestamp(s.maxTimestamp) << ")" << nl
+        << "Odchylenie std.: " << s.stddev << nl
+        << "Mediana / P95 / P98: " << s.p50 << " / " << s.p95 << " / " << s.p98 << nl;
+    for (size_t k = 0; k < s.limits.size(); ++k) //przekroczenia progow
+        oss << "Przekroczenia > " << s.limits[k] << ": " << s.exceedances[k] << nl;
+
+    //tendencja na podstawie nachylenia prostej najmniejszych kwadratow (a nie tylko pierwszego i ostatniego pomiaru)
+    const double epsilon = 1e-9;
+    if (s.trendPerHour > epsilon) oss << "Tendencja: wzrostowa ";
+    else if (s.trendPerHour < -epsilon) oss << "Tendencja: malejąca ";
+    else oss << "Tendencja: brak zmian ";
+    oss << "(" << std::showpos << s.trendPerHour * 24 << std::noshowpos << " µg/m^3 na dobę)" << nl;
+    return oss.str();
+}
@@ -0,0 +1,46 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MeasurementSeries.h"  //SeriesView
+
+/// Wynik analizy jednej serii pomiarów.
+struct SeriesStatistics {
+    size_t count = 0;               ///< Liczba pomiarów
+    int64_t firstTimestamp = 0;     ///< Czas pierwszego pomiaru
+    int64_t lastTimestamp = 0;      ///< Czas ostatniego pomiaru
+    double mean = 0.0;              ///< Średnia
+    double min = 0.0;               ///< Minimum
+    double max = 0.0;               ///< Maksimum
+    int64_t minTimestamp = 0;       ///< Czas pierwszego wystąpienia minimum
+    int64_t maxTimestamp = 0;       ///< Czas pierwszego wystąpienia maksimum
+    double variance = 0.0;          ///< Wariancja (populacyjna)
+    double stddev = 0.0;            ///< Odchylenie standardowe
+    double p50 = 0.0;               ///< Mediana
+    double p95 = 0.0;               ///< Percentyl 95
+    double p98 = 0.0;               ///< Percentyl 98
+    std::vector<double> limits;     ///< Progi, dla których liczono przekroczenia
+    std::vector<size_t> exceedances;///< Liczba pomiarów powyżej każdego progu (ten sam indeks co limits)
+    double trendPerHour = 0.0;      ///< Nachylenie prostej najmniejszych kwadratów [jednostka / godzinę]
+};
+
+/// Zwraca domyślne progi dla miernika (normy jakości powietrza w µg/m³, np. PM10 -> 50).
+/// Dla nieznanego miernika zwraca pustą listę.
+std::vector<double> defaultLimits(const std::string& metric);
+
+/// Liczy statystyki serii w dwóch przebiegach po ciągłych tablicach:
+/// 1) suma, minimum, maksimum, średni czas; 2) wariancja, kowariancja czasu i wartości, przekroczenia progów.
+/// Przebiegi używają AVX2, jeśli procesor je obsługuje (w przeciwnym razie wersja skalarna).
+/// Percentyle liczone są przez częściowe sortowanie kopii wartości (nth_element).
+SeriesStatistics computeStatistics(const SeriesView& series, const std::vector<double>& limits);
+
+/// Buduje tekstowy raport statystyk (panel analizy w GUI, narzędzie konsolowe).
+/// \param newline Znak końca linii ("\r\n" dla pola tekstowego WinAPI, "\n" dla konsoli).
+std::string formatStatisticsReport(const std::string& metric, const SeriesStatistics& stats, const std::string& newline);
+
+/// Czy statystyki są liczone z użyciem AVX2 na tym procesorze.
+bool statisticsUseAvx2();
+
+/// Wymusza wersję skalarną (np. do porównania wyników) - false przywraca automatyczny wybór.
+void setStatisticsScalarOnly(bool scalarOnly);
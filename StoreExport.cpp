@@ -0,0 +1,312 @@
+﻿#include "StoreExport.h"
+#include <nlohmann/json.hpp>     // Biblioteka do obsługi JSON (tylko nietypowe wpisy)
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "BinaryCache.h"    //BinaryCacheWriter
+#include "StationIndex.h"   //foldSearchText
+#include "TimeUtils.h"
+#include "Trace.h"
+
+using json = nlohmann::json;
+
+namespace {
+    const size_t readBufferSize = 1 << 20;      //bufor odczytu segmentu
+    const size_t writeBufferSize = 1 << 20;     //bufor zapisu CSV
+
+    /// Bufor zapisu o stałym rozmiarze (jeden zapis do pliku na bufor).
+    class OutputBuffer {
+    public:
+        explicit OutputBuffer(std::ofstream& file) : file(file), buffer(writeBufferSize) {}
+        ~OutputBuffer() { flush(); }
+
+        /// Miejsce na co najwyżej size bajtów (size <= writeBufferSize).
+        char* reserve(size_t size) {
+            if (used + size > buffer.size()) flush();
+            return buffer.data() + used;
+        }
+        void commit(size_t size) { used += size; }
+
+        void write(const char* data, size_t size) {
+            std::memcpy(reserve(size), data, size);
+            commit(size);
+        }
+
+        void flush() {
+            file.write(buffer.data(), (std::streamsize)used);
+            written += used;
+            used = 0;
+        }
+
+        uint64_t bytesWritten() const { return written + used; }
+
+    private:
+        std::ofstream& file;
+        std::vector<char> buffer;
+        size_t used = 0;
+        uint64_t written = 0;
+    };
+
+    /// Wartość tekstowa pola key (np. "\"name\"") we wpisie zakończonym zerem.
+    /// \return false, gdy brak pola lub napis zawiera znaki ucieczki (wtedy wpis czyta pełny parser).
+    bool findText(const char* line, const char* key, const char*& text, size_t& length) {
+        const char* p = std::strstr(line, key);
+        if (!p) return false;
+        p += std::strlen(key);
+        while (*p == ' ') ++p;
+        if (*p++ != ':') return false;
+        while (*p == ' ') ++p;
+        if (*p++ != '"') return false;
+        text = p;
+        for (; *p != '"'; ++p)
+            if (*p == '\0' || *p == '\\') return false;
+        length = (size_t)(p - text);
+        return true;
+    }
+
+    /// Wartość liczbowa pola key we wpisie zakończonym zerem.
+    bool findNumber(const char* line, const char* key, double& value) {
+        const char* p = std::strstr(line, key);
+        if (!p) return false;
+        p += std::strlen(key);
+        while (*p == ' ') ++p;
+        if (*p++ != ':') return false;
+        char* end = nullptr;
+        value = std::strtod(p, &end);
+        return end != p;
+    }
+
+    /// Zapisuje liczbę dokładnie (odczyt daje tę samą wartość double) bez alokacji.
+    /// Wartości z co najwyżej 3 miejscami po przecinku (dane GIOŚ) są składane ręcznie, pozostałe przez %.17g.
+    size_t formatValue(double value, char* out) {
+        static const double powers[] = { 1.0, 10.0, 100.0, 1000.0 };
+        for (int decimals = 0; decimals < 4; ++decimals) {
+            double scaled = std::round(value * powers[decimals]);
+            if (std::fabs(scaled) >= 1e15 || scaled / powers[decimals] != value) continue;
+            char digits[24];
+            int64_t n = (int64_t)std::fabs(scaled);
+            int count = 0;
+            do { digits[count++] = (char)('0' + n % 10); n /= 10; } while (n > 0 || count <= decimals);
+            size_t length = 0;
+            if (scaled < 0) out[length++] = '-';
+            while (count > 0) {
+                if (count == decimals) out[length++] = '.';
+                out[length++] = digits[--count];
+            }
+            return length;
+        }
+        return (size_t)std::snprintf(out, 32, "%.17g", value);
+    }
+
+    /// Nazwa miernika jako pole CSV (w cudzysłowie, gdy zawiera przecinek lub cudzysłów).
+    std::string csvField(const std::string& text) {
+        if (text.find_first_of(",\"\n") == std::string::npos) return text;
+        std::string out = "\"";
+        for (char c : text) {
+            if (c == '"') out += '"';
+            out += c;
+        }
+        return out + "\"";
+    }
+}
+
+std::vector<int> selectExportStations(const std::vector<std::string>& storeIds, const std::vector<Station>& stations, const ExportFilter& filter) {
+    std::string province = foldSearchText(filter.province);
+    std::vector<int> result;
+    for (const auto& id : storeIds) {
+        char* end = nullptr;
+        long stationId = std::strtol(id.c_str(), &end, 10);
+        if (id.empty() || *end != '\0') continue; //plik spoza bazy stacji
+        if (!filter.stationIds.empty() && std::find(filter.stationIds.begin(), filter.stationIds.end(), (int)stationId) == filter.stationIds.end()) continue;
+        if (!province.empty()) {
+            auto it = std::find_if(stations.begin(), stations.end(), [&](const Station& s) { return s.id == (int)stationId; });
+            if (it == stations.end() || foldSearchText(it->province) != province) continue;
+        }
+        result.push_back((int)stationId);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+StoreExporter::StoreExporter(const MeasurementStore& store, const ExportFilter& filter)
+    : store(store), filter(filter), readBuffer(readBufferSize + 1) {
+}
+
+int StoreExporter::metricSlot(const char* name, size_t length) {
+    for (size_t i = 0; i < metricNames.size(); ++i) //kilka miernikow - przeglad szybszy niz mapa
+        if (metricNames[i].size() == length && std::memcmp(metricNames[i].data(), name, length) == 0)
+            return metricAllowed[i] ? (int)i : -1;
+    metricNames.emplace_back(name, length); //jedna alokacja na nowy miernik
+    bool allowed = filter.metrics.empty() || std::find(filter.metrics.begin(), filter.metrics.end(), metricNames.back()) != filter.metrics.end();
+    metricAllowed.push_back(allowed);
+    return allowed ? (int)metricNames.size() - 1 : -1;
+}
+
+void StoreExporter::addRow(int slot, int64_t timestamp, double value) {
+    Row row;
+    row.timestamp = timestamp;
+    row.value = value;
+    row.sequence = (uint32_t)rows.size();
+    row.metric = (uint16_t)slot;
+    rows.push_back(row);
+}
+
+void StoreExporter::scanLine(char* line, size_t length) {
+    if (length > 0 && line[length - 1] == '\r') --length;
+    if (length == 0) return;
+    line[length] = '\0'; //bufor ma zapas na zero za ostatnim wpisem
+    counters.linesRead++;
+
+    const char* name;
+    const char* date;
+    size_t nameLength, dateLength;
+    double value;
+    if (findText(line, "\"name\"", name, nameLength) && findText(line, "\"date\"", date, dateLength)) {
+        int slot = metricSlot(name, nameLength); //filtr miernika i daty przed odczytem wartosci
+        int64_t ts;
+        if (slot < 0 || !parseTimestamp(date, dateLength, ts) || ts < filter.start || ts > filter.end) return;
+        if (findNumber(line, "\"value\"", value)) {
+            addRow(slot, ts, value);
+            return;
+        }
+    }
+
+    counters.slowLines++; //znaki ucieczki, inna postac liczby lub uszkodzony wpis
+    try {
+        json j = json::parse(line, line + length);
+        std::string metric = j.value("name", "Brak");
+        std::string text = j.value("date", "brak daty");
+        value = j.value("value", 0.0);
+        int slot = metricSlot(metric.data(), metric.size());
+        int64_t ts;
+        if (slot < 0 || !parseTimestamp(text, ts) || ts < filter.start || ts > filter.end) return;
+        addRow(slot, ts, value);
+    }
+    catch (...) { //jak MeasurementStore - uszkodzony wpis jest pomijany
+    }
+}
+
+bool StoreExporter::scanStation(int stationId) {
+    AQ_TRACE_SCOPE("export.scan");
+    rows.clear(); //pojemnosc zostaje z poprzedniej stacji
+    std::ifstream file(store.segmentPath(std::to_string(stationId)), std::ios::binary);
+    if (!file.is_open()) return false;
+    counters.stations++;
+
+    size_t carry = 0; //niedokonczony wpis z poprzedniego odczytu
+    while (true) {
+        size_t capacity = readBuffer.size() - 1;
+        file.read(readBuffer.data() + carry, (std::streamsize)(capacity - carry));
+        size_t got = (size_t)file.gcount();
+        counters.bytesRead += got;
+        size_t end = carry + got, pos = 0;
+        while (pos < end) {
+            char* newline = static_cast<char*>(std::memchr(readBuffer.data() + pos, '\n', end - pos));
+            if (!newline) break;
+            scanLine(readBuffer.data() + pos, (size_t)(newline - readBuffer.data()) - pos);
+            pos = (size_t)(newline - readBuffer.data()) + 1;
+        }
+        if (got == 0) { //koniec pliku - ostatni wpis bez znaku nowej linii
+            if (pos < end) scanLine(readBuffer.data() + pos, end - pos);
+            break;
+        }
+        carry = end - pos;
+        std::memmove(readBuffer.data(), readBuffer.data() + pos, carry);
+        if (carry == capacity) readBuffer.resize(readBuffer.size() * 2); //wpis dluzszy niz bufor
+    }
+
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+        if (a.metric != b.metric) return a.metric < b.metric;
+        if (a.timestamp != b.timestamp) return a.timestamp < b.timestamp;
+        return a.sequence < b.sequence;
+    });
+    size_t kept = 0;
+    for (size_t i = 0; i < rows.size(); ++i) { //z powtorzonej pary (miernik, data) zostaje ostatni wpis
+        if (i + 1 < rows.size() && rows[i + 1].metric == rows[i].metric && rows[i + 1].timestamp == rows[i].timestamp) continue;
+        rows[kept++] = rows[i];
+    }
+    rows.resize(kept);
+    return true;
+}
+
+bool StoreExporter::writeCsv(const std::vector<int>& stationIds, const std::string& filename) {
+    AQ_TRACE_SCOPE("export.csv");
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Nie można utworzyć pliku " << filename << "\n";
+        return false;
+    }
+    std::vector<std::string> names; //nazwy miernikow gotowe do wpisania (pozycja = pozycja w metricNames)
+    {
+        OutputBuffer out(file);
+        const char header[] = "station_id,metric,date,value\n";
+        out.write(header, sizeof(header) - 1);
+        for (int id : stationIds) {
+            if (!scanStation(id)) continue;
+            while (names.size() < metricNames.size()) names.push_back(csvField(metricNames[names.size()]) + ',');
+            char prefix[16];
+            size_t prefixLength = (size_t)std::snprintf(prefix, sizeof(prefix), "%d,", id);
+            for (const auto& row : rows) {
+                const std::string& name = names[row.metric];
+                char* p = out.reserve(prefixLength + name.size() + 20 + 1 + 32 + 1);
+                std::memcpy(p, prefix, prefixLength);
+                size_t length = prefixLength;
+                std::memcpy(p + length, name.data(), name.size());
+                length += name.size();
+                formatTimestamp(row.timestamp, p + length);
+                length += 19;
+                p[length++] = ',';
+                length += formatValue(row.value, p + length);
+                p[length++] = '\n';
+                out.commit(length);
+            }
+            counters.rowsWritten += rows.size();
+        }
+        out.flush();
+        counters.bytesWritten += out.bytesWritten();
+    }
+    if (!file) {
+        std::cerr << "Błąd zapisu pliku " << filename << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool StoreExporter::writeColumnar(const std::vector<int>& stationIds, const std::string& filename) {
+    AQ_TRACE_SCOPE("export.columnar");
+    BinaryCacheWriter writer;
+    if (!writer.open(filename)) {
+        std::cerr << "Nie można utworzyć pliku " << filename << "\n";
+        return false;
+    }
+    std::vector<int64_t> timestamps; //kolumny stacji (pojemnosc uzywana ponownie)
+    std::vector<double> values;
+    std::vector<uint8_t> metrics;
+    for (int id : stationIds) {
+        if (!scanStation(id)) continue;
+        if (metricNames.size() > 256) {
+            std::cerr << "Zbyt wiele mierników dla pliku kolumnowego.\n";
+            return false;
+        }
+        timestamps.resize(rows.size());
+        values.resize(rows.size());
+        metrics.resize(rows.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            timestamps[i] = rows[i].timestamp;
+            values[i] = rows[i].value;
+            metrics[i] = (uint8_t)rows[i].metric;
+        }
+        if (!writer.addStation(id, timestamps.data(), values.data(), metrics.data(), rows.size())) return false;
+        counters.rowsWritten += rows.size();
+    }
+    if (!writer.finish(metricNames)) {
+        std::cerr << "Błąd zapisu pliku " << filename << "\n";
+        return false;
+    }
+    counters.bytesWritten += writer.bytesWritten();
+    return true;
+}
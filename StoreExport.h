@@ -0,0 +1,74 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "ApiClient.h"          //Station
+#include "MeasurementStore.h"
+
+/// Filtr eksportu (puste pole = bez ograniczenia).
+struct ExportFilter {
+    std::vector<int> stationIds;                                ///< Wybrane stacje
+    std::string province;                                       ///< Województwo (bez polskich znaków i wielkości liter)
+    std::vector<std::string> metrics;                           ///< Nazwy mierników (np. "PM10")
+    int64_t start = (std::numeric_limits<int64_t>::min)();      ///< Zakres dat [start, end] (sekundy, TimeUtils.h)
+    int64_t end = (std::numeric_limits<int64_t>::max)();
+};
+
+/// Liczniki eksportu.
+struct ExportStats {
+    size_t stations = 0;        ///< Przeczytane segmenty stacji
+    size_t linesRead = 0;       ///< Wpisy w segmentach (z nieaktualnymi)
+    size_t rowsWritten = 0;     ///< Zapisane pomiary (po filtrze i usunięciu nieaktualnych wpisów)
+    size_t slowLines = 0;       ///< Wpisy odczytane pełnym parserem JSON (np. znaki ucieczki w nazwie)
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+};
+
+/// Stacje bazy (storeIds) spełniające filtr stacji i województwa - wybierane przed otwarciem plików.
+/// Województwo jest brane z listy stations; stacja spoza listy nie przechodzi filtra województwa.
+/// \return Id stacji rosnąco.
+std::vector<int> selectExportStations(const std::vector<std::string>& storeIds, const std::vector<Station>& stations, const ExportFilter& filter);
+
+/// Strumieniowy eksport lokalnej bazy do CSV lub pliku kolumnowego.
+/// Segmenty są czytane stałym buforem, filtr miernika i daty jest sprawdzany na surowym tekście wpisu
+/// przed odczytem wartości, a wynik trafia do stałego bufora zapisu. Pamięć zależy od największej
+/// stacji, nie od rozmiaru bazy; bufory są używane ponownie, więc wiersz nie alokuje pamięci.
+/// Wiersze stacji są uporządkowane po mierniku i czasie, dla powtórzonej pary (miernik, data)
+/// zostaje ostatni wpis (jak w MeasurementStore::load).
+class StoreExporter {
+public:
+    StoreExporter(const MeasurementStore& store, const ExportFilter& filter);
+
+    /// Zapisuje CSV "station_id,metric,date,value" (kropka dziesiętna, daty jak w API).
+    bool writeCsv(const std::vector<int>& stationIds, const std::string& filename);
+
+    /// Zapisuje plik w formacie BinaryCache (kolumny stacji, słownik mierników i indeks na końcu),
+    /// który można otworzyć przez BinaryCache::open.
+    bool writeColumnar(const std::vector<int>& stationIds, const std::string& filename);
+
+    const ExportStats& stats() const { return counters; }
+
+private:
+    /// Pomiar stacji po odczycie wpisu.
+    struct Row {
+        int64_t timestamp;
+        double value;
+        uint32_t sequence;  //kolejnosc w segmencie (ostatni wpis wygrywa)
+        uint16_t metric;    //pozycja w metricNames
+    };
+
+    bool scanStation(int stationId);                            //wypelnia rows pomiarami stacji
+    void scanLine(char* line, size_t length);
+    int metricSlot(const char* name, size_t length);            //-1 = miernik odrzucony przez filtr
+    void addRow(int slot, int64_t timestamp, double value);
+
+    const MeasurementStore& store;
+    ExportFilter filter;
+    std::vector<char> readBuffer;               ///< Bufor odczytu segmentu
+    std::vector<Row> rows;                      ///< Pomiary bieżącej stacji
+    std::vector<std::string> metricNames;       ///< Mierniki spotkane w bazie
+    std::vector<char> metricAllowed;            ///< Czy miernik przechodzi filtr
+    ExportStats counters;
+};
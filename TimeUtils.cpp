@@ -0,0 +1,94 @@
+﻿#include "TimeUtils.h"
+
+namespace {
+    /// Liczba dni od 1970-01-01 dla daty kalendarza gregoriańskiego.
+    int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+        y -= m <= 2;
+        const int64_t era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned yoe = (unsigned)(y - era * 400);                         //rok w erze [0, 399]
+        const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;    //dzien w roku [0, 365]
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;             //dzien w erze [0, 146096]
+        return era * 146097 + (int64_t)doe - 719468;
+    }
+
+    /// Odwrotność daysFromCivil.
+    void civilFromDays(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+        z += 719468;
+        const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        const unsigned doe = (unsigned)(z - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        y = (int64_t)yoe + era * 400;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        d = doy - (153 * mp + 2) / 5 + 1;
+        m = mp + (mp < 10 ? 3 : -9);
+        y += m <= 2;
+    }
+
+    /// Liczba dni miesiąca (luty w latach przestępnych kalendarza gregoriańskiego ma 29).
+    int daysInMonth(int year, int month) {
+        static const int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        return month == 2 && leap ? 29 : days[month - 1];
+    }
+
+    /// Czyta liczbę o stałej liczbie cyfr.
+    bool readDigits(const char* p, int count, int& out) {
+        out = 0;
+        for (int i = 0; i < count; ++i) {
+            if (p[i] < '0' || p[i] > '9') return false;
+            out = out * 10 + (p[i] - '0');
+        }
+        return true;
+    }
+
+    /// Zapisuje liczbę z wiodącymi zerami.
+    void writeDigits(char* p, int count, int64_t value) {
+        for (int i = count - 1; i >= 0; --i) {
+            p[i] = (char)('0' + value % 10);
+            value /= 10;
+        }
+    }
+}
+
+bool parseTimestamp(const char* text, size_t length, int64_t& seconds) {
+    if (length != 16 && length != 19) return false; //"YYYY-MM-DD HH:MM" lub "YYYY-MM-DD HH:MM:SS" - bez znakow za data
+    int year, month, day, hour, minute, second = 0;
+    if (!readDigits(text, 4, year) || text[4] != '-' || !readDigits(text + 5, 2, month) || text[7] != '-' ||
+        !readDigits(text + 8, 2, day) || (text[10] != ' ' && text[10] != 'T') ||
+        !readDigits(text + 11, 2, hour) || text[13] != ':' || !readDigits(text + 14, 2, minute))
+        return false;
+    if (length == 19 && (text[16] != ':' || !readDigits(text + 17, 2, second))) return false;
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month) || hour > 23 || minute > 59 || second > 59)
+        return false; //np. 2025-02-30 nie jest przenoszony na marzec
+
+    seconds = daysFromCivil(year, (unsigned)month, (unsigned)day) * 86400 + hour * 3600 + minute * 60 + second;
+    return true;
+}
+
+void formatTimestamp(int64_t seconds, char* buffer) {
+    int64_t days = seconds >= 0 ? seconds / 86400 : (seconds - 86399) / 86400; //zaokraglenie w dol
+    int64_t rest = seconds - days * 86400;
+    int64_t year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+
+    writeDigits(buffer, 4, year);
+    buffer[4] = '-';
+    writeDigits(buffer + 5, 2, month);
+    buffer[7] = '-';
+    writeDigits(buffer + 8, 2, day);
+    buffer[10] = ' ';
+    writeDigits(buffer + 11, 2, rest / 3600);
+    buffer[13] = ':';
+    writeDigits(buffer + 14, 2, rest / 60 % 60);
+    buffer[16] = ':';
+    writeDigits(buffer + 17, 2, rest % 60);
+    buffer[19] = '\0';
+}
+
+std::string formatTimestamp(int64_t seconds) {
+    char buffer[20];
+    formatTimestamp(seconds, buffer);
+    return std::string(buffer, 19);
+}
@@ -0,0 +1,21 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <cstdint>
+#include <string>
+
+/// Zamienia datę w formacie API GIOŚ ("YYYY-MM-DD HH:MM[:SS]") na liczbę sekund od 1970-01-01 00:00.
+/// Czas lokalny stacji jest traktowany jak UTC - liczy się kolejność i odstępy, nie strefa czasowa.
+/// \return false, jeśli tekst nie jest poprawną datą: inna długość lub znaki za datą, dzień spoza
+/// długości miesiąca (z latami przestępnymi), godzina, minuta lub sekunda poza zakresem.
+bool parseTimestamp(const char* text, size_t length, int64_t& seconds);
+
+/// Wersja parseTimestamp dla std::string.
+inline bool parseTimestamp(const std::string& text, int64_t& seconds) {
+    return parseTimestamp(text.data(), text.size(), seconds);
+}
+
+/// Zamienia liczbę sekund od 1970-01-01 na tekst "YYYY-MM-DD HH:MM:SS" (format API GIOŚ).
+std::string formatTimestamp(int64_t seconds);
+
+/// Zapisuje datę "YYYY-MM-DD HH:MM:SS" do bufora (co najmniej 20 znaków, z zerem na końcu) bez alokacji.
+void formatTimestamp(int64_t seconds, char* buffer);
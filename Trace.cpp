@@ -0,0 +1,223 @@
+﻿#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <thread>
+
+namespace {
+    const int kBuckets = 40;                    //przedzialy histogramu: [2^i, 2^(i+1)) mikrosekund
+    const size_t kMaxEvents = 1u << 20;         //limit zdarzen sladu (okolo 32 MB)
+
+    struct Stage {
+        size_t calls = 0;
+        long long totalUs = 0;
+        long long maxUs = 0;
+        size_t allocations = 0;
+        size_t histogram[kBuckets] = {};
+    };
+
+    struct Event {
+        const char* name;   //napis staly z makra AQ_TRACE_SCOPE
+        int thread;
+        long long startUs;
+        long long durationUs;
+    };
+
+    struct State {
+        std::mutex mutex;
+        std::map<std::string, Stage> stages;
+        std::map<std::string, long long> counters;
+        std::vector<Event> events;
+        std::map<std::thread::id, int> threads;     //kolejne numery watkow w sladzie
+        size_t droppedEvents = 0;
+    };
+
+    State& state() {
+        static State s; //tworzony przy pierwszym uzyciu (niezaleznie od kolejnosci inicjalizacji)
+        return s;
+    }
+
+#if defined(AQ_TRACE_ALLOCATIONS) && !defined(AQ_NO_TRACE)
+    const bool kCountAllocations = true;
+#else
+    const bool kCountAllocations = false;      //operator new nie jest podmieniany - liczba alokacji zawsze 0
+#endif
+
+    std::atomic<bool> tracing(false);
+    const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    thread_local size_t allocationCount = 0;
+
+    int bucketOf(long long us) {
+        int b = 0;
+        while (us > 1 && b < kBuckets - 1) { us >>= 1; ++b; }
+        return b;
+    }
+
+    double percentileMs(const Stage& s, double q) { //gorna granica przedzialu, w ktorym wypada kwantyl
+        size_t target = (size_t)(q * s.calls);
+        size_t seen = 0;
+        for (int b = 0; b < kBuckets; ++b) {
+            seen += s.histogram[b];
+            if (seen > target) return std::min((double)(2LL << b), (double)s.maxUs) / 1000.0;
+        }
+        return s.maxUs / 1000.0;
+    }
+
+    std::string jsonEscape(const char* text) {
+        std::string out;
+        for (; *text; ++text) {
+            if (*text == '"' || *text == '\\') out += '\\';
+            out += *text;
+        }
+        return out;
+    }
+}
+
+#if defined(AQ_TRACE_ALLOCATIONS) && !defined(AQ_NO_TRACE)
+//Zliczanie alokacji (na zadanie): zastapiony globalny operator new (koszt - jedna inkrementacja zmiennej watku).
+//Podmiana dotyczy calego programu, takze bibliotek i alokatorow diagnostycznych, dlatego nie jest domyslna.
+void* operator new(size_t size) {
+    ++allocationCount;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    ++allocationCount;
+    return std::malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+#endif
+
+namespace Trace {
+
+    void setEnabled(bool enabled) {
+        tracing.store(enabled, std::memory_order_relaxed);
+    }
+
+#ifndef AQ_NO_TRACE
+    bool enabled() {
+        return tracing.load(std::memory_order_relaxed);
+    }
+#endif
+
+    size_t threadAllocations() {
+        return allocationCount;
+    }
+
+    long long nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    void record(const char* stage, long long startUs, long long durationUs, size_t allocations) {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex); //etapy sa grube (zadanie, plik, raport) - blokada nie przeszkadza
+        Stage& st = s.stages[stage];
+        st.calls++;
+        st.totalUs += durationUs;
+        st.maxUs = std::max(st.maxUs, durationUs);
+        st.allocations += allocations;
+        st.histogram[bucketOf(durationUs)]++;
+
+        if (s.events.size() >= kMaxEvents) {
+            s.droppedEvents++;
+            return;
+        }
+        auto thread = s.threads.find(std::this_thread::get_id());
+        if (thread == s.threads.end()) thread = s.threads.emplace(std::this_thread::get_id(), (int)s.threads.size() + 1).first;
+        s.events.push_back(Event{ stage, thread->second, startUs, durationUs });
+    }
+
+    void count(const char* counter, long long value) {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.counters[counter] += value;
+    }
+
+    std::vector<StageSummary> stages() {
+        std::vector<StageSummary> out;
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (const auto& kv : s.stages) {
+            const Stage& st = kv.second;
+            StageSummary sum;
+            sum.name = kv.first;
+            sum.calls = st.calls;
+            sum.totalMs = st.totalUs / 1000.0;
+            sum.meanMs = st.calls ? sum.totalMs / st.calls : 0;
+            sum.p50Ms = percentileMs(st, 0.50);
+            sum.p95Ms = percentileMs(st, 0.95);
+            sum.maxMs = st.maxUs / 1000.0;
+            sum.allocationsPerCall = st.calls ? (double)st.allocations / st.calls : 0;
+            out.push_back(sum);
+        }
+        std::sort(out.begin(), out.end(), [](const StageSummary& a, const StageSummary& b) { return a.totalMs > b.totalMs; });
+        return out;
+    }
+
+    std::string summary(const char* newline) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2);
+        out << "Etap: wywołania, łącznie / średnio / p50 / p95 / maks [ms]" << (kCountAllocations ? ", alokacje na wywołanie" : "") << newline;
+        for (const auto& st : stages()) {
+            out << "  " << st.name << ": " << st.calls << ", " << st.totalMs << " / " << st.meanMs << " / " << st.p50Ms
+                << " / " << st.p95Ms << " / " << st.maxMs;
+            if (kCountAllocations) out << ", " << std::setprecision(1) << st.allocationsPerCall << std::setprecision(2);
+            out << newline;
+        }
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (!s.counters.empty()) out << "Liczniki:" << newline;
+        for (const auto& kv : s.counters) out << "  " << kv.first << ": " << kv.second << newline;
+        if (s.droppedEvents) out << "Pominięte zdarzenia śladu (limit): " << s.droppedEvents << newline;
+        return out.str();
+    }
+
+    bool writeChromeTrace(const std::string& filename) {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file) {
+            std::cerr << "Nie można zapisać śladu do pliku: " << filename << "\n";
+            return false;
+        }
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        file << "{\"traceEvents\":[";
+        bool first = true;
+        for (const auto& e : s.events) { //zdarzenia "X" (czas trwania) w mikrosekundach
+            file << (first ? "" : ",") << "\n{\"name\":\"" << jsonEscape(e.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+                << ",\"ts\":" << e.startUs << ",\"dur\":" << e.durationUs << "}";
+            first = false;
+        }
+        long long now = nowUs();
+        for (const auto& kv : s.counters) { //liczniki jako zdarzenia "C" na koncu sladu
+            file << (first ? "" : ",") << "\n{\"name\":\"" << jsonEscape(kv.first.c_str()) << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << now
+                << ",\"args\":{\"value\":" << kv.second << "}}";
+            first = false;
+        }
+        file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        return (bool)file;
+    }
+
+    void reset() {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.stages.clear();
+        s.counters.clear();
+        s.events.clear();
+        s.droppedEvents = 0;
+    }
+}
@@ -0,0 +1,132 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// Pomiary wydajności etapów programu (pobieranie, parsowanie, baza, filtrowanie, analiza, wykres).
+/// Każdy etap ma licznik wywołań, histogram czasów (przedziały potęg dwójki w mikrosekundach)
+/// i (po zdefiniowaniu AQ_TRACE_ALLOCATIONS) liczbę alokacji pamięci; osobne liczniki zbierają bajty i rekordy. Wyniki można zapisać jako
+/// ślad Chrome (chrome://tracing, Perfetto) albo wypisać jako tekstowe podsumowanie.
+///
+/// Domyślnie pomiar jest wyłączony w czasie działania (makro kosztuje jedno sprawdzenie flagi),
+/// a zdefiniowanie AQ_NO_TRACE usuwa pomiary z kodu całkowicie. Zliczanie alokacji podmienia globalny
+/// operator new/delete dla całego programu, więc jest włączane osobno makrem AQ_TRACE_ALLOCATIONS.
+namespace Trace {
+
+    /// Włącza lub wyłącza zbieranie pomiarów.
+    void setEnabled(bool enabled);
+
+    /// Czy pomiary są zbierane.
+#ifdef AQ_NO_TRACE
+    inline bool enabled() { return false; }     //kompilator usuwa kod pomiarow
+#else
+    bool enabled();
+#endif
+
+    /// Dodaje czas etapu (zwykle przez ScopedTimer). start liczony od uruchomienia programu.
+    void record(const char* stage, long long startUs, long long durationUs, size_t allocations);
+
+    /// Dodaje wartość do licznika (np. bajty odebrane z sieci, liczba pomiarów).
+    void count(const char* counter, long long value);
+
+    /// Liczba alokacji wykonanych dotąd w bieżącym wątku (operator new); 0 bez AQ_TRACE_ALLOCATIONS.
+    size_t threadAllocations();
+
+    /// Mikrosekundy od uruchomienia programu.
+    long long nowUs();
+
+    /// Podsumowanie jednego etapu.
+    struct StageSummary {
+        std::string name;
+        size_t calls = 0;
+        double totalMs = 0;
+        double meanMs = 0;
+        double p50Ms = 0;       ///< Górna granica przedziału histogramu z medianą
+        double p95Ms = 0;
+        double maxMs = 0;
+        double allocationsPerCall = 0;
+    };
+
+    /// Zwraca podsumowania etapów (posortowane po łącznym czasie malejąco).
+    std::vector<StageSummary> stages();
+
+    /// Zwraca podsumowanie etapów i liczników jako tekst (newline: "\n" w konsoli, "\r\n" w polu EDIT).
+    std::string summary(const char* newline = "\n");
+
+    /// Zapisuje zebrane zdarzenia jako ślad Chrome (format JSON "traceEvents").
+    bool writeChromeTrace(const std::string& filename);
+
+    /// Czyści zebrane pomiary.
+    void reset();
+
+    /// Mierzy czas życia obiektu jako jeden przebieg etapu.
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(const char* stage) : stage(enabled() ? stage : nullptr) {
+            if (this->stage) {
+                allocations = threadAllocations();
+                start = nowUs();
+            }
+        }
+        ~ScopedTimer() {
+            if (stage) record(stage, start, nowUs() - start, threadAllocations() - allocations);
+        }
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        const char* stage;      ///< nullptr, gdy pomiar wyłączony
+        long long start = 0;
+        size_t allocations = 0;
+    };
+
+    /// Sumuje czas wielu krótkich odcinków (np. parsowania kolejnych kawałków odpowiedzi HTTP)
+    /// i zapisuje go jako jeden przebieg etapu - pozwala oddzielić czas parsowania od czasu sieci.
+    class SplitTimer {
+    public:
+        explicit SplitTimer(const char* stage) : stage(enabled() ? stage : nullptr) {}
+        ~SplitTimer() {
+            if (stage && first >= 0) record(stage, first, total, allocations);
+        }
+        SplitTimer(const SplitTimer&) = delete;
+        SplitTimer& operator=(const SplitTimer&) = delete;
+
+        /// Początek odcinka.
+        void start() {
+            if (!stage) return;
+            lapAllocations = threadAllocations();
+            lap = nowUs();
+            if (first < 0) first = lap;
+        }
+
+        /// Koniec odcinka (w tym samym wątku co start).
+        void stop() {
+            if (!stage) return;
+            total += nowUs() - lap;
+            allocations += threadAllocations() - lapAllocations;
+        }
+
+    private:
+        const char* stage;
+        long long first = -1;   ///< Początek pierwszego odcinka (pozycja w śladzie)
+        long long lap = 0;
+        long long total = 0;
+        size_t lapAllocations = 0;
+        size_t allocations = 0;
+    };
+}
+
+#define AQ_TRACE_CONCAT2(a, b) a##b
+#define AQ_TRACE_CONCAT(a, b) AQ_TRACE_CONCAT2(a, b)
+
+#ifdef AQ_NO_TRACE
+#define AQ_TRACE_SCOPE(stage) ((void)0)
+#define AQ_TRACE_COUNT(counter, value) ((void)0)
+#else
+/// Mierzy czas do końca bieżącego bloku jako etap stage.
+#define AQ_TRACE_SCOPE(stage) Trace::ScopedTimer AQ_TRACE_CONCAT(aqTraceScope, __LINE__)(stage)
+/// Dodaje value do licznika (tylko gdy pomiary są włączone).
+#define AQ_TRACE_COUNT(counter, value) do { if (Trace::enabled()) Trace::count(counter, (long long)(value)); } while (0)
+#endif
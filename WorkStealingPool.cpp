@@ -0,0 +1,88 @@
+﻿#include "WorkStealingPool.h"
+
+namespace {
+    thread_local const WorkStealingPool* currentPool = nullptr; //pula, do ktorej nalezy biezacy watek
+    thread_local size_t currentIndex = 0;                       //indeks kolejki biezacego watku
+}
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount) {
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency(); //domyslnie liczba rdzeni
+    if (threadCount == 0) threadCount = 1;  //gdy system nie zna liczby rdzeni
+
+    for (unsigned i = 0; i < threadCount; ++i)
+        queues.emplace_back(new WorkQueue());
+    for (unsigned i = 0; i < threadCount; ++i)
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait(); //dokoncz wszystkie zadania
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+    size_t index = (currentPool == this) ? currentIndex : nextQueue++ % queues.size(); //wlasna kolejka albo round-robin
+    pending++;
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex); //zapobiega zgubieniu powiadomienia
+        queued++;
+    }
+    workAvailable.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    allDone.wait(lock, [this] { return pending.load() == 0; });
+}
+
+bool WorkStealingPool::popLocal(size_t index, Task& task) {
+    std::lock_guard<std::mutex> lock(queues[index]->mutex);
+    if (queues[index]->tasks.empty()) return false;
+    task = std::move(queues[index]->tasks.back()); //najnowsze zadanie - dane sa jeszcze "cieple"
+    queues[index]->tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t index, Task& task) {
+    for (size_t i = 1; i < queues.size(); ++i) { //przeglada pozostale kolejki po kolei
+        WorkQueue& victim = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.front()); //najstarsze zadanie z cudzej kolejki
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentIndex = index;
+
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            queued--;
+            try { task(); } //wykonanie zadania
+            catch (...) {}  //wyjatek z zadania nie moze zatrzymac watku puli
+            if (--pending == 0) { //ostatnie zadanie - budzimy wait()
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex); //brak pracy - watek zasypia
+        workAvailable.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
@@ -0,0 +1,58 @@
+﻿#pragma once //zabezpieczenie przed wielokrotnym dołączaniem pliku
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Pula wątków z podkradaniem zadań (work stealing).
+/// Każdy wątek ma własną kolejkę: zadania zlecone z wnętrza zadania trafiają do kolejki
+/// bieżącego wątku (LIFO), a bezczynny wątek zabiera najstarsze zadanie z kolejki innego wątku.
+/// Dzięki temu wolna stacja nie blokuje szybkich - jej czujniki mogą zostać przejęte przez inne wątki.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>; ///< Pojedyncze zadanie do wykonania
+
+    /// Tworzy pulę z podaną liczbą wątków (0 = liczba rdzeni procesora).
+    explicit WorkStealingPool(unsigned threadCount = 0);
+
+    /// Czeka na zakończenie wszystkich zadań i zatrzymuje wątki.
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /// Zleca zadanie. Wywołane z wątku puli trafia do jego własnej kolejki.
+    void submit(Task task);
+
+    /// Blokuje do momentu wykonania wszystkich zleconych zadań (również tych zleconych w trakcie).
+    void wait();
+
+    /// Zwraca liczbę wątków roboczych.
+    size_t size() const { return workers.size(); }
+
+private:
+    /// Kolejka zadań jednego wątku.
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(size_t index);              //petla glowna watku
+    bool popLocal(size_t index, Task& task);    //zadanie z wlasnej kolejki (najnowsze)
+    bool steal(size_t index, Task& task);       //zadanie podkradzione z innej kolejki (najstarsze)
+
+    std::vector<std::unique_ptr<WorkQueue>> queues; ///< Kolejki zadań (po jednej na wątek)
+    std::vector<std::thread> workers;               ///< Wątki robocze
+    std::atomic<size_t> queued{ 0 };                ///< Zadania czekające w kolejkach
+    std::atomic<size_t> pending{ 0 };               ///< Zadania zlecone i jeszcze niezakończone
+    std::atomic<size_t> nextQueue{ 0 };             ///< Kolejka dla zadań zleconych spoza puli (round-robin)
+    std::mutex sleepMutex;                          ///< Chroni usypianie i budzenie wątków
+    std::condition_variable workAvailable;          ///< Budzi wątki, gdy pojawi się zadanie
+    std::condition_variable allDone;                ///< Budzi wait(), gdy pending spadnie do zera
+    bool stopping = false;                          ///< Flaga zatrzymania puli
+};